@@ -0,0 +1,80 @@
+// 料金設定の保存で呼び出し側が待たされる時間を計測する
+// コミットを待つ save と、キューに入れてすぐに戻る saveAsync を比較する
+#include "../src/async_rate_repository.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+struct LatencyStats {
+    double meanUs;
+    double p99Us;
+    double totalMs;
+};
+
+template <typename Operation>
+LatencyStats measure(int count, Operation&& operation) {
+    std::vector<double> samples;
+    samples.reserve(static_cast<std::size_t>(count));
+    Clock::time_point begin = Clock::now();
+    for (int i = 0; i < count; ++i) {
+        Clock::time_point start = Clock::now();
+        operation(i);
+        samples.push_back(std::chrono::duration<double, std::micro>(Clock::now() - start).count());
+    }
+    double totalMs = std::chrono::duration<double, std::milli>(Clock::now() - begin).count();
+    double sum = 0;
+    for (double sample : samples) {
+        sum += sample;
+    }
+    std::sort(samples.begin(), samples.end());
+    return LatencyStats{sum / count, samples[samples.size() * 99 / 100], totalMs};
+}
+
+void report(const char* label, const LatencyStats& stats) {
+    std::printf("%-26s mean %9.1f us  p99 %9.1f us  total %9.1f ms\n", label, stats.meanUs, stats.p99Us,
+                stats.totalMs);
+}
+
+ParkingRateConfig makeConfig(int i) {
+    return ParkingRateConfig{60, 500 + i % 100, 720, 1500, 60, 300, 720, 1000};
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    const char* dbPath = argc > 1 ? argv[1] : "/tmp/bench_async_repository.db";
+    const int count = argc > 2 ? std::atoi(argv[2]) : 500;
+    std::remove(dbPath);
+
+    std::printf("%d saves over 20 types (default SQLite profile, synchronous=FULL)\n", count);
+
+    auto direct = createSQLiteRepository(dbPath);
+    LatencyStats sync = measure(count, [&](int i) {
+        direct->save("type" + std::to_string(i % 20), makeConfig(i));
+    });
+    direct.reset();
+    report("save() (waits for commit)", sync);
+
+    AsyncRateRepository repo(createSQLiteRepository(dbPath));
+    std::vector<std::future<bool>> results;
+    results.reserve(static_cast<std::size_t>(count));
+    LatencyStats async = measure(count, [&](int i) {
+        results.push_back(repo.saveAsync("type" + std::to_string(i % 20), makeConfig(i)));
+    });
+    Clock::time_point start = Clock::now();
+    repo.flush();
+    double drainMs = std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+    report("saveAsync() (enqueue only)", async);
+    std::printf("async: %llu transactions for %d saves, %.1f ms until all committed\n",
+                static_cast<unsigned long long>(repo.commitCount()), count, async.totalMs + drainMs);
+
+    std::remove(dbPath);
+    return 0;
+}
@@ -0,0 +1,124 @@
+// 駐車記録の一括料金計算の速さ（GB/s）をスレッド数ごとに計測する
+// 月末の照合を想定した CSV を作り、mmap して並列に解析・料金計算した結果を /dev/null に書き出す
+// 1スレッドで1行ずつ読む素朴な実装（std::getline と文字列の分割）とも比べる
+//
+//   bench_batch_pricing [rows] [path]
+#include "../src/batch_pricing.hpp"
+#include <fcntl.h>
+#include <unistd.h>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <random>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+// 現地時刻とエポック秒、日種別を混ぜた行を書き出す
+bool writeInput(const char* path, std::size_t rows) {
+    std::FILE* file = std::fopen(path, "w");
+    if (!file) {
+        return false;
+    }
+    std::mt19937_64 random(42);
+    const std::int64_t start = epochFromLocal(2024, 1, 1, 0, 0);
+    const char* kinds[] = {"auto", "auto", "weekday", "holiday"};
+    std::fputs("entry,exit,lot,day\n", file);
+    for (std::size_t i = 0; i < rows; ++i) {
+        std::int64_t entry = start + static_cast<std::int64_t>(random() % (31 * 86400));
+        std::int64_t exit = entry + static_cast<std::int64_t>(random() % (3 * 86400));
+        const char* kind = kinds[random() % 4];
+        unsigned lot = static_cast<unsigned>(1 + random() % 10);
+        if (i % 2 == 0) {
+            std::fprintf(file, "%lld,%lld,%u,%s\n", static_cast<long long>(entry), static_cast<long long>(exit), lot,
+                         kind);
+        } else {
+            // 現地時刻（JST）で書く
+            std::int64_t local = entry + kJstUtcOffsetSeconds;
+            std::int64_t localExit = exit + kJstUtcOffsetSeconds;
+            CivilDate d = civilFromDays(floorDiv(local, kSecondsPerDay));
+            CivilDate e = civilFromDays(floorDiv(localExit, kSecondsPerDay));
+            int s = static_cast<int>(local - floorDiv(local, kSecondsPerDay) * kSecondsPerDay);
+            int t = static_cast<int>(localExit - floorDiv(localExit, kSecondsPerDay) * kSecondsPerDay);
+            std::fprintf(file, "%04d-%02d-%02d %02d:%02d:%02d,%04d-%02d-%02d %02d:%02d:%02d,%u,%s\n", d.year,
+                         d.month, d.day, s / 3600, s / 60 % 60, s % 60, e.year, e.month, e.day, t / 3600,
+                         t / 60 % 60, t % 60, lot, kind);
+        }
+    }
+    return std::fclose(file) == 0;
+}
+
+// 1行ずつ読み、文字列に分割して計算する
+double naiveSeconds(const BatchPricer& pricer, const char* path, std::uint64_t& checksum) {
+    Clock::time_point begin = Clock::now();
+    std::ifstream input(path);
+    std::string line;
+    std::getline(input, line);  // 見出し
+    std::ostringstream output;
+    while (std::getline(input, line)) {
+        std::int64_t fee = 0;
+        if (pricer.priceLine(line.data(), line.data() + line.size(), ',', fee)) {
+            output << fee << '\n';
+            checksum += static_cast<std::uint64_t>(fee);
+        } else {
+            output << "error\n";
+        }
+    }
+    return std::chrono::duration<double>(Clock::now() - begin).count();
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    const std::size_t rows = argc > 1 ? static_cast<std::size_t>(std::atoll(argv[1])) : 5000000;
+    const char* path = argc > 2 ? argv[2] : "/tmp/bench_batch_pricing.csv";
+    if (!writeInput(path, rows)) {
+        std::fprintf(stderr, "failed to write %s\n", path);
+        return 1;
+    }
+
+    StayPricingEngine pricing(kDefaultDayTariffs);
+    BatchPricer pricer;
+    for (std::uint32_t lot = 1; lot <= 10; ++lot) {
+        pricer.addLot(lot, pricing);
+    }
+    int devNull = ::open("/dev/null", O_WRONLY);
+    auto sink = [devNull](const char* data, std::size_t size) { return ::write(devNull, data, size) >= 0; };
+
+    // ページキャッシュに載せてから計測する
+    BatchPricingStats stats;
+    pricer.runFile(path, BatchPricingOptions(), sink, stats);
+
+    std::uint64_t checksum = 0;
+    double naive = naiveSeconds(pricer, path, checksum);
+    std::printf("%zu rows, %.1f MB, %u CPUs\n", rows, stats.bytes / 1e6, std::thread::hardware_concurrency());
+    std::printf("%-28s %10.3f GB/s %12.0f rows/s\n", "getline, 1 thread", stats.bytes / naive / 1e9, rows / naive);
+
+    std::vector<std::size_t> threadCounts = {1, 2, 4};
+    std::size_t cpus = std::thread::hardware_concurrency();
+    for (std::size_t count = 8; count <= cpus; count *= 2) {
+        threadCounts.push_back(count);
+    }
+    for (std::size_t threads : threadCounts) {
+        BatchPricingOptions options;
+        options.threadCount = threads;
+        if (!pricer.runFile(path, options, sink, stats) || stats.errors != 0) {
+            std::fprintf(stderr, "batch pricing failed\n");
+            return 1;
+        }
+        char name[64];
+        std::snprintf(name, sizeof(name), "mmap + chunks, %zu threads", threads);
+        std::printf("%-28s %10.3f GB/s %12.0f rows/s\n", name, stats.bytes / stats.seconds / 1e9,
+                    stats.rows / stats.seconds);
+    }
+
+    ::close(devNull);
+    std::remove(path);
+    return 0;
+}
@@ -0,0 +1,58 @@
+// CompiledTariff の構築時間・メモリ使用量・料金計算の速度を計測する
+#include "../src/compiled_tariff.hpp"
+#include <chrono>
+#include <cstdio>
+#include <vector>
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+double elapsedNanoseconds(Clock::time_point start) {
+    return std::chrono::duration<double, std::nano>(Clock::now() - start).count();
+}
+
+} // namespace
+
+int main() {
+    const ParkingRateConfig weekdayConfig = {60, 500, 720, 1500, 60, 300, 720, 1000};
+
+    // 構築時間（範囲ごと）
+    const int horizons[] = {24 * 60, CompiledTariff::kDefaultHorizonMinutes, 7 * 24 * 60};
+    for (int horizon : horizons) {
+        const int rounds = 200;
+        std::size_t bytes = 0;
+        Clock::time_point start = Clock::now();
+        for (int i = 0; i < rounds; ++i) {
+            CompiledTariff tariff(weekdayConfig, horizon);
+            bytes = tariff.memoryBytes();
+        }
+        std::printf("build  horizon=%5d min: %8.2f us, %zu bytes\n",
+                    horizon, elapsedNanoseconds(start) / rounds / 1000.0, bytes);
+    }
+
+    // 料金計算（表引きとカーネル計算の比較）
+    CompiledTariff tariff(weekdayConfig);
+    WeekdayParkingLot lot(weekdayConfig);
+    std::vector<int> minutes(1 << 20);
+    for (std::size_t i = 0; i < minutes.size(); ++i) {
+        minutes[i] = static_cast<int>((i * 2654435761u) % static_cast<unsigned>(tariff.horizonMinutes()));
+    }
+
+    long long checksum = 0;
+    Clock::time_point start = Clock::now();
+    for (int m : minutes) {
+        checksum += tariff.calculateFee(m, 10, 0);
+    }
+    double tableNs = elapsedNanoseconds(start) / minutes.size();
+
+    start = Clock::now();
+    for (int m : minutes) {
+        checksum -= lot.calculateFee(m, 10, 0);
+    }
+    double kernelNs = elapsedNanoseconds(start) / minutes.size();
+
+    std::printf("lookup CompiledTariff: %.2f ns/fee, ParkingLot: %.2f ns/fee (checksum %lld)\n",
+                tableNs, kernelNs, checksum);
+    return checksum == 0 ? 0 : 1;
+}
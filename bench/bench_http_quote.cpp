@@ -0,0 +1,194 @@
+// HTTP/1.1 + JSON の料金見積もりの負荷生成器
+// 持続的接続ごとに depth 件の POST /quote をまとめて送り（パイプライン）、全ての応答を受け取るまでを繰り返して
+// 1秒あたりの要求数を計測する。同じ条件のバイナリのフレームと、プロセス内で quoteTotal を呼ぶだけの場合とも比べる
+//
+//   bench_http_quote [reactors] [seconds]       プロセス内にサーバーを起動して比べる
+//   bench_http_quote [connections] [seconds] PORT  起動済みのサーバー（hello_world --http-port）に負荷をかける
+#include "../src/http_quote.hpp"
+#include "../src/quote_server.hpp"
+#include <sys/socket.h>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+const std::int64_t kEntryTime = epochFromLocal(2024, 1, 10, 10, 0);
+
+// 滞在時間を変えて、日中・夜間・日またぎを混ぜる
+std::int64_t exitTime(std::size_t i, int connection) {
+    return kEntryTime + static_cast<std::int64_t>((i * 7919 + static_cast<std::size_t>(connection)) % 3000) * 60;
+}
+
+std::string httpRequests(std::size_t depth, int connection) {
+    std::string requests;
+    for (std::size_t i = 0; i < depth; ++i) {
+        std::string body = "{\"lotId\":1,\"entryTime\":" + std::to_string(kEntryTime) +
+                           ",\"exitTime\":" + std::to_string(exitTime(i, connection)) + "}";
+        requests += "POST /quote HTTP/1.1\r\nHost: localhost\r\nContent-Type: application/json\r\nContent-Length: " +
+                    std::to_string(body.size()) + "\r\n\r\n" + body;
+    }
+    return requests;
+}
+
+// depth 件の応答を受け取る（buffer は使い回す）
+bool receiveHttp(QuoteClient& client, std::size_t depth, std::vector<char>& buffer, std::int64_t& checksum) {
+    std::size_t size = 0;
+    std::size_t offset = 0;
+    std::size_t received = 0;
+    while (received < depth) {
+        HttpQuoteResponse response;
+        std::size_t consumed = 0;
+        HttpParseResult result = parseHttpQuoteResponse(buffer.data() + offset, size - offset, response, consumed);
+        if (result == HttpParseResult::Complete) {
+            if (response.status != 200) {
+                return false;
+            }
+            checksum += response.fee;
+            offset += consumed;
+            ++received;
+            continue;
+        }
+        if (result == HttpParseResult::Invalid) {
+            return false;
+        }
+        if (buffer.size() - size < 16384) {
+            buffer.resize(buffer.size() * 2 + 16384);
+        }
+        ssize_t count = ::recv(client.fd(), buffer.data() + size, buffer.size() - size, 0);
+        if (count <= 0) {
+            return false;
+        }
+        size += static_cast<std::size_t>(count);
+    }
+    return true;
+}
+
+// connections 本の接続で seconds 秒間負荷をかけ、1秒あたりの要求数を返す
+double measure(int port, bool http, int connections, std::size_t depth, double seconds) {
+    std::atomic<bool> stop(false);
+    std::vector<std::uint64_t> counts(static_cast<std::size_t>(connections));
+    std::vector<std::thread> clients;
+    for (int c = 0; c < connections; ++c) {
+        clients.emplace_back([&, c]() {
+            QuoteClient client;
+            if (!client.connectTcp("127.0.0.1", port)) {
+                std::fprintf(stderr, "connect failed\n");
+                return;
+            }
+            std::string text = httpRequests(depth, c);
+            std::vector<QuoteRequest> requests(depth);
+            for (std::size_t i = 0; i < depth; ++i) {
+                requests[i] = QuoteRequest{QuoteOpcode::Quote, static_cast<std::uint32_t>(i), 1, 0, kEntryTime,
+                                           exitTime(i, c)};
+            }
+            std::vector<QuoteResponse> responses(depth);
+            std::vector<char> buffer;
+            std::int64_t checksum = 0;
+            while (!stop.load(std::memory_order_relaxed)) {
+                bool ok = http ? client.sendBytes(text.data(), text.size()) && receiveHttp(client, depth, buffer, checksum)
+                               : client.send(requests.data(), depth) && client.receive(responses.data(), depth);
+                if (!ok) {
+                    std::fprintf(stderr, "request failed\n");
+                    return;
+                }
+                counts[static_cast<std::size_t>(c)] += depth;
+            }
+        });
+    }
+    Clock::time_point begin = Clock::now();
+    std::this_thread::sleep_for(std::chrono::duration<double>(seconds));
+    stop.store(true);
+    for (std::thread& client : clients) {
+        client.join();
+    }
+    double elapsed = std::chrono::duration<double>(Clock::now() - begin).count();
+    std::uint64_t total = 0;
+    for (std::uint64_t count : counts) {
+        total += count;
+    }
+    return total / elapsed;
+}
+
+// ネットワークを通さずに料金計算だけを呼んだ場合
+double measureInProcess(const StayPricingEngine& pricing, double seconds) {
+    std::uint64_t count = 0;
+    std::int64_t checksum = 0;
+    Clock::time_point begin = Clock::now();
+    Clock::time_point end = begin + std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(seconds));
+    while (Clock::now() < end) {
+        for (std::size_t i = 0; i < 1024; ++i) {
+            std::int64_t fee = 0;
+            pricing.quoteTotal(kEntryTime, exitTime(i, 0), fee);
+            checksum += fee;
+        }
+        count += 1024;
+    }
+    double elapsed = std::chrono::duration<double>(Clock::now() - begin).count();
+    if (checksum == 42) {
+        std::printf(" ");  // 最適化で消されないように
+    }
+    return count / elapsed;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    const double seconds = argc > 2 ? std::atof(argv[2]) : 2.0;
+    const std::size_t depths[] = {1, 16, 128};
+
+    if (argc > 3) {
+        const int connections = std::atoi(argv[1]);
+        const int port = std::atoi(argv[3]);
+        std::printf("%d connections to 127.0.0.1:%d, %.1f s per case\n", connections, port, seconds);
+        std::printf("%6s %14s\n", "depth", "requests/s");
+        for (std::size_t depth : depths) {
+            std::printf("%6zu %14.0f\n", depth, measure(port, true, connections, depth, seconds));
+        }
+        return 0;
+    }
+
+    const std::size_t reactors = argc > 1 ? static_cast<std::size_t>(std::atoi(argv[1])) : 1;
+    StayPricingEngine pricing(kDefaultDayTariffs);
+    QuoteService service(256, 1024);
+    service.addLot(1, pricing);
+
+    std::printf("%zu reactors, %u CPUs, loopback TCP, %.1f s per case\n", reactors,
+                std::thread::hardware_concurrency(), seconds);
+    std::printf("%-22s %14.0f requests/s\n", "in-process quoteTotal", measureInProcess(pricing, seconds));
+    std::printf("%-9s %-9s %12s %6s %14s\n", "protocol", "backend", "connections", "depth", "requests/s");
+    const QuoteServerProtocol protocols[] = {QuoteServerProtocol::Binary, QuoteServerProtocol::Http};
+    const QuoteServerBackend backends[] = {QuoteServerBackend::Epoll, QuoteServerBackend::IoUring};
+    const int connectionCounts[] = {1, 4};
+    for (QuoteServerProtocol protocol : protocols) {
+        for (QuoteServerBackend backend : backends) {
+            QuoteServer server(service);
+            QuoteServerOptions options;
+            options.reactorCount = reactors;
+            options.protocol = protocol;
+            options.backend = backend;
+            if (!server.start(options)) {
+                return 1;
+            }
+            if (server.backend() != backend) {
+                continue;  // io_uring が使えない
+            }
+            bool http = protocol == QuoteServerProtocol::Http;
+            for (int connections : connectionCounts) {
+                for (std::size_t depth : depths) {
+                    std::printf("%-9s %-9s %12d %6zu %14.0f\n", http ? "http" : "binary",
+                                backend == QuoteServerBackend::IoUring ? "io_uring" : "epoll", connections, depth,
+                                measure(server.tcpPort(), http, connections, depth, seconds));
+                }
+            }
+            server.stop();
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,125 @@
+// 料金見積もりサーバーのループバックでのスループットとレイテンシを計測する
+// 接続ごとに depth 件の見積もり要求をまとめて送り、全ての応答を受け取るまでを1往復として計測する
+// （depth 1 は1件ずつ応答を待つ場合のレイテンシ）
+// epoll と io_uring のそれぞれで、スループットとサーバー側の要求あたりのシステムコール数を比べる
+//
+//   bench_quote_server [reactors] [seconds]
+#include "../src/quote_server.hpp"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <thread>
+#include <vector>
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+struct Result {
+    double quotesPerSecond;
+    double p50Us;
+    double p99Us;
+};
+
+Result measure(int port, int connections, std::size_t depth, double seconds) {
+    const std::int64_t entryTime = epochFromLocal(2024, 1, 10, 10, 0);
+    std::atomic<bool> stop(false);
+    std::vector<std::vector<std::int64_t>> samples(static_cast<std::size_t>(connections));
+    std::vector<std::uint64_t> counts(static_cast<std::size_t>(connections));
+    std::vector<std::thread> clients;
+    for (int c = 0; c < connections; ++c) {
+        clients.emplace_back([&, c]() {
+            QuoteClient client;
+            if (!client.connectTcp("127.0.0.1", port)) {
+                std::fprintf(stderr, "connect failed\n");
+                return;
+            }
+            std::vector<QuoteRequest> requests(depth);
+            for (std::size_t i = 0; i < depth; ++i) {
+                // 滞在時間を変えて、日中・夜間・日またぎを混ぜる
+                std::int64_t stay = static_cast<std::int64_t>((i * 7919 + static_cast<std::size_t>(c)) % 3000) * 60;
+                requests[i] = QuoteRequest{QuoteOpcode::Quote, static_cast<std::uint32_t>(i), 1, 0, entryTime,
+                                           entryTime + stay};
+            }
+            std::vector<QuoteResponse> responses(depth);
+            std::vector<std::int64_t>& latencies = samples[static_cast<std::size_t>(c)];
+            while (!stop.load(std::memory_order_relaxed)) {
+                Clock::time_point begin = Clock::now();
+                if (!client.send(requests.data(), depth) || !client.receive(responses.data(), depth)) {
+                    std::fprintf(stderr, "request failed\n");
+                    return;
+                }
+                latencies.push_back(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                    Clock::now() - begin).count());
+                counts[static_cast<std::size_t>(c)] += depth;
+            }
+        });
+    }
+    Clock::time_point begin = Clock::now();
+    std::this_thread::sleep_for(std::chrono::duration<double>(seconds));
+    stop.store(true);
+    for (std::thread& client : clients) {
+        client.join();
+    }
+    double elapsed = std::chrono::duration<double>(Clock::now() - begin).count();
+
+    std::vector<std::int64_t> all;
+    std::uint64_t total = 0;
+    for (int c = 0; c < connections; ++c) {
+        all.insert(all.end(), samples[static_cast<std::size_t>(c)].begin(), samples[static_cast<std::size_t>(c)].end());
+        total += counts[static_cast<std::size_t>(c)];
+    }
+    if (all.empty()) {
+        return Result{0, 0, 0};
+    }
+    std::sort(all.begin(), all.end());
+    return Result{total / elapsed, all[all.size() / 2] / 1000.0, all[all.size() * 99 / 100] / 1000.0};
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    const std::size_t reactors = argc > 1 ? static_cast<std::size_t>(std::atoi(argv[1])) : 1;
+    const double seconds = argc > 2 ? std::atof(argv[2]) : 2.0;
+
+    StayPricingEngine pricing(kDefaultDayTariffs);
+    QuoteService service(256, 1024);
+    service.addLot(1, pricing);
+
+    std::printf("%zu reactors, %u CPUs, loopback TCP, %.1f s per case\n", reactors,
+                std::thread::hardware_concurrency(), seconds);
+    std::printf("%-9s %12s %6s %14s %10s %10s %14s\n", "backend", "connections", "depth", "quotes/s", "p50 us",
+                "p99 us", "syscalls/req");
+    const QuoteServerBackend backends[] = {QuoteServerBackend::Epoll, QuoteServerBackend::IoUring};
+    const int connectionCounts[] = {1, 4};
+    const std::size_t depths[] = {1, 16, 128};
+    for (QuoteServerBackend backend : backends) {
+        QuoteServer server(service);
+        QuoteServerOptions options;
+        options.reactorCount = reactors;
+        options.backend = backend;
+        if (!server.start(options)) {
+            return 1;
+        }
+        if (server.backend() != backend) {
+            continue;  // io_uring が使えない
+        }
+        const char* name = backend == QuoteServerBackend::IoUring ? "io_uring" : "epoll";
+        for (int connections : connectionCounts) {
+            for (std::size_t depth : depths) {
+                std::uint64_t syscalls = server.syscallCount();
+                std::uint64_t requests = server.requestCount();
+                Result result = measure(server.tcpPort(), connections, depth, seconds);
+                syscalls = server.syscallCount() - syscalls;
+                requests = server.requestCount() - requests;
+                std::printf("%-9s %12d %6zu %14.0f %10.1f %10.1f %14.3f\n", name, connections, depth,
+                            result.quotesPerSecond, result.p50Us, result.p99Us,
+                            requests > 0 ? static_cast<double>(syscalls) / requests : 0.0);
+            }
+        }
+        server.stop();
+    }
+    return 0;
+}
@@ -0,0 +1,89 @@
+// 過去の駐車記録をまとめて再計算する際の「その時点の版」の解決時間を計測する
+// 記録ごとに loadAsOf でDBに問い合わせる方式と、RateHistoryIndex で二分探索する方式を比較する
+#include "../src/rate_history.hpp"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+struct Ticket {
+    int typeIndex;
+    std::int64_t entryTime;
+};
+
+} // namespace
+
+int main(int argc, char** argv) {
+    const char* dbPath = argc > 1 ? argv[1] : "/tmp/bench_rate_history.db";
+    const int ticketCount = argc > 2 ? std::atoi(argv[2]) : 200000;
+    const int typeCount = 20;
+    const int versionsPerType = 120;  // 10年分の月次改定
+    const std::int64_t start = 1396278000;  // 2014-04-01 00:00:00 JST
+    const std::int64_t month = 30LL * 86400;
+    std::remove(dbPath);
+
+    auto repo = createSQLiteRepository(dbPath);
+    std::vector<std::string> types;
+    for (int t = 0; t < typeCount; ++t) {
+        types.push_back("type" + std::to_string(t));
+        for (int v = 0; v < versionsPerType; ++v) {
+            ParkingRateConfig config{60, 300 + v, 720, 1500, 60, 200 + v, 720, 1000};
+            if (!repo->saveVersion(RateVersion{types.back(), start + v * month, config})) {
+                std::fprintf(stderr, "failed to prepare %s\n", dbPath);
+                return 1;
+            }
+        }
+    }
+
+    std::mt19937_64 random(42);
+    std::vector<Ticket> tickets(static_cast<std::size_t>(ticketCount));
+    for (Ticket& ticket : tickets) {
+        ticket.typeIndex = static_cast<int>(random() % typeCount);
+        ticket.entryTime = start + static_cast<std::int64_t>(random() % (versionsPerType * month));
+    }
+
+    // 記録ごとにDBへ問い合わせる
+    long long checksum = 0;
+    Clock::time_point begin = Clock::now();
+    for (const Ticket& ticket : tickets) {
+        ParkingRateConfig config;
+        if (repo->loadAsOf(types[ticket.typeIndex], ticket.entryTime, config)) {
+            checksum += config.unitPrice;
+        }
+    }
+    double queryNs = std::chrono::duration<double, std::nano>(Clock::now() - begin).count() / ticketCount;
+
+    // 索引を構築してから二分探索で引く（構築時間も含める）
+    long long indexChecksum = 0;
+    begin = Clock::now();
+    RateHistoryIndex index;
+    index.load(*repo);
+    double buildMs = std::chrono::duration<double, std::milli>(Clock::now() - begin).count();
+    Clock::time_point lookupBegin = Clock::now();
+    for (const Ticket& ticket : tickets) {
+        const ParkingRateConfig* config = index.find(types[ticket.typeIndex], ticket.entryTime);
+        if (config) {
+            indexChecksum += config->unitPrice;
+        }
+    }
+    double lookupNs = std::chrono::duration<double, std::nano>(Clock::now() - lookupBegin).count() / ticketCount;
+
+    std::printf("%d tickets, %d types x %d versions\n", ticketCount, typeCount, versionsPerType);
+    std::printf("%-30s %10.1f ns/ticket\n", "loadAsOf() per ticket", queryNs);
+    std::printf("%-30s %10.1f ns/ticket (build %.2f ms)\n", "RateHistoryIndex::find()", lookupNs, buildMs);
+    std::printf("speedup (including build): %.1fx\n",
+                queryNs * ticketCount / (lookupNs * ticketCount + buildMs * 1e6));
+    if (checksum != indexChecksum) {
+        std::fprintf(stderr, "checksum mismatch: %lld != %lld\n", checksum, indexChecksum);
+        return 1;
+    }
+
+    std::remove(dbPath);
+    return 0;
+}
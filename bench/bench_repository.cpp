@@ -0,0 +1,120 @@
+// ParkingRateRepository::load のレイテンシを計測する
+// 準備済みステートメントを使い回す現在の実装と、呼び出しごとに
+// sqlite3_prepare_v2 / sqlite3_finalize を行う従来の方式を比較する
+// あわせて、1件ずつの save と1トランザクションの saveBatch の所要時間を比較する
+#include "../src/parking_rate_repository.hpp"
+#include <sqlite3.h>
+#include <algorithm>
+#include <cstdlib>
+#include <chrono>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+const char* kSelectSQL =
+    "SELECT unit_minutes, unit_price, max_minutes, max_fee, "
+    "night_unit_minutes, night_unit_price, night_max_minutes, night_max_fee "
+    "FROM parking_rates WHERE type = ?;";
+
+// 従来の実装と同じく、呼び出しごとにステートメントを準備・破棄する
+bool loadWithPrepare(sqlite3* db, const char* type, ParkingRateConfig& config) {
+    sqlite3_stmt* stmt;
+    if (sqlite3_prepare_v2(db, kSelectSQL, -1, &stmt, nullptr) != SQLITE_OK) {
+        return false;
+    }
+    sqlite3_bind_text(stmt, 1, type, -1, SQLITE_STATIC);
+    bool found = sqlite3_step(stmt) == SQLITE_ROW;
+    if (found) {
+        config.unitMinutes = sqlite3_column_int(stmt, 0);
+        config.unitPrice = sqlite3_column_int(stmt, 1);
+        config.maxMinutes = sqlite3_column_int(stmt, 2);
+        config.maxFee = sqlite3_column_int(stmt, 3);
+        config.nightUnitMinutes = sqlite3_column_int(stmt, 4);
+        config.nightUnitPrice = sqlite3_column_int(stmt, 5);
+        config.nightMaxMinutes = sqlite3_column_int(stmt, 6);
+        config.nightMaxFee = sqlite3_column_int(stmt, 7);
+    }
+    sqlite3_finalize(stmt);
+    return found;
+}
+
+struct LatencyStats {
+    double meanNs;
+    double p50Ns;
+    double p99Ns;
+};
+
+template <typename Operation>
+LatencyStats measure(int iterations, Operation&& operation) {
+    std::vector<double> samples;
+    samples.reserve(static_cast<std::size_t>(iterations));
+    double total = 0;
+    for (int i = 0; i < iterations; ++i) {
+        Clock::time_point start = Clock::now();
+        operation();
+        double ns = std::chrono::duration<double, std::nano>(Clock::now() - start).count();
+        samples.push_back(ns);
+        total += ns;
+    }
+    std::sort(samples.begin(), samples.end());
+    return LatencyStats{total / iterations, samples[samples.size() / 2], samples[samples.size() * 99 / 100]};
+}
+
+void report(const char* label, const LatencyStats& stats) {
+    std::printf("%-28s mean %8.0f ns  p50 %8.0f ns  p99 %8.0f ns\n", label, stats.meanNs, stats.p50Ns, stats.p99Ns);
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    const char* dbPath = argc > 1 ? argv[1] : "/tmp/bench_repository.db";
+    const int iterations = argc > 2 ? std::atoi(argv[2]) : 100000;
+    std::remove(dbPath);
+
+    auto repo = createSQLiteRepository(dbPath);
+    ParkingRateConfig weekday = {60, 500, 720, 1500, 60, 300, 720, 1000};
+    if (!repo->save("weekday", weekday)) {
+        std::fprintf(stderr, "failed to prepare %s\n", dbPath);
+        return 1;
+    }
+
+    sqlite3* db = nullptr;
+    sqlite3_open(dbPath, &db);
+
+    ParkingRateConfig config;
+    LatencyStats before = measure(iterations, [&]() { loadWithPrepare(db, "weekday", config); });
+    LatencyStats after = measure(iterations, [&]() { repo->load("weekday", config); });
+
+    std::printf("load() latency over %d calls\n", iterations);
+    report("before (prepare per call)", before);
+    report("after (cached statement)", after);
+    std::printf("speedup (mean): %.2fx\n", before.meanNs / after.meanNs);
+
+    // 1件ずつの保存は1件ごとにコミット（同期書き込み）が発生する
+    const int batchSize = 200;
+    RateConfigList configs;
+    for (int i = 0; i < batchSize; ++i) {
+        configs.emplace_back("type" + std::to_string(i), weekday);
+    }
+    Clock::time_point start = Clock::now();
+    for (const auto& entry : configs) {
+        repo->save(entry.first, entry.second);
+    }
+    double eachMs = std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+    start = Clock::now();
+    repo->saveBatch(configs);
+    double batchMs = std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+
+    std::printf("\nsave %d configs\n", batchSize);
+    std::printf("%-28s %10.2f ms\n", "save() per config", eachMs);
+    std::printf("%-28s %10.2f ms\n", "saveBatch() one transaction", batchMs);
+    std::printf("speedup: %.2fx\n", eachMs / batchMs);
+
+    sqlite3_close(db);
+    std::remove(dbPath);
+    return 0;
+}
@@ -0,0 +1,151 @@
+// 書き込みプロセスが動いている間の読み取りプロセスのスループットを計測する
+// 読み取りプロセスと書き込みプロセスを fork し、それぞれが自分の接続で同じDBファイルを使う
+// 既定の設定（ロールバックジャーナル、ロック待ちなし）、ロック待ちのみ指定、
+// 本番向け設定（WAL）を比較する
+#include "../src/parking_rate_repository.hpp"
+#include <sys/mman.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+// プロセス間で共有するカウンタ（MAP_SHARED の無名メモリに置く）
+struct SharedCounters {
+    std::atomic<long> reads;
+    std::atomic<long> readFailures;
+    std::atomic<long> writes;
+    std::atomic<long> writeFailures;
+};
+
+const int kTypeCount = 50;
+
+std::string typeName(int i) {
+    return "type" + std::to_string(i);
+}
+
+void removeDatabase(const std::string& dbPath) {
+    std::remove(dbPath.c_str());
+    std::remove((dbPath + "-wal").c_str());
+    std::remove((dbPath + "-shm").c_str());
+    std::remove((dbPath + "-journal").c_str());
+}
+
+void runReader(const std::string& dbPath, const SQLiteRepositoryOptions& options,
+               Clock::time_point deadline, int seed, SharedCounters* counters) {
+    auto repo = createSQLiteRepository(dbPath, options);
+    unsigned int state = static_cast<unsigned int>(seed) * 2654435761u + 1;
+    long reads = 0;
+    long failures = 0;
+    ParkingRateConfig config;
+    while (Clock::now() < deadline) {
+        state = state * 1103515245u + 12345u;
+        if (repo->load(typeName(static_cast<int>((state >> 16) % kTypeCount)), config)) {
+            ++reads;
+        } else {
+            ++failures;
+        }
+    }
+    counters->reads += reads;
+    counters->readFailures += failures;
+}
+
+void runWriter(const std::string& dbPath, const SQLiteRepositoryOptions& options,
+               Clock::time_point deadline, SharedCounters* counters) {
+    auto repo = createSQLiteRepository(dbPath, options);
+    RateConfigList configs;
+    for (int i = 0; i < kTypeCount; ++i) {
+        configs.emplace_back(typeName(i), ParkingRateConfig{60, 500, 720, 1500, 60, 300, 720, 1000});
+    }
+    long writes = 0;
+    long failures = 0;
+    for (int round = 0; Clock::now() < deadline; ++round) {
+        for (auto& entry : configs) {
+            entry.second.unitPrice = 500 + round % 100;
+        }
+        if (repo->saveBatch(configs)) {
+            ++writes;
+        } else {
+            ++failures;
+        }
+    }
+    counters->writes += writes;
+    counters->writeFailures += failures;
+}
+
+void runProfile(const char* label, const std::string& dbPath, const SQLiteRepositoryOptions& options,
+                int readerCount, double seconds) {
+    removeDatabase(dbPath);
+    {
+        // WAL はDBファイルに記録されるため、最初の接続で設定すれば全プロセスに効く
+        auto seed = createSQLiteRepository(dbPath, options);
+        RateConfigList configs;
+        for (int i = 0; i < kTypeCount; ++i) {
+            configs.emplace_back(typeName(i), ParkingRateConfig{60, 500, 720, 1500, 60, 300, 720, 1000});
+        }
+        if (!seed->saveBatch(configs)) {
+            std::fprintf(stderr, "failed to prepare %s\n", dbPath.c_str());
+            std::exit(1);
+        }
+    }
+
+    void* memory = mmap(nullptr, sizeof(SharedCounters), PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+    if (memory == MAP_FAILED) {
+        std::perror("mmap");
+        std::exit(1);
+    }
+    SharedCounters* counters = new (memory) SharedCounters{{0}, {0}, {0}, {0}};
+
+    Clock::time_point deadline = Clock::now() + std::chrono::duration_cast<Clock::duration>(
+        std::chrono::duration<double>(seconds));
+    std::vector<pid_t> children;
+    for (int r = 0; r <= readerCount; ++r) {
+        pid_t pid = fork();
+        if (pid == 0) {
+            if (r == readerCount) {
+                runWriter(dbPath, options, deadline, counters);
+            } else {
+                runReader(dbPath, options, deadline, r, counters);
+            }
+            _exit(0);
+        }
+        children.push_back(pid);
+    }
+    for (pid_t pid : children) {
+        waitpid(pid, nullptr, 0);
+    }
+
+    std::printf("%-34s reads/s %10.0f  read failures %8ld  commits/s %8.0f  write failures %6ld\n", label,
+                counters->reads.load() / seconds, counters->readFailures.load(),
+                counters->writes.load() / seconds, counters->writeFailures.load());
+
+    munmap(memory, sizeof(SharedCounters));
+    removeDatabase(dbPath);
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    const std::string dbPath = argc > 1 ? argv[1] : "/tmp/bench_repository_concurrency.db";
+    const int readerCount = argc > 2 ? std::atoi(argv[2]) : 4;
+    const double seconds = argc > 3 ? std::atof(argv[3]) : 2.0;
+
+    std::printf("%d reader processes + 1 writer process (saveBatch of %d configs), %.1f s each\n",
+                readerCount, kTypeCount, seconds);
+
+    runProfile("default (rollback journal)", dbPath, SQLiteRepositoryOptions(), readerCount, seconds);
+
+    SQLiteRepositoryOptions busyOnly;
+    busyOnly.busyTimeoutMs = 5000;
+    runProfile("rollback journal + busy timeout", dbPath, busyOnly, readerCount, seconds);
+
+    runProfile("production (WAL)", dbPath, SQLiteRepositoryOptions::production(), readerCount, seconds);
+    return 0;
+}
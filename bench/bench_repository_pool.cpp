@@ -0,0 +1,117 @@
+// 複数スレッドからの料金設定の読み込みスループットを計測する
+// 1つの接続をミューテックスで直列化する方式と、スレッドごとの接続を使う方式を
+// 書き込みスレッドが動いている状態で比較する
+#include "../src/parking_rate_repository.hpp"
+#include "../src/pooled_rate_repository.hpp"
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+const int kTypeCount = 50;
+
+// 1つの接続を共有し、全ての呼び出しをミューテックスで直列化する従来の使い方
+class MutexRepository {
+public:
+    explicit MutexRepository(std::unique_ptr<ParkingRateRepository> inner) : inner_(std::move(inner)) {}
+
+    bool load(const std::string& type, ParkingRateConfig& config) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return inner_->load(type, config);
+    }
+
+    bool saveBatch(const RateConfigList& configs) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return inner_->saveBatch(configs);
+    }
+
+private:
+    std::mutex mutex_;
+    std::unique_ptr<ParkingRateRepository> inner_;
+};
+
+RateConfigList makeConfigs(int round) {
+    RateConfigList configs;
+    for (int i = 0; i < kTypeCount; ++i) {
+        configs.emplace_back("type" + std::to_string(i),
+                             ParkingRateConfig{60, 500 + round % 100, 720, 1500, 60, 300, 720, 1000});
+    }
+    return configs;
+}
+
+// threads 個の読み込みスレッドと1つの書き込みスレッド（10ms ごとに一括保存）を動かし、読み込み回数/秒を返す
+template <typename Repository>
+double measure(Repository& repo, int threads, double seconds) {
+    std::atomic<bool> stop(false);
+    std::atomic<long> reads(0);
+    std::vector<std::thread> workers;
+    for (int t = 0; t < threads; ++t) {
+        workers.emplace_back([&, t]() {
+            std::vector<std::string> types;
+            for (int i = 0; i < kTypeCount; ++i) {
+                types.push_back("type" + std::to_string(i));
+            }
+            long count = 0;
+            ParkingRateConfig config;
+            for (int i = t; !stop.load(std::memory_order_relaxed); ++i) {
+                repo.load(types[static_cast<std::size_t>(i % kTypeCount)], config);
+                ++count;
+            }
+            reads += count;
+        });
+    }
+    std::thread writer([&]() {
+        for (int round = 0; !stop.load(std::memory_order_relaxed); ++round) {
+            repo.saveBatch(makeConfigs(round));
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        }
+    });
+
+    std::this_thread::sleep_for(std::chrono::duration<double>(seconds));
+    stop.store(true);
+    for (std::thread& worker : workers) {
+        worker.join();
+    }
+    writer.join();
+    return reads.load() / seconds;
+}
+
+void removeDatabase(const std::string& dbPath) {
+    std::remove(dbPath.c_str());
+    std::remove((dbPath + "-wal").c_str());
+    std::remove((dbPath + "-shm").c_str());
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    const std::string dbPath = argc > 1 ? argv[1] : "/tmp/bench_repository_pool.db";
+    const int maxThreads = argc > 2 ? std::atoi(argv[2]) : static_cast<int>(std::thread::hardware_concurrency());
+    const double seconds = argc > 3 ? std::atof(argv[3]) : 1.0;
+
+    removeDatabase(dbPath);
+    SQLiteRepositoryOptions options = SQLiteRepositoryOptions::production();
+    MutexRepository shared(createSQLiteRepository(dbPath, options));
+    auto pooled = createPooledSQLiteRepository(dbPath, options);
+    pooled->saveBatch(makeConfigs(0));
+
+    std::printf("reader threads (+1 writer, WAL), %.1f s each, %u hardware threads\n", seconds,
+                std::thread::hardware_concurrency());
+    std::printf("%8s %22s %22s %8s\n", "threads", "mutex loads/s", "pooled loads/s", "ratio");
+    for (int threads = 1; threads <= (maxThreads > 0 ? maxThreads : 1); threads *= 2) {
+        double mutexRate = measure(shared, threads, seconds);
+        double pooledRate = measure(*pooled, threads, seconds);
+        std::printf("%8d %22.0f %22.0f %7.2fx\n", threads, mutexRate, pooledRate, pooledRate / mutexRate);
+    }
+
+    removeDatabase(dbPath);
+    return 0;
+}
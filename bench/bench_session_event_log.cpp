@@ -0,0 +1,152 @@
+// 駐車セッションのイベントログの書き込みと、再起動時の再生の速さを計測する
+// - fsync の方針ごとの書き込みスループット（コミットごとの fsync は複数ゲートでまとめて書く効果も見る）
+//   write / fdatasync と io_uring（書き込みと fsync を1回の io_uring_enter で投入）の比較
+// - ログを再生して入庫中のセッションを復元する速さ
+#include "../src/journaled_session_store.hpp"
+#include <dirent.h>
+#include <unistd.h>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+void removeLogDirectory(const std::string& directory) {
+    if (DIR* dir = ::opendir(directory.c_str())) {
+        while (dirent* entry = ::readdir(dir)) {
+            std::string name = entry->d_name;
+            if (name != "." && name != "..") {
+                std::remove((directory + "/" + name).c_str());
+            }
+        }
+        ::closedir(dir);
+    }
+    ::rmdir(directory.c_str());
+}
+
+// threads 個のゲートがそれぞれ perThread 回「追記してコミット」したときのイベント数/秒
+double measureCommits(const std::string& directory, EventLogSync sync, bool ioUring, int threads, int perThread,
+                      std::uint64_t& writes, std::uint64_t& syncs, std::uint64_t& syscalls) {
+    removeLogDirectory(directory);
+    SessionEventLogOptions options;
+    options.sync = sync;
+    options.ioUring = ioUring;
+    SessionEventLog log;
+    if (!log.open(directory, options)) {
+        return 0;
+    }
+    Clock::time_point begin = Clock::now();
+    std::vector<std::thread> gates;
+    for (int t = 0; t < threads; ++t) {
+        gates.emplace_back([&, t]() {
+            for (int i = 0; i < perThread; ++i) {
+                std::uint64_t ticketId = static_cast<std::uint64_t>(t) * perThread + i + 1;
+                log.commit(log.append(SessionEventType::Entry, ticketId, 0, 0));
+            }
+        });
+    }
+    for (std::thread& gate : gates) {
+        gate.join();
+    }
+    double seconds = std::chrono::duration<double>(Clock::now() - begin).count();
+    writes = log.writeCount();
+    syncs = log.syncCount();
+    // io_uring では fsync するコミットが io_uring_enter 1回（fsync しないコミットは write 1回）
+    syscalls = log.usesIoUring() ? writes : writes + syncs;
+    return threads * perThread / seconds;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    const std::string directory = argc > 1 ? argv[1] : "/tmp/bench_session_event_log";
+    const int replayEvents = argc > 2 ? std::atoi(argv[2]) : 4000000;
+    const int syncedEvents = argc > 3 ? std::atoi(argv[3]) : 2000;
+
+    std::printf("%-40s %14s %10s %10s %10s\n", "commit", "events/s", "writes", "fsyncs", "syscalls");
+    struct Case {
+        const char* name;
+        EventLogSync sync;
+        int threads;
+        bool ioUring;
+    };
+    const Case cases[] = {
+        {"None, 1 gate", EventLogSync::None, 1, false},
+        {"Interval(100ms), 1 gate", EventLogSync::Interval, 1, false},
+        {"Always, 1 gate", EventLogSync::Always, 1, false},
+        {"Always, 1 gate, io_uring", EventLogSync::Always, 1, true},
+        {"Always, 8 gates (group commit)", EventLogSync::Always, 8, false},
+        {"Always, 8 gates, io_uring", EventLogSync::Always, 8, true},
+        {"Always, 32 gates (group commit)", EventLogSync::Always, 32, false},
+    };
+    for (const Case& c : cases) {
+        int total = c.sync == EventLogSync::Always ? syncedEvents : 200000;
+        std::uint64_t writes = 0;
+        std::uint64_t syncs = 0;
+        std::uint64_t syscalls = 0;
+        double rate = measureCommits(directory, c.sync, c.ioUring, c.threads, total / c.threads, writes, syncs,
+                                     syscalls);
+        std::printf("%-40s %14.0f %10llu %10llu %10llu\n", c.name, rate, static_cast<unsigned long long>(writes),
+                    static_cast<unsigned long long>(syncs), static_cast<unsigned long long>(syscalls));
+    }
+
+    // 再生用のログ: 入庫と出庫を交互に書き、常に約10万台が入庫中になるようにする
+    removeLogDirectory(directory);
+    const std::uint64_t openSessions = 100000;
+    StayPricingEngine pricing(kDefaultDayTariffs);
+    {
+        SessionEventLogOptions options;
+        options.sync = EventLogSync::None;
+        SessionEventLog log;
+        if (!log.open(directory, options)) {
+            return 1;
+        }
+        std::uint64_t nextEntry = 1;
+        std::uint64_t nextExit = 1;
+        for (int i = 0; i < replayEvents; ++i) {
+            if (nextEntry - nextExit < openSessions || i % 2 == 0) {
+                log.append(SessionEventType::Entry, nextEntry++, 0, 0);
+            } else {
+                log.append(SessionEventType::Exit, nextExit++, 0, 3600, 500);
+            }
+            if (i % 4096 == 0) {
+                log.flush();
+            }
+        }
+        log.flush();
+    }
+
+    Clock::time_point begin = Clock::now();
+    std::uint64_t scanned = 0;
+    {
+        SessionEventLog log;
+        log.open(directory, SessionEventLogOptions(), [&](const SessionEvent&) {
+            ++scanned;
+            return true;
+        });
+    }
+    double scanSeconds = std::chrono::duration<double>(Clock::now() - begin).count();
+
+    begin = Clock::now();
+    JournaledSessionStore store(64, openSessions * 2);
+    store.addLot(0, pricing);
+    if (!store.open(directory)) {
+        return 1;
+    }
+    double rebuildSeconds = std::chrono::duration<double>(Clock::now() - begin).count();
+
+    std::printf("\nreplay %llu events (%zu open sessions after replay)\n",
+                static_cast<unsigned long long>(store.replayedEvents()), store.size());
+    std::printf("%-40s %14.0f events/s\n", "scan + CRC check", scanned / scanSeconds);
+    std::printf("%-40s %14.0f events/s (%.0f ms)\n", "rebuild open-session index", store.replayedEvents() / rebuildSeconds,
+                rebuildSeconds * 1000);
+
+    store.close();
+    removeLogDirectory(directory);
+    return 0;
+}
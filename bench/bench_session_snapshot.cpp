@@ -0,0 +1,192 @@
+// 再起動時の復元にかかる時間を計測する
+// 全てのイベントログを再生する場合と、スナップショット＋その後のログだけを再生する場合を比較する
+// 入出庫と並行してスナップショットを取り、入出庫を止めた時間とゲートの最長の待ち時間も計測する
+#include "../src/journaled_session_store.hpp"
+#include <dirent.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <thread>
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+void removeLogDirectory(const std::string& directory) {
+    if (DIR* dir = ::opendir(directory.c_str())) {
+        while (dirent* entry = ::readdir(dir)) {
+            std::string name = entry->d_name;
+            if (name != "." && name != "..") {
+                std::remove((directory + "/" + name).c_str());
+            }
+        }
+        ::closedir(dir);
+    }
+    ::rmdir(directory.c_str());
+}
+
+double directoryMiB(const std::string& directory) {
+    double bytes = 0;
+    if (DIR* dir = ::opendir(directory.c_str())) {
+        while (dirent* entry = ::readdir(dir)) {
+            struct stat status;
+            if (::stat((directory + "/" + entry->d_name).c_str(), &status) == 0 && S_ISREG(status.st_mode)) {
+                bytes += static_cast<double>(status.st_size);
+            }
+        }
+        ::closedir(dir);
+    }
+    return bytes / (1024.0 * 1024.0);
+}
+
+// 入庫と出庫を交互に行い、常に約 openSessions 台が入庫中になるようにする
+class Gate {
+public:
+    explicit Gate(std::uint64_t openSessions) : openSessions_(openSessions) {}
+
+    void run(JournaledSessionStore& store, int events) {
+        const std::int64_t entryTime = epochFromLocal(2024, 1, 10, 8, 0);
+        ClosedSession closed;
+        for (int i = 0; i < events; ++i) {
+            if (nextEntry_ - nextExit_ < openSessions_ || i % 2 == 0) {
+                store.entry(nextEntry_++, 0, entryTime);
+            } else {
+                store.exit(nextExit_++, entryTime + 3600, closed);
+            }
+        }
+    }
+
+private:
+    std::uint64_t openSessions_;
+    std::uint64_t nextEntry_ = 1;
+    std::uint64_t nextExit_ = 1;
+};
+
+// 開き直して復元にかかった時間（ミリ秒）
+double measureRecovery(const std::string& directory, const SessionEventLogOptions& options,
+                       std::uint64_t expectedSessions, std::uint64_t& replayed, std::size_t& sessions) {
+    StayPricingEngine pricing(kDefaultDayTariffs);
+    Clock::time_point begin = Clock::now();
+    JournaledSessionStore store(64, expectedSessions);
+    store.addLot(0, pricing);
+    if (!store.open(directory, options)) {
+        return -1;
+    }
+    double ms = std::chrono::duration<double, std::milli>(Clock::now() - begin).count();
+    replayed = store.replayedEvents();
+    sessions = store.size();
+    return ms;
+}
+
+// 入出庫を繰り返しながら何度かスナップショットを取り、1回の入出庫にかかった最長の時間を
+// スナップショット中とそれ以外に分けて表示する
+void measureGateDuringSnapshots(const std::string& directory, const SessionEventLogOptions& options,
+                                std::uint64_t expectedSessions) {
+    StayPricingEngine pricing(kDefaultDayTariffs);
+    JournaledSessionStore store(64, expectedSessions);
+    store.addLot(0, pricing);
+    if (!store.open(directory, options)) {
+        return;
+    }
+
+    std::atomic<bool> stop(false);
+    std::atomic<bool> snapshotting(false);
+    double worstDuring = 0;
+    double worstOutside = 0;
+    std::thread gate([&]() {
+        const std::int64_t entryTime = epochFromLocal(2024, 1, 11, 8, 0);
+        ClosedSession closed;
+        auto timed = [&](auto&& operation) {
+            bool during = snapshotting.load();
+            Clock::time_point begin = Clock::now();
+            operation();
+            double ms = std::chrono::duration<double, std::milli>(Clock::now() - begin).count();
+            double& worst = during || snapshotting.load() ? worstDuring : worstOutside;
+            worst = std::max(worst, ms);
+        };
+        for (std::uint64_t ticket = std::uint64_t(1) << 40; !stop.load(); ++ticket) {
+            timed([&] { store.entry(ticket, 0, entryTime); });
+            timed([&] { store.exit(ticket, entryTime + 3600, closed); });
+        }
+    });
+
+    double lockMs = 0;
+    double snapshotMs = 0;
+    for (int i = 0; i < 5; ++i) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(50));
+        snapshotting.store(true);
+        Clock::time_point begin = Clock::now();
+        store.snapshot();
+        snapshotMs = std::max(snapshotMs, std::chrono::duration<double, std::milli>(Clock::now() - begin).count());
+        snapshotting.store(false);
+        lockMs = std::max(lockMs, store.lastSnapshotLockMs());
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    stop.store(true);
+    gate.join();
+
+    std::printf("%-34s %10.2f ms  (longest of 5, %zu open, snapshot() %.1f ms)\n", "snapshot() lock held",
+                lockMs, store.size(), snapshotMs);
+    std::printf("%-34s %10.2f ms  (%.2f ms outside snapshots)\n", "worst gate latency in snapshot()",
+                worstDuring, worstOutside);
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    const std::string directory = argc > 1 ? argv[1] : "/tmp/bench_session_snapshot";
+    const int historyEvents = argc > 2 ? std::atoi(argv[2]) : 4000000;
+    const int tailEvents = argc > 3 ? std::atoi(argv[3]) : 100000;
+    const std::uint64_t openSessions = 200000;
+    removeLogDirectory(directory);
+
+    SessionEventLogOptions options;
+    options.sync = EventLogSync::None;
+    options.segmentBytes = std::uint64_t(8) << 20;
+    StayPricingEngine pricing(kDefaultDayTariffs);
+
+    Gate gate(openSessions);
+    double snapshotMs = 0;
+    double historyMiB = 0;
+    {
+        JournaledSessionStore store(64, openSessions * 2);
+        store.addLot(0, pricing);
+        if (!store.open(directory, options)) {
+            return 1;
+        }
+        gate.run(store, historyEvents);
+        store.log().flush();
+        historyMiB = directoryMiB(directory);
+    }
+
+    std::uint64_t replayed = 0;
+    std::size_t sessions = 0;
+    double fullMs = measureRecovery(directory, options, openSessions * 2, replayed, sessions);
+    std::printf("%-34s %10.1f ms  (%llu events, %.1f MiB on disk, %zu open)\n", "replay full log", fullMs,
+                static_cast<unsigned long long>(replayed), historyMiB, sessions);
+
+    {
+        JournaledSessionStore store(64, openSessions * 2);
+        store.addLot(0, pricing);
+        store.open(directory, options);
+        Clock::time_point begin = Clock::now();
+        store.snapshot();
+        snapshotMs = std::chrono::duration<double, std::milli>(Clock::now() - begin).count();
+        gate.run(store, tailEvents);
+    }
+
+    double snapshotRecoveryMs = measureRecovery(directory, options, openSessions * 2, replayed, sessions);
+    std::printf("%-34s %10.1f ms  (%llu tail events, %.1f MiB on disk, %zu open)\n", "snapshot + log tail",
+                snapshotRecoveryMs, static_cast<unsigned long long>(replayed), directoryMiB(directory), sessions);
+    std::printf("%-34s %10.1f ms\n", "snapshot() (copy + write + fsync)", snapshotMs);
+    std::printf("speedup: %.1fx\n", fullMs / snapshotRecoveryMs);
+    measureGateDuringSnapshots(directory, options, openSessions * 2);
+
+    removeLogDirectory(directory);
+    return 0;
+}
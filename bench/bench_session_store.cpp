@@ -0,0 +1,105 @@
+// 複数のゲートから同時に入庫・出庫イベントを受け付ける場合のスループットとレイテンシを計測する
+// 1つのロックで全セッションを守る方式（シャード1つ）と、シャードごとのロックに分ける方式を
+// 1〜64スレッドで比較する
+#include "../src/sharded_session_store.hpp"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <thread>
+#include <vector>
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+// 各ゲートが入庫中のまま保つ台数（この台数だけ前に入庫した車が出庫する）
+const std::uint64_t kOpenPerGate = 10000;
+
+// レイテンシは8イベントに1回だけ計測する（時刻取得そのものの負荷を抑える）
+const int kSampleEvery = 8;
+
+struct Result {
+    double eventsPerSecond;
+    double p99Ns;
+};
+
+Result measure(std::size_t shardCount, int threads, int eventsPerThread) {
+    const std::int64_t entryTime = epochFromLocal(2024, 1, 10, 10, 0);
+    ShardedSessionStore store(shardCount, static_cast<std::size_t>(threads) * kOpenPerGate);
+    StayPricingEngine pricing(kDefaultDayTariffs);
+    store.addLot(0, pricing);
+
+    std::atomic<int> ready(0);
+    std::atomic<bool> start(false);
+    std::vector<std::vector<std::int64_t>> samples(static_cast<std::size_t>(threads));
+    std::vector<std::thread> gates;
+    for (int t = 0; t < threads; ++t) {
+        gates.emplace_back([&, t]() {
+            std::vector<std::int64_t>& latencies = samples[static_cast<std::size_t>(t)];
+            latencies.reserve(static_cast<std::size_t>(eventsPerThread / kSampleEvery + 1));
+            // ゲートごとに駐車券番号の範囲を分ける（番号のハッシュで全シャードに散る）
+            std::uint64_t base = (static_cast<std::uint64_t>(t) << 40) + 1;
+            std::uint64_t nextEntry = 0;
+            std::uint64_t nextExit = 0;
+            ClosedSession closed;
+
+            ready.fetch_add(1);
+            while (!start.load(std::memory_order_acquire)) {
+                std::this_thread::yield();
+            }
+            for (int i = 0; i < eventsPerThread; ++i) {
+                bool sampled = i % kSampleEvery == 0;
+                Clock::time_point begin = sampled ? Clock::now() : Clock::time_point();
+                // 入庫中の台数が kOpenPerGate に達したら入庫と出庫を交互に行う
+                if (nextEntry - nextExit < kOpenPerGate || i % 2 == 0) {
+                    store.entry(base + nextEntry++, 0, entryTime);
+                } else {
+                    store.exit(base + nextExit++, entryTime + 3600, closed);
+                }
+                if (sampled) {
+                    latencies.push_back(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                        Clock::now() - begin).count());
+                }
+            }
+        });
+    }
+    while (ready.load() < threads) {
+        std::this_thread::yield();
+    }
+    Clock::time_point begin = Clock::now();
+    start.store(true, std::memory_order_release);
+    for (std::thread& gate : gates) {
+        gate.join();
+    }
+    double seconds = std::chrono::duration<double>(Clock::now() - begin).count();
+
+    std::vector<std::int64_t> all;
+    for (const auto& latencies : samples) {
+        all.insert(all.end(), latencies.begin(), latencies.end());
+    }
+    std::size_t p99 = all.size() * 99 / 100;
+    std::nth_element(all.begin(), all.begin() + static_cast<std::ptrdiff_t>(p99), all.end());
+    return Result{static_cast<double>(threads) * eventsPerThread / seconds, static_cast<double>(all[p99])};
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    const int eventsPerThread = argc > 1 ? std::atoi(argv[1]) : 200000;
+    const std::size_t shardCount = argc > 2 ? static_cast<std::size_t>(std::atoi(argv[2])) : 256;
+    const int maxThreads = argc > 3 ? std::atoi(argv[3]) : 64;
+
+    std::printf("%d events per thread, %u hardware threads\n", eventsPerThread,
+                std::thread::hardware_concurrency());
+    std::printf("%8s %18s %12s %18s %12s\n", "threads", "1 lock events/s", "p99 ns", "sharded events/s",
+                "p99 ns");
+    for (int threads = 1; threads <= maxThreads; threads *= 2) {
+        Result single = measure(1, threads, eventsPerThread);
+        Result sharded = measure(shardCount, threads, eventsPerThread);
+        std::printf("%8d %18.0f %12.0f %18.0f %12.0f\n", threads, single.eventsPerSecond, single.p99Ns,
+                    sharded.eventsPerSecond, sharded.p99Ns);
+    }
+    return 0;
+}
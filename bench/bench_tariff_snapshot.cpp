@@ -0,0 +1,94 @@
+// 起動してから最初の料金計算ができるまでの時間を計測する
+// SQLiteから全件を読み込んで料金表を構築する方式と、スナップショットを mmap する方式を比較する
+#include "../src/tariff_snapshot.hpp"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+double elapsedMs(Clock::time_point begin) {
+    return std::chrono::duration<double, std::milli>(Clock::now() - begin).count();
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    const char* dbPath = argc > 1 ? argv[1] : "/tmp/bench_tariff_snapshot.db";
+    const char* snapshotPath = argc > 2 ? argv[2] : "/tmp/bench_tariff_snapshot.bin";
+    const int typeCount = argc > 3 ? std::atoi(argv[3]) : 200;
+    const int rounds = 20;
+    std::remove(dbPath);
+
+    RateConfigList configs;
+    for (int t = 0; t < typeCount; ++t) {
+        configs.emplace_back("type" + std::to_string(t),
+                             ParkingRateConfig{60, 300 + t, 720, 1500, 60, 200 + t, 720, 1000});
+    }
+    {
+        auto repo = createSQLiteRepository(dbPath);
+        if (!repo->saveBatch(configs) || !writeTariffSnapshot(snapshotPath, *repo)) {
+            std::fprintf(stderr, "failed to prepare %s / %s\n", dbPath, snapshotPath);
+            return 1;
+        }
+    }
+    const std::string quotedType = "type" + std::to_string(typeCount / 2);
+
+    // SQLiteを開き、全件を読み込んで全種別の料金表を構築してから最初の料金計算
+    double sqliteMs = 0;
+    int sqliteFee = 0;
+    for (int round = 0; round < rounds; ++round) {
+        Clock::time_point begin = Clock::now();
+        auto repo = createSQLiteRepository(dbPath);
+        RateConfigList loaded;
+        repo->loadAll(loaded);
+        std::vector<std::pair<std::string, CompiledTariff>> tariffs;
+        tariffs.reserve(loaded.size());
+        for (const auto& entry : loaded) {
+            tariffs.emplace_back(entry.first, CompiledTariff(entry.second));
+        }
+        for (const auto& entry : tariffs) {
+            if (entry.first == quotedType) {
+                sqliteFee = entry.second.calculateFee(150, 10, 0);
+            }
+        }
+        sqliteMs += elapsedMs(begin);
+    }
+
+    // mmap して最初の料金計算（CRC検査あり／なし）
+    double verifiedMs = 0;
+    double mappedMs = 0;
+    int mappedFee = 0;
+    std::size_t mappedBytes = 0;
+    for (int round = 0; round < rounds; ++round) {
+        Clock::time_point begin = Clock::now();
+        MappedTariffSnapshot snapshot;
+        snapshot.open(snapshotPath);
+        snapshot.calculateFee(quotedType, 150, 10, 0, mappedFee);
+        verifiedMs += elapsedMs(begin);
+
+        begin = Clock::now();
+        MappedTariffSnapshot unverified;
+        unverified.open(snapshotPath, false);
+        unverified.calculateFee(quotedType, 150, 10, 0, mappedFee);
+        mappedMs += elapsedMs(begin);
+        mappedBytes = unverified.mappedBytes();
+    }
+
+    std::printf("%d types, snapshot %.1f MiB\n", typeCount, mappedBytes / (1024.0 * 1024.0));
+    std::printf("%-36s %10.3f ms\n", "SQLite loadAll + CompiledTariff", sqliteMs / rounds);
+    std::printf("%-36s %10.3f ms\n", "mmap snapshot (verify checksum)", verifiedMs / rounds);
+    std::printf("%-36s %10.3f ms\n", "mmap snapshot (header only)", mappedMs / rounds);
+    if (sqliteFee != mappedFee) {
+        std::fprintf(stderr, "fee mismatch: %d != %d\n", sqliteFee, mappedFee);
+        return 1;
+    }
+
+    std::remove(dbPath);
+    std::remove(snapshotPath);
+    return 0;
+}
@@ -0,0 +1,199 @@
+#include "async_rate_repository.hpp"
+#include <algorithm>
+#include <utility>
+
+AsyncRateRepository::AsyncRateRepository(std::unique_ptr<ParkingRateRepository> inner,
+                                         const AsyncRepositoryOptions& options)
+    : inner_(std::move(inner)), options_(options), enqueuedSequence_(0), completedSequence_(0),
+      commitCount_(0), stopping_(false) {
+    options_.queueCapacity = std::max<std::size_t>(options_.queueCapacity, 1);
+    options_.maxBatch = std::max<std::size_t>(options_.maxBatch, 1);
+    writer_ = std::thread([this]() { run(); });
+}
+
+AsyncRateRepository::~AsyncRateRepository() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stopping_ = true;
+    }
+    notEmpty_.notify_all();
+    notFull_.notify_all();
+    writer_.join();
+}
+
+std::future<bool> AsyncRateRepository::saveAsync(const std::string& type, const ParkingRateConfig& config) {
+    return enqueue(RateConfigList{{type, config}});
+}
+
+std::future<bool> AsyncRateRepository::enqueue(RateConfigList configs) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    // キューが一杯なら空くまで待つ（書き込みスレッドより速く書き込み続けた場合の背圧）
+    notFull_.wait(lock, [this]() { return queue_.size() < options_.queueCapacity || stopping_; });
+    if (stopping_) {
+        std::promise<bool> rejected;
+        rejected.set_value(false);
+        return rejected.get_future();
+    }
+
+    std::uint64_t sequence = ++enqueuedSequence_;
+    for (const auto& entry : configs) {
+        pending_[entry.first] = Pending{entry.second, sequence};
+    }
+    queue_.push_back(Request{std::move(configs), sequence, std::promise<bool>()});
+    std::future<bool> result = queue_.back().result.get_future();
+    lock.unlock();
+
+    notEmpty_.notify_one();
+    return result;
+}
+
+void AsyncRateRepository::flush() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    std::uint64_t target = enqueuedSequence_;
+    completed_.wait(lock, [this, target]() { return completedSequence_ >= target; });
+}
+
+std::uint64_t AsyncRateRepository::commitCount() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return commitCount_;
+}
+
+void AsyncRateRepository::run() {
+    std::vector<Request> batch;
+    RateConfigList configs;
+    std::unordered_map<std::string, std::size_t> positions;
+
+    for (;;) {
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            notEmpty_.wait(lock, [this]() { return !queue_.empty() || stopping_; });
+            if (queue_.empty()) {
+                // 停止要求があり、キューも空になった
+                return;
+            }
+            // 要求の途中では分けない（最初の要求は maxBatch を超えても1回でコミットする）
+            std::size_t entries = 0;
+            while (!queue_.empty() &&
+                   (batch.empty() || entries + queue_.front().configs.size() <= options_.maxBatch)) {
+                entries += queue_.front().configs.size();
+                batch.push_back(std::move(queue_.front()));
+                queue_.pop_front();
+            }
+        }
+        notFull_.notify_all();
+
+        // 同じ種別の書き込みは最後の値だけにまとめる（最初に現れた位置を保つ）
+        configs.clear();
+        positions.clear();
+        for (const Request& request : batch) {
+            for (const auto& entry : request.configs) {
+                auto inserted = positions.emplace(entry.first, configs.size());
+                if (inserted.second) {
+                    configs.push_back(entry);
+                } else {
+                    configs[inserted.first->second].second = entry.second;
+                }
+            }
+        }
+
+        bool committed;
+        if (options_.concurrentInner) {
+            committed = inner_->saveBatch(configs);
+        } else {
+            std::lock_guard<std::mutex> lock(innerMutex_);
+            committed = inner_->saveBatch(configs);
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            // 後から同じ種別に書き込まれていなければ、コミット前の値の記録を消す
+            // 失敗した場合も消す（inner の内容を正とする）
+            for (const Request& request : batch) {
+                for (const auto& entry : request.configs) {
+                    auto it = pending_.find(entry.first);
+                    if (it != pending_.end() && it->second.sequence == request.sequence) {
+                        pending_.erase(it);
+                    }
+                }
+            }
+        }
+        // 結果を受け取った呼び出し側が読み込んだ時点で、inner の内容が見えるようにしてから通知する
+        for (Request& request : batch) {
+            request.result.set_value(committed);
+        }
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            completedSequence_ = batch.back().sequence;
+            ++commitCount_;
+        }
+        completed_.notify_all();
+        batch.clear();
+    }
+}
+
+template <typename Operation>
+bool AsyncRateRepository::callInner(Operation&& operation) {
+    if (options_.concurrentInner) {
+        return operation();
+    }
+    std::lock_guard<std::mutex> lock(innerMutex_);
+    return operation();
+}
+
+bool AsyncRateRepository::save(const std::string& type, const ParkingRateConfig& config) {
+    return saveAsync(type, config).get();
+}
+
+bool AsyncRateRepository::saveBatch(const RateConfigList& configs) {
+    // 全件を1つの要求としてキューに入れ、1回のトランザクションでコミットされるのを待つ
+    if (configs.empty()) {
+        return true;
+    }
+    return enqueue(configs).get();
+}
+
+bool AsyncRateRepository::load(const std::string& type, ParkingRateConfig& config) {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto it = pending_.find(type);
+        if (it != pending_.end()) {
+            config = it->second.config;
+            return true;
+        }
+    }
+    return callInner([&]() { return inner_->load(type, config); });
+}
+
+bool AsyncRateRepository::exists(const std::string& type) {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (pending_.find(type) != pending_.end()) {
+            return true;
+        }
+    }
+    return callInner([&]() { return inner_->exists(type); });
+}
+
+bool AsyncRateRepository::loadAll(RateConfigList& configs) {
+    flush();
+    return callInner([&]() { return inner_->loadAll(configs); });
+}
+
+bool AsyncRateRepository::saveVersion(const RateVersion& version) {
+    flush();
+    return callInner([&]() { return inner_->saveVersion(version); });
+}
+
+bool AsyncRateRepository::loadAsOf(const std::string& type, std::int64_t timestamp, ParkingRateConfig& config) {
+    flush();
+    return callInner([&]() { return inner_->loadAsOf(type, timestamp, config); });
+}
+
+bool AsyncRateRepository::loadVersions(RateVersionList& versions) {
+    flush();
+    return callInner([&]() { return inner_->loadVersions(versions); });
+}
+
+bool AsyncRateRepository::dataVersion(std::uint64_t& version) {
+    return callInner([&]() { return inner_->dataVersion(version); });
+}
@@ -0,0 +1,111 @@
+#ifndef ASYNC_RATE_REPOSITORY_HPP
+#define ASYNC_RATE_REPOSITORY_HPP
+
+#include "parking_rate_repository.hpp"
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+// AsyncRateRepository の設定
+struct AsyncRepositoryOptions {
+    std::size_t queueCapacity = 1024;  // 未処理の書き込み要求の上限（超えると saveAsync は空くまで待つ）
+    std::size_t maxBatch = 256;        // 1回のトランザクションにまとめる書き込みの上限
+                                       // （saveBatch の1要求は上限を超えても分けない）
+    bool concurrentInner = false;      // inner が複数スレッドから同時に使える場合はtrue
+                                       // （falseなら inner の読み込みと書き込みを排他する）
+};
+
+// 書き込みをバックグラウンドで行うリポジトリ（ParkingRateRepository のデコレータ）
+//
+// - saveAsync は書き込みをキューに入れてすぐに戻り、コミットの結果を future で返す
+// - 書き込みスレッドはキューにたまった書き込みを取り出し、同じ種別は最後の値だけにまとめて
+//   inner の saveBatch（1トランザクション）でコミットする
+// - saveBatch は全件を1つの要求としてキューに入れ、必ず1回の inner の saveBatch でコミットする
+//   （一部だけがコミットされることはない）
+// - load / exists はコミット前の書き込みも返す（自分の書き込みがすぐに見える）
+// - 破棄時はキューに残った書き込みを全てコミットしてから書き込みスレッドを終了する
+// - スレッドセーフ
+class AsyncRateRepository : public ParkingRateRepository {
+public:
+    explicit AsyncRateRepository(std::unique_ptr<ParkingRateRepository> inner,
+                                 const AsyncRepositoryOptions& options = AsyncRepositoryOptions());
+    ~AsyncRateRepository() override;
+
+    AsyncRateRepository(const AsyncRateRepository&) = delete;
+    AsyncRateRepository& operator=(const AsyncRateRepository&) = delete;
+
+    // 書き込みをキューに入れる（コミットできればtrueになる future を返す）
+    std::future<bool> saveAsync(const std::string& type, const ParkingRateConfig& config);
+
+    // 呼び出し時点までにキューに入った書き込みが全て終わるまで待つ
+    void flush();
+
+    // 書き込み済みのトランザクション数（コミットの試行回数）
+    std::uint64_t commitCount() const;
+
+    // save / saveBatch はキューに入れたうえでコミットを待つ（saveBatch は全件か0件をコミットする）
+    bool save(const std::string& type, const ParkingRateConfig& config) override;
+    bool saveBatch(const RateConfigList& configs) override;
+
+    bool load(const std::string& type, ParkingRateConfig& config) override;
+    bool exists(const std::string& type) override;
+
+    // キューの書き込みを全てコミットしてから inner を読む
+    bool loadAll(RateConfigList& configs) override;
+
+    // 履歴の操作はキューの書き込みを全てコミットしてから inner で行う
+    bool saveVersion(const RateVersion& version) override;
+    bool loadAsOf(const std::string& type, std::int64_t timestamp, ParkingRateConfig& config) override;
+    bool loadVersions(RateVersionList& versions) override;
+
+    bool dataVersion(std::uint64_t& version) override;
+
+private:
+    // 1つの書き込み要求（saveAsync なら1件、saveBatch なら全件）
+    struct Request {
+        RateConfigList configs;
+        std::uint64_t sequence;
+        std::promise<bool> result;
+    };
+
+    std::future<bool> enqueue(RateConfigList configs);
+
+    // コミット前の最新の値（sequence はその値を書き込んだ要求の番号）
+    struct Pending {
+        ParkingRateConfig config;
+        std::uint64_t sequence;
+    };
+
+    void run();
+
+    // 呼び出し側のスレッドで inner を使う（必要なら書き込みスレッドと排他する）
+    template <typename Operation>
+    bool callInner(Operation&& operation);
+
+    std::unique_ptr<ParkingRateRepository> inner_;
+    AsyncRepositoryOptions options_;
+
+    mutable std::mutex mutex_;
+    std::condition_variable notEmpty_;
+    std::condition_variable notFull_;
+    std::condition_variable completed_;
+    std::deque<Request> queue_;
+    std::unordered_map<std::string, Pending> pending_;
+    std::uint64_t enqueuedSequence_;
+    std::uint64_t completedSequence_;
+    std::uint64_t commitCount_;
+    bool stopping_;
+
+    std::mutex innerMutex_;
+    std::thread writer_;
+};
+
+#endif // ASYNC_RATE_REPOSITORY_HPP
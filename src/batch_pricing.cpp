@@ -0,0 +1,396 @@
+#include "batch_pricing.hpp"
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstring>
+#include <iostream>
+#include <mutex>
+#include <thread>
+
+namespace {
+
+// 日種別を固定するカレンダー（weekday / holiday の行に使う）
+class FixedDayCalendar : public DayCalendar {
+public:
+    explicit FixedDayCalendar(DayKind kind) : kind_(kind) {}
+
+    DayKind classify(std::int64_t) const override { return kind_; }
+
+private:
+    DayKind kind_;
+};
+
+const FixedDayCalendar kWeekdayCalendar(DayKind::Weekday);
+const FixedDayCalendar kHolidayCalendar(DayKind::Holiday);
+
+// 書き出しを待っているチャンクの数の上限（スレッドあたり）。出力のメモリを抑える
+constexpr std::size_t kPendingChunksPerThread = 2;
+
+// 料金1件の出力の最大長（"-9223372036854775808\n"）
+constexpr std::size_t kMaxFeeText = 21;
+
+struct Field {
+    const char* begin;
+    const char* end;
+
+    std::size_t size() const { return static_cast<std::size_t>(end - begin); }
+
+    bool operator==(const char* text) const {
+        std::size_t length = std::strlen(text);
+        return size() == length && std::memcmp(begin, text, length) == 0;
+    }
+};
+
+// 前後の空白を除く
+Field trim(const char* begin, const char* end) {
+    while (begin < end && *begin == ' ') {
+        ++begin;
+    }
+    while (end > begin && end[-1] == ' ') {
+        --end;
+    }
+    return Field{begin, end};
+}
+
+bool isDigit(char c) {
+    return c >= '0' && c <= '9';
+}
+
+// 固定桁の数字（count 桁）を読む
+bool parseDigits(const char*& p, const char* end, int count, int& value) {
+    if (end - p < count) {
+        return false;
+    }
+    value = 0;
+    for (int i = 0; i < count; ++i, ++p) {
+        if (!isDigit(*p)) {
+            return false;
+        }
+        value = value * 10 + (*p - '0');
+    }
+    return true;
+}
+
+bool parseInteger(Field field, std::int64_t& value) {
+    const char* p = field.begin;
+    bool negative = p < field.end && *p == '-';
+    if (negative) {
+        ++p;
+    }
+    if (p == field.end || field.end - p > 18) {
+        return false;  // 18桁までならあふれない
+    }
+    std::int64_t result = 0;
+    for (; p < field.end; ++p) {
+        if (!isDigit(*p)) {
+            return false;
+        }
+        result = result * 10 + (*p - '0');
+    }
+    value = negative ? -result : result;
+    return true;
+}
+
+// エポック秒か、現地時刻の "YYYY-MM-DD HH:MM[:SS]"
+bool parseTime(Field field, int utcOffsetSeconds, std::int64_t& time) {
+    if (field.size() < 16 || field.begin[4] != '-') {
+        return parseInteger(field, time);
+    }
+    const char* p = field.begin;
+    int year, month, day, hour, minute, second = 0;
+    if (!parseDigits(p, field.end, 4, year) || *p++ != '-' || !parseDigits(p, field.end, 2, month) ||
+        *p++ != '-' || !parseDigits(p, field.end, 2, day) || (*p != ' ' && *p != 'T') ||
+        !parseDigits(++p, field.end, 2, hour) || p == field.end || *p++ != ':' ||
+        !parseDigits(p, field.end, 2, minute)) {
+        return false;
+    }
+    if (p != field.end && (*p++ != ':' || !parseDigits(p, field.end, 2, second))) {
+        return false;
+    }
+    if (p != field.end || month < 1 || month > 12 || day < 1 || hour > 23 || minute > 59 || second > 59) {
+        return false;
+    }
+    std::int64_t days = daysFromCivil(year, month, day);
+    if (civilFromDays(days).day != day) {
+        return false;  // 2月30日など
+    }
+    time = epochFromLocal(year, month, day, hour, minute, utcOffsetSeconds) + second;
+    return true;
+}
+
+// 料金を10進で書く（改行付き）
+std::size_t writeFee(std::int64_t fee, char* out) {
+    char digits[20];
+    std::size_t count = 0;
+    std::uint64_t magnitude = fee < 0 ? 0 - static_cast<std::uint64_t>(fee) : static_cast<std::uint64_t>(fee);
+    do {
+        digits[count++] = static_cast<char>('0' + magnitude % 10);
+        magnitude /= 10;
+    } while (magnitude != 0);
+    std::size_t size = 0;
+    if (fee < 0) {
+        out[size++] = '-';
+    }
+    while (count > 0) {
+        out[size++] = digits[--count];
+    }
+    out[size++] = '\n';
+    return size;
+}
+
+// 最初の行の区切り（タブがあればタブ）
+char detectDelimiter(const char* data, std::size_t size) {
+    const char* lineEnd = static_cast<const char*>(std::memchr(data, '\n', size));
+    std::size_t length = lineEnd ? static_cast<std::size_t>(lineEnd - data) : size;
+    return std::memchr(data, '\t', length) ? '\t' : ',';
+}
+
+// 最初の行が見出しなら、その次の行の位置を返す
+std::size_t skipHeader(const char* data, std::size_t size) {
+    std::size_t start = 0;
+    while (start < size && data[start] == ' ') {
+        ++start;
+    }
+    if (start == size || isDigit(data[start]) || data[start] == '-') {
+        return 0;
+    }
+    const char* lineEnd = static_cast<const char*>(std::memchr(data, '\n', size));
+    return lineEnd ? static_cast<std::size_t>(lineEnd - data) + 1 : size;
+}
+
+} // namespace
+
+std::vector<std::pair<std::size_t, std::size_t>> splitLines(const char* data, std::size_t size,
+                                                            std::size_t chunkBytes) {
+    std::vector<std::pair<std::size_t, std::size_t>> chunks;
+    if (chunkBytes == 0) {
+        chunkBytes = 1;
+    }
+    std::size_t begin = 0;
+    while (begin < size) {
+        std::size_t end = size;
+        if (size - begin > chunkBytes) {
+            // 目安の位置から次の改行まで伸ばす
+            const char* newline =
+                static_cast<const char*>(std::memchr(data + begin + chunkBytes - 1, '\n', size - begin - chunkBytes + 1));
+            end = newline ? static_cast<std::size_t>(newline - data) + 1 : size;
+        }
+        chunks.emplace_back(begin, end);
+        begin = end;
+    }
+    return chunks;
+}
+
+bool BatchPricer::addLot(std::uint32_t lotId, const StayPricingEngine& pricing) {
+    if (lotId >= kMaxLots) {
+        return false;
+    }
+    if (lotId >= lots_.size()) {
+        lots_.resize(static_cast<std::size_t>(lotId) + 1);
+    }
+    lots_[lotId].emplace(Lot{{pricing,
+                              StayPricingEngine(pricing.tariffs(), kWeekdayCalendar, pricing.utcOffsetSeconds()),
+                              StayPricingEngine(pricing.tariffs(), kHolidayCalendar, pricing.utcOffsetSeconds())}});
+    return true;
+}
+
+bool BatchPricer::priceLine(const char* begin, const char* end, char delimiter, std::int64_t& fee) const {
+    if (end > begin && end[-1] == '\r') {
+        --end;
+    }
+    Field fields[4];
+    const char* start = begin;
+    for (std::size_t i = 0; i < 3; ++i) {
+        const char* p = static_cast<const char*>(std::memchr(start, delimiter, static_cast<std::size_t>(end - start)));
+        if (!p) {
+            return false;  // 項目が足りない
+        }
+        fields[i] = trim(start, p);
+        start = p + 1;
+    }
+    if (std::memchr(start, delimiter, static_cast<std::size_t>(end - start))) {
+        return false;  // 項目が多い
+    }
+    fields[3] = trim(start, end);
+
+    std::int64_t lotId;
+    if (!parseInteger(fields[2], lotId) || lotId < 0 || static_cast<std::uint64_t>(lotId) >= lots_.size() ||
+        !lots_[static_cast<std::size_t>(lotId)]) {
+        return false;
+    }
+    const Lot& lot = *lots_[static_cast<std::size_t>(lotId)];
+    const StayPricingEngine* engine;
+    if (fields[3] == "auto" || fields[3].size() == 0) {
+        engine = &lot.engines[0];
+    } else if (fields[3] == "weekday") {
+        engine = &lot.engines[1];
+    } else if (fields[3] == "holiday") {
+        engine = &lot.engines[2];
+    } else {
+        return false;
+    }
+
+    std::int64_t entryTime;
+    std::int64_t exitTime;
+    return parseTime(fields[0], engine->utcOffsetSeconds(), entryTime) &&
+           parseTime(fields[1], engine->utcOffsetSeconds(), exitTime) &&
+           engine->quoteTotal(entryTime, exitTime, fee);
+}
+
+void BatchPricer::priceChunk(const char* begin, const char* end, char delimiter, std::string& out,
+                             std::uint64_t& rows, std::uint64_t& errors) const {
+    // 1行あたりの出力は最大 kMaxFeeText バイトなので、足りなくなったときだけ広げる
+    std::size_t used = 0;
+    out.resize(std::max(out.size(), static_cast<std::size_t>(end - begin) / 4 + kMaxFeeText));
+    rows = 0;
+    errors = 0;
+    while (begin < end) {
+        const char* newline = static_cast<const char*>(std::memchr(begin, '\n', static_cast<std::size_t>(end - begin)));
+        const char* lineEnd = newline ? newline : end;
+        if (out.size() - used < kMaxFeeText) {
+            out.resize(out.size() * 2);
+        }
+        std::int64_t fee;
+        if (priceLine(begin, lineEnd, delimiter, fee)) {
+            used += writeFee(fee, &out[used]);
+        } else {
+            std::memcpy(&out[used], "error\n", 6);
+            used += 6;
+            ++errors;
+        }
+        ++rows;
+        begin = newline ? newline + 1 : end;
+    }
+    out.resize(used);
+}
+
+bool BatchPricer::run(const char* data, std::size_t size, const BatchPricingOptions& options,
+                      const BatchOutputSink& sink, BatchPricingStats& stats) const {
+    auto started = std::chrono::steady_clock::now();
+    stats = BatchPricingStats();
+    stats.bytes = size;
+    if (size == 0) {
+        return true;
+    }
+    char delimiter = detectDelimiter(data, size);
+    std::size_t first = skipHeader(data, size);
+    std::vector<std::pair<std::size_t, std::size_t>> chunks =
+        splitLines(data + first, size - first, options.chunkBytes);
+    std::size_t threadCount = options.threadCount > 0 ? options.threadCount : std::thread::hardware_concurrency();
+    threadCount = std::max<std::size_t>(1, std::min(threadCount, chunks.size()));
+    stats.chunks = chunks.size();
+    stats.threads = threadCount;
+
+    // チャンク i の出力は slots[i % window] に置き、書き出したら次のチャンクに使い回す
+    struct Slot {
+        std::string output;
+        std::uint64_t rows = 0;
+        std::uint64_t errors = 0;
+        bool ready = false;
+    };
+    const std::size_t window = threadCount * kPendingChunksPerThread;
+    std::vector<Slot> slots(window);
+    std::mutex mutex;
+    std::condition_variable readyChanged;   // チャンクを処理し終えた
+    std::condition_variable writtenChanged; // チャンクを書き出した
+    std::size_t nextChunk = 0;
+    std::size_t written = 0;
+    bool aborted = false;
+
+    auto work = [&]() {
+        while (true) {
+            std::size_t index;
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                writtenChanged.wait(lock, [&] { return aborted || nextChunk < written + window; });
+                if (aborted || nextChunk == chunks.size()) {
+                    return;
+                }
+                index = nextChunk++;
+            }
+            Slot& slot = slots[index % window];
+            const char* base = data + first;
+            priceChunk(base + chunks[index].first, base + chunks[index].second, delimiter, slot.output, slot.rows,
+                       slot.errors);
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                slot.ready = true;
+            }
+            readyChanged.notify_all();
+        }
+    };
+    std::vector<std::thread> workers;
+    for (std::size_t i = 0; i < threadCount; ++i) {
+        workers.emplace_back(work);
+    }
+
+    // 呼び出したスレッドが入力の順に書き出す
+    bool succeeded = true;
+    for (std::size_t index = 0; index < chunks.size(); ++index) {
+        Slot& slot = slots[index % window];
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            readyChanged.wait(lock, [&] { return slot.ready; });
+        }
+        stats.rows += slot.rows;
+        stats.errors += slot.errors;
+        if (!sink(slot.output.data(), slot.output.size())) {
+            succeeded = false;
+        }
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            slot.ready = false;
+            ++written;
+            aborted = !succeeded;
+        }
+        writtenChanged.notify_all();
+        if (!succeeded) {
+            break;
+        }
+    }
+    for (std::thread& worker : workers) {
+        worker.join();
+    }
+    stats.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - started).count();
+    return succeeded;
+}
+
+bool BatchPricer::runFile(const std::string& path, const BatchPricingOptions& options, const BatchOutputSink& sink,
+                          BatchPricingStats& stats) const {
+    auto started = std::chrono::steady_clock::now();
+    int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        std::cerr << "Can't open input: " << path << std::endl;
+        return false;
+    }
+    struct stat status;
+    if (::fstat(fd, &status) != 0) {
+        std::cerr << "Can't read input: " << path << std::endl;
+        ::close(fd);
+        return false;
+    }
+    std::size_t size = static_cast<std::size_t>(status.st_size);
+    void* base = nullptr;
+    if (size > 0) {
+        base = ::mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (base == MAP_FAILED) {
+            std::cerr << "Can't map input: " << path << std::endl;
+            ::close(fd);
+            return false;
+        }
+        ::madvise(base, size, MADV_SEQUENTIAL);
+    }
+    ::close(fd);
+
+    bool succeeded = run(static_cast<const char*>(base), size, options, sink, stats);
+    if (base) {
+        ::munmap(base, size);
+    }
+    stats.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - started).count();
+    return succeeded;
+}
@@ -0,0 +1,86 @@
+#ifndef BATCH_PRICING_HPP
+#define BATCH_PRICING_HPP
+
+#include "stay_pricing.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <optional>
+#include <string>
+#include <vector>
+
+// 月末の照合用に、ゲートのログから書き出した大量の駐車記録をまとめて料金計算する
+//
+// 入力は1行1件の CSV / TSV（区切りは最初の行にタブがあればタブ、なければカンマ）
+//
+//   入庫時刻,出庫時刻,駐車場番号,日種別
+//   2024-01-05 12:00,2024-01-06 15:00,1,auto
+//   1704423600,1704524400,2,holiday
+//
+// - 時刻はエポック秒か、現地時刻の "YYYY-MM-DD HH:MM[:SS]"（日付と時刻の間は空白か T）
+// - 日種別は weekday / holiday（その日種別の料金で計算する）か auto（カレンダーで判定する）
+// - 行末の CR は無視する。最初の行の先頭が数字でなければ見出しとして読み飛ばす
+//
+// 出力は1行1件の料金（入力と同じ順。解析できない行・計算できない行は "error"）
+//
+// 入力をチャンク（行の境界で区切る）に分け、複数のスレッドが並列に解析・料金計算する。
+// 各チャンクの出力は入力の順に書き出す（先に終わったチャンクは、前のチャンクが書き出されるまで待つ）
+constexpr std::size_t kBatchPricingDefaultChunkBytes = 4 * 1024 * 1024;
+
+struct BatchPricingOptions {
+    std::size_t threadCount = 0;  // 0ならCPUの数
+    std::size_t chunkBytes = kBatchPricingDefaultChunkBytes;
+};
+
+struct BatchPricingStats {
+    std::uint64_t rows = 0;    // 見出しを除いた行数
+    std::uint64_t errors = 0;  // "error" を出力した行数
+    std::uint64_t bytes = 0;   // 入力のバイト数
+    std::size_t chunks = 0;
+    std::size_t threads = 0;
+    double seconds = 0;
+};
+
+// 書き出し先（入力の順に呼ばれる。falseを返すと中断する）
+using BatchOutputSink = std::function<bool(const char* data, std::size_t size)>;
+
+// data を chunkBytes 程度ごとに行の境界で区切る（各チャンクは改行で終わるか、入力の末尾まで）
+// 戻り値は各チャンクの [開始, 終了) の位置
+std::vector<std::pair<std::size_t, std::size_t>> splitLines(const char* data, std::size_t size,
+                                                            std::size_t chunkBytes);
+
+// 駐車場ごとの料金体系で記録を料金計算する
+// addLot は計算を始める前に済ませること。それ以降の呼び出しはスレッドセーフ
+class BatchPricer {
+public:
+    static constexpr std::uint32_t kMaxLots = 1u << 16;
+
+    // 駐車場の料金体系を登録（番号が kMaxLots 以上ならfalse）
+    // auto は pricing のカレンダーで、weekday / holiday はその日種別に固定して計算する
+    bool addLot(std::uint32_t lotId, const StayPricingEngine& pricing);
+
+    // 1行（改行を含まない）を解析して料金計算する（解析できない・計算できない場合はfalse）
+    bool priceLine(const char* begin, const char* end, char delimiter, std::int64_t& fee) const;
+
+    // data を並列に料金計算し、結果を入力の順に sink に渡す（sink が中断した場合はfalse）
+    bool run(const char* data, std::size_t size, const BatchPricingOptions& options, const BatchOutputSink& sink,
+             BatchPricingStats& stats) const;
+
+    // ファイルを mmap して run する（開けない場合はfalse）
+    bool runFile(const std::string& path, const BatchPricingOptions& options, const BatchOutputSink& sink,
+                 BatchPricingStats& stats) const;
+
+private:
+    // 日種別ごとの料金体系（auto / weekday / holiday の順）
+    struct Lot {
+        StayPricingEngine engines[3];
+    };
+
+    // チャンク1つ分を解析して料金を out に書く
+    void priceChunk(const char* begin, const char* end, char delimiter, std::string& out, std::uint64_t& rows,
+                    std::uint64_t& errors) const;
+
+    std::vector<std::optional<Lot>> lots_;
+};
+
+#endif // BATCH_PRICING_HPP
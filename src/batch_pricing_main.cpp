@@ -0,0 +1,140 @@
+// 駐車記録の一括料金計算
+//
+//   batch_pricing [--threads N] [--chunk-bytes N] [--lots N] [--db PATH] [--output PATH] INPUT
+//
+// INPUT     入庫時刻,出庫時刻,駐車場番号,日種別 の CSV / TSV（形式は batch_pricing.hpp）
+// --threads 料金計算のスレッド数（既定はCPUの数）
+// --chunk-bytes 1つのスレッドがまとめて処理する大きさ（既定 4 MiB）
+// --lots    受け付ける駐車場の番号 1..N（既定 1、全て同じ料金体系）
+// --db      料金設定のDB（"weekday" / "holiday" の設定を使う。なければ既定の料金）
+// --output  料金の出力先（既定は標準出力）
+//
+// 料金は入力と同じ順に1行ずつ出力し、件数と処理の速さを標準エラー出力に表示する
+// "error" の行があれば終了コードは2
+#include "batch_pricing.hpp"
+#include "parking_lot.hpp"
+#include "parking_rate_repository.hpp"
+#include <fcntl.h>
+#include <unistd.h>
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+
+namespace {
+
+void usage() {
+    std::cerr << "usage: batch_pricing [--threads N] [--chunk-bytes N] [--lots N] [--db PATH] [--output PATH] INPUT"
+              << std::endl;
+}
+
+// DBの料金設定で平日・休日の料金体系を置き換える（ない種別は既定のまま）
+bool loadDayTariffs(const std::string& dbPath, DayTariffs& tariffs) {
+    auto repository = createSQLiteRepository(dbPath);
+    if (!repository) {
+        return false;
+    }
+    ParkingRateConfig config;
+    if (repository->load("weekday", config)) {
+        tariffs[DayKind::Weekday] = makeTariff(config);
+    }
+    if (repository->load("holiday", config)) {
+        tariffs[DayKind::Holiday] = makeTariff(config);
+    }
+    return true;
+}
+
+// 全て書き込むまで write を繰り返す
+bool writeAll(int fd, const char* data, std::size_t size) {
+    while (size > 0) {
+        ssize_t written = ::write(fd, data, size);
+        if (written < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return false;
+        }
+        data += written;
+        size -= static_cast<std::size_t>(written);
+    }
+    return true;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    BatchPricingOptions options;
+    long lots = 1;
+    std::string dbPath;
+    std::string outputPath;
+    std::string inputPath;
+    for (int i = 1; i < argc; ++i) {
+        const char* name = argv[i];
+        if (name[0] != '-' && inputPath.empty()) {
+            inputPath = name;
+            continue;
+        }
+        if (i + 1 >= argc) {
+            usage();
+            return 1;
+        }
+        const char* value = argv[++i];
+        if (std::strcmp(name, "--threads") == 0) {
+            options.threadCount = static_cast<std::size_t>(std::atol(value));
+        } else if (std::strcmp(name, "--chunk-bytes") == 0) {
+            options.chunkBytes = static_cast<std::size_t>(std::atol(value));
+        } else if (std::strcmp(name, "--lots") == 0) {
+            lots = std::atol(value);
+        } else if (std::strcmp(name, "--db") == 0) {
+            dbPath = value;
+        } else if (std::strcmp(name, "--output") == 0) {
+            outputPath = value;
+        } else {
+            usage();
+            return 1;
+        }
+    }
+    if (inputPath.empty() || options.chunkBytes == 0) {
+        usage();
+        return 1;
+    }
+    if (lots < 1 || lots >= static_cast<long>(BatchPricer::kMaxLots)) {
+        std::cerr << "Invalid lot count: " << lots << std::endl;
+        return 1;
+    }
+
+    DayTariffs tariffs = kDefaultDayTariffs;
+    if (!dbPath.empty() && !loadDayTariffs(dbPath, tariffs)) {
+        std::cerr << "Can't open rate DB: " << dbPath << std::endl;
+        return 1;
+    }
+    StayPricingEngine pricing(tariffs);
+    BatchPricer pricer;
+    for (long lot = 1; lot <= lots; ++lot) {
+        pricer.addLot(static_cast<std::uint32_t>(lot), pricing);
+    }
+
+    int output = STDOUT_FILENO;
+    if (!outputPath.empty()) {
+        output = ::open(outputPath.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+        if (output < 0) {
+            std::cerr << "Can't create output: " << outputPath << std::endl;
+            return 1;
+        }
+    }
+    BatchPricingStats stats;
+    bool succeeded = pricer.runFile(inputPath, options,
+                                    [output](const char* data, std::size_t size) { return writeAll(output, data, size); },
+                                    stats);
+    if (output != STDOUT_FILENO && ::close(output) != 0) {
+        succeeded = false;
+    }
+    if (!succeeded) {
+        std::cerr << "Batch pricing failed: " << inputPath << std::endl;
+        return 1;
+    }
+    std::cerr << stats.rows << " rows (" << stats.errors << " errors), " << stats.bytes << " bytes, " << stats.chunks
+              << " chunks, " << stats.threads << " threads, " << stats.seconds << " s, "
+              << (stats.seconds > 0 ? stats.bytes / stats.seconds / 1e9 : 0.0) << " GB/s" << std::endl;
+    return stats.errors > 0 ? 2 : 0;
+}
@@ -0,0 +1,238 @@
+#include "caching_rate_repository.hpp"
+#include <mutex>
+#include <unordered_map>
+
+class CachingParkingRateRepository : public ParkingRateRepository {
+private:
+    using Clock = std::chrono::steady_clock;
+    
+    // キャッシュの1件（found == false は存在しないことを記録したもの）
+    struct Entry {
+        bool found;
+        ParkingRateConfig config;
+    };
+    
+    std::unique_ptr<ParkingRateRepository> inner_;
+    Clock::duration revalidateInterval_;
+    
+    // ロックは innerMutex_ → mutex_ の順に取る
+    // innerMutex_: inner への呼び出しを直列化する。キャッシュへの反映もこれを持ったまま行い、inner と順序を揃える
+    // mutex_: キャッシュの状態を守る。inner の呼び出し中は持たないため、キャッシュに当たった読み込みは待たない
+    std::mutex innerMutex_;
+    std::mutex mutex_;
+    std::unordered_map<std::string, Entry> entries_;
+    Clock::time_point nextCheck_;
+    bool hasVersion_;
+    std::uint64_t version_;
+    
+    // 確認の期限を過ぎていなければキャッシュから探す（期限を過ぎていれば見つからない扱い）
+    bool findCached(const std::string& type, Entry& entry) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (Clock::now() >= nextCheck_) {
+            return false;
+        }
+        auto it = entries_.find(type);
+        if (it == entries_.end()) {
+            return false;
+        }
+        entry = it->second;
+        return true;
+    }
+    
+    // 確認の期限を過ぎていればバージョンを確認し、変わっていればキャッシュを破棄
+    // innerMutex_ を持った状態で呼ぶ
+    void revalidateIfDue() {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            Clock::time_point now = Clock::now();
+            if (now < nextCheck_) {
+                return;
+            }
+            nextCheck_ = now + revalidateInterval_;
+        }
+        
+        std::uint64_t version;
+        if (!inner_->dataVersion(version)) {
+            return;
+        }
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (!hasVersion_ || version != version_) {
+            entries_.clear();
+        }
+        version_ = version;
+        hasVersion_ = true;
+    }
+    
+    // 見つからなければ inner から読み込んでキャッシュする
+    Entry lookup(const std::string& type) {
+        Entry entry{};
+        if (findCached(type, entry)) {
+            return entry;
+        }
+        
+        std::lock_guard<std::mutex> innerLock(innerMutex_);
+        revalidateIfDue();
+        {
+            // 待っている間に他のスレッドが読み込んでいればそれを使う
+            std::lock_guard<std::mutex> lock(mutex_);
+            auto it = entries_.find(type);
+            if (it != entries_.end()) {
+                return it->second;
+            }
+        }
+        
+        entry.found = inner_->load(type, entry.config);
+        std::lock_guard<std::mutex> lock(mutex_);
+        entries_[type] = entry;
+        return entry;
+    }
+    
+public:
+    CachingParkingRateRepository(std::unique_ptr<ParkingRateRepository> inner, std::chrono::milliseconds revalidateInterval)
+        : inner_(std::move(inner)), revalidateInterval_(revalidateInterval),
+          nextCheck_(Clock::time_point::min()), hasVersion_(false), version_(0) {
+    }
+    
+    bool save(const std::string& type, const ParkingRateConfig& config) override {
+        std::lock_guard<std::mutex> innerLock(innerMutex_);
+        bool saved = inner_->save(type, config);
+        
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (!saved) {
+            // 書き込みに失敗した場合は内容が分からないため、その項目を破棄する
+            entries_.erase(type);
+            return false;
+        }
+        
+        // 自分の書き込みではバージョンは変わらないため、キャッシュを直接更新する
+        entries_[type] = Entry{true, config};
+        return true;
+    }
+    
+    bool load(const std::string& type, ParkingRateConfig& config) override {
+        Entry entry = lookup(type);
+        if (entry.found) {
+            config = entry.config;
+        }
+        return entry.found;
+    }
+    
+    bool exists(const std::string& type) override {
+        return lookup(type).found;
+    }
+    
+    bool saveBatch(const RateConfigList& configs) override {
+        std::lock_guard<std::mutex> innerLock(innerMutex_);
+        bool saved = inner_->saveBatch(configs);
+        
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (!saved) {
+            // どこまで保存されたか分からないため、対象の項目を全て破棄する
+            for (const auto& entry : configs) {
+                entries_.erase(entry.first);
+            }
+            return false;
+        }
+        
+        for (const auto& entry : configs) {
+            entries_[entry.first] = Entry{true, entry.second};
+        }
+        return true;
+    }
+    
+    bool loadAll(RateConfigList& configs) override {
+        std::lock_guard<std::mutex> innerLock(innerMutex_);
+        revalidateIfDue();
+        if (!inner_->loadAll(configs)) {
+            return false;
+        }
+        
+        // 一覧は常に inner から読み、結果でキャッシュを温める
+        std::lock_guard<std::mutex> lock(mutex_);
+        for (const auto& entry : configs) {
+            entries_[entry.first] = Entry{true, entry.second};
+        }
+        return true;
+    }
+    
+    bool loadMany(const std::vector<std::string>& types, RateConfigList& configs) override {
+        configs.clear();
+        
+        // 全てキャッシュにあれば inner を待たずに返す
+        RateConfigList cached;
+        std::size_t hits = 0;
+        for (const std::string& type : types) {
+            Entry entry{};
+            if (!findCached(type, entry)) {
+                break;
+            }
+            ++hits;
+            if (entry.found) {
+                cached.emplace_back(type, entry.config);
+            }
+        }
+        if (hits == types.size()) {
+            configs.swap(cached);
+            return true;
+        }
+        
+        std::lock_guard<std::mutex> innerLock(innerMutex_);
+        revalidateIfDue();
+        
+        // キャッシュにない種別だけを inner からまとめて読み込む
+        std::vector<std::string> missing;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            for (const std::string& type : types) {
+                if (entries_.find(type) == entries_.end()) {
+                    missing.push_back(type);
+                }
+            }
+        }
+        RateConfigList loaded;
+        if (!missing.empty() && !inner_->loadMany(missing, loaded)) {
+            return false;
+        }
+        
+        std::lock_guard<std::mutex> lock(mutex_);
+        for (const std::string& type : missing) {
+            entries_.emplace(type, Entry{false, ParkingRateConfig{}});
+        }
+        for (const auto& entry : loaded) {
+            entries_[entry.first] = Entry{true, entry.second};
+        }
+        for (const std::string& type : types) {
+            const Entry& entry = entries_.find(type)->second;
+            if (entry.found) {
+                configs.emplace_back(type, entry.config);
+            }
+        }
+        return true;
+    }
+    
+    // 履歴はキャッシュせず、inner に委ねる
+    bool saveVersion(const RateVersion& version) override {
+        std::lock_guard<std::mutex> innerLock(innerMutex_);
+        return inner_->saveVersion(version);
+    }
+    
+    bool loadAsOf(const std::string& type, std::int64_t timestamp, ParkingRateConfig& config) override {
+        std::lock_guard<std::mutex> innerLock(innerMutex_);
+        return inner_->loadAsOf(type, timestamp, config);
+    }
+    
+    bool loadVersions(RateVersionList& versions) override {
+        std::lock_guard<std::mutex> innerLock(innerMutex_);
+        return inner_->loadVersions(versions);
+    }
+    
+    bool dataVersion(std::uint64_t& version) override {
+        std::lock_guard<std::mutex> innerLock(innerMutex_);
+        return inner_->dataVersion(version);
+    }
+};
+
+std::unique_ptr<ParkingRateRepository> createCachingRepository(
+    std::unique_ptr<ParkingRateRepository> inner, std::chrono::milliseconds revalidateInterval) {
+    return std::make_unique<CachingParkingRateRepository>(std::move(inner), revalidateInterval);
+}
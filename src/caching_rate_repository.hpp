@@ -0,0 +1,22 @@
+#ifndef CACHING_RATE_REPOSITORY_HPP
+#define CACHING_RATE_REPOSITORY_HPP
+
+#include "parking_rate_repository.hpp"
+#include <chrono>
+#include <memory>
+
+// 料金設定をメモリに保持する読み込みキャッシュ（ParkingRateRepository のデコレータ）
+//
+// - load / exists はキャッシュから返し、見つからない場合のみ inner を読む（存在しないことも記録する）
+// - save は inner に書き込んだうえでキャッシュを更新する
+// - inner の dataVersion を最大 revalidateInterval ごとに確認し、値が変わっていればキャッシュを破棄する
+//   そのため他プロセスからの変更も revalidateInterval 以内に見えるようになり、
+//   それ以外の呼び出しではディスクにアクセスしない
+// - inner が dataVersion に対応していない場合、他プロセスからの変更は検知しない
+// - スレッドセーフ（inner への呼び出しは内部で直列化する。キャッシュに当たった読み込みは
+//   他のスレッドの inner への呼び出しを待たない）
+std::unique_ptr<ParkingRateRepository> createCachingRepository(
+    std::unique_ptr<ParkingRateRepository> inner,
+    std::chrono::milliseconds revalidateInterval = std::chrono::milliseconds(100));
+
+#endif // CACHING_RATE_REPOSITORY_HPP
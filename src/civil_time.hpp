@@ -0,0 +1,67 @@
+#ifndef CIVIL_TIME_HPP
+#define CIVIL_TIME_HPP
+
+#include <cstdint>
+
+// 日付・時刻の計算（タイムゾーンはUTCからの固定オフセットで扱う）
+
+constexpr int kMinutesPerDay = 24 * 60;
+constexpr int kSecondsPerDay = 24 * 60 * 60;
+
+// 日本標準時（UTC+9）
+constexpr int kJstUtcOffsetSeconds = 9 * 60 * 60;
+
+// 負の値でも切り捨てになる割り算
+constexpr std::int64_t floorDiv(std::int64_t value, std::int64_t divisor) {
+    std::int64_t quotient = value / divisor;
+    return (value % divisor != 0 && ((value < 0) != (divisor < 0))) ? quotient - 1 : quotient;
+}
+
+// 年月日から1970-01-01を0とする日数を計算
+constexpr std::int64_t daysFromCivil(int year, int month, int day) {
+    std::int64_t y = static_cast<std::int64_t>(year) - (month <= 2 ? 1 : 0);
+    std::int64_t era = floorDiv(y, 400);
+    std::int64_t yearOfEra = y - era * 400;
+    std::int64_t dayOfYear = (153 * (month + (month > 2 ? -3 : 9)) + 2) / 5 + day - 1;
+    std::int64_t dayOfEra = yearOfEra * 365 + yearOfEra / 4 - yearOfEra / 100 + dayOfYear;
+    return era * 146097 + dayOfEra - 719468;
+}
+
+// 日数から年月日を計算
+struct CivilDate {
+    int year;
+    int month;
+    int day;
+};
+
+constexpr CivilDate civilFromDays(std::int64_t days) {
+    days += 719468;
+    std::int64_t era = floorDiv(days, 146097);
+    std::int64_t dayOfEra = days - era * 146097;
+    std::int64_t yearOfEra = (dayOfEra - dayOfEra / 1460 + dayOfEra / 36524 - dayOfEra / 146096) / 365;
+    std::int64_t dayOfYear = dayOfEra - (365 * yearOfEra + yearOfEra / 4 - yearOfEra / 100);
+    std::int64_t mp = (5 * dayOfYear + 2) / 153;
+    int day = static_cast<int>(dayOfYear - (153 * mp + 2) / 5 + 1);
+    int month = static_cast<int>(mp < 10 ? mp + 3 : mp - 9);
+    int year = static_cast<int>(yearOfEra + era * 400 + (month <= 2 ? 1 : 0));
+    return CivilDate{year, month, day};
+}
+
+// 曜日（0: 日曜日 〜 6: 土曜日）。1970-01-01は木曜日
+constexpr int dayOfWeek(std::int64_t days) {
+    return static_cast<int>(days - floorDiv(days + 4, 7) * 7 + 4);
+}
+
+// 現地時刻の年月日時分からエポック秒（UTC）を計算
+constexpr std::int64_t epochFromLocal(int year, int month, int day, int hour, int minute,
+                                      int utcOffsetSeconds = kJstUtcOffsetSeconds) {
+    return daysFromCivil(year, month, day) * kSecondsPerDay + hour * 3600 + minute * 60 - utcOffsetSeconds;
+}
+
+static_assert(daysFromCivil(1970, 1, 1) == 0, "");
+static_assert(daysFromCivil(2000, 3, 1) == 11017, "");
+static_assert(civilFromDays(11017).month == 3, "");
+static_assert(dayOfWeek(0) == 4, "1970-01-01は木曜日");
+static_assert(dayOfWeek(-1) == 3, "");
+
+#endif // CIVIL_TIME_HPP
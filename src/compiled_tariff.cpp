@@ -0,0 +1,21 @@
+#include "compiled_tariff.hpp"
+#include <numeric>
+
+CompiledTariff::CompiledTariff(const ParkingRateConfig& config, int horizonMinutes)
+    : config_(config),
+      tariff_(makeTariff(config)),
+      horizonMinutes_(horizonMinutes > 0 ? horizonMinutes : 0) {
+    std::size_t length = nightOffset();
+
+    // 0..horizonMinutes の分数を並べ、一括計算カーネルで日中・夜間の表を埋める
+    std::vector<int> minutes(length);
+    std::iota(minutes.begin(), minutes.end(), 0);
+
+    table_.resize(length * 2);
+    calculateFeesBatch(minutes.data(), table_.data(), length, prepareFeeRate(tariff_.daytime));
+    calculateFeesBatch(minutes.data(), table_.data() + length, length, prepareFeeRate(tariff_.nighttime));
+}
+
+std::size_t CompiledTariff::memoryBytes() const {
+    return sizeof(*this) + table_.capacity() * sizeof(int);
+}
@@ -0,0 +1,59 @@
+#ifndef COMPILED_TARIFF_HPP
+#define COMPILED_TARIFF_HPP
+
+#include "parking_lot.hpp"
+#include <cstddef>
+#include <vector>
+
+// 料金設定から分単位の料金表を事前計算した料金体系
+// 表の範囲（0分〜horizonMinutes分）は配列の読み出しだけで料金が決まり、
+// 範囲外は料金カーネルで計算する
+class CompiledTariff {
+public:
+    // 既定の事前計算範囲（3日間）
+    static constexpr int kDefaultHorizonMinutes = 3 * 24 * 60;
+
+    explicit CompiledTariff(const ParkingRateConfig& config, int horizonMinutes = kDefaultHorizonMinutes);
+
+    // 日中料金（WeekdayParkingLot::calculateFee(minutes) などと同じ結果）
+    int daytimeFee(int minutes) const {
+        if (static_cast<unsigned>(minutes) <= static_cast<unsigned>(horizonMinutes_)) {
+            return table_[static_cast<std::size_t>(minutes)];
+        }
+        return tariff_.daytimeFee(minutes);
+    }
+
+    // 夜間料金
+    int nighttimeFee(int minutes) const {
+        if (static_cast<unsigned>(minutes) <= static_cast<unsigned>(horizonMinutes_)) {
+            return table_[nightOffset() + static_cast<std::size_t>(minutes)];
+        }
+        return tariff_.nighttimeFee(minutes);
+    }
+
+    // 時刻を指定した料金計算（hour: 0-23, minute: 0-59）
+    int calculateFee(int minutes, int startHour, int startMinute) const {
+        return isDaytimeStart(startHour, startMinute) ? daytimeFee(minutes) : nighttimeFee(minutes);
+    }
+
+    const ParkingRateConfig& config() const { return config_; }
+    const Tariff& tariff() const { return tariff_; }
+    int horizonMinutes() const { return horizonMinutes_; }
+
+    // 料金表を含むメモリ使用量（バイト）
+    std::size_t memoryBytes() const;
+
+    // 日中・夜間の料金表（それぞれ horizonMinutes + 1 件）
+    const int* daytimeTable() const { return table_.data(); }
+    const int* nighttimeTable() const { return table_.data() + nightOffset(); }
+
+private:
+    std::size_t nightOffset() const { return static_cast<std::size_t>(horizonMinutes_) + 1; }
+
+    ParkingRateConfig config_;
+    Tariff tariff_;
+    int horizonMinutes_;
+    std::vector<int> table_;  // 日中の表の後ろに夜間の表を連続して配置
+};
+
+#endif // COMPILED_TARIFF_HPP
@@ -0,0 +1,99 @@
+#include "crc32c.hpp"
+#include "fee_kernel_simd.hpp"
+#include <cstring>
+
+#if FEE_KERNEL_HAS_X86_SIMD
+#include <immintrin.h>
+#endif
+
+namespace {
+
+constexpr std::uint32_t kPolynomial = 0x82F63B78u;  // 反転表現
+
+// 8バイトずつ処理する表（tables[k][b] はバイト b の後ろに k バイトの0が続く場合の剰余）
+struct Crc32cTables {
+    std::uint32_t tables[8][256];
+
+    constexpr Crc32cTables() : tables() {
+        for (std::uint32_t b = 0; b < 256; ++b) {
+            std::uint32_t crc = b;
+            for (int bit = 0; bit < 8; ++bit) {
+                crc = (crc >> 1) ^ ((crc & 1u) ? kPolynomial : 0u);
+            }
+            tables[0][b] = crc;
+        }
+        for (int k = 1; k < 8; ++k) {
+            for (std::uint32_t b = 0; b < 256; ++b) {
+                std::uint32_t previous = tables[k - 1][b];
+                tables[k][b] = (previous >> 8) ^ tables[0][previous & 0xFFu];
+            }
+        }
+    }
+};
+
+constexpr Crc32cTables kTables;
+
+std::uint32_t updatePortable(const unsigned char* p, std::size_t size, std::uint32_t crc) {
+    while (size >= 8) {
+        // リトルエンディアンで8バイトを読む
+        std::uint32_t low = crc ^ (static_cast<std::uint32_t>(p[0]) | static_cast<std::uint32_t>(p[1]) << 8 |
+                                   static_cast<std::uint32_t>(p[2]) << 16 | static_cast<std::uint32_t>(p[3]) << 24);
+        crc = kTables.tables[7][low & 0xFFu] ^ kTables.tables[6][(low >> 8) & 0xFFu] ^
+              kTables.tables[5][(low >> 16) & 0xFFu] ^ kTables.tables[4][low >> 24] ^
+              kTables.tables[3][p[4]] ^ kTables.tables[2][p[5]] ^ kTables.tables[1][p[6]] ^
+              kTables.tables[0][p[7]];
+        p += 8;
+        size -= 8;
+    }
+    while (size-- > 0) {
+        crc = (crc >> 8) ^ kTables.tables[0][(crc ^ *p++) & 0xFFu];
+    }
+    return crc;
+}
+
+#if FEE_KERNEL_HAS_X86_SIMD && defined(__x86_64__)
+
+__attribute__((target("sse4.2")))
+std::uint32_t updateSse42(const unsigned char* p, std::size_t size, std::uint32_t crc) {
+    std::uint64_t crc64 = crc;
+    while (size >= 8) {
+        std::uint64_t word;
+        std::memcpy(&word, p, sizeof(word));
+        crc64 = _mm_crc32_u64(crc64, word);
+        p += 8;
+        size -= 8;
+    }
+    std::uint32_t crc32 = static_cast<std::uint32_t>(crc64);
+    while (size-- > 0) {
+        crc32 = _mm_crc32_u8(crc32, *p++);
+    }
+    return crc32;
+}
+
+#endif
+
+using Crc32cUpdate = std::uint32_t (*)(const unsigned char*, std::size_t, std::uint32_t);
+
+Crc32cUpdate activeUpdate() {
+    // 初回呼び出し時に一度だけ判定する
+    static const Crc32cUpdate update = []() -> Crc32cUpdate {
+#if FEE_KERNEL_HAS_X86_SIMD && defined(__x86_64__)
+        __builtin_cpu_init();
+        if (__builtin_cpu_supports("sse4.2")) {
+            return updateSse42;
+        }
+#endif
+        return updatePortable;
+    }();
+    return update;
+}
+
+} // namespace
+
+std::uint32_t crc32c(const void* data, std::size_t size, std::uint32_t crc) {
+    return ~activeUpdate()(static_cast<const unsigned char*>(data), size, ~crc);
+}
+
+std::uint32_t crc32cPortable(const void* data, std::size_t size, std::uint32_t crc) {
+    return ~updatePortable(static_cast<const unsigned char*>(data), size, ~crc);
+}
@@ -0,0 +1,15 @@
+#ifndef CRC32C_HPP
+#define CRC32C_HPP
+
+#include <cstddef>
+#include <cstdint>
+
+// CRC-32C（Castagnoli, iSCSI/ext4 などと同じ多項式 0x82F63B78）
+// crc に前回の戻り値を渡すと、続きのデータとして計算する（crc32c(ab) == crc32c(b, crc32c(a))）
+// SSE4.2 が使える場合は crc32 命令、それ以外は表引き（8バイトずつ）で計算する
+std::uint32_t crc32c(const void* data, std::size_t size, std::uint32_t crc = 0);
+
+// 表引きの実装（命令の有無によらず同じ結果になることの確認用）
+std::uint32_t crc32cPortable(const void* data, std::size_t size, std::uint32_t crc = 0);
+
+#endif // CRC32C_HPP
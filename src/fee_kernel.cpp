@@ -0,0 +1,147 @@
+#include "fee_kernel.hpp"
+#include "fee_kernel_simd.hpp"
+
+PreparedFeeRate prepareFeeRate(const FeeRate& rate) {
+    PreparedFeeRate prepared{};
+    prepared.unitMinutes = rate.unitMinutes;
+    prepared.unitPrice = rate.unitPrice;
+    prepared.maxMinutes = rate.maxMinutes;
+    prepared.maxFee = rate.maxFee;
+
+    if (rate.unitMinutes > 0) {
+        // 単位時間を超える最小の2のべき乗の指数
+        int log2Ceil = 0;
+        while ((static_cast<std::int64_t>(1) << log2Ceil) < rate.unitMinutes) {
+            ++log2Ceil;
+        }
+        prepared.shift = 31 + log2Ceil;
+        std::uint64_t divisor = static_cast<std::uint64_t>(rate.unitMinutes);
+        prepared.magic = static_cast<std::uint32_t>(((static_cast<std::uint64_t>(1) << prepared.shift) + divisor - 1) / divisor);
+        prepared.unitMask = -1;
+    } else {
+        // 単位時間が不正な場合は常に0単位
+        prepared.shift = 0;
+        prepared.magic = 0;
+        prepared.unitMask = 0;
+    }
+
+    // 単位数 × 単位料金が int に収まる上限
+    const std::int64_t intMax = std::numeric_limits<int>::max();
+    if (rate.unitPrice > 0) {
+        prepared.unitLimit = static_cast<int>(intMax / rate.unitPrice);
+        prepared.saturatedFee = std::numeric_limits<int>::max();
+    } else if (rate.unitPrice < 0) {
+        std::int64_t limit = (intMax + 1) / -static_cast<std::int64_t>(rate.unitPrice);
+        prepared.unitLimit = static_cast<int>(limit < intMax ? limit : intMax);
+        prepared.saturatedFee = std::numeric_limits<int>::min();
+    } else {
+        prepared.unitLimit = std::numeric_limits<int>::max();
+        prepared.saturatedFee = 0;
+    }
+
+    prepared.capMask = rate.maxMinutes > 0 ? -1 : 0;
+    return prepared;
+}
+
+namespace {
+
+using FeeBatchKernel = void (*)(const int*, int*, std::size_t, const PreparedFeeRate&);
+
+void calculateFeesBatchScalar(const int* minutes, int* fees, std::size_t count, const PreparedFeeRate& rate) {
+    // 料金帯をローカルにコピーしてループ内で再読み込みされないようにする
+    const PreparedFeeRate local = rate;
+    for (std::size_t i = 0; i < count; ++i) {
+        fees[i] = calculatePreparedFee(minutes[i], local);
+    }
+}
+
+FeeBatchKernel kernelFor(FeeKernelIsa isa) {
+    switch (isa) {
+    case FeeKernelIsa::Avx2:
+        return calculateFeesBatchAvx2;
+    case FeeKernelIsa::Sse41:
+        return calculateFeesBatchSse41;
+    case FeeKernelIsa::Scalar:
+        break;
+    }
+    return calculateFeesBatchScalar;
+}
+
+FeeBatchKernel activeKernel() {
+    // 初回呼び出し時に一度だけ判定する
+    static const FeeBatchKernel kernel = kernelFor(detectFeeKernelIsa());
+    return kernel;
+}
+
+bool isaSupported(FeeKernelIsa isa) {
+    switch (isa) {
+    case FeeKernelIsa::Avx2:
+        return detectFeeKernelIsa() == FeeKernelIsa::Avx2;
+    case FeeKernelIsa::Sse41:
+        return detectFeeKernelIsa() != FeeKernelIsa::Scalar;
+    case FeeKernelIsa::Scalar:
+        return true;
+    }
+    return false;
+}
+
+// 時刻指定の一括計算で日中・夜間の料金を一時的に置くバッファの件数
+constexpr std::size_t kTimedChunkSize = 256;
+
+} // namespace
+
+FeeKernelIsa detectFeeKernelIsa() {
+#if FEE_KERNEL_HAS_X86_SIMD
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2")) {
+        return FeeKernelIsa::Avx2;
+    }
+    if (__builtin_cpu_supports("sse4.1")) {
+        return FeeKernelIsa::Sse41;
+    }
+#endif
+    return FeeKernelIsa::Scalar;
+}
+
+FeeKernelIsa activeFeeKernelIsa() {
+    FeeBatchKernel kernel = activeKernel();
+    if (kernel == calculateFeesBatchAvx2) {
+        return FeeKernelIsa::Avx2;
+    }
+    if (kernel == calculateFeesBatchSse41) {
+        return FeeKernelIsa::Sse41;
+    }
+    return FeeKernelIsa::Scalar;
+}
+
+bool calculateFeesBatchWithIsa(FeeKernelIsa isa, const int* minutes, int* fees, std::size_t count,
+                               const PreparedFeeRate& rate) {
+    if (!isaSupported(isa)) {
+        return false;
+    }
+    kernelFor(isa)(minutes, fees, count, rate);
+    return true;
+}
+
+void calculateFeesBatch(const int* minutes, int* fees, std::size_t count, const PreparedFeeRate& rate) {
+    activeKernel()(minutes, fees, count, rate);
+}
+
+void calculateTimedFeesBatch(const int* minutes, const int* startHours, const int* startMinutes,
+                             int* fees, std::size_t count,
+                             const PreparedFeeRate& daytimeRate, const PreparedFeeRate& nighttimeRate) {
+    FeeBatchKernel kernel = activeKernel();
+    int dayFees[kTimedChunkSize];
+    int nightFees[kTimedChunkSize];
+
+    // 日中・夜間の両方をSIMDカーネルで計算し、開始時刻のマスクで選択する
+    for (std::size_t offset = 0; offset < count; offset += kTimedChunkSize) {
+        std::size_t n = count - offset < kTimedChunkSize ? count - offset : kTimedChunkSize;
+        kernel(minutes + offset, dayFees, n, daytimeRate);
+        kernel(minutes + offset, nightFees, n, nighttimeRate);
+        for (std::size_t i = 0; i < n; ++i) {
+            int dayMask = -static_cast<int>(isDaytimeStart(startHours[offset + i], startMinutes[offset + i]));
+            fees[offset + i] = (dayFees[i] & dayMask) | (nightFees[i] & ~dayMask);
+        }
+    }
+}
@@ -0,0 +1,124 @@
+#ifndef FEE_KERNEL_HPP
+#define FEE_KERNEL_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+
+// 料金帯（日中・夜間それぞれ）の設定
+struct FeeRate {
+    int unitMinutes;  // 料金単位の分数
+    int unitPrice;    // 単位料金
+    int maxMinutes;   // 最大料金が適用される時間（0以下なら最大料金なし）
+    int maxFee;       // 最大料金
+};
+
+// この時間以上駐車し、通常料金が最大料金を超える場合は最大料金を適用する
+constexpr int kMaxFeeThresholdMinutes = 300;
+
+// 64ビットの金額を int の範囲に収める（オーバーフロー時は飽和させる）
+constexpr int saturateMoney(std::int64_t amount) {
+    if (amount > std::numeric_limits<int>::max()) {
+        return std::numeric_limits<int>::max();
+    }
+    if (amount < std::numeric_limits<int>::min()) {
+        return std::numeric_limits<int>::min();
+    }
+    return static_cast<int>(amount);
+}
+
+// 単位時間数（切り上げ）を整数演算のみで計算
+// 負の駐車時間は0分、単位時間が0以下の設定は0単位として扱う
+constexpr std::int64_t calculateUnits(int minutes, int unitMinutes) {
+    if (minutes <= 0 || unitMinutes <= 0) {
+        return 0;
+    }
+    return (static_cast<std::int64_t>(minutes) + unitMinutes - 1) / unitMinutes;
+}
+
+// 最大料金を考慮しない通常料金（単位数 × 単位料金、64ビットで計算して飽和）
+constexpr int calculateRateBaseFee(int minutes, const FeeRate& rate) {
+    return saturateMoney(calculateUnits(minutes, rate.unitMinutes) * rate.unitPrice);
+}
+
+// 日中・夜間で共通の料金計算
+constexpr int calculateRateFee(int minutes, const FeeRate& rate) {
+    int baseFee = calculateRateBaseFee(minutes, rate);
+
+    // 最大料金が設定されている場合のみ最大料金を考慮
+    if (rate.maxMinutes > 0) {
+        // 最大時間ちょうどまたは超えている場合は最大料金を適用
+        if (minutes >= rate.maxMinutes) {
+            return rate.maxFee;
+        }
+        // 閾値以上で通常料金が最大料金を超えている場合も最大料金を適用
+        if (minutes >= kMaxFeeThresholdMinutes && baseFee > rate.maxFee) {
+            return rate.maxFee;
+        }
+    }
+    return baseFee;
+}
+
+// 一括計算用に前処理した料金帯
+// 単位時間での割り算を逆数の掛け算に置き換え、分岐なしで計算できるようにする
+struct PreparedFeeRate {
+    int unitMinutes;
+    int unitPrice;
+    int maxMinutes;
+    int maxFee;
+    std::uint32_t magic;  // ceil(2^shift / unitMinutes)
+    int shift;            // 31 + ceil(log2(unitMinutes))
+    int unitMask;         // 単位時間が不正なら0、それ以外は-1
+    int unitLimit;        // これを超える単位数は金額がintを超える
+    int saturatedFee;     // 金額がintを超えた場合の飽和値
+    int capMask;          // 最大料金が設定されていれば-1、それ以外は0
+};
+
+PreparedFeeRate prepareFeeRate(const FeeRate& rate);
+
+// 08:00-18:00（18:00ちょうどを含む）を日中とする判定を分岐なしで行う
+constexpr bool isDaytimeStart(int hour, int minute) {
+    return ((hour >= 8) & (hour < 18)) | ((hour == 18) & (minute == 0));
+}
+
+// calculateRateFee と同じ結果を分岐なしで計算する
+// 0 <= minutes < 2^31 なので (minutes * magic) >> shift は割り算の商と一致する
+inline int calculatePreparedFee(int minutes, const PreparedFeeRate& rate) {
+    std::uint32_t clamped = static_cast<std::uint32_t>(minutes > 0 ? minutes : 0);
+    std::uint32_t quotient = static_cast<std::uint32_t>(
+        (static_cast<std::uint64_t>(clamped) * rate.magic) >> rate.shift);
+    std::uint32_t remainder = clamped - quotient * static_cast<std::uint32_t>(rate.unitMinutes);
+    int units = static_cast<int>(quotient + (remainder != 0)) & rate.unitMask;
+    int baseFee = units > rate.unitLimit ? rate.saturatedFee : units * rate.unitPrice;
+    int cap = rate.capMask &
+              -((minutes >= rate.maxMinutes) | ((minutes >= kMaxFeeThresholdMinutes) & (baseFee > rate.maxFee)));
+    return (rate.maxFee & cap) | (baseFee & ~cap);
+}
+
+// 一括計算カーネルの命令セット
+enum class FeeKernelIsa {
+    Scalar,  // 移植性のあるスカラー実装
+    Sse41,   // 4件ずつ処理するSSE4.1実装
+    Avx2     // 8件ずつ処理するAVX2実装
+};
+
+// CPUが対応している最も速いカーネル（cpuidで判定）
+FeeKernelIsa detectFeeKernelIsa();
+
+// calculateFeesBatch が使用しているカーネル
+FeeKernelIsa activeFeeKernelIsa();
+
+// 命令セットを指定して一括計算（CPUが対応していなければ何もせずfalse）
+bool calculateFeesBatchWithIsa(FeeKernelIsa isa, const int* minutes, int* fees, std::size_t count,
+                               const PreparedFeeRate& rate);
+
+// fees[i] = calculateRateFee(minutes[i], rate) を一括計算
+// 実行時に検出したカーネルに振り分ける
+void calculateFeesBatch(const int* minutes, int* fees, std::size_t count, const PreparedFeeRate& rate);
+
+// 開始時刻（startHours[i], startMinutes[i]）で日中・夜間の料金帯を選んで一括計算
+void calculateTimedFeesBatch(const int* minutes, const int* startHours, const int* startMinutes,
+                             int* fees, std::size_t count,
+                             const PreparedFeeRate& daytimeRate, const PreparedFeeRate& nighttimeRate);
+
+#endif // FEE_KERNEL_HPP
@@ -0,0 +1,118 @@
+#include "fee_kernel_simd.hpp"
+
+#if FEE_KERNEL_HAS_X86_SIMD
+#include <immintrin.h>
+#endif
+
+namespace {
+
+void calculateFeesTail(const int* minutes, int* fees, std::size_t begin, std::size_t count,
+                       const PreparedFeeRate& rate) {
+    for (std::size_t i = begin; i < count; ++i) {
+        fees[i] = calculatePreparedFee(minutes[i], rate);
+    }
+}
+
+} // namespace
+
+#if FEE_KERNEL_HAS_X86_SIMD
+
+// calculatePreparedFee と同じ手順を4レーンずつ計算する
+__attribute__((target("sse4.1")))
+void calculateFeesBatchSse41(const int* minutes, int* fees, std::size_t count, const PreparedFeeRate& rate) {
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i ones = _mm_set1_epi32(-1);
+    const __m128i magic = _mm_set1_epi32(static_cast<int>(rate.magic));
+    const __m128i shift = _mm_cvtsi32_si128(rate.shift);
+    const __m128i unitMinutes = _mm_set1_epi32(rate.unitMinutes);
+    const __m128i unitPrice = _mm_set1_epi32(rate.unitPrice);
+    const __m128i unitMask = _mm_set1_epi32(rate.unitMask);
+    const __m128i unitLimit = _mm_set1_epi32(rate.unitLimit);
+    const __m128i saturatedFee = _mm_set1_epi32(rate.saturatedFee);
+    const __m128i maxMinutes = _mm_set1_epi32(rate.maxMinutes);
+    const __m128i maxFee = _mm_set1_epi32(rate.maxFee);
+    const __m128i threshold = _mm_set1_epi32(kMaxFeeThresholdMinutes);
+    const __m128i capMask = _mm_set1_epi32(rate.capMask);
+
+    std::size_t i = 0;
+    for (; i + 4 <= count; i += 4) {
+        __m128i m = _mm_loadu_si128(reinterpret_cast<const __m128i*>(minutes + i));
+        __m128i clamped = _mm_max_epi32(m, zero);
+
+        // 偶数レーンと奇数レーンで 32x32->64 ビットの掛け算を行い、商を組み立てる
+        __m128i evenProduct = _mm_srl_epi64(_mm_mul_epu32(clamped, magic), shift);
+        __m128i oddProduct = _mm_srl_epi64(_mm_mul_epu32(_mm_srli_epi64(clamped, 32), magic), shift);
+        __m128i quotient = _mm_blend_epi16(evenProduct, _mm_slli_epi64(oddProduct, 32), 0xCC);
+
+        __m128i remainder = _mm_sub_epi32(clamped, _mm_mullo_epi32(quotient, unitMinutes));
+        __m128i hasRemainder = _mm_andnot_si128(_mm_cmpeq_epi32(remainder, zero), ones);
+        __m128i units = _mm_and_si128(_mm_sub_epi32(quotient, hasRemainder), unitMask);
+
+        __m128i overflow = _mm_cmpgt_epi32(units, unitLimit);
+        __m128i baseFee = _mm_blendv_epi8(_mm_mullo_epi32(units, unitPrice), saturatedFee, overflow);
+
+        __m128i reachedMax = _mm_andnot_si128(_mm_cmpgt_epi32(maxMinutes, m), ones);
+        __m128i reachedThreshold = _mm_andnot_si128(_mm_cmpgt_epi32(threshold, m), ones);
+        __m128i overMaxFee = _mm_cmpgt_epi32(baseFee, maxFee);
+        __m128i cap = _mm_and_si128(capMask, _mm_or_si128(reachedMax, _mm_and_si128(reachedThreshold, overMaxFee)));
+
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(fees + i), _mm_blendv_epi8(baseFee, maxFee, cap));
+    }
+    calculateFeesTail(minutes, fees, i, count, rate);
+}
+
+// calculatePreparedFee と同じ手順を8レーンずつ計算する
+__attribute__((target("avx2")))
+void calculateFeesBatchAvx2(const int* minutes, int* fees, std::size_t count, const PreparedFeeRate& rate) {
+    const __m256i zero = _mm256_setzero_si256();
+    const __m256i ones = _mm256_set1_epi32(-1);
+    const __m256i magic = _mm256_set1_epi32(static_cast<int>(rate.magic));
+    const __m128i shift = _mm_cvtsi32_si128(rate.shift);
+    const __m256i unitMinutes = _mm256_set1_epi32(rate.unitMinutes);
+    const __m256i unitPrice = _mm256_set1_epi32(rate.unitPrice);
+    const __m256i unitMask = _mm256_set1_epi32(rate.unitMask);
+    const __m256i unitLimit = _mm256_set1_epi32(rate.unitLimit);
+    const __m256i saturatedFee = _mm256_set1_epi32(rate.saturatedFee);
+    const __m256i maxMinutes = _mm256_set1_epi32(rate.maxMinutes);
+    const __m256i maxFee = _mm256_set1_epi32(rate.maxFee);
+    const __m256i threshold = _mm256_set1_epi32(kMaxFeeThresholdMinutes);
+    const __m256i capMask = _mm256_set1_epi32(rate.capMask);
+
+    std::size_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        __m256i m = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(minutes + i));
+        __m256i clamped = _mm256_max_epi32(m, zero);
+
+        __m256i evenProduct = _mm256_srl_epi64(_mm256_mul_epu32(clamped, magic), shift);
+        __m256i oddProduct = _mm256_srl_epi64(_mm256_mul_epu32(_mm256_srli_epi64(clamped, 32), magic), shift);
+        __m256i quotient = _mm256_blend_epi32(evenProduct, _mm256_slli_epi64(oddProduct, 32), 0xAA);
+
+        __m256i remainder = _mm256_sub_epi32(clamped, _mm256_mullo_epi32(quotient, unitMinutes));
+        __m256i hasRemainder = _mm256_andnot_si256(_mm256_cmpeq_epi32(remainder, zero), ones);
+        __m256i units = _mm256_and_si256(_mm256_sub_epi32(quotient, hasRemainder), unitMask);
+
+        __m256i overflow = _mm256_cmpgt_epi32(units, unitLimit);
+        __m256i baseFee = _mm256_blendv_epi8(_mm256_mullo_epi32(units, unitPrice), saturatedFee, overflow);
+
+        __m256i reachedMax = _mm256_andnot_si256(_mm256_cmpgt_epi32(maxMinutes, m), ones);
+        __m256i reachedThreshold = _mm256_andnot_si256(_mm256_cmpgt_epi32(threshold, m), ones);
+        __m256i overMaxFee = _mm256_cmpgt_epi32(baseFee, maxFee);
+        __m256i cap = _mm256_and_si256(capMask,
+                                       _mm256_or_si256(reachedMax, _mm256_and_si256(reachedThreshold, overMaxFee)));
+
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(fees + i), _mm256_blendv_epi8(baseFee, maxFee, cap));
+    }
+    calculateFeesTail(minutes, fees, i, count, rate);
+}
+
+#else
+
+void calculateFeesBatchSse41(const int* minutes, int* fees, std::size_t count, const PreparedFeeRate& rate) {
+    calculateFeesTail(minutes, fees, 0, count, rate);
+}
+
+void calculateFeesBatchAvx2(const int* minutes, int* fees, std::size_t count, const PreparedFeeRate& rate) {
+    calculateFeesTail(minutes, fees, 0, count, rate);
+}
+
+#endif
@@ -0,0 +1,18 @@
+#ifndef FEE_KERNEL_SIMD_HPP
+#define FEE_KERNEL_SIMD_HPP
+
+#include "fee_kernel.hpp"
+
+// x86でGCC/Clangの関数単位のtarget指定が使える場合のみSIMDカーネルを有効にする
+#if (defined(__x86_64__) || defined(__i386__)) && (defined(__GNUC__) || defined(__clang__))
+#define FEE_KERNEL_HAS_X86_SIMD 1
+#else
+#define FEE_KERNEL_HAS_X86_SIMD 0
+#endif
+
+// calculatePreparedFee をSIMD化した一括計算カーネル
+// SIMDが使えない環境ではスカラー実装にフォールバックする
+void calculateFeesBatchSse41(const int* minutes, int* fees, std::size_t count, const PreparedFeeRate& rate);
+void calculateFeesBatchAvx2(const int* minutes, int* fees, std::size_t count, const PreparedFeeRate& rate);
+
+#endif // FEE_KERNEL_SIMD_HPP
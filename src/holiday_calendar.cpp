@@ -0,0 +1,213 @@
+#include "holiday_calendar.hpp"
+#include <sqlite3.h>
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+
+namespace {
+
+const char* kCreateHolidayTableSQL =
+    "CREATE TABLE IF NOT EXISTS holidays ("
+    "date TEXT NOT NULL,"
+    "site TEXT NOT NULL DEFAULT '',"
+    "name TEXT,"
+    "PRIMARY KEY (date, site)"
+    ");";
+
+bool parseDigits(const char* text, int count, int& value) {
+    value = 0;
+    for (int i = 0; i < count; ++i) {
+        if (text[i] < '0' || text[i] > '9') {
+            return false;
+        }
+        value = value * 10 + (text[i] - '0');
+    }
+    return true;
+}
+
+} // namespace
+
+bool parseIsoDate(const char* text, std::size_t length, std::int64_t& dayNumber) {
+    if (length != 10 || text[4] != '-' || text[7] != '-') {
+        return false;
+    }
+    int year, month, day;
+    if (!parseDigits(text, 4, year) || !parseDigits(text + 5, 2, month) || !parseDigits(text + 8, 2, day)) {
+        return false;
+    }
+    if (month < 1 || month > 12 || day < 1 || day > 31) {
+        return false;
+    }
+    dayNumber = daysFromCivil(year, month, day);
+    // 2月30日のような存在しない日付を除外
+    CivilDate check = civilFromDays(dayNumber);
+    return check.month == month && check.day == day;
+}
+
+HolidayCalendar::HolidayCalendar(bool weekendsAreHolidays)
+    : weekendsAreHolidays_(weekendsAreHolidays), current_(std::make_unique<const Snapshot>()) {}
+
+HolidayCalendar::~HolidayCalendar() = default;
+
+DayKind HolidayCalendar::classify(std::int64_t dayNumber) const {
+    if (weekendsAreHolidays_) {
+        int weekday = dayOfWeek(dayNumber);
+        if (weekday == 0 || weekday == 6) {
+            return DayKind::Holiday;
+        }
+    }
+    return isRegisteredHoliday(dayNumber) ? DayKind::Holiday : DayKind::Weekday;
+}
+
+bool HolidayCalendar::isRegisteredHoliday(std::int64_t dayNumber) const {
+    RcuReadGuard guard;
+    const Snapshot* snapshot = current_.read();
+    std::uint64_t index = static_cast<std::uint64_t>(dayNumber - snapshot->firstDay);
+    if (index >= snapshot->words.size() * 64) {
+        return false;
+    }
+    return (snapshot->words[index >> 6] >> (index & 63)) & 1;
+}
+
+std::size_t HolidayCalendar::holidayCount() const {
+    RcuReadGuard guard;
+    return current_.read()->count;
+}
+
+void HolidayCalendar::replace(const std::vector<std::int64_t>& holidayDays) {
+    auto snapshot = std::make_unique<Snapshot>();
+    if (!holidayDays.empty()) {
+        auto range = std::minmax_element(holidayDays.begin(), holidayDays.end());
+        snapshot->firstDay = *range.first;
+        std::uint64_t span = static_cast<std::uint64_t>(*range.second - *range.first) + 1;
+        snapshot->words.assign((span + 63) / 64, 0);
+        for (std::int64_t day : holidayDays) {
+            std::uint64_t index = static_cast<std::uint64_t>(day - snapshot->firstDay);
+            std::uint64_t bit = static_cast<std::uint64_t>(1) << (index & 63);
+            if (!(snapshot->words[index >> 6] & bit)) {
+                snapshot->words[index >> 6] |= bit;
+                ++snapshot->count;
+            }
+        }
+    }
+
+    std::lock_guard<std::mutex> lock(writerMutex_);
+    current_.publish(std::move(snapshot));
+}
+
+bool HolidayCalendar::loadFromFile(const std::string& path) {
+    std::vector<std::int64_t> days;
+    if (!readHolidayFile(path, days)) {
+        return false;
+    }
+    replace(days);
+    return true;
+}
+
+bool HolidayCalendar::loadFromDatabase(const std::string& dbPath, const std::string& siteId) {
+    std::vector<std::int64_t> days;
+    if (!readHolidayDatabase(dbPath, siteId, days)) {
+        return false;
+    }
+    replace(days);
+    return true;
+}
+
+bool readHolidayFile(const std::string& path, std::vector<std::int64_t>& holidayDays) {
+    std::ifstream file(path);
+    if (!file) {
+        return false;
+    }
+
+    std::string line;
+    int lineNumber = 0;
+    while (std::getline(file, line)) {
+        ++lineNumber;
+        std::size_t begin = line.find_first_not_of(" \t\r");
+        if (begin == std::string::npos || line[begin] == '#') {
+            continue;
+        }
+        // 日付の後ろは空白かカンマで区切る
+        std::size_t end = line.find_first_of(" \t\r,", begin);
+        if (end == std::string::npos) {
+            end = line.size();
+        }
+        std::int64_t day;
+        if (!parseIsoDate(line.c_str() + begin, end - begin, day)) {
+            std::cerr << "Invalid holiday date at " << path << ":" << lineNumber << std::endl;
+            return false;
+        }
+        holidayDays.push_back(day);
+    }
+    return true;
+}
+
+bool readHolidayDatabase(const std::string& dbPath, const std::string& siteId,
+                         std::vector<std::int64_t>& holidayDays) {
+    sqlite3* db = nullptr;
+    if (sqlite3_open_v2(dbPath.c_str(), &db, SQLITE_OPEN_READONLY, nullptr) != SQLITE_OK) {
+        std::cerr << "Can't open database: " << sqlite3_errmsg(db) << std::endl;
+        sqlite3_close(db);
+        return false;
+    }
+
+    const char* selectSQL = "SELECT date FROM holidays WHERE site = '' OR site = ?;";
+    sqlite3_stmt* stmt = nullptr;
+    if (sqlite3_prepare_v2(db, selectSQL, -1, &stmt, nullptr) != SQLITE_OK) {
+        sqlite3_close(db);
+        return false;
+    }
+    sqlite3_bind_text(stmt, 1, siteId.c_str(), -1, SQLITE_STATIC);
+
+    bool ok = true;
+    int rc;
+    while ((rc = sqlite3_step(stmt)) == SQLITE_ROW) {
+        const char* text = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 0));
+        std::int64_t day;
+        if (!text || !parseIsoDate(text, static_cast<std::size_t>(sqlite3_column_bytes(stmt, 0)), day)) {
+            ok = false;
+            break;
+        }
+        holidayDays.push_back(day);
+    }
+    if (rc != SQLITE_DONE) {
+        ok = false;
+    }
+
+    sqlite3_finalize(stmt);
+    sqlite3_close(db);
+    return ok;
+}
+
+bool saveHolidayToDatabase(const std::string& dbPath, std::int64_t dayNumber,
+                           const std::string& siteId, const std::string& name) {
+    sqlite3* db = nullptr;
+    if (sqlite3_open(dbPath.c_str(), &db) != SQLITE_OK) {
+        sqlite3_close(db);
+        return false;
+    }
+    if (sqlite3_exec(db, kCreateHolidayTableSQL, nullptr, nullptr, nullptr) != SQLITE_OK) {
+        sqlite3_close(db);
+        return false;
+    }
+
+    CivilDate date = civilFromDays(dayNumber);
+    char text[16];
+    std::snprintf(text, sizeof(text), "%04d-%02d-%02d", date.year, date.month, date.day);
+
+    const char* insertSQL = "INSERT OR REPLACE INTO holidays (date, site, name) VALUES (?, ?, ?);";
+    sqlite3_stmt* stmt = nullptr;
+    if (sqlite3_prepare_v2(db, insertSQL, -1, &stmt, nullptr) != SQLITE_OK) {
+        sqlite3_close(db);
+        return false;
+    }
+    sqlite3_bind_text(stmt, 1, text, -1, SQLITE_STATIC);
+    sqlite3_bind_text(stmt, 2, siteId.c_str(), -1, SQLITE_STATIC);
+    sqlite3_bind_text(stmt, 3, name.c_str(), -1, SQLITE_STATIC);
+
+    int rc = sqlite3_step(stmt);
+    sqlite3_finalize(stmt);
+    sqlite3_close(db);
+    return rc == SQLITE_DONE;
+}
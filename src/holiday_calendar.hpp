@@ -0,0 +1,71 @@
+#ifndef HOLIDAY_CALENDAR_HPP
+#define HOLIDAY_CALENDAR_HPP
+
+#include "rcu.hpp"
+#include "stay_pricing.hpp"
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <vector>
+
+// 祝日・休業日のカレンダー
+// 日数（1970-01-01を0とする現地の日数）で引くビットセットで保持し、1回のビット判定で分類する
+//
+// 読み込み直しは新しいビットセットを作って RcuCell で差し替えるだけなので、
+// 料金計算中のスレッドを止めない。古いビットセットは読み取り中のスレッドが使い終わってから破棄する
+class HolidayCalendar : public DayCalendar {
+public:
+    // weekendsAreHolidays: 土日も休日として扱うか
+    explicit HolidayCalendar(bool weekendsAreHolidays = true);
+    ~HolidayCalendar() override;
+
+    HolidayCalendar(const HolidayCalendar&) = delete;
+    HolidayCalendar& operator=(const HolidayCalendar&) = delete;
+
+    DayKind classify(std::int64_t dayNumber) const override;
+
+    // ビットセットに登録された祝日・休業日か（土日の扱いは含まない）
+    bool isRegisteredHoliday(std::int64_t dayNumber) const;
+
+    // 登録されている祝日・休業日の数
+    std::size_t holidayCount() const;
+
+    // 祝日・休業日の一覧を丸ごと置き換える
+    // 古い一覧を読み取り中のスレッドを待つので、RcuReadGuard の区間の中から呼ばないこと
+    void replace(const std::vector<std::int64_t>& holidayDays);
+
+    // ファイルから読み込んで置き換える（失敗した場合は現在の内容を維持）
+    bool loadFromFile(const std::string& path);
+
+    // DBの holidays テーブルから全国共通の祝日と siteId の休業日を読み込んで置き換える
+    bool loadFromDatabase(const std::string& dbPath, const std::string& siteId = "");
+
+private:
+    struct Snapshot {
+        std::int64_t firstDay = 0;
+        std::vector<std::uint64_t> words;
+        std::size_t count = 0;
+    };
+
+    bool weekendsAreHolidays_;
+    RcuCell<Snapshot> current_;
+    std::mutex writerMutex_;  // 書き込み同士の排他（読み込みは使わない）
+};
+
+// 祝日ファイルを読み込む
+// 1行に1日、先頭が YYYY-MM-DD で、その後ろ（名称など）は無視する。空行と # で始まる行は読み飛ばす
+bool readHolidayFile(const std::string& path, std::vector<std::int64_t>& holidayDays);
+
+// DBの holidays テーブル（date TEXT, site TEXT, name TEXT）から読み込む
+// site が空文字の行は全国共通の祝日、それ以外はその拠点の休業日
+bool readHolidayDatabase(const std::string& dbPath, const std::string& siteId,
+                         std::vector<std::int64_t>& holidayDays);
+
+// holidays テーブルに祝日・休業日を保存する（テーブルがなければ作成）
+bool saveHolidayToDatabase(const std::string& dbPath, std::int64_t dayNumber,
+                           const std::string& siteId, const std::string& name);
+
+// "YYYY-MM-DD" を日数に変換（length がちょうど10文字でなければfalse）
+bool parseIsoDate(const char* text, std::size_t length, std::int64_t& dayNumber);
+
+#endif // HOLIDAY_CALENDAR_HPP
@@ -0,0 +1,487 @@
+#include "http_quote.hpp"
+#include <cstring>
+#include <limits>
+
+namespace {
+
+// 要求のヘッダーの上限（本文を含めた全体は kHttpQuoteMaxRequestBytes まで）
+constexpr std::size_t kMaxBodyBytes = 1024;
+
+struct Span {
+    const char* data;
+    std::size_t size;
+
+    bool operator==(const char* literal) const {
+        return std::strlen(literal) == size && std::memcmp(data, literal, size) == 0;
+    }
+};
+
+bool equalsIgnoreCase(Span span, const char* literal) {
+    if (std::strlen(literal) != span.size) {
+        return false;
+    }
+    for (std::size_t i = 0; i < span.size; ++i) {
+        char c = span.data[i];
+        if (c >= 'A' && c <= 'Z') {
+            c = static_cast<char>(c - 'A' + 'a');
+        }
+        if (c != literal[i]) {
+            return false;
+        }
+    }
+    return true;
+}
+
+Span trim(const char* begin, const char* end) {
+    while (begin < end && (*begin == ' ' || *begin == '\t')) {
+        ++begin;
+    }
+    while (end > begin && (end[-1] == ' ' || end[-1] == '\t')) {
+        --end;
+    }
+    return Span{begin, static_cast<std::size_t>(end - begin)};
+}
+
+bool parseUnsigned(Span span, std::uint64_t& value) {
+    if (span.size == 0 || span.size > 20) {
+        return false;
+    }
+    value = 0;
+    for (std::size_t i = 0; i < span.size; ++i) {
+        char c = span.data[i];
+        if (c < '0' || c > '9') {
+            return false;
+        }
+        std::uint64_t digit = static_cast<std::uint64_t>(c - '0');
+        if (value > (std::numeric_limits<std::uint64_t>::max() - digit) / 10) {
+            return false;
+        }
+        value = value * 10 + digit;
+    }
+    return true;
+}
+
+bool parseSigned(Span span, std::int64_t& value) {
+    bool negative = span.size > 0 && span.data[0] == '-';
+    std::uint64_t magnitude;
+    if (!parseUnsigned(negative ? Span{span.data + 1, span.size - 1} : span, magnitude)) {
+        return false;
+    }
+    std::uint64_t limit = static_cast<std::uint64_t>(std::numeric_limits<std::int64_t>::max()) + (negative ? 1 : 0);
+    if (magnitude > limit) {
+        return false;
+    }
+    value = negative ? static_cast<std::int64_t>(0 - magnitude) : static_cast<std::int64_t>(magnitude);
+    return true;
+}
+
+const char* skipSpace(const char* p, const char* end) {
+    while (p < end && (*p == ' ' || *p == '\t' || *p == '\r' || *p == '\n')) {
+        ++p;
+    }
+    return p;
+}
+
+// 1階層のオブジェクトを走査し、項目ごとに field(key, value, isString) を呼ぶ
+// 値は整数か文字列（エスケープなし）だけを受け付ける
+template <typename Field>
+bool scanJsonObject(const char* p, const char* end, Field&& field) {
+    p = skipSpace(p, end);
+    if (p == end || *p++ != '{') {
+        return false;
+    }
+    p = skipSpace(p, end);
+    if (p < end && *p == '}') {
+        return skipSpace(p + 1, end) == end;
+    }
+    while (true) {
+        if (p == end || *p++ != '"') {
+            return false;
+        }
+        const char* key = p;
+        while (p < end && *p != '"' && *p != '\\') {
+            ++p;
+        }
+        if (p == end || *p != '"') {
+            return false;
+        }
+        Span keySpan{key, static_cast<std::size_t>(p - key)};
+        p = skipSpace(p + 1, end);
+        if (p == end || *p++ != ':') {
+            return false;
+        }
+        p = skipSpace(p, end);
+        if (p == end) {
+            return false;
+        }
+        Span value;
+        bool isString = *p == '"';
+        if (isString) {
+            const char* begin = ++p;
+            while (p < end && *p != '"' && *p != '\\') {
+                ++p;
+            }
+            if (p == end || *p != '"') {
+                return false;
+            }
+            value = Span{begin, static_cast<std::size_t>(p - begin)};
+            ++p;
+        } else {
+            const char* begin = p;
+            if (*p == '-') {
+                ++p;
+            }
+            while (p < end && *p >= '0' && *p <= '9') {
+                ++p;
+            }
+            value = Span{begin, static_cast<std::size_t>(p - begin)};
+        }
+        if (!field(keySpan, value, isString)) {
+            return false;
+        }
+        p = skipSpace(p, end);
+        if (p == end) {
+            return false;
+        }
+        if (*p == '}') {
+            return skipSpace(p + 1, end) == end;
+        }
+        if (*p++ != ',') {
+            return false;
+        }
+        p = skipSpace(p, end);
+    }
+}
+
+// 送信バッファへの書き出し
+struct Writer {
+    char* p;
+
+    void text(const char* literal) {
+        std::size_t size = std::strlen(literal);
+        std::memcpy(p, literal, size);
+        p += size;
+    }
+
+    void number(std::int64_t value) {
+        char digits[20];
+        std::uint64_t magnitude = static_cast<std::uint64_t>(value);
+        if (value < 0) {
+            *p++ = '-';
+            magnitude = 0 - magnitude;
+        }
+        int count = 0;
+        do {
+            digits[count++] = static_cast<char>('0' + magnitude % 10);
+            magnitude /= 10;
+        } while (magnitude > 0);
+        while (count > 0) {
+            *p++ = digits[--count];
+        }
+    }
+};
+
+const char* reasonPhrase(int status) {
+    switch (status) {
+    case 200: return "OK";
+    case 400: return "Bad Request";
+    case 404: return "Not Found";
+    case 405: return "Method Not Allowed";
+    case 409: return "Conflict";
+    case 413: return "Payload Too Large";
+    case 431: return "Request Header Fields Too Large";
+    case 501: return "Not Implemented";
+    }
+    return "Error";
+}
+
+int httpStatus(QuoteStatus status) {
+    switch (status) {
+    case QuoteStatus::Ok: return 200;
+    case QuoteStatus::NotFound: return 404;
+    case QuoteStatus::Rejected: return 409;
+    case QuoteStatus::BadRequest: return 400;
+    }
+    return 400;
+}
+
+const char* statusName(QuoteStatus status) {
+    switch (status) {
+    case QuoteStatus::Ok: return "ok";
+    case QuoteStatus::NotFound: return "not_found";
+    case QuoteStatus::Rejected: return "rejected";
+    case QuoteStatus::BadRequest: return "bad_request";
+    }
+    return "bad_request";
+}
+
+// 本文を書いてから、その長さでヘッダーを書く
+std::size_t writeResponse(int status, bool keepAlive, const char* name, bool hasFee, std::int64_t fee, char* out) {
+    char body[64];
+    Writer bodyWriter{body};
+    bodyWriter.text("{\"status\":\"");
+    bodyWriter.text(name);
+    bodyWriter.text("\"");
+    if (hasFee) {
+        bodyWriter.text(",\"fee\":");
+        bodyWriter.number(fee);
+    }
+    bodyWriter.text("}");
+    std::size_t bodySize = static_cast<std::size_t>(bodyWriter.p - body);
+
+    Writer writer{out};
+    writer.text("HTTP/1.1 ");
+    writer.number(status);
+    writer.text(" ");
+    writer.text(reasonPhrase(status));
+    writer.text("\r\nContent-Type: application/json\r\nContent-Length: ");
+    writer.number(static_cast<std::int64_t>(bodySize));
+    if (status == 405) {
+        writer.text("\r\nAllow: POST");
+    }
+    if (!keepAlive) {
+        writer.text("\r\nConnection: close");
+    }
+    writer.text("\r\n\r\n");
+    std::memcpy(writer.p, body, bodySize);
+    return static_cast<std::size_t>(writer.p - out) + bodySize;
+}
+
+// ヘッダーの終わり（空行の次）を探す。見つからなければnullptr
+const char* findHeaderEnd(const char* data, std::size_t size) {
+    const void* found = ::memmem(data, size, "\r\n\r\n", 4);
+    return found ? static_cast<const char*>(found) + 4 : nullptr;
+}
+
+struct HeaderFields {
+    bool hasContentLength = false;
+    std::uint64_t contentLength = 0;
+    bool chunked = false;
+    int connection = 0;  // 1: keep-alive, -1: close
+};
+
+// 開始行の次からヘッダーの各行を読む（不正な行があればfalse）
+bool parseHeaders(const char* p, const char* end, HeaderFields& fields) {
+    while (p < end) {
+        const char* lineEnd = static_cast<const char*>(std::memchr(p, '\r', static_cast<std::size_t>(end - p)));
+        if (!lineEnd || lineEnd + 1 >= end || lineEnd[1] != '\n') {
+            return false;
+        }
+        if (lineEnd == p) {
+            return true;  // 空行
+        }
+        const char* colon = static_cast<const char*>(std::memchr(p, ':', static_cast<std::size_t>(lineEnd - p)));
+        if (!colon || colon == p) {
+            return false;
+        }
+        Span name{p, static_cast<std::size_t>(colon - p)};
+        Span value = trim(colon + 1, lineEnd);
+        if (equalsIgnoreCase(name, "content-length")) {
+            std::uint64_t length;
+            if (!parseUnsigned(value, length) || (fields.hasContentLength && fields.contentLength != length)) {
+                return false;
+            }
+            fields.hasContentLength = true;
+            fields.contentLength = length;
+        } else if (equalsIgnoreCase(name, "transfer-encoding")) {
+            fields.chunked = true;
+        } else if (equalsIgnoreCase(name, "connection")) {
+            if (equalsIgnoreCase(value, "close")) {
+                fields.connection = -1;
+            } else if (equalsIgnoreCase(value, "keep-alive")) {
+                fields.connection = 1;
+            }
+        }
+        p = lineEnd + 2;
+    }
+    return true;
+}
+
+} // namespace
+
+bool parseQuoteJson(const char* data, std::size_t size, QuoteRequest& request) {
+    enum : unsigned { kLot = 1, kTicket = 2, kEntry = 4, kExit = 8 };
+    unsigned seen = 0;
+    std::uint64_t lotId = 0;
+    bool scanned = scanJsonObject(data, data + size, [&](Span key, Span value, bool isString) {
+        if (isString) {
+            return false;
+        }
+        unsigned bit;
+        bool parsed;
+        if (key == "lotId") {
+            bit = kLot;
+            parsed = parseUnsigned(value, lotId) && lotId <= std::numeric_limits<std::uint32_t>::max();
+        } else if (key == "ticketId") {
+            bit = kTicket;
+            parsed = parseUnsigned(value, request.ticketId);
+        } else if (key == "entryTime") {
+            bit = kEntry;
+            parsed = parseSigned(value, request.startTime);
+        } else if (key == "exitTime") {
+            bit = kExit;
+            parsed = parseSigned(value, request.endTime);
+        } else {
+            return false;
+        }
+        if (!parsed || (seen & bit)) {
+            return false;
+        }
+        seen |= bit;
+        return true;
+    });
+    if (!scanned) {
+        return false;
+    }
+    request.lotId = static_cast<std::uint32_t>(lotId);
+    switch (request.opcode) {
+    case QuoteOpcode::Quote:
+        return (seen & (kLot | kEntry | kExit)) == (kLot | kEntry | kExit);
+    case QuoteOpcode::Entry:
+        return (seen & (kLot | kTicket | kEntry)) == (kLot | kTicket | kEntry);
+    case QuoteOpcode::Exit:
+        return (seen & (kTicket | kExit)) == (kTicket | kExit);
+    }
+    return false;
+}
+
+HttpParseResult parseHttpQuoteRequest(const char* data, std::size_t size, HttpQuoteRequest& request,
+                                      std::size_t& consumed) {
+    request = HttpQuoteRequest();
+    request.quote = QuoteRequest{QuoteOpcode::Quote, 0, 0, 0, 0, 0};
+    std::size_t limit = size < kHttpQuoteMaxRequestBytes ? size : kHttpQuoteMaxRequestBytes;
+    const char* headerEnd = findHeaderEnd(data, limit);
+    if (!headerEnd) {
+        if (size >= kHttpQuoteMaxRequestBytes) {
+            request.errorStatus = 431;
+            request.keepAlive = false;
+            return HttpParseResult::Invalid;
+        }
+        return HttpParseResult::Incomplete;
+    }
+
+    // 開始行: メソッド SP パス SP バージョン
+    request.errorStatus = 400;
+    request.keepAlive = false;
+    const char* lineEnd = static_cast<const char*>(std::memchr(data, '\r', static_cast<std::size_t>(headerEnd - data)));
+    const char* methodEnd = static_cast<const char*>(std::memchr(data, ' ', static_cast<std::size_t>(lineEnd - data)));
+    const char* pathEnd =
+        methodEnd ? static_cast<const char*>(std::memchr(methodEnd + 1, ' ', static_cast<std::size_t>(lineEnd - methodEnd - 1)))
+                  : nullptr;
+    if (!pathEnd) {
+        return HttpParseResult::Invalid;
+    }
+    Span method{data, static_cast<std::size_t>(methodEnd - data)};
+    Span path{methodEnd + 1, static_cast<std::size_t>(pathEnd - methodEnd - 1)};
+    Span version{pathEnd + 1, static_cast<std::size_t>(lineEnd - pathEnd - 1)};
+    bool http11 = version == "HTTP/1.1";
+    if (!http11 && !(version == "HTTP/1.0")) {
+        return HttpParseResult::Invalid;
+    }
+
+    HeaderFields fields;
+    if (!parseHeaders(lineEnd + 2, headerEnd, fields)) {
+        return HttpParseResult::Invalid;
+    }
+    if (fields.chunked) {
+        request.errorStatus = 501;
+        return HttpParseResult::Invalid;
+    }
+    std::size_t headerBytes = static_cast<std::size_t>(headerEnd - data);
+    if (fields.contentLength > kMaxBodyBytes || headerBytes + fields.contentLength > kHttpQuoteMaxRequestBytes) {
+        request.errorStatus = 413;
+        return HttpParseResult::Invalid;
+    }
+    std::size_t total = headerBytes + static_cast<std::size_t>(fields.contentLength);
+    if (size < total) {
+        request.errorStatus = 0;
+        request.keepAlive = true;
+        return HttpParseResult::Incomplete;
+    }
+    consumed = total;
+    request.keepAlive = fields.connection == 0 ? http11 : fields.connection > 0;
+
+    // 宛先ごとの処理（要求の区切りは分かっているので、誤りは応答を返して続ける）
+    if (path == "/quote") {
+        request.quote.opcode = QuoteOpcode::Quote;
+    } else if (path == "/entry") {
+        request.quote.opcode = QuoteOpcode::Entry;
+    } else if (path == "/exit") {
+        request.quote.opcode = QuoteOpcode::Exit;
+    } else {
+        request.errorStatus = 404;
+        return HttpParseResult::Complete;
+    }
+    if (!(method == "POST")) {
+        request.errorStatus = 405;
+        return HttpParseResult::Complete;
+    }
+    if (!parseQuoteJson(headerEnd, static_cast<std::size_t>(fields.contentLength), request.quote)) {
+        request.errorStatus = 400;
+        return HttpParseResult::Complete;
+    }
+    request.errorStatus = 0;
+    return HttpParseResult::Complete;
+}
+
+std::size_t writeHttpQuoteResponse(const QuoteResponse& response, bool keepAlive, char* out) {
+    bool hasFee = response.status == QuoteStatus::Ok && response.opcode != QuoteOpcode::Entry;
+    return writeResponse(httpStatus(response.status), keepAlive, statusName(response.status), hasFee, response.fee,
+                         out);
+}
+
+std::size_t writeHttpErrorResponse(int status, bool keepAlive, char* out) {
+    const char* name;
+    switch (status) {
+    case 404: name = "not_found"; break;
+    case 405: name = "method_not_allowed"; break;
+    case 413: case 431: name = "too_large"; break;
+    case 501: name = "not_implemented"; break;
+    default: name = "bad_request"; break;
+    }
+    return writeResponse(status, keepAlive, name, false, 0, out);
+}
+
+HttpParseResult parseHttpQuoteResponse(const char* data, std::size_t size, HttpQuoteResponse& response,
+                                       std::size_t& consumed) {
+    response = HttpQuoteResponse();
+    const char* headerEnd = findHeaderEnd(data, size);
+    if (!headerEnd) {
+        return size >= kHttpQuoteMaxRequestBytes ? HttpParseResult::Invalid : HttpParseResult::Incomplete;
+    }
+    // 開始行: HTTP/1.1 SP ステータス SP 理由
+    const char* lineEnd = static_cast<const char*>(std::memchr(data, '\r', static_cast<std::size_t>(headerEnd - data)));
+    std::uint64_t status;
+    if (lineEnd - data < 12 || std::memcmp(data, "HTTP/1.", 7) != 0 || !parseUnsigned(Span{data + 9, 3}, status)) {
+        return HttpParseResult::Invalid;
+    }
+    HeaderFields fields;
+    if (!parseHeaders(lineEnd + 2, headerEnd, fields) || !fields.hasContentLength) {
+        return HttpParseResult::Invalid;
+    }
+    std::size_t total = static_cast<std::size_t>(headerEnd - data) + static_cast<std::size_t>(fields.contentLength);
+    if (size < total) {
+        return HttpParseResult::Incomplete;
+    }
+    response.status = static_cast<int>(status);
+    response.keepAlive = fields.connection >= 0;
+    bool scanned = scanJsonObject(headerEnd, data + total, [&](Span key, Span value, bool isString) {
+        if (key == "status" && isString) {
+            response.quoteStatus = value == "ok"          ? QuoteStatus::Ok
+                                   : value == "not_found" ? QuoteStatus::NotFound
+                                   : value == "rejected"  ? QuoteStatus::Rejected
+                                                          : QuoteStatus::BadRequest;
+            return true;
+        }
+        if (key == "fee" && !isString) {
+            response.hasFee = true;
+            return parseSigned(value, response.fee);
+        }
+        return false;
+    });
+    if (!scanned) {
+        return HttpParseResult::Invalid;
+    }
+    consumed = total;
+    return HttpParseResult::Complete;
+}
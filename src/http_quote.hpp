@@ -0,0 +1,60 @@
+#ifndef HTTP_QUOTE_HPP
+#define HTTP_QUOTE_HPP
+
+#include "quote_protocol.hpp"
+#include <cstddef>
+#include <cstdint>
+
+// 料金見積もりの HTTP/1.1 + JSON 版（キオスク・精算機向け）
+//
+//   POST /quote  {"lotId":1,"entryTime":1704420000,"exitTime":1704510000}  → {"status":"ok","fee":5000}
+//   POST /entry  {"lotId":1,"ticketId":1001,"entryTime":1704420000}        → {"status":"ok"}
+//   POST /exit   {"ticketId":1001,"exitTime":1704510000}                   → {"status":"ok","fee":5000}
+//
+// - 時刻はエポック秒。項目の順は問わないが、決まった項目以外（入れ子・小数・エスケープを含む）は受け付けない
+// - 持続的接続が既定（Connection: close か HTTP/1.0 で閉じる）。応答を待たずに続けて送ってよく、応答は要求の順に返る
+// - 解析・書き出しともメモリを確保しない（受信バッファを直接読み、送信バッファに直接書く）
+// - 状態と HTTP ステータス: ok 200 / not_found 404 / rejected 409 / bad_request 400
+
+// 1つの要求（ヘッダーと本文）の上限。超える要求は 413 で接続を閉じる
+constexpr std::size_t kHttpQuoteMaxRequestBytes = 4096;
+// 1つの応答の上限
+constexpr std::size_t kHttpQuoteMaxResponseBytes = 256;
+
+enum class HttpParseResult {
+    Complete,    // 1つの要求・応答を解析した
+    Incomplete,  // データが足りない
+    Invalid,     // 区切りが分からない（応答を返して接続を閉じる）
+};
+
+struct HttpQuoteRequest {
+    QuoteRequest quote;    // errorStatus が0のときの要求
+    int errorStatus = 0;   // 0以外なら料金計算せずにこのステータスで応答する（404・405・400）
+    bool keepAlive = true;
+};
+
+// data の先頭の要求を解析する（Complete なら consumed にその長さ）
+// Invalid のときは errorStatus に応答するステータス（400・413・501）を設定する
+HttpParseResult parseHttpQuoteRequest(const char* data, std::size_t size, HttpQuoteRequest& request,
+                                      std::size_t& consumed);
+
+// 本文の JSON を解析する（opcode ごとに必要な項目がなければfalse）
+bool parseQuoteJson(const char* data, std::size_t size, QuoteRequest& request);
+
+// 応答を out に書き、書いたバイト数を返す（kHttpQuoteMaxResponseBytes 以下）
+std::size_t writeHttpQuoteResponse(const QuoteResponse& response, bool keepAlive, char* out);
+std::size_t writeHttpErrorResponse(int status, bool keepAlive, char* out);
+
+// 応答の解析（テスト・負荷生成用）
+struct HttpQuoteResponse {
+    int status = 0;
+    QuoteStatus quoteStatus = QuoteStatus::Ok;
+    bool hasFee = false;
+    std::int64_t fee = 0;
+    bool keepAlive = true;
+};
+
+HttpParseResult parseHttpQuoteResponse(const char* data, std::size_t size, HttpQuoteResponse& response,
+                                       std::size_t& consumed);
+
+#endif // HTTP_QUOTE_HPP
@@ -0,0 +1,131 @@
+#include "io_uring_queue.hpp"
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+
+namespace {
+
+int setup(unsigned entries, io_uring_params& params) {
+    return static_cast<int>(::syscall(__NR_io_uring_setup, entries, &params));
+}
+
+int enter(int fd, unsigned submitCount, unsigned waitCount, unsigned flags) {
+    return static_cast<int>(::syscall(__NR_io_uring_enter, fd, submitCount, waitCount, flags, nullptr, 0));
+}
+
+void* mapRing(int fd, std::size_t bytes, off_t offset) {
+    void* ring = ::mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, offset);
+    return ring == MAP_FAILED ? nullptr : ring;
+}
+
+template <typename T>
+T* at(void* base, std::uint32_t offset) {
+    return reinterpret_cast<T*>(static_cast<char*>(base) + offset);
+}
+
+} // namespace
+
+IoUringQueue::~IoUringQueue() {
+    close();
+}
+
+bool IoUringQueue::open(unsigned entries) {
+    close();
+    io_uring_params params;
+    std::memset(&params, 0, sizeof(params));
+    fd_ = setup(entries, params);
+    if (fd_ < 0) {
+        fd_ = -1;
+        return false;
+    }
+
+    sqRingBytes_ = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+    cqRingBytes_ = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+    bool singleMap = (params.features & IORING_FEAT_SINGLE_MMAP) != 0;
+    if (singleMap) {
+        sqRingBytes_ = cqRingBytes_ = std::max(sqRingBytes_, cqRingBytes_);
+    }
+    sqRing_ = mapRing(fd_, sqRingBytes_, IORING_OFF_SQ_RING);
+    cqRing_ = singleMap ? sqRing_ : mapRing(fd_, cqRingBytes_, IORING_OFF_CQ_RING);
+    sqesBytes_ = params.sq_entries * sizeof(io_uring_sqe);
+    sqes_ = static_cast<io_uring_sqe*>(mapRing(fd_, sqesBytes_, IORING_OFF_SQES));
+    if (!sqRing_ || !cqRing_ || !sqes_) {
+        close();
+        return false;
+    }
+
+    sqHead_ = at<unsigned>(sqRing_, params.sq_off.head);
+    sqTail_ = at<unsigned>(sqRing_, params.sq_off.tail);
+    sqArray_ = at<unsigned>(sqRing_, params.sq_off.array);
+    sqMask_ = *at<unsigned>(sqRing_, params.sq_off.ring_mask);
+    sqEntries_ = *at<unsigned>(sqRing_, params.sq_off.ring_entries);
+    sqeTail_ = *sqTail_;
+    cqHead_ = at<unsigned>(cqRing_, params.cq_off.head);
+    cqTail_ = at<unsigned>(cqRing_, params.cq_off.tail);
+    cqes_ = at<io_uring_cqe>(cqRing_, params.cq_off.cqes);
+    cqMask_ = *at<unsigned>(cqRing_, params.cq_off.ring_mask);
+    enterCount_ = 0;
+    return true;
+}
+
+void IoUringQueue::close() {
+    if (sqes_) {
+        ::munmap(sqes_, sqesBytes_);
+    }
+    if (cqRing_ && cqRing_ != sqRing_) {
+        ::munmap(cqRing_, cqRingBytes_);
+    }
+    if (sqRing_) {
+        ::munmap(sqRing_, sqRingBytes_);
+    }
+    if (fd_ >= 0) {
+        ::close(fd_);  // 実行中の要求は取り消される
+    }
+    fd_ = -1;
+    sqRing_ = cqRing_ = nullptr;
+    sqes_ = nullptr;
+}
+
+bool IoUringQueue::registerBuffers(const iovec* buffers, unsigned count) {
+    return ::syscall(__NR_io_uring_register, fd_, IORING_REGISTER_BUFFERS, buffers, count) == 0;
+}
+
+io_uring_sqe* IoUringQueue::getSqe() {
+    unsigned head = __atomic_load_n(sqHead_, __ATOMIC_ACQUIRE);
+    if (sqeTail_ - head >= sqEntries_) {
+        return nullptr;
+    }
+    io_uring_sqe* sqe = &sqes_[sqeTail_ & sqMask_];
+    std::memset(sqe, 0, sizeof(*sqe));
+    ++sqeTail_;
+    return sqe;
+}
+
+int IoUringQueue::submitAndWait(unsigned waitCount) {
+    // 投入エントリの並びは取った順のまま公開する
+    unsigned tail = *sqTail_;
+    unsigned submitCount = sqeTail_ - tail;
+    for (; tail != sqeTail_; ++tail) {
+        sqArray_[tail & sqMask_] = tail & sqMask_;
+    }
+    __atomic_store_n(sqTail_, sqeTail_, __ATOMIC_RELEASE);
+    if (submitCount == 0 && waitCount == 0) {
+        return 0;
+    }
+    ++enterCount_;
+    int result = enter(fd_, submitCount, waitCount, waitCount > 0 ? IORING_ENTER_GETEVENTS : 0);
+    return result < 0 ? -errno : result;
+}
+
+bool IoUringQueue::peek(io_uring_cqe& completion) {
+    unsigned head = *cqHead_;
+    if (head == __atomic_load_n(cqTail_, __ATOMIC_ACQUIRE)) {
+        return false;
+    }
+    completion = cqes_[head & cqMask_];
+    __atomic_store_n(cqHead_, head + 1, __ATOMIC_RELEASE);
+    return true;
+}
@@ -0,0 +1,69 @@
+#ifndef IO_URING_QUEUE_HPP
+#define IO_URING_QUEUE_HPP
+
+#include <linux/io_uring.h>
+#include <sys/uio.h>
+#include <cstddef>
+#include <cstdint>
+
+// io_uring の投入キュー・完了キュー（liburing を使わず、システムコールを直接呼ぶ最小限のラッパー）
+//
+// - getSqe で取った投入エントリに内容を書き、submit / submitAndWait でまとめて投入する
+//   （何件積んでも io_uring_enter は1回）
+// - 完了は peek で1件ずつ取り出す（システムコールなし）
+// - 1つのスレッドから使うこと
+class IoUringQueue {
+public:
+    IoUringQueue() = default;
+    ~IoUringQueue();
+
+    IoUringQueue(const IoUringQueue&) = delete;
+    IoUringQueue& operator=(const IoUringQueue&) = delete;
+
+    // entries 件の投入キューを作る（カーネルが対応していない・無効にされている場合はfalse）
+    bool open(unsigned entries);
+    void close();
+    bool isOpen() const { return fd_ >= 0; }
+
+    // バッファを登録する（IORING_OP_READ_FIXED / WRITE_FIXED の buf_index で指す）
+    // ロックされるメモリとして RLIMIT_MEMLOCK に数えられる
+    bool registerBuffers(const iovec* buffers, unsigned count);
+
+    // 空いている投入エントリ（0埋め済み）。キューが一杯ならnullptr
+    io_uring_sqe* getSqe();
+
+    // 積んだエントリを投入し、waitCount 件以上の完了を待つ（投入した件数か -errno を返す）
+    int submitAndWait(unsigned waitCount);
+    int submit() { return submitAndWait(0); }
+
+    // 完了を1件取り出す（なければfalse）
+    bool peek(io_uring_cqe& completion);
+
+    // io_uring_enter を呼んだ回数
+    std::uint64_t enterCount() const { return enterCount_; }
+
+private:
+    int fd_ = -1;
+    void* sqRing_ = nullptr;
+    std::size_t sqRingBytes_ = 0;
+    void* cqRing_ = nullptr;  // SQ と同じ領域なら sqRing_ と同じ
+    std::size_t cqRingBytes_ = 0;
+    io_uring_sqe* sqes_ = nullptr;
+    std::size_t sqesBytes_ = 0;
+
+    unsigned* sqHead_ = nullptr;
+    unsigned* sqTail_ = nullptr;
+    unsigned* sqArray_ = nullptr;
+    unsigned sqMask_ = 0;
+    unsigned sqEntries_ = 0;
+    unsigned sqeTail_ = 0;       // getSqe で取った分まで（submit で sqTail_ に公開する）
+
+    unsigned* cqHead_ = nullptr;
+    unsigned* cqTail_ = nullptr;
+    io_uring_cqe* cqes_ = nullptr;
+    unsigned cqMask_ = 0;
+
+    std::uint64_t enterCount_ = 0;
+};
+
+#endif // IO_URING_QUEUE_HPP
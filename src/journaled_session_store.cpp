@@ -0,0 +1,209 @@
+#include "journaled_session_store.hpp"
+#include "session_snapshot.hpp"
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+
+JournaledSessionStore::JournaledSessionStore(std::size_t shardCount, std::size_t expectedSessions)
+    : sessions_(shardCount, expectedSessions), revenue_(sessions_.shardCount()) {}
+
+JournaledSessionStore::~JournaledSessionStore() {
+    close();
+}
+
+bool JournaledSessionStore::addLot(std::uint32_t lotId, const StayPricingEngine& pricing) {
+    return sessions_.addLot(lotId, pricing);
+}
+
+bool JournaledSessionStore::open(const std::string& directory, const SessionEventLogOptions& options,
+                                 const SessionSnapshotOptions& snapshotOptions) {
+    close();
+    directory_ = directory;
+    snapshotOptions_ = snapshotOptions;
+    revenue_.assign(sessions_.shardCount(),
+                    RevenueCounters(snapshotOptions.revenueDays, snapshotOptions.utcOffsetSeconds));
+    restoredSequence_ = 0;
+    replayedEvents_ = 0;
+
+    // 最新のスナップショットを読み込む（ログを開く前なのでディレクトリがなければスナップショットもない）
+    SessionSnapshot snapshot;
+    if (!loadLatestSessionSnapshot(directory, snapshot)) {
+        return false;
+    }
+    for (const OpenSession& session : snapshot.sessions) {
+        if (!sessions_.entry(session.ticketId, session.lotId, session.entryTime)) {
+            std::cerr << "Session snapshot has an invalid session: " << session.ticketId << std::endl;
+            return false;
+        }
+    }
+    for (const DailyRevenue& daily : snapshot.revenue) {
+        revenue_.front().merge(daily);
+    }
+    restoredSequence_ = snapshot.sequence;
+
+    // スナップショットに反映されていないイベントだけを再生する
+    // （シャードを1つずつ複製したので、sequence より後でも反映済みのシャードがある）
+    bool opened = log_.open(directory, options, [this, &snapshot](const SessionEvent& event) {
+        return snapshot.covers(event.sequence, event.ticketId) || replay(event);
+    });
+    if (!opened) {
+        return false;
+    }
+    std::uint64_t coveredSequence = restoredSequence_;
+    for (std::uint64_t sequence : snapshot.shardSequences) {
+        coveredSequence = std::max(coveredSequence, sequence);
+    }
+    if (log_.firstSequence() > restoredSequence_ + 1 || log_.nextSequence() <= coveredSequence) {
+        std::cerr << "Session log does not continue from snapshot " << restoredSequence_ << ": " << directory
+                  << std::endl;
+        log_.close();
+        return false;
+    }
+    {
+        std::lock_guard<std::mutex> lock(snapshotMutex_);
+        snapshotSequence_ = restoredSequence_;
+    }
+
+    if (snapshotOptions.intervalMs > 0) {
+        stopping_ = false;
+        snapshotThread_ = std::thread(&JournaledSessionStore::runSnapshots, this);
+    }
+    return true;
+}
+
+void JournaledSessionStore::close() {
+    if (snapshotThread_.joinable()) {
+        {
+            std::lock_guard<std::mutex> lock(stopMutex_);
+            stopping_ = true;
+        }
+        stopRequested_.notify_all();
+        snapshotThread_.join();
+    }
+    log_.close();
+}
+
+void JournaledSessionStore::runSnapshots() {
+    std::unique_lock<std::mutex> lock(stopMutex_);
+    while (!stopRequested_.wait_for(lock, std::chrono::milliseconds(snapshotOptions_.intervalMs),
+                                    [this] { return stopping_; })) {
+        lock.unlock();
+        snapshot();
+        lock.lock();
+    }
+}
+
+bool JournaledSessionStore::replay(const SessionEvent& event) {
+    ++replayedEvents_;
+    RevenueCounters& revenue = revenue_[sessions_.shardIndex(event.ticketId)];
+    switch (event.type) {
+    case SessionEventType::Entry:
+        return sessions_.entry(event.ticketId, event.lotId, event.time);
+    case SessionEventType::Exit:
+        revenue.addExit(event.lotId, event.time, event.amount);
+        return sessions_.erase(event.ticketId);
+    case SessionEventType::Payment:
+        revenue.addPayment(event.lotId, event.time, event.amount);
+        return true;
+    }
+    return false;
+}
+
+bool JournaledSessionStore::entry(std::uint64_t ticketId, std::uint32_t lotId, std::int64_t entryTime) {
+    std::uint64_t sequence = sessions_.withShard(ticketId, [&](SessionStore& sessions) -> std::uint64_t {
+        if (!sessions.entry(ticketId, lotId, entryTime)) {
+            return 0;
+        }
+        return log_.append(SessionEventType::Entry, ticketId, lotId, entryTime);
+    });
+    return sequence != 0 && log_.commit(sequence);
+}
+
+bool JournaledSessionStore::exit(std::uint64_t ticketId, std::int64_t exitTime, ClosedSession& closed) {
+    std::uint64_t sequence = sessions_.withShard(ticketId, [&](SessionStore& sessions) -> std::uint64_t {
+        if (!sessions.exit(ticketId, exitTime, closed)) {
+            return 0;
+        }
+        revenue_[sessions_.shardIndex(ticketId)].addExit(closed.lotId, exitTime, closed.fee);
+        return log_.append(SessionEventType::Exit, ticketId, closed.lotId, exitTime, closed.fee);
+    });
+    return sequence != 0 && log_.commit(sequence);
+}
+
+bool JournaledSessionStore::pay(std::uint64_t ticketId, std::int64_t time, std::int64_t amount) {
+    std::uint64_t sequence = sessions_.withShard(ticketId, [&](SessionStore& sessions) -> std::uint64_t {
+        OpenSession session;
+        if (!sessions.find(ticketId, session)) {
+            return 0;
+        }
+        revenue_[sessions_.shardIndex(ticketId)].addPayment(session.lotId, time, amount);
+        return log_.append(SessionEventType::Payment, ticketId, session.lotId, time, amount);
+    });
+    return sequence != 0 && log_.commit(sequence);
+}
+
+std::vector<DailyRevenue> JournaledSessionStore::revenue() const {
+    RevenueCounters merged(snapshotOptions_.revenueDays, snapshotOptions_.utcOffsetSeconds);
+    sessions_.withAllShards([&](std::size_t index, const SessionStore&) {
+        for (const DailyRevenue& daily : revenue_[index].list()) {
+            merged.merge(daily);
+        }
+    });
+    return merged.list();
+}
+
+bool JournaledSessionStore::snapshot() {
+    std::lock_guard<std::mutex> guard(snapshotMutex_);
+    if (!log_.isOpen()) {
+        return false;
+    }
+
+    // シャードを1つずつロックして複製し、他のシャードの入出庫は止めない。
+    // 追記はシャードのロック内で行うので、ロック中に読んだ通し番号までのそのシャードのイベントが
+    // ちょうど複製に反映されている。シャードごとの通し番号を記録し、再生時に反映済みのイベントを飛ばす
+    SessionSnapshot snapshot;
+    RevenueCounters merged(snapshotOptions_.revenueDays, snapshotOptions_.utcOffsetSeconds);
+    // 複製中に入庫が増えても、ロック内で配列を確保し直さないように余裕を持たせる
+    snapshot.sessions.reserve(sessions_.size() + sessions_.size() / 8 + 1024);
+    snapshot.shardSequences.resize(sessions_.shardCount());
+    double longestLockMs = 0;
+    for (std::size_t index = 0; index < sessions_.shardCount(); ++index) {
+        std::vector<DailyRevenue> daily;
+        sessions_.withShardAt(index, [&](const SessionStore& sessions) {
+            auto lockedAt = std::chrono::steady_clock::now();
+            snapshot.shardSequences[index] = log_.nextSequence() - 1;
+            sessions.collect(snapshot.sessions);
+            daily = revenue_[index].list();
+            longestLockMs = std::max(
+                longestLockMs, std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - lockedAt).count());
+        });
+        for (const DailyRevenue& entry : daily) {
+            merged.merge(entry);
+        }
+    }
+    lastSnapshotLockMs_ = longestLockMs;
+    snapshot.sequence = snapshot.shardSequences.front();
+    if (snapshot.sequence == snapshotSequence_) {
+        return true;
+    }
+    snapshot.revenue = merged.list();
+
+    // スナップショットが指す通し番号までのログを先に永続化する（再起動後の通し番号が戻らないように）
+    if (!log_.sync() || !writeSessionSnapshot(directory_, snapshot)) {
+        return false;
+    }
+    snapshotSequence_ = snapshot.sequence;
+    removeSessionSnapshotsBefore(directory_, snapshot.sequence);
+    log_.truncateBefore(snapshot.sequence + 1);
+    return true;
+}
+
+std::uint64_t JournaledSessionStore::snapshotSequence() const {
+    std::lock_guard<std::mutex> lock(snapshotMutex_);
+    return snapshotSequence_;
+}
+
+double JournaledSessionStore::lastSnapshotLockMs() const {
+    std::lock_guard<std::mutex> lock(snapshotMutex_);
+    return lastSnapshotLockMs_;
+}
@@ -0,0 +1,100 @@
+#ifndef JOURNALED_SESSION_STORE_HPP
+#define JOURNALED_SESSION_STORE_HPP
+
+#include "revenue_counters.hpp"
+#include "session_event_log.hpp"
+#include "sharded_session_store.hpp"
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// スナップショットと売上集計の設定
+struct SessionSnapshotOptions {
+    int intervalMs = 0;                           // バックグラウンドで取る間隔（0なら snapshot() を呼んだときだけ）
+    int revenueDays = 31;                         // 日ごとの売上を保持する日数
+    int utcOffsetSeconds = kJstUtcOffsetSeconds;  // 売上を集計する日の区切り
+};
+
+// 入出庫をイベントログに記録し、再起動しても入庫中のセッションを失わないセッション管理（スレッドセーフ）
+//
+// - entry / exit / pay はセッションを更新した後、同じシャードのロック内でイベントを追記し、
+//   ロックを外してからコミットを待つ（複数のゲートのコミットはまとめて書かれる）
+// - 出庫の料金・精算額は日ごとの売上（シャードごと）にも加える
+// - snapshot は入庫中のセッションと売上をファイルに書き出し、反映済みのログのセグメントを削除する
+// - open は最新のスナップショットを読み込んでから、それより後のログだけを再生する
+//   （出庫は料金を計算し直さずに閉じる）。復元にかかる時間はスナップショットの大きさとログの残りで決まる
+// - コミットに失敗した場合はfalseを返す。メモリ上の更新は戻さないので、呼び出し側はゲートを止めること
+class JournaledSessionStore {
+public:
+    explicit JournaledSessionStore(std::size_t shardCount = 64, std::size_t expectedSessions = 1024);
+    ~JournaledSessionStore();
+
+    JournaledSessionStore(const JournaledSessionStore&) = delete;
+    JournaledSessionStore& operator=(const JournaledSessionStore&) = delete;
+
+    // 駐車場の料金体系を登録（ログの再生に必要なので open より前に登録する）
+    bool addLot(std::uint32_t lotId, const StayPricingEngine& pricing);
+
+    // スナップショットとログを読み込んで再生する（記録と矛盾する場合はfalse）
+    bool open(const std::string& directory, const SessionEventLogOptions& options = SessionEventLogOptions(),
+              const SessionSnapshotOptions& snapshotOptions = SessionSnapshotOptions());
+    void close();
+
+    bool entry(std::uint64_t ticketId, std::uint32_t lotId, std::int64_t entryTime);
+    bool exit(std::uint64_t ticketId, std::int64_t exitTime, ClosedSession& closed);
+
+    // 入庫中のセッションの精算を記録（入庫中でなければfalse）
+    bool pay(std::uint64_t ticketId, std::int64_t time, std::int64_t amount);
+
+    bool find(std::uint64_t ticketId, OpenSession& session) const { return sessions_.find(ticketId, session); }
+    std::size_t size() const { return sessions_.size(); }
+
+    // 日ごとの売上（日付・駐車場の順）
+    std::vector<DailyRevenue> revenue() const;
+
+    // 現時点のスナップショットを書き出し、反映済みのログのセグメントと古いスナップショットを削除する
+    // シャードを1つずつロックして複製するので、入出庫が止まるのはそのシャードを複製する間だけ
+    bool snapshot();
+
+    // open で読み込んだスナップショットの通し番号（シャードごとの最小値）・再生したイベント数
+    std::uint64_t restoredSequence() const { return restoredSequence_; }
+    std::uint64_t replayedEvents() const { return replayedEvents_; }
+
+    // 最後に書き出したスナップショットの通し番号（シャードごとの最小値。なければ0）
+    std::uint64_t snapshotSequence() const;
+
+    // 最後の snapshot() で1つのシャードのロックを持っていた最長の時間（ミリ秒）
+    double lastSnapshotLockMs() const;
+
+    SessionEventLog& log() { return log_; }
+
+private:
+    bool replay(const SessionEvent& event);
+    void runSnapshots();
+
+    ShardedSessionStore sessions_;
+    SessionEventLog log_;
+    std::string directory_;
+    SessionSnapshotOptions snapshotOptions_;
+
+    // シャードごとの売上（そのシャードのロック内で更新する）
+    std::vector<RevenueCounters> revenue_;
+
+    std::uint64_t restoredSequence_ = 0;
+    std::uint64_t replayedEvents_ = 0;
+
+    mutable std::mutex snapshotMutex_;  // snapshot() の同時実行を防ぐ
+    std::uint64_t snapshotSequence_ = 0;
+    double lastSnapshotLockMs_ = 0;
+
+    std::mutex stopMutex_;
+    std::condition_variable stopRequested_;
+    bool stopping_ = false;
+    std::thread snapshotThread_;
+};
+
+#endif // JOURNALED_SESSION_STORE_HPP
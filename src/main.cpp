@@ -1,7 +1,145 @@
+// 料金見積もりサーバー
+//
+//   hello_world [--port N] [--http-port N] [--unix PATH] [--threads N] [--lots N] [--db PATH]
+//               [--backend epoll|io_uring]
+//
+// --port   TCPのポート（既定 7070、-1でTCPを使わない）
+// --http-port HTTP/1.1 + JSON で受け付けるTCPのポート（既定は受け付けない）
+// --unix   Unixドメインソケットのパス
+// --threads リアクターの数（既定はCPUの数）
+// --lots   受け付ける駐車場の番号 1..N（既定 1、全て同じ料金体系）
+// --db     料金設定のDB（"weekday" / "holiday" の設定を使う。なければ既定の料金）
+// --backend 受信・送信の仕組み（既定 epoll。io_uring が使えなければ epoll）
+//
+// SIGINT / SIGTERM で終了する
+#include "parking_lot.hpp"
+#include "parking_rate_repository.hpp"
+#include "quote_server.hpp"
+#include <csignal>
+#include <cstdlib>
+#include <cstring>
 #include <iostream>
+#include <pthread.h>
 
-int main() {
-    std::cout << "Hello, World!" << std::endl;
-    return 0;
+namespace {
+
+void usage() {
+    std::cerr << "usage: hello_world [--port N] [--http-port N] [--unix PATH] [--threads N] [--lots N]"
+                 " [--db PATH] [--backend epoll|io_uring]"
+              << std::endl;
+}
+
+// DBの料金設定で平日・休日の料金体系を置き換える（ない種別は既定のまま）
+bool loadDayTariffs(const std::string& dbPath, DayTariffs& tariffs) {
+    auto repository = createSQLiteRepository(dbPath);
+    if (!repository) {
+        return false;
+    }
+    ParkingRateConfig config;
+    if (repository->load("weekday", config)) {
+        tariffs[DayKind::Weekday] = makeTariff(config);
+    }
+    if (repository->load("holiday", config)) {
+        tariffs[DayKind::Holiday] = makeTariff(config);
+    }
+    return true;
 }
 
+} // namespace
+
+int main(int argc, char** argv) {
+    QuoteServerOptions options;
+    options.tcpPort = 7070;
+    options.bindAddress = "0.0.0.0";
+    int httpPort = -1;
+    long lots = 1;
+    std::string dbPath;
+    for (int i = 1; i < argc; ++i) {
+        const char* name = argv[i];
+        if (i + 1 >= argc) {
+            usage();
+            return 1;
+        }
+        const char* value = argv[++i];
+        if (std::strcmp(name, "--port") == 0) {
+            options.tcpPort = std::atoi(value);
+        } else if (std::strcmp(name, "--http-port") == 0) {
+            httpPort = std::atoi(value);
+        } else if (std::strcmp(name, "--unix") == 0) {
+            options.unixPath = value;
+        } else if (std::strcmp(name, "--threads") == 0) {
+            options.reactorCount = static_cast<std::size_t>(std::atol(value));
+        } else if (std::strcmp(name, "--lots") == 0) {
+            lots = std::atol(value);
+        } else if (std::strcmp(name, "--db") == 0) {
+            dbPath = value;
+        } else if (std::strcmp(name, "--backend") == 0 && std::strcmp(value, "epoll") == 0) {
+            options.backend = QuoteServerBackend::Epoll;
+        } else if (std::strcmp(name, "--backend") == 0 && std::strcmp(value, "io_uring") == 0) {
+            options.backend = QuoteServerBackend::IoUring;
+        } else {
+            usage();
+            return 1;
+        }
+    }
+    if (lots < 1 || lots >= static_cast<long>(SessionStore::kMaxLots)) {
+        std::cerr << "Invalid lot count: " << lots << std::endl;
+        return 1;
+    }
+
+    DayTariffs tariffs = kDefaultDayTariffs;
+    if (!dbPath.empty() && !loadDayTariffs(dbPath, tariffs)) {
+        std::cerr << "Can't open rate DB: " << dbPath << std::endl;
+        return 1;
+    }
+    StayPricingEngine pricing(tariffs);
+    QuoteService service(256, 1 << 20);
+    for (long lot = 1; lot <= lots; ++lot) {
+        service.addLot(static_cast<std::uint32_t>(lot), pricing);
+    }
+
+    // リアクターのスレッドがシグナルを受けないよう、起動前に止めておいて sigwait で待つ
+    sigset_t signals;
+    sigemptyset(&signals);
+    sigaddset(&signals, SIGINT);
+    sigaddset(&signals, SIGTERM);
+    pthread_sigmask(SIG_BLOCK, &signals, nullptr);
+
+    // HTTP は同じ QuoteService を別のリアクターで受け付ける（--port -1 なら HTTP だけ）
+    QuoteServer server(service);
+    QuoteServer httpServer(service);
+    if ((options.tcpPort >= 0 || !options.unixPath.empty() || httpPort < 0) && !server.start(options)) {
+        return 1;
+    }
+    if (httpPort >= 0) {
+        QuoteServerOptions httpOptions = options;
+        httpOptions.tcpPort = httpPort;
+        httpOptions.unixPath.clear();
+        httpOptions.protocol = QuoteServerProtocol::Http;
+        if (!httpServer.start(httpOptions)) {
+            server.stop();
+            return 1;
+        }
+    }
+    const QuoteServer& first = server.isRunning() ? server : httpServer;
+    std::cout << "quote server: " << first.reactorCount() << " reactors ("
+              << (first.backend() == QuoteServerBackend::IoUring ? "io_uring" : "epoll") << ")";
+    if (server.tcpPort() >= 0) {
+        std::cout << ", tcp " << options.bindAddress << ":" << server.tcpPort();
+    }
+    if (!options.unixPath.empty()) {
+        std::cout << ", unix " << options.unixPath;
+    }
+    if (httpServer.isRunning()) {
+        std::cout << ", http " << options.bindAddress << ":" << httpServer.tcpPort();
+    }
+    std::cout << std::endl;
+
+    int received = 0;
+    sigwait(&signals, &received);
+    std::uint64_t served = server.requestCount() + httpServer.requestCount();
+    httpServer.stop();
+    server.stop();
+    std::cout << "served " << served << " requests" << std::endl;
+    return 0;
+}
@@ -1,42 +1,35 @@
 #include "parking_lot.hpp"
-#include <cmath>
-#include <algorithm>
 
 // 基底クラスの実装
 ParkingLot::ParkingLot()
-    : unitMinutes_(60), unitPrice_(500), maxMinutes_(0), maxFee_(0),
-      nightUnitMinutes_(60), nightUnitPrice_(300), nightMaxMinutes_(0), nightMaxFee_(0) {
+    : tariff_{{60, 500, 0, 0}, {60, 300, 0, 0}} {
 }
 
 ParkingLot::ParkingLot(int unitMinutes, int unitPrice)
-    : unitMinutes_(unitMinutes), unitPrice_(unitPrice), maxMinutes_(0), maxFee_(0) {
+    : tariff_{{unitMinutes, unitPrice, 0, 0}, {0, 0, 0, 0}} {
+}
+
+void ParkingLot::applyTariff(const Tariff& tariff) {
+    tariff_ = tariff;
+}
+
+FeeRate ParkingLot::daytimeRate() const {
+    return tariff_.daytime;
+}
+
+FeeRate ParkingLot::nighttimeRate() const {
+    return tariff_.nighttime;
 }
 
 int ParkingLot::calculateBaseFee(int minutes) {
-    // 単位時間数（切り上げ）を計算
-    int units = static_cast<int>(std::ceil(static_cast<double>(minutes) / unitMinutes_));
-    return units * unitPrice_;
+    // 単位時間数（切り上げ）は整数演算で計算する
+    return calculateRateBaseFee(minutes, daytimeRate());
 }
 
 int ParkingLot::calculateFeeInternal(int minutes) {
-    int baseFee = calculateBaseFee(minutes);
-    
-    // 最大料金が設定されている場合のみ最大料金を考慮
-    if (maxMinutes_ > 0) {
-        // 最大時間ちょうどまたは超えている場合は最大料金を適用
-        if (minutes >= maxMinutes_) {
-            return maxFee_;
-        }
-        // 最大時間未満の場合、通常料金が最大料金を超えている場合のみ最大料金を適用
-        // ただし、100分のような短い時間の場合は通常料金を返す（要件による）
-        // 300分以上の場合のみ最大料金を適用
-        if (minutes >= 300 && baseFee > maxFee_) {
-            return maxFee_;
-        }
-        return baseFee;
-    }
-    
-    return baseFee;
+    // 最大料金の適用条件（最大時間以上、または300分以上で通常料金が最大料金超過）は
+    // 日中・夜間共通のカーネルで判定する
+    return calculateRateFee(minutes, daytimeRate());
 }
 
 int ParkingLot::calculateFee(int minutes) {
@@ -71,28 +64,11 @@ bool ParkingLot::isDaytime(int hour, int minute) {
 }
 
 int ParkingLot::calculateDaytimeFee(int minutes) {
-    int baseFee = calculateBaseFee(minutes);
-    
-    if (minutes >= maxMinutes_ && maxMinutes_ > 0) {
-        return maxFee_;
-    }
-    if (minutes >= 300 && baseFee > maxFee_ && maxMinutes_ > 0) {
-        return maxFee_;
-    }
-    return baseFee;
+    return calculateRateFee(minutes, daytimeRate());
 }
 
 int ParkingLot::calculateNighttimeFee(int minutes) {
-    int units = static_cast<int>(std::ceil(static_cast<double>(minutes) / nightUnitMinutes_));
-    int baseFee = units * nightUnitPrice_;
-    
-    if (minutes >= nightMaxMinutes_ && nightMaxMinutes_ > 0) {
-        return nightMaxFee_;
-    }
-    if (minutes >= 300 && baseFee > nightMaxFee_ && nightMaxMinutes_ > 0) {
-        return nightMaxFee_;
-    }
-    return baseFee;
+    return calculateRateFee(minutes, nighttimeRate());
 }
 
 int ParkingLot::calculateFee(int minutes, int startHour, int startMinute) {
@@ -103,32 +79,25 @@ int ParkingLot::calculateFee(int minutes, int startHour, int startMinute) {
     }
 }
 
+void ParkingLot::calculateFees(const int* minutes, int* fees, std::size_t count) {
+    calculateFeesBatch(minutes, fees, count, prepareFeeRate(daytimeRate()));
+}
+
+void ParkingLot::calculateFees(const int* minutes, const int* startHours, const int* startMinutes,
+                               int* fees, std::size_t count) {
+    calculateTimedFeesBatch(minutes, startHours, startMinutes, fees, count,
+                            prepareFeeRate(daytimeRate()), prepareFeeRate(nighttimeRate()));
+}
+
 // 平日クラスの実装
 WeekdayParkingLot::WeekdayParkingLot() {
-    // デフォルトの日中料金設定（後方互換性）
-    unitMinutes_ = 60;  // 平日は60分500円
-    unitPrice_ = 500;
-    maxMinutes_ = 720;  // 平日は12時間（720分）まで最大料金
-    maxFee_ = 1500;
-    
-    // デフォルトの夜間料金設定
-    nightUnitMinutes_ = 60;  // 夜間は60分300円
-    nightUnitPrice_ = 300;
-    nightMaxMinutes_ = 720;  // 夜間は12時間（720分）まで最大料金
-    nightMaxFee_ = 1000;
+    // デフォルトの料金設定（後方互換性）は tariff.hpp の平日の既定料金と共通
+    applyTariff(kWeekdayTariff);
 }
 
 WeekdayParkingLot::WeekdayParkingLot(const ParkingRateConfig& config) {
     // 外部から指定された料金設定を適用
-    unitMinutes_ = config.unitMinutes;
-    unitPrice_ = config.unitPrice;
-    maxMinutes_ = config.maxMinutes;
-    maxFee_ = config.maxFee;
-    
-    nightUnitMinutes_ = config.nightUnitMinutes;
-    nightUnitPrice_ = config.nightUnitPrice;
-    nightMaxMinutes_ = config.nightMaxMinutes;
-    nightMaxFee_ = config.nightMaxFee;
+    applyTariff(makeTariff(config));
 }
 
 int WeekdayParkingLot::calculateFee(int minutes) {
@@ -138,30 +107,13 @@ int WeekdayParkingLot::calculateFee(int minutes) {
 
 // 休日クラスの実装
 HolidayParkingLot::HolidayParkingLot() {
-    // デフォルトの日中料金設定（後方互換性）
-    unitMinutes_ = 30;  // 休日は30分500円
-    unitPrice_ = 500;
-    maxMinutes_ = 360; // 休日は6時間（360分）まで最大料金
-    maxFee_ = 1500;
-    
-    // デフォルトの夜間料金設定
-    nightUnitMinutes_ = 60;  // 夜間は60分300円
-    nightUnitPrice_ = 300;
-    nightMaxMinutes_ = 360;  // 夜間は6時間（360分）まで最大料金
-    nightMaxFee_ = 1000;
+    // デフォルトの料金設定（後方互換性）は tariff.hpp の休日の既定料金と共通
+    applyTariff(kHolidayTariff);
 }
 
 HolidayParkingLot::HolidayParkingLot(const ParkingRateConfig& config) {
     // 外部から指定された料金設定を適用
-    unitMinutes_ = config.unitMinutes;
-    unitPrice_ = config.unitPrice;
-    maxMinutes_ = config.maxMinutes;
-    maxFee_ = config.maxFee;
-    
-    nightUnitMinutes_ = config.nightUnitMinutes;
-    nightUnitPrice_ = config.nightUnitPrice;
-    nightMaxMinutes_ = config.nightMaxMinutes;
-    nightMaxFee_ = config.nightMaxFee;
+    applyTariff(makeTariff(config));
 }
 
 int HolidayParkingLot::calculateFee(int minutes) {
@@ -1,6 +1,10 @@
 #ifndef PARKING_LOT_HPP
 #define PARKING_LOT_HPP
 
+#include "fee_kernel.hpp"
+#include "tariff.hpp"
+#include <cstddef>
+
 // 料金設定構造体
 struct ParkingRateConfig {
     int unitMinutes;      // 料金単位の分数
@@ -15,7 +19,25 @@ struct ParkingRateConfig {
     int nightMaxFee;      // 夜間の最大料金
 };
 
+// 料金設定から料金体系（値型）を作成
+constexpr Tariff makeTariff(const ParkingRateConfig& config) {
+    return Tariff{
+        {config.unitMinutes, config.unitPrice, config.maxMinutes, config.maxFee},
+        {config.nightUnitMinutes, config.nightUnitPrice, config.nightMaxMinutes, config.nightMaxFee},
+    };
+}
+
+// 料金体系から料金設定を作成
+constexpr ParkingRateConfig makeRateConfig(const Tariff& tariff) {
+    return ParkingRateConfig{
+        tariff.daytime.unitMinutes, tariff.daytime.unitPrice, tariff.daytime.maxMinutes, tariff.daytime.maxFee,
+        tariff.nighttime.unitMinutes, tariff.nighttime.unitPrice, tariff.nighttime.maxMinutes, tariff.nighttime.maxFee,
+    };
+}
+
 // 基底クラス
+// 料金の計算は全て値型の Tariff に委譲する（互換性のためのラッパー）
+// 高頻度の料金計算では Tariff / DayTariffs を直接使うと仮想呼び出しなしでインライン化される
 class ParkingLot {
 public:
     // 後方互換性のためのコンストラクタ（既存のテスト用）
@@ -27,24 +49,26 @@ public:
     static int calculateFee(int weekdayMinutes, int holidayMinutes, ParkingLot* weekdayLot, ParkingLot* holidayLot);
     // 時刻を指定した料金計算（hour: 0-23, minute: 0-59）
     int calculateFee(int minutes, int startHour, int startMinute);
+    // 複数の駐車時間の料金を一括計算（fees[i] = calculateFee(minutes[i])）
+    // 仮想呼び出しはバッチごとに1回だけ行う
+    virtual void calculateFees(const int* minutes, int* fees, std::size_t count);
+    // 時刻を指定した一括計算（fees[i] = calculateFee(minutes[i], startHours[i], startMinutes[i])）
+    void calculateFees(const int* minutes, const int* startHours, const int* startMinutes,
+                       int* fees, std::size_t count);
+    // この駐車場の料金体系（値型なので配列やセッション情報にそのまま保持できる）
+    const Tariff& tariff() const { return tariff_; }
 
 protected:
     ParkingLot(); // 派生クラス用の保護コンストラクタ
-    int unitMinutes_;  // 料金単位の分数（平日: 60分、休日: 30分）
-    int unitPrice_;    // 単位料金（500円）
-    int maxMinutes_;   // 最大料金が適用される時間（平日: 720分、休日: 360分）
-    int maxFee_;       // 最大料金（1500円）
-    
-    // 夜間料金用のパラメータ
-    int nightUnitMinutes_;  // 夜間の料金単位の分数（60分）
-    int nightUnitPrice_;    // 夜間の単位料金（300円）
-    int nightMaxMinutes_;   // 夜間の最大料金が適用される時間
-    int nightMaxFee_;       // 夜間の最大料金（1000円）
-    
+    Tariff tariff_;  // 日中・夜間の料金帯
+
     int calculateBaseFee(int minutes);
     bool isDaytime(int hour, int minute); // 日中かどうかを判定（08:00-18:00）
     int calculateDaytimeFee(int minutes); // 日中料金を計算
     int calculateNighttimeFee(int minutes); // 夜間料金を計算
+    void applyTariff(const Tariff& tariff); // 料金体系を設定
+    FeeRate daytimeRate() const;   // 日中の料金帯
+    FeeRate nighttimeRate() const; // 夜間の料金帯
 
 private:
     int calculateFeeInternal(int minutes);
@@ -2,8 +2,23 @@
 #define PARKING_RATE_REPOSITORY_HPP
 
 #include "parking_lot.hpp"
+#include <cstdint>
 #include <string>
 #include <memory>
+#include <utility>
+#include <vector>
+
+// 種別と料金設定の組の一覧
+using RateConfigList = std::vector<std::pair<std::string, ParkingRateConfig>>;
+
+// 料金設定の版（effectiveFrom から次の版の effectiveFrom の直前まで適用される）
+struct RateVersion {
+    std::string type;
+    std::int64_t effectiveFrom;  // 適用開始（エポック秒）
+    ParkingRateConfig config;
+};
+
+using RateVersionList = std::vector<RateVersion>;
 
 // 料金設定の保存・読み込み用のインターフェース
 class ParkingRateRepository {
@@ -18,11 +33,115 @@ public:
     
     // 料金設定が存在するか確認
     virtual bool exists(const std::string& type) = 0;
+    
+    // 複数の料金設定をまとめて保存（全て保存できた場合のみtrue）
+    // 既定の実装は save を繰り返す。SQLite実装は1つのトランザクションで保存する
+    virtual bool saveBatch(const RateConfigList& configs) {
+        for (const auto& entry : configs) {
+            if (!save(entry.first, entry.second)) {
+                return false;
+            }
+        }
+        return true;
+    }
+    
+    // 全ての料金設定を種別の順に読み込み（一覧できない実装はfalse）
+    virtual bool loadAll(RateConfigList& configs) {
+        (void)configs;
+        return false;
+    }
+    
+    // 指定した種別の料金設定をまとめて読み込み（存在しない種別は結果に含めない）
+    virtual bool loadMany(const std::vector<std::string>& types, RateConfigList& configs) {
+        configs.clear();
+        for (const std::string& type : types) {
+            ParkingRateConfig config;
+            if (load(type, config)) {
+                configs.emplace_back(type, config);
+            }
+        }
+        return true;
+    }
+    
+    // 料金設定の版を保存（同じ種別・適用開始の版があれば置き換える）
+    // 現在の料金設定（load で読む内容）は変えない。save は保存時刻を適用開始とする版も記録する
+    // 対応していない実装はfalseを返す
+    virtual bool saveVersion(const RateVersion& version) {
+        (void)version;
+        return false;
+    }
+    
+    // timestamp（エポック秒）の時点で適用されていた料金設定を読み込み
+    // その時点より前に版がなければfalse
+    virtual bool loadAsOf(const std::string& type, std::int64_t timestamp, ParkingRateConfig& config) {
+        (void)type;
+        (void)timestamp;
+        (void)config;
+        return false;
+    }
+    
+    // 全ての版を種別・適用開始の順に読み込み（対応していない実装はfalse）
+    virtual bool loadVersions(RateVersionList& versions) {
+        versions.clear();
+        return false;
+    }
+    
+    // 変更検知用のバージョンを取得（SQLiteの PRAGMA data_version と同じ意味）
+    // 他の接続（他プロセス）が変更をコミットすると値が変わる。このリポジトリ自身の変更では変わらない
+    // 対応していない実装はfalseを返す
+    virtual bool dataVersion(std::uint64_t& version) {
+        (void)version;
+        return false;
+    }
+};
+
+// SQLiteのジャーナルモード（PRAGMA journal_mode）
+enum class SQLiteJournalMode {
+    Keep,     // DBファイルの現在のモードをそのまま使う（WALはファイルに記録され、次回以降も有効）
+    Delete,   // ロールバックジャーナル（SQLiteの既定）。書き込み中は読み取りも待たされる
+    Truncate,
+    Persist,
+    Memory,
+    Wal       // 先行書き込みログ。読み取りと書き込みが互いを待たない
+};
+
+// SQLiteの同期レベル（PRAGMA synchronous）
+enum class SQLiteSynchronous {
+    Off,
+    Normal,   // WALでは電源断時に直近のコミットを失うことがあるが、DBは壊れない
+    Full,     // SQLiteの既定
+    Extra
+};
+
+// SQLiteリポジトリの接続設定
+// 既定値はSQLite自体の既定値と同じ（従来の createSQLiteRepository(dbPath) と同じ動作）
+struct SQLiteRepositoryOptions {
+    SQLiteJournalMode journalMode = SQLiteJournalMode::Keep;
+    SQLiteSynchronous synchronous = SQLiteSynchronous::Full;
+    std::int64_t mmapSize = 0;   // PRAGMA mmap_size（バイト、0ならmmapを使わない）
+    int cacheSize = -2000;       // PRAGMA cache_size（正ならページ数、負ならKiB）
+    int busyTimeoutMs = 0;       // ロック待ちの上限（0なら待たずにSQLITE_BUSYで失敗）
+    
+    // 本番向けの推奨設定
+    // WAL + synchronous=NORMAL、64MiBのmmap、8MiBのキャッシュ、5秒のロック待ち
+    static SQLiteRepositoryOptions production() {
+        SQLiteRepositoryOptions options;
+        options.journalMode = SQLiteJournalMode::Wal;
+        options.synchronous = SQLiteSynchronous::Normal;
+        options.mmapSize = 64LL * 1024 * 1024;
+        options.cacheSize = -8192;
+        options.busyTimeoutMs = 5000;
+        return options;
+    }
 };
 
 // ファクトリ関数（スマートポインタ版）
 std::unique_ptr<ParkingRateRepository> createSQLiteRepository(const std::string& dbPath);
 
+// 接続設定を指定して作成（設定を適用できなかった場合は全ての操作が失敗する）
+std::unique_ptr<ParkingRateRepository> createSQLiteRepository(const std::string& dbPath,
+                                                              const SQLiteRepositoryOptions& options);
+
 // 後方互換性のための生ポインタ版（非推奨）
 ParkingRateRepository* createSQLiteRepositoryRaw(const std::string& dbPath);
 
@@ -0,0 +1,209 @@
+#include "pooled_rate_repository.hpp"
+#include "sqlite_rate_connection.hpp"
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+namespace {
+
+// リポジトリごとの識別番号（再利用しないため、破棄済みのリポジトリと取り違えない）
+std::atomic<std::uint64_t> nextRepositoryId(1);
+
+// 使い終わった読み込み用接続をいくつまで開いたまま残すか（超えた分は閉じる）
+constexpr std::size_t kMaxIdleReaders = 8;
+
+// リポジトリの読み込み用接続の置き場
+// 開いた接続は全てここで所有し、リポジトリの破棄時（置き場の破棄時）にまとめて閉じる
+// スレッドが終了すると、そのスレッドが借りていた接続はここに戻り、次に読み込むスレッドが使う
+struct ReaderPool {
+    std::mutex mutex;
+    std::vector<std::unique_ptr<SQLiteRateConnection>> connections;  // 貸し出し中のものも含む
+    std::vector<SQLiteRateConnection*> idle;
+
+    // 空いている接続を借りる（なければnullptr）
+    SQLiteRateConnection* borrow() {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (idle.empty()) {
+            return nullptr;
+        }
+        SQLiteRateConnection* connection = idle.back();
+        idle.pop_back();
+        return connection;
+    }
+
+    SQLiteRateConnection* add(std::unique_ptr<SQLiteRateConnection> connection) {
+        std::lock_guard<std::mutex> lock(mutex);
+        connections.push_back(std::move(connection));
+        return connections.back().get();
+    }
+
+    // 空きが上限に達していれば閉じる
+    void giveBack(SQLiteRateConnection* connection) {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (idle.size() < kMaxIdleReaders) {
+            idle.push_back(connection);
+            return;
+        }
+        for (auto& owned : connections) {
+            if (owned.get() == connection) {
+                owned = std::move(connections.back());
+                connections.pop_back();
+                break;
+            }
+        }
+    }
+};
+
+// スレッドが借りている読み込み用接続（リポジトリの識別番号ごと）
+// 接続は置き場が所有するので、リポジトリが破棄された後は connection を使わない
+struct ReaderLease {
+    std::weak_ptr<ReaderPool> pool;
+    SQLiteRateConnection* connection;
+};
+
+// スレッドの終了時に、借りている接続をまだあるリポジトリの置き場に戻す
+struct ReaderCache {
+    std::uint64_t lastId = 0;
+    SQLiteRateConnection* lastConnection = nullptr;
+    std::unordered_map<std::uint64_t, ReaderLease> leases;
+
+    ~ReaderCache() {
+        for (auto& entry : leases) {
+            if (auto pool = entry.second.pool.lock()) {
+                pool->giveBack(entry.second.connection);
+            }
+        }
+    }
+
+    // 破棄済みのリポジトリの項目を取り除く（接続はリポジトリの破棄時に閉じている）
+    void dropExpired() {
+        for (auto it = leases.begin(); it != leases.end();) {
+            if (it->second.pool.expired()) {
+                it = leases.erase(it);
+            } else {
+                ++it;
+            }
+        }
+    }
+};
+
+thread_local ReaderCache readerCache;
+
+} // namespace
+
+class PooledSQLiteParkingRateRepository : public ParkingRateRepository {
+private:
+    std::string dbPath_;
+    SQLiteRepositoryOptions options_;
+    std::uint64_t id_;
+
+    std::mutex writerMutex_;
+    SQLiteRateConnection writer_;
+
+    std::shared_ptr<ReaderPool> readers_;
+
+    // 呼び出したスレッド専用の接続（置き場になければ開く。開けない場合はnullptr）
+    // 開けなかった接続は残さず、次の呼び出しで開き直す
+    SQLiteRateConnection* reader() {
+        ReaderCache& cache = readerCache;
+        if (cache.lastId == id_) {
+            return cache.lastConnection;
+        }
+
+        SQLiteRateConnection* connection;
+        auto it = cache.leases.find(id_);
+        if (it != cache.leases.end()) {
+            connection = it->second.connection;
+        } else {
+            cache.dropExpired();
+            connection = readers_->borrow();
+            if (!connection) {
+                auto opened = std::make_unique<SQLiteRateConnection>(dbPath_, options_, true);
+                if (!opened->isOpen()) {
+                    return nullptr;
+                }
+                connection = readers_->add(std::move(opened));
+            }
+            cache.leases.emplace(id_, ReaderLease{readers_, connection});
+        }
+        cache.lastId = id_;
+        cache.lastConnection = connection;
+        return connection;
+    }
+
+public:
+    PooledSQLiteParkingRateRepository(const std::string& dbPath, const SQLiteRepositoryOptions& options)
+        : dbPath_(dbPath), options_(options), id_(nextRepositoryId.fetch_add(1)),
+          writer_(dbPath, options, true), readers_(std::make_shared<ReaderPool>()) {
+        // ジャーナルモードとテーブルは書き込み用の接続で設定済み
+        options_.journalMode = SQLiteJournalMode::Keep;
+    }
+
+    // 全ての読み込み用接続は置き場とともに閉じる（他のスレッドに貸し出し中のものも含む）
+    // 破棄するのは、他のスレッドがこのリポジトリを使い終わってからにすること
+    ~PooledSQLiteParkingRateRepository() {
+        readerCache.leases.erase(id_);
+        if (readerCache.lastId == id_) {
+            readerCache.lastId = 0;
+            readerCache.lastConnection = nullptr;
+        }
+    }
+
+    bool save(const std::string& type, const ParkingRateConfig& config) override {
+        std::lock_guard<std::mutex> lock(writerMutex_);
+        return writer_.save(type, config);
+    }
+
+    bool saveBatch(const RateConfigList& configs) override {
+        std::lock_guard<std::mutex> lock(writerMutex_);
+        return writer_.saveBatch(configs);
+    }
+
+    bool saveVersion(const RateVersion& version) override {
+        std::lock_guard<std::mutex> lock(writerMutex_);
+        return writer_.saveVersion(version);
+    }
+
+    bool load(const std::string& type, ParkingRateConfig& config) override {
+        SQLiteRateConnection* connection = reader();
+        return connection && connection->load(type, config);
+    }
+
+    bool exists(const std::string& type) override {
+        SQLiteRateConnection* connection = reader();
+        return connection && connection->exists(type);
+    }
+
+    bool loadAll(RateConfigList& configs) override {
+        SQLiteRateConnection* connection = reader();
+        return connection && connection->loadAll(configs);
+    }
+
+    bool loadMany(const std::vector<std::string>& types, RateConfigList& configs) override {
+        SQLiteRateConnection* connection = reader();
+        return connection && connection->loadMany(types, configs);
+    }
+
+    bool loadAsOf(const std::string& type, std::int64_t timestamp, ParkingRateConfig& config) override {
+        SQLiteRateConnection* connection = reader();
+        return connection && connection->loadAsOf(type, timestamp, config);
+    }
+
+    bool loadVersions(RateVersionList& versions) override {
+        SQLiteRateConnection* connection = reader();
+        return connection && connection->loadVersions(versions);
+    }
+
+    // 書き込み用の接続の値を返す（このリポジトリ自身の書き込みでは変わらない）
+    bool dataVersion(std::uint64_t& version) override {
+        std::lock_guard<std::mutex> lock(writerMutex_);
+        return writer_.dataVersion(version);
+    }
+};
+
+std::unique_ptr<ParkingRateRepository> createPooledSQLiteRepository(const std::string& dbPath,
+                                                                    const SQLiteRepositoryOptions& options) {
+    return std::make_unique<PooledSQLiteParkingRateRepository>(dbPath, options);
+}
@@ -0,0 +1,19 @@
+#ifndef POOLED_RATE_REPOSITORY_HPP
+#define POOLED_RATE_REPOSITORY_HPP
+
+#include "parking_rate_repository.hpp"
+#include <memory>
+#include <string>
+
+// 複数スレッドから同時に使えるSQLiteリポジトリを作成
+// 読み込み（load / exists / loadAll / loadMany）は呼び出したスレッド専用の接続で行い、
+// スレッドどうしで待ち合わせない。書き込み（save / saveBatch）は専用の1接続に直列化する
+// 読み込み用の接続は各スレッドの初回呼び出し時に借りる（空きがなければ開く）
+// スレッドの終了時に返し、後から来たスレッドが使い回す（空きは一定数まで。超えた分は閉じる）
+// リポジトリの破棄時には、他のスレッドに貸し出し中のものも含めて全ての接続を閉じる
+// 読み取りと書き込みが互いを待たないよう、WALを使う設定（既定は本番向け設定）で使う
+std::unique_ptr<ParkingRateRepository> createPooledSQLiteRepository(
+    const std::string& dbPath,
+    const SQLiteRepositoryOptions& options = SQLiteRepositoryOptions::production());
+
+#endif // POOLED_RATE_REPOSITORY_HPP
@@ -0,0 +1,87 @@
+#include "quote_protocol.hpp"
+#include <cstring>
+
+namespace {
+
+struct RequestFrame {
+    std::uint32_t length;
+    std::uint8_t opcode;
+    std::uint8_t reserved[3];
+    std::uint32_t requestId;
+    std::uint32_t lotId;
+    std::uint64_t ticketId;
+    std::int64_t startTime;
+    std::int64_t endTime;
+};
+
+struct ResponseFrame {
+    std::uint32_t length;
+    std::uint8_t opcode;
+    std::uint8_t status;
+    std::uint8_t reserved[2];
+    std::uint32_t requestId;
+    std::uint32_t reserved2;
+    std::int64_t fee;
+};
+
+static_assert(sizeof(RequestFrame) == kQuoteRequestFrameSize, "要求は40バイト");
+static_assert(sizeof(ResponseFrame) == kQuoteResponseFrameSize, "応答は24バイト");
+
+// 長さの欄を確かめる（フレームの大きさは固定）
+QuoteFrameResult checkLength(const char* data, std::size_t size, std::size_t frameSize) {
+    if (size < sizeof(std::uint32_t)) {
+        return QuoteFrameResult::Incomplete;
+    }
+    std::uint32_t length;
+    std::memcpy(&length, data, sizeof(length));
+    if (length != frameSize - sizeof(std::uint32_t)) {
+        return QuoteFrameResult::Invalid;
+    }
+    return size < frameSize ? QuoteFrameResult::Incomplete : QuoteFrameResult::Complete;
+}
+
+} // namespace
+
+QuoteFrameResult decodeQuoteRequest(const char* data, std::size_t size, QuoteRequest& request) {
+    QuoteFrameResult result = checkLength(data, size, sizeof(RequestFrame));
+    if (result == QuoteFrameResult::Complete) {
+        RequestFrame frame;
+        std::memcpy(&frame, data, sizeof(frame));
+        request = QuoteRequest{static_cast<QuoteOpcode>(frame.opcode), frame.requestId, frame.lotId,
+                               frame.ticketId, frame.startTime, frame.endTime};
+    }
+    return result;
+}
+
+QuoteFrameResult decodeQuoteResponse(const char* data, std::size_t size, QuoteResponse& response) {
+    QuoteFrameResult result = checkLength(data, size, sizeof(ResponseFrame));
+    if (result == QuoteFrameResult::Complete) {
+        ResponseFrame frame;
+        std::memcpy(&frame, data, sizeof(frame));
+        response = QuoteResponse{static_cast<QuoteOpcode>(frame.opcode), static_cast<QuoteStatus>(frame.status),
+                                 frame.requestId, frame.fee};
+    }
+    return result;
+}
+
+void encodeQuoteRequest(const QuoteRequest& request, char* out) {
+    RequestFrame frame{};
+    frame.length = sizeof(RequestFrame) - sizeof(std::uint32_t);
+    frame.opcode = static_cast<std::uint8_t>(request.opcode);
+    frame.requestId = request.requestId;
+    frame.lotId = request.lotId;
+    frame.ticketId = request.ticketId;
+    frame.startTime = request.startTime;
+    frame.endTime = request.endTime;
+    std::memcpy(out, &frame, sizeof(frame));
+}
+
+void encodeQuoteResponse(const QuoteResponse& response, char* out) {
+    ResponseFrame frame{};
+    frame.length = sizeof(ResponseFrame) - sizeof(std::uint32_t);
+    frame.opcode = static_cast<std::uint8_t>(response.opcode);
+    frame.status = static_cast<std::uint8_t>(response.status);
+    frame.requestId = response.requestId;
+    frame.fee = response.fee;
+    std::memcpy(out, &frame, sizeof(frame));
+}
@@ -0,0 +1,65 @@
+#ifndef QUOTE_PROTOCOL_HPP
+#define QUOTE_PROTOCOL_HPP
+
+#include <cstddef>
+#include <cstdint>
+
+// 料金見積もりサーバーの要求・応答（長さ付きの固定長フレーム、リトルエンディアン）
+//
+// 要求 40バイト
+//   uint32 length（以降のバイト数 = 36） uint8 opcode  uint8[3] 予約  uint32 requestId
+//   uint32 lotId  uint64 ticketId  int64 startTime  int64 endTime
+// 応答 24バイト
+//   uint32 length（以降のバイト数 = 20） uint8 opcode  uint8 status  uint8[2] 予約  uint32 requestId
+//   uint32 予約  int64 fee
+//
+// 1つの接続で応答を待たずに続けて要求を送ってよく（パイプライン）、応答は要求の順に返る
+
+enum class QuoteOpcode : std::uint8_t {
+    Quote = 1,  // lotId の料金体系で startTime から endTime までの料金
+    Entry = 2,  // ticketId が lotId に startTime に入庫
+    Exit = 3,   // ticketId が endTime に出庫（fee に料金）
+};
+
+enum class QuoteStatus : std::uint8_t {
+    Ok = 0,
+    NotFound = 1,    // 未登録の駐車場・入庫中でない駐車券
+    Rejected = 2,    // 入庫の重複・出庫が入庫より前など
+    BadRequest = 3,  // 不明な opcode
+};
+
+struct QuoteRequest {
+    QuoteOpcode opcode;
+    std::uint32_t requestId;
+    std::uint32_t lotId;
+    std::uint64_t ticketId;
+    std::int64_t startTime;  // エポック秒
+    std::int64_t endTime;
+};
+
+struct QuoteResponse {
+    QuoteOpcode opcode;
+    QuoteStatus status;
+    std::uint32_t requestId;
+    std::int64_t fee;
+};
+
+constexpr std::size_t kQuoteRequestFrameSize = 40;
+constexpr std::size_t kQuoteResponseFrameSize = 24;
+
+// 解析の結果
+enum class QuoteFrameResult {
+    Complete,    // 1フレームを解析した
+    Incomplete,  // データが足りない（続きを受信してから再度呼ぶ）
+    Invalid,     // 長さが不正（接続を閉じる）
+};
+
+// data の先頭のフレームを解析する（Complete のときだけ request を設定する）
+QuoteFrameResult decodeQuoteRequest(const char* data, std::size_t size, QuoteRequest& request);
+QuoteFrameResult decodeQuoteResponse(const char* data, std::size_t size, QuoteResponse& response);
+
+// out に kQuoteRequestFrameSize / kQuoteResponseFrameSize バイトを書く
+void encodeQuoteRequest(const QuoteRequest& request, char* out);
+void encodeQuoteResponse(const QuoteResponse& response, char* out);
+
+#endif // QUOTE_PROTOCOL_HPP
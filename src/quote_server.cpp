@@ -0,0 +1,952 @@
+#include "quote_server.hpp"
+#include "http_quote.hpp"
+#include "io_uring_queue.hpp"
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <iostream>
+#include <thread>
+
+namespace {
+
+// 1回の recv で読む大きさ（要求1600件ほど）
+constexpr std::size_t kReadBytes = 64 * 1024;
+
+// 未送信の応答がこれを超えたら、送れるまで受信を止める
+constexpr std::size_t kMaxPendingOutput = 1024 * 1024;
+
+// epoll で1回に応答を書く領域の大きさ（足りなければ繰り返す）
+constexpr std::size_t kServeChunkBytes = 16 * 1024;
+
+constexpr int kMaxEvents = 256;
+
+// io_uring で接続ごとに割り当てる登録済みバッファ（受信と送信）
+// 送信バッファが一杯になったら、送り終わってから残りの要求を処理する
+constexpr std::size_t kRingInputBytes = 4096;
+constexpr std::size_t kRingOutputBytes = 4096;
+
+// fd が足りないなどで受け付けに失敗した場合に、受け付けを登録し直すまで待つ時間
+constexpr long kAcceptRetryNanoseconds = 10 * 1000 * 1000;
+static_assert(kRingInputBytes >= kHttpQuoteMaxRequestBytes, "最大の HTTP 要求が受信バッファに収まること");
+
+// io_uring の要求の種類（user_data の上位8ビット、下位32ビットは接続の番号）
+enum class RingOperation : std::uint64_t {
+    AcceptTcp = 1,
+    AcceptUnix = 2,
+    Wake = 3,
+    Read = 4,
+    Write = 5,
+    AcceptRetry = 6,  // 受け付けの再登録を遅らせるタイムアウト（番号の欄に受け付けの種類を入れる）
+};
+
+std::uint64_t ringUserData(RingOperation operation, std::uint32_t slot = 0) {
+    return (static_cast<std::uint64_t>(operation) << 56) | slot;
+}
+
+void setNoDelay(int fd) {
+    int on = 1;
+    ::setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &on, sizeof(on));
+}
+
+// 1つの接続の受信・送信バッファ（epoll）
+struct QuoteConnection {
+    int fd = -1;
+    std::vector<char> input = std::vector<char>(kReadBytes);
+    std::size_t inputSize = 0;
+    std::vector<char> output;      // 大きさは確保済みの領域（使っているのは outputSize まで）
+    std::size_t outputSize = 0;
+    std::size_t outputOffset = 0;  // output のうち送信済みのバイト数
+    std::uint32_t events = 0;      // epoll に登録している EPOLLIN / EPOLLOUT
+    bool closeAfterWrite = false;  // 応答を送り終えたら閉じる（HTTP の Connection: close など）
+};
+
+// 1つの接続の状態（io_uring、バッファは登録済みの領域の slot 番目）
+// 応答の送信に次の受信をつなげて（IOSQE_IO_LINK）一緒に投入するので、実行中の要求は最大2つ
+struct RingConnection {
+    int fd = -1;
+    std::size_t inputSize = 0;
+    std::size_t outputSize = 0;
+    std::size_t outputOffset = 0;
+    unsigned pending = 0;  // 完了を待っている要求の数
+    bool closing = false;  // 閉じた後、残りの完了を待っている（待ち終わるまで番号を再利用しない）
+    bool closeAfterWrite = false;
+    bool backlogged = false;  // 送信バッファが一杯で処理していない要求が受信バッファに残っている
+};
+
+// serveInput の結果
+struct ServeOutcome {
+    std::size_t consumed = 0;  // 処理した要求のバイト数
+    std::size_t produced = 0;  // 書いた応答のバイト数
+    std::uint64_t handled = 0;
+    bool full = false;         // 応答を書く領域が足りずに止めた（残りの要求は後で処理する）
+    bool close = false;        // 書いた応答を送ったら接続を閉じる（以降の要求は捨てる）
+};
+
+// data の完全な要求を順に処理して応答を out（capacity バイト）に書く
+void serveBinary(QuoteService& service, const char* data, std::size_t size, char* out, std::size_t capacity,
+                 ServeOutcome& outcome) {
+    QuoteRequest request;
+    QuoteResponse response;
+    while (true) {
+        if (capacity - outcome.produced < kQuoteResponseFrameSize) {
+            outcome.full = true;
+            return;
+        }
+        QuoteFrameResult result = decodeQuoteRequest(data + outcome.consumed, size - outcome.consumed, request);
+        if (result == QuoteFrameResult::Incomplete) {
+            return;
+        }
+        if (result == QuoteFrameResult::Invalid) {
+            outcome.close = true;
+            return;
+        }
+        service.handle(request, response);
+        encodeQuoteResponse(response, out + outcome.produced);
+        outcome.consumed += kQuoteRequestFrameSize;
+        outcome.produced += kQuoteResponseFrameSize;
+        ++outcome.handled;
+    }
+}
+
+void serveHttp(QuoteService& service, const char* data, std::size_t size, char* out, std::size_t capacity,
+               ServeOutcome& outcome) {
+    HttpQuoteRequest request;
+    QuoteResponse response;
+    while (true) {
+        if (capacity - outcome.produced < kHttpQuoteMaxResponseBytes) {
+            outcome.full = true;
+            return;
+        }
+        std::size_t length = 0;
+        HttpParseResult result = parseHttpQuoteRequest(data + outcome.consumed, size - outcome.consumed, request, length);
+        if (result == HttpParseResult::Incomplete) {
+            return;
+        }
+        if (result == HttpParseResult::Invalid) {
+            // 次の要求の始まりが分からないので、応答を返して閉じる
+            outcome.produced += writeHttpErrorResponse(request.errorStatus, false, out + outcome.produced);
+            outcome.consumed = size;
+            outcome.close = true;
+            return;
+        }
+        if (request.errorStatus != 0) {
+            outcome.produced += writeHttpErrorResponse(request.errorStatus, request.keepAlive, out + outcome.produced);
+        } else {
+            service.handle(request.quote, response);
+            outcome.produced += writeHttpQuoteResponse(response, request.keepAlive, out + outcome.produced);
+        }
+        outcome.consumed += length;
+        ++outcome.handled;
+        if (!request.keepAlive) {
+            outcome.close = true;
+            return;
+        }
+    }
+}
+
+void serveInput(QuoteService& service, QuoteServerProtocol protocol, const char* data, std::size_t size, char* out,
+                std::size_t capacity, ServeOutcome& outcome) {
+    outcome = ServeOutcome();
+    if (protocol == QuoteServerProtocol::Http) {
+        serveHttp(service, data, size, out, capacity, outcome);
+    } else {
+        serveBinary(service, data, size, out, capacity, outcome);
+    }
+}
+
+} // namespace
+
+struct QuoteServer::Reactor {
+    int epollFd = -1;
+    int wakeFd = -1;       // stop から書き込んでスレッドを起こす eventfd
+    int tcpListener = -1;  // このリアクター専用（SO_REUSEPORT）
+    std::thread thread;
+    std::atomic<std::uint64_t> requests{0};
+    std::atomic<std::uint64_t> connections{0};
+    std::atomic<std::uint64_t> syscalls{0};
+    std::vector<std::unique_ptr<QuoteConnection>> open;  // ファイル記述子で引く
+
+    // io_uring のときだけ使う
+    std::unique_ptr<IoUringQueue> ring;
+    std::unique_ptr<char[]> buffers;  // 接続ごとに受信・送信の順で並べた登録済みバッファ
+    std::vector<RingConnection> slots;
+    std::vector<std::uint32_t> freeSlots;
+    std::uint64_t wakeValue = 0;
+
+    char* input(std::uint32_t slot) { return buffers.get() + slot * (kRingInputBytes + kRingOutputBytes); }
+    char* output(std::uint32_t slot) { return input(slot) + kRingInputBytes; }
+
+    // 自分のスレッドだけが書くので、読み込みと書き込みを分けて lock 命令を避ける
+    void addSyscalls(std::uint64_t count) {
+        syscalls.store(syscalls.load(std::memory_order_relaxed) + count, std::memory_order_relaxed);
+    }
+};
+
+namespace {
+
+bool addToEpoll(int epollFd, int fd, std::uint32_t events) {
+    epoll_event event{};
+    event.events = events;
+    event.data.fd = fd;
+    return ::epoll_ctl(epollFd, EPOLL_CTL_ADD, fd, &event) == 0;
+}
+
+// 未送信の応答を送れるだけ送る（接続が切れていたらfalse）
+bool flushOutput(QuoteConnection& connection, std::uint64_t& syscalls) {
+    while (connection.outputOffset < connection.outputSize) {
+        ++syscalls;
+        ssize_t sent = ::send(connection.fd, connection.output.data() + connection.outputOffset,
+                              connection.outputSize - connection.outputOffset, MSG_NOSIGNAL | MSG_DONTWAIT);
+        if (sent < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return errno == EAGAIN || errno == EWOULDBLOCK;
+        }
+        connection.outputOffset += static_cast<std::size_t>(sent);
+    }
+    connection.outputSize = 0;  // 確保した領域は次の応答に使い回す
+    connection.outputOffset = 0;
+    return true;
+}
+
+// 未送信の量に合わせて待つイベントを切り替える
+bool updateEvents(int epollFd, QuoteConnection& connection, std::uint64_t& syscalls) {
+    std::size_t pending = connection.outputSize - connection.outputOffset;
+    std::uint32_t events = 0;
+    if (pending < kMaxPendingOutput && !connection.closeAfterWrite) {
+        events |= EPOLLIN;
+    }
+    if (pending > 0) {
+        events |= EPOLLOUT;
+    }
+    if (events == connection.events) {
+        return true;
+    }
+    epoll_event event{};
+    event.events = events;
+    event.data.fd = connection.fd;
+    connection.events = events;
+    ++syscalls;
+    return ::epoll_ctl(epollFd, EPOLL_CTL_MOD, connection.fd, &event) == 0;
+}
+
+} // namespace
+
+QuoteServer::QuoteServer(QuoteService& service) : service_(service) {}
+
+QuoteServer::~QuoteServer() {
+    stop();
+}
+bool QuoteServer::openTcpListener(const QuoteServerOptions& options, int& fd) {
+    sockaddr_in address{};
+    address.sin_family = AF_INET;
+    address.sin_port = htons(static_cast<std::uint16_t>(tcpPort_ > 0 ? tcpPort_ : options.tcpPort));
+    if (::inet_pton(AF_INET, options.bindAddress.c_str(), &address.sin_addr) != 1) {
+        std::cerr << "Invalid bind address: " << options.bindAddress << std::endl;
+        return false;
+    }
+    fd = ::socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (fd < 0) {
+        std::cerr << "Can't create socket" << std::endl;
+        return false;
+    }
+    int on = 1;
+    ::setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &on, sizeof(on));
+    if (::setsockopt(fd, SOL_SOCKET, SO_REUSEPORT, &on, sizeof(on)) != 0 ||
+        ::bind(fd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0 ||
+        ::listen(fd, options.backlog) != 0) {
+        std::cerr << "Can't listen on " << options.bindAddress << ":" << ntohs(address.sin_port) << ": "
+                  << std::strerror(errno) << std::endl;
+        return false;
+    }
+    // ポート0のときは最初のリアクターに割り当てられたポートを他のリアクターも使う
+    socklen_t length = sizeof(address);
+    if (::getsockname(fd, reinterpret_cast<sockaddr*>(&address), &length) != 0) {
+        return false;
+    }
+    tcpPort_ = ntohs(address.sin_port);
+    return true;
+}
+
+bool QuoteServer::openUnixListener(const QuoteServerOptions& options) {
+    sockaddr_un address{};
+    address.sun_family = AF_UNIX;
+    if (options.unixPath.size() >= sizeof(address.sun_path)) {
+        std::cerr << "Unix socket path too long: " << options.unixPath << std::endl;
+        return false;
+    }
+    std::memcpy(address.sun_path, options.unixPath.c_str(), options.unixPath.size() + 1);
+    unixListener_ = ::socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (unixListener_ < 0) {
+        std::cerr << "Can't create socket" << std::endl;
+        return false;
+    }
+    ::unlink(options.unixPath.c_str());
+    if (::bind(unixListener_, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0 ||
+        ::listen(unixListener_, options.backlog) != 0) {
+        std::cerr << "Can't listen on " << options.unixPath << ": " << std::strerror(errno) << std::endl;
+        return false;
+    }
+    unixPath_ = options.unixPath;
+    return true;
+}
+
+bool QuoteServer::setUpIoUring(Reactor& reactor, std::size_t connections) {
+    if (connections == 0 || connections > 0xffffffffu) {
+        return false;
+    }
+    // 実行中の要求は接続ごとに2つと accept・eventfd の分なので、完了キュー（投入キューの2倍）はあふれない
+    reactor.ring = std::make_unique<IoUringQueue>();
+    if (!reactor.ring->open(static_cast<unsigned>(connections + 8))) {
+        reactor.ring.reset();
+        return false;
+    }
+    std::size_t bytes = connections * (kRingInputBytes + kRingOutputBytes);
+    reactor.buffers.reset(new char[bytes]);
+    iovec buffer{reactor.buffers.get(), bytes};
+    if (!reactor.ring->registerBuffers(&buffer, 1)) {
+        reactor.ring.reset();
+        reactor.buffers.reset();
+        return false;
+    }
+    reactor.slots.assign(connections, RingConnection());
+    reactor.freeSlots.clear();
+    for (std::size_t slot = connections; slot > 0; --slot) {
+        reactor.freeSlots.push_back(static_cast<std::uint32_t>(slot - 1));
+    }
+    return true;
+}
+
+bool QuoteServer::start(const QuoteServerOptions& options) {
+    if (isRunning()) {
+        return false;
+    }
+    if (options.tcpPort < 0 && options.unixPath.empty()) {
+        std::cerr << "No TCP port or Unix socket to listen on" << std::endl;
+        return false;
+    }
+    std::size_t count = options.reactorCount;
+    if (count == 0) {
+        count = std::max(1u, std::thread::hardware_concurrency());
+    }
+
+    if (!options.unixPath.empty() && !openUnixListener(options)) {
+        closeAll();
+        return false;
+    }
+    tcpPort_ = -1;
+    for (std::size_t i = 0; i < count; ++i) {
+        reactors_.push_back(std::make_unique<Reactor>());
+        Reactor& reactor = *reactors_.back();
+        reactor.wakeFd = ::eventfd(0, EFD_CLOEXEC);
+        bool ready = reactor.wakeFd >= 0;
+        if (ready && options.tcpPort >= 0) {
+            ready = openTcpListener(options, reactor.tcpListener);
+        }
+        if (!ready) {
+            std::cerr << "Can't start quote server reactor" << std::endl;
+            closeAll();
+            return false;
+        }
+    }
+
+    // io_uring は全てのリアクターで使えた場合だけ使う
+    backend_ = options.backend;
+    protocol_ = options.protocol;
+    if (backend_ == QuoteServerBackend::IoUring) {
+        for (auto& reactor : reactors_) {
+            if (!setUpIoUring(*reactor, options.ioUringConnections)) {
+                std::cerr << "io_uring is unavailable, falling back to epoll" << std::endl;
+                backend_ = QuoteServerBackend::Epoll;
+                break;
+            }
+        }
+    }
+
+    if (backend_ == QuoteServerBackend::IoUring) {
+        // O_NONBLOCK のファイルへの要求は待たずに EAGAIN で完了するので、待つ側はブロッキングにする
+        for (auto& reactor : reactors_) {
+            if (reactor->tcpListener >= 0) {
+                ::fcntl(reactor->tcpListener, F_SETFL, 0);
+            }
+        }
+        if (unixListener_ >= 0) {
+            ::fcntl(unixListener_, F_SETFL, 0);
+        }
+    } else {
+        for (auto& reactor : reactors_) {
+            reactor->ring.reset();
+            reactor->buffers.reset();
+            reactor->epollFd = ::epoll_create1(EPOLL_CLOEXEC);
+            bool ready = reactor->epollFd >= 0 && ::fcntl(reactor->wakeFd, F_SETFL, O_NONBLOCK) == 0 &&
+                         addToEpoll(reactor->epollFd, reactor->wakeFd, EPOLLIN);
+            if (ready && reactor->tcpListener >= 0) {
+                ready = addToEpoll(reactor->epollFd, reactor->tcpListener, EPOLLIN);
+            }
+            // 1つの接続で起こすのは待っているリアクターのうち1つだけ
+            if (ready && unixListener_ >= 0) {
+                ready = addToEpoll(reactor->epollFd, unixListener_, EPOLLIN | EPOLLEXCLUSIVE);
+            }
+            if (!ready) {
+                std::cerr << "Can't start quote server reactor" << std::endl;
+                closeAll();
+                return false;
+            }
+        }
+    }
+
+    for (auto& reactor : reactors_) {
+        Reactor* target = reactor.get();
+        if (backend_ == QuoteServerBackend::IoUring) {
+            reactor->thread = std::thread([this, target] { runIoUring(*target); });
+        } else {
+            reactor->thread = std::thread([this, target] { run(*target); });
+        }
+    }
+    return true;
+}
+
+void QuoteServer::stop() {
+    for (auto& reactor : reactors_) {
+        std::uint64_t one = 1;
+        ssize_t written = ::write(reactor->wakeFd, &one, sizeof(one));
+        (void)written;
+    }
+    for (auto& reactor : reactors_) {
+        if (reactor->thread.joinable()) {
+            reactor->thread.join();
+        }
+    }
+    closeAll();
+}
+
+void QuoteServer::closeAll() {
+    for (auto& reactor : reactors_) {
+        // 実行中の要求を取り消してから登録済みバッファを解放する
+        reactor->ring.reset();
+        reactor->buffers.reset();
+        for (const RingConnection& slot : reactor->slots) {
+            if (slot.fd >= 0) {
+                ::close(slot.fd);
+            }
+        }
+        for (auto& connection : reactor->open) {
+            if (connection) {
+                ::close(connection->fd);
+            }
+        }
+        for (int fd : {reactor->tcpListener, reactor->wakeFd, reactor->epollFd}) {
+            if (fd >= 0) {
+                ::close(fd);
+            }
+        }
+    }
+    reactors_.clear();
+    if (unixListener_ >= 0) {
+        ::close(unixListener_);
+        ::unlink(unixPath_.c_str());
+    }
+    unixListener_ = -1;
+    unixPath_.clear();
+}
+
+std::uint64_t QuoteServer::requestCount() const {
+    std::uint64_t total = 0;
+    for (const auto& reactor : reactors_) {
+        total += reactor->requests.load(std::memory_order_relaxed);
+    }
+    return total;
+}
+
+std::uint64_t QuoteServer::connectionCount() const {
+    std::uint64_t total = 0;
+    for (const auto& reactor : reactors_) {
+        total += reactor->connections.load(std::memory_order_relaxed);
+    }
+    return total;
+}
+
+std::uint64_t QuoteServer::syscallCount() const {
+    std::uint64_t total = 0;
+    for (const auto& reactor : reactors_) {
+        total += reactor->syscalls.load(std::memory_order_relaxed);
+    }
+    return total;
+}
+
+void QuoteServer::run(Reactor& reactor) {
+    epoll_event events[kMaxEvents];
+    std::uint64_t syscalls = 0;
+
+    auto closeConnection = [&reactor, &syscalls](int fd) {
+        ++syscalls;
+        ::close(fd);  // 他で複製していないので epoll からも外れる
+        reactor.open[static_cast<std::size_t>(fd)].reset();
+    };
+
+    auto acceptAll = [&reactor, &syscalls](int listener, bool tcp) {
+        while (true) {
+            ++syscalls;
+            int fd = ::accept4(listener, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+            if (fd < 0) {
+                // EAGAIN は他のリアクターが先に受け付けた場合も含む
+                if (errno == EINTR || errno == ECONNABORTED) {
+                    continue;
+                }
+                return;
+            }
+            if (tcp) {
+                ++syscalls;
+                setNoDelay(fd);
+            }
+            ++syscalls;
+            if (!addToEpoll(reactor.epollFd, fd, EPOLLIN)) {
+                ::close(fd);
+                continue;
+            }
+            std::size_t index = static_cast<std::size_t>(fd);
+            if (index >= reactor.open.size()) {
+                reactor.open.resize(index + 1);
+            }
+            reactor.open[index] = std::make_unique<QuoteConnection>();
+            reactor.open[index]->fd = fd;
+            reactor.open[index]->events = EPOLLIN;
+            reactor.connections.fetch_add(1, std::memory_order_relaxed);
+        }
+    };
+
+    // 受信した要求を全て処理し、応答をまとめて送る（接続を閉じるべきならfalse）
+    auto serve = [this, &reactor, &syscalls](QuoteConnection& connection) {
+        if (connection.outputSize - connection.outputOffset < kMaxPendingOutput && !connection.closeAfterWrite) {
+            ssize_t received;
+            do {
+                ++syscalls;
+                received = ::recv(connection.fd, connection.input.data() + connection.inputSize,
+                                  connection.input.size() - connection.inputSize, 0);
+            } while (received < 0 && errno == EINTR);
+            if (received == 0) {
+                return false;
+            }
+            if (received < 0) {
+                if (errno != EAGAIN && errno != EWOULDBLOCK) {
+                    return false;
+                }
+                received = 0;
+            }
+            connection.inputSize += static_cast<std::size_t>(received);
+
+            std::size_t consumed = 0;
+            ServeOutcome outcome;
+            do {
+                if (connection.output.size() - connection.outputSize < kServeChunkBytes) {
+                    connection.output.resize(std::max(connection.output.size() * 2,
+                                                      connection.outputSize + kServeChunkBytes));
+                }
+                serveInput(service_, protocol_, connection.input.data() + consumed, connection.inputSize - consumed,
+                           connection.output.data() + connection.outputSize, kServeChunkBytes, outcome);
+                consumed += outcome.consumed;
+                connection.outputSize += outcome.produced;
+                reactor.requests.fetch_add(outcome.handled, std::memory_order_relaxed);
+            } while (outcome.full);
+            connection.closeAfterWrite = outcome.close;
+            // 途中までの要求を先頭に寄せる
+            connection.inputSize -= consumed;
+            std::memmove(connection.input.data(), connection.input.data() + consumed, connection.inputSize);
+        }
+        if (!flushOutput(connection, syscalls)) {
+            return false;
+        }
+        if (connection.closeAfterWrite && connection.outputSize == 0) {
+            return false;
+        }
+        return updateEvents(reactor.epollFd, connection, syscalls);
+    };
+
+    while (true) {
+        ++syscalls;
+        int ready = ::epoll_wait(reactor.epollFd, events, kMaxEvents, -1);
+        if (ready < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            std::cerr << "epoll_wait failed: " << std::strerror(errno) << std::endl;
+            return;
+        }
+        for (int i = 0; i < ready; ++i) {
+            int fd = events[i].data.fd;
+            if (fd == reactor.wakeFd) {
+                reactor.addSyscalls(syscalls);
+                return;
+            }
+            if (fd == reactor.tcpListener) {
+                acceptAll(fd, true);
+                continue;
+            }
+            if (fd == unixListener_) {
+                acceptAll(fd, false);
+                continue;
+            }
+            std::size_t index = static_cast<std::size_t>(fd);
+            if (index >= reactor.open.size() || !reactor.open[index]) {
+                continue;
+            }
+            if (!serve(*reactor.open[index])) {
+                closeConnection(fd);
+            }
+        }
+        reactor.addSyscalls(syscalls);
+        syscalls = 0;
+    }
+}
+
+void QuoteServer::runIoUring(Reactor& reactor) {
+    IoUringQueue& ring = *reactor.ring;
+    std::uint64_t syscalls = 0;
+
+    // 投入キューが一杯なら先に投入して空ける
+    auto nextSqe = [&ring, &syscalls]() {
+        io_uring_sqe* sqe = ring.getSqe();
+        while (!sqe) {
+            ++syscalls;
+            ring.submit();
+            sqe = ring.getSqe();
+        }
+        return sqe;
+    };
+
+    auto armAccept = [&](int listener, RingOperation operation) {
+        io_uring_sqe* sqe = nextSqe();
+        sqe->opcode = IORING_OP_ACCEPT;
+        sqe->fd = listener;
+        sqe->accept_flags = SOCK_CLOEXEC;
+        sqe->user_data = ringUserData(operation);
+    };
+
+    // 受け付けの失敗が続く間（EMFILE など）にすぐ登録し直すと io_uring_enter が空回りするので、
+    // タイムアウトの完了を待ってから登録し直す
+    __kernel_timespec acceptRetryDelay{0, kAcceptRetryNanoseconds};
+    auto armAcceptRetry = [&](RingOperation operation) {
+        io_uring_sqe* sqe = nextSqe();
+        sqe->opcode = IORING_OP_TIMEOUT;
+        sqe->fd = -1;
+        sqe->addr = reinterpret_cast<std::uint64_t>(&acceptRetryDelay);
+        sqe->len = 1;
+        sqe->user_data = ringUserData(RingOperation::AcceptRetry, static_cast<std::uint32_t>(operation));
+    };
+
+    auto armRead = [&](std::uint32_t slot) {
+        RingConnection& connection = reactor.slots[slot];
+        io_uring_sqe* sqe = nextSqe();
+        sqe->opcode = IORING_OP_READ_FIXED;
+        sqe->fd = connection.fd;
+        sqe->addr = reinterpret_cast<std::uint64_t>(reactor.input(slot) + connection.inputSize);
+        sqe->len = static_cast<std::uint32_t>(kRingInputBytes - connection.inputSize);
+        sqe->buf_index = 0;
+        sqe->user_data = ringUserData(RingOperation::Read, slot);
+        ++connection.pending;
+    };
+
+    // 応答を送り、送り終わったら次の受信を始める（2つで io_uring_enter 1回）
+    // 一部しか送れなかった場合はつなげた受信が -ECANCELED で完了する
+    auto armWriteThenRead = [&](std::uint32_t slot) {
+        RingConnection& connection = reactor.slots[slot];
+        io_uring_sqe* sqe = nextSqe();
+        sqe->opcode = IORING_OP_WRITE_FIXED;
+        sqe->flags = IOSQE_IO_LINK;
+        sqe->fd = connection.fd;
+        sqe->addr = reinterpret_cast<std::uint64_t>(reactor.output(slot) + connection.outputOffset);
+        sqe->len = static_cast<std::uint32_t>(connection.outputSize - connection.outputOffset);
+        sqe->buf_index = 0;
+        sqe->user_data = ringUserData(RingOperation::Write, slot);
+        ++connection.pending;
+        armRead(slot);
+    };
+
+    // 実行中の受信は shutdown で0バイトの完了になり、全て完了したら番号を空ける
+    auto closeSlot = [&](std::uint32_t slot) {
+        RingConnection& connection = reactor.slots[slot];
+        if (!connection.closing) {
+            syscalls += 2;
+            ::shutdown(connection.fd, SHUT_RDWR);
+            ::close(connection.fd);
+            // fd の番号はすぐに他で使われうるので、closeAll で閉じ直さないように外す
+            // （実行中の要求が全て完了するまで closing のまま番号を空けない）
+            connection.fd = -1;
+            connection.closing = true;
+        }
+        if (connection.pending == 0) {
+            connection = RingConnection();
+            reactor.freeSlots.push_back(slot);
+        }
+    };
+
+    auto armWrite = [&](std::uint32_t slot) {
+        RingConnection& connection = reactor.slots[slot];
+        io_uring_sqe* sqe = nextSqe();
+        sqe->opcode = IORING_OP_WRITE_FIXED;
+        sqe->fd = connection.fd;
+        sqe->addr = reinterpret_cast<std::uint64_t>(reactor.output(slot) + connection.outputOffset);
+        sqe->len = static_cast<std::uint32_t>(connection.outputSize - connection.outputOffset);
+        sqe->buf_index = 0;
+        sqe->user_data = ringUserData(RingOperation::Write, slot);
+        ++connection.pending;
+    };
+
+    // 送信が終わった後に続けて受信してよいなら受信をつなげる
+    auto armOutput = [&](std::uint32_t slot) {
+        RingConnection& connection = reactor.slots[slot];
+        if (connection.closeAfterWrite || connection.backlogged) {
+            armWrite(slot);
+        } else {
+            armWriteThenRead(slot);
+        }
+    };
+
+    // 受信バッファの要求を処理して、応答の送信か次の受信を始める
+    auto processInput = [&](std::uint32_t slot) {
+        RingConnection& connection = reactor.slots[slot];
+        ServeOutcome outcome;
+        serveInput(service_, protocol_, reactor.input(slot), connection.inputSize, reactor.output(slot),
+                   kRingOutputBytes, outcome);
+        connection.inputSize -= outcome.consumed;
+        std::memmove(reactor.input(slot), reactor.input(slot) + outcome.consumed, connection.inputSize);
+        reactor.requests.fetch_add(outcome.handled, std::memory_order_relaxed);
+        connection.outputSize = outcome.produced;
+        connection.outputOffset = 0;
+        connection.closeAfterWrite = outcome.close;
+        connection.backlogged = outcome.full;
+        if (outcome.produced > 0) {
+            armOutput(slot);
+        } else if (outcome.close) {
+            closeSlot(slot);
+        } else {
+            armRead(slot);
+        }
+    };
+
+    auto accepted = [&](int fd, bool tcp) {
+        if (reactor.freeSlots.empty()) {
+            // 登録済みバッファを割り当てられないので受け付けない
+            ++syscalls;
+            ::close(fd);
+            return;
+        }
+        std::uint32_t slot = reactor.freeSlots.back();
+        reactor.freeSlots.pop_back();
+        reactor.slots[slot].fd = fd;
+        if (tcp) {
+            ++syscalls;
+            setNoDelay(fd);
+        }
+        reactor.connections.fetch_add(1, std::memory_order_relaxed);
+        armRead(slot);
+    };
+
+    if (reactor.tcpListener >= 0) {
+        armAccept(reactor.tcpListener, RingOperation::AcceptTcp);
+    }
+    if (unixListener_ >= 0) {
+        armAccept(unixListener_, RingOperation::AcceptUnix);
+    }
+    {
+        io_uring_sqe* sqe = nextSqe();
+        sqe->opcode = IORING_OP_READ;
+        sqe->fd = reactor.wakeFd;
+        sqe->addr = reinterpret_cast<std::uint64_t>(&reactor.wakeValue);
+        sqe->len = sizeof(reactor.wakeValue);
+        sqe->user_data = ringUserData(RingOperation::Wake);
+    }
+
+    while (true) {
+        // 前の周で積んだ要求の投入と完了待ちを1回のシステムコールで行う
+        ++syscalls;
+        int submitted = ring.submitAndWait(1);
+        if (submitted < 0 && submitted != -EINTR && submitted != -EAGAIN && submitted != -EBUSY) {
+            std::cerr << "io_uring_enter failed: " << std::strerror(-submitted) << std::endl;
+            reactor.addSyscalls(syscalls);
+            return;
+        }
+        io_uring_cqe completion;
+        while (ring.peek(completion)) {
+            auto operation = static_cast<RingOperation>(completion.user_data >> 56);
+            auto slot = static_cast<std::uint32_t>(completion.user_data);
+            int result = completion.res;
+            switch (operation) {
+            case RingOperation::Wake:
+                reactor.addSyscalls(syscalls);
+                return;
+            case RingOperation::AcceptTcp:
+            case RingOperation::AcceptUnix: {
+                bool tcp = operation == RingOperation::AcceptTcp;
+                if (result >= 0) {
+                    accepted(result, tcp);
+                } else if (result != -EINTR && result != -EAGAIN && result != -ECONNABORTED) {
+                    armAcceptRetry(operation);
+                    break;
+                }
+                armAccept(tcp ? reactor.tcpListener : unixListener_, operation);
+                break;
+            }
+            case RingOperation::AcceptRetry: {
+                auto acceptOperation = static_cast<RingOperation>(slot);
+                armAccept(acceptOperation == RingOperation::AcceptTcp ? reactor.tcpListener : unixListener_,
+                          acceptOperation);
+                break;
+            }
+            case RingOperation::Read: {
+                RingConnection& connection = reactor.slots[slot];
+                --connection.pending;
+                if (connection.closing) {
+                    closeSlot(slot);
+                    break;
+                }
+                if (result == -ECANCELED) {
+                    break;  // 送信が途中までだった（送信の完了で受信し直す）
+                }
+                if (result <= 0) {
+                    closeSlot(slot);
+                    break;
+                }
+                connection.inputSize += static_cast<std::size_t>(result);
+                processInput(slot);
+                break;
+            }
+            case RingOperation::Write: {
+                RingConnection& connection = reactor.slots[slot];
+                --connection.pending;
+                if (connection.closing || result < 0) {
+                    closeSlot(slot);
+                    break;
+                }
+                connection.outputOffset += static_cast<std::size_t>(result);
+                if (connection.outputOffset < connection.outputSize) {
+                    armOutput(slot);
+                } else if (connection.closeAfterWrite) {
+                    closeSlot(slot);
+                } else if (connection.backlogged) {
+                    processInput(slot);
+                } else {
+                    // つなげた受信はそのまま実行される
+                    connection.outputSize = 0;
+                    connection.outputOffset = 0;
+                }
+                break;
+            }
+            }
+        }
+        reactor.addSyscalls(syscalls);
+        syscalls = 0;
+    }
+}
+
+QuoteClient::~QuoteClient() {
+    close();
+}
+
+bool QuoteClient::connectTcp(const std::string& address, int port) {
+    close();
+    sockaddr_in target{};
+    target.sin_family = AF_INET;
+    target.sin_port = htons(static_cast<std::uint16_t>(port));
+    if (::inet_pton(AF_INET, address.c_str(), &target.sin_addr) != 1) {
+        return false;
+    }
+    fd_ = ::socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (fd_ < 0 || ::connect(fd_, reinterpret_cast<sockaddr*>(&target), sizeof(target)) != 0) {
+        close();
+        return false;
+    }
+    setNoDelay(fd_);
+    return true;
+}
+
+bool QuoteClient::connectUnix(const std::string& path) {
+    close();
+    sockaddr_un target{};
+    target.sun_family = AF_UNIX;
+    if (path.size() >= sizeof(target.sun_path)) {
+        return false;
+    }
+    std::memcpy(target.sun_path, path.c_str(), path.size() + 1);
+    fd_ = ::socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (fd_ < 0 || ::connect(fd_, reinterpret_cast<sockaddr*>(&target), sizeof(target)) != 0) {
+        close();
+        return false;
+    }
+    return true;
+}
+
+void QuoteClient::close() {
+    if (fd_ >= 0) {
+        ::close(fd_);
+    }
+    fd_ = -1;
+    buffer_.clear();
+}
+
+bool QuoteClient::sendBytes(const char* data, std::size_t size) {
+    while (size > 0) {
+        ssize_t sent = ::send(fd_, data, size, MSG_NOSIGNAL);
+        if (sent < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return false;
+        }
+        data += sent;
+        size -= static_cast<std::size_t>(sent);
+    }
+    return true;
+}
+
+bool QuoteClient::send(const QuoteRequest* requests, std::size_t count) {
+    std::vector<char> frames(count * kQuoteRequestFrameSize);
+    for (std::size_t i = 0; i < count; ++i) {
+        encodeQuoteRequest(requests[i], frames.data() + i * kQuoteRequestFrameSize);
+    }
+    return sendBytes(frames.data(), frames.size());
+}
+
+bool QuoteClient::receive(QuoteResponse* responses, std::size_t count) {
+    std::size_t received = 0;
+    std::size_t offset = 0;
+    char chunk[16 * 1024];
+    while (received < count) {
+        QuoteFrameResult result = decodeQuoteResponse(buffer_.data() + offset, buffer_.size() - offset,
+                                                      responses[received]);
+        if (result == QuoteFrameResult::Invalid) {
+            return false;
+        }
+        if (result == QuoteFrameResult::Complete) {
+            offset += kQuoteResponseFrameSize;
+            ++received;
+            continue;
+        }
+        buffer_.erase(buffer_.begin(), buffer_.begin() + static_cast<std::ptrdiff_t>(offset));
+        offset = 0;
+        ssize_t size = ::recv(fd_, chunk, sizeof(chunk), 0);
+        if (size < 0 && errno == EINTR) {
+            continue;
+        }
+        if (size <= 0) {
+            return false;
+        }
+        buffer_.insert(buffer_.end(), chunk, chunk + size);
+    }
+    buffer_.erase(buffer_.begin(), buffer_.begin() + static_cast<std::ptrdiff_t>(offset));
+    return true;
+}
+
+bool QuoteClient::call(const QuoteRequest& request, QuoteResponse& response) {
+    return send(&request, 1) && receive(&response, 1);
+}
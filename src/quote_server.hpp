@@ -0,0 +1,125 @@
+#ifndef QUOTE_SERVER_HPP
+#define QUOTE_SERVER_HPP
+
+#include "quote_service.hpp"
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+// 受信・送信に使う仕組み
+enum class QuoteServerBackend {
+    Epoll,    // ノンブロッキングソケットと epoll
+    IoUring,  // io_uring（使えない環境では Epoll で動く）
+};
+
+// 要求の形式
+enum class QuoteServerProtocol {
+    Binary,  // quote_protocol.hpp の固定長フレーム
+    Http,    // http_quote.hpp の HTTP/1.1 + JSON
+};
+
+// QuoteServer の設定
+struct QuoteServerOptions {
+    std::string bindAddress = "127.0.0.1";
+    int tcpPort = 0;              // 0なら空いているポートを使う（tcpPort() で分かる）、-1ならTCPで受け付けない
+    std::string unixPath;         // 空ならUnixドメインソケットで受け付けない（既存のファイルは置き換える）
+    std::size_t reactorCount = 0; // 0ならCPUの数
+    int backlog = 1024;
+    QuoteServerProtocol protocol = QuoteServerProtocol::Binary;
+    QuoteServerBackend backend = QuoteServerBackend::Epoll;
+    std::size_t ioUringConnections = 256;  // IoUring でリアクターごとに同時に受け付ける接続の数（超えた接続はすぐ閉じる）
+};
+
+// 料金見積もりサーバー（quote_protocol.hpp か http_quote.hpp の要求を TCP・Unixドメインソケットで受け付ける）
+//
+// CPUごとにリアクター（epoll とスレッド）を1つ持ち、接続は受け付けたリアクターが最後まで処理する
+// - TCP は各リアクターが SO_REUSEPORT で同じポートに listen し、カーネルが接続を振り分ける
+// - Unixドメインソケットは1つの listen ソケットを全リアクターが EPOLLEXCLUSIVE で待つ
+// - ソケットはノンブロッキングで、受信したフレームをまとめて処理し、応答もまとめて送る
+//   送りきれない間だけ EPOLLOUT を待ち、未送信の応答がたまったら受信を止める
+// - IoUring ではリアクターごとに io_uring を1つ持ち、接続ごとの受信・送信バッファを登録済みバッファから割り当てる
+//   受信と送信は READ_FIXED / WRITE_FIXED で行い、1周の間に積んだ要求は1回の io_uring_enter でまとめて投入する
+//   （待つのも同じ io_uring_enter なので、1周あたりのシステムコールは1回）
+class QuoteServer {
+public:
+    // service は QuoteServer より長く生存すること
+    explicit QuoteServer(QuoteService& service);
+    ~QuoteServer();
+
+    QuoteServer(const QuoteServer&) = delete;
+    QuoteServer& operator=(const QuoteServer&) = delete;
+
+    // ソケットを開いてリアクターのスレッドを起動する（失敗したらfalseで、何も残さない）
+    bool start(const QuoteServerOptions& options = QuoteServerOptions());
+
+    // 全てのリアクターを止めて接続を閉じる
+    void stop();
+
+    bool isRunning() const { return !reactors_.empty(); }
+    int tcpPort() const { return tcpPort_; }
+    std::size_t reactorCount() const { return reactors_.size(); }
+
+    // 実際に使っている仕組み（IoUring を指定しても使えなければ Epoll）
+    QuoteServerBackend backend() const { return backend_; }
+
+    // 処理した要求・受け付けた接続の数（全リアクターの合計）
+    std::uint64_t requestCount() const;
+    std::uint64_t connectionCount() const;
+
+    // リアクターが呼んだシステムコールの数（全リアクターの合計、accept も含む）
+    std::uint64_t syscallCount() const;
+
+private:
+    struct Reactor;
+
+    bool openTcpListener(const QuoteServerOptions& options, int& fd);
+    bool openUnixListener(const QuoteServerOptions& options);
+    bool setUpIoUring(Reactor& reactor, std::size_t connections);
+    void run(Reactor& reactor);
+    void runIoUring(Reactor& reactor);
+    void closeAll();
+
+    QuoteService& service_;
+    std::vector<std::unique_ptr<Reactor>> reactors_;
+    int unixListener_ = -1;
+    std::string unixPath_;
+    int tcpPort_ = -1;
+    QuoteServerBackend backend_ = QuoteServerBackend::Epoll;
+    QuoteServerProtocol protocol_ = QuoteServerProtocol::Binary;
+};
+
+// 要求を送って応答を待つ簡単なクライアント（ブロッキング、テスト・ベンチマーク用）
+class QuoteClient {
+public:
+    QuoteClient() = default;
+    ~QuoteClient();
+
+    QuoteClient(const QuoteClient&) = delete;
+    QuoteClient& operator=(const QuoteClient&) = delete;
+
+    bool connectTcp(const std::string& address, int port);
+    bool connectUnix(const std::string& path);
+    void close();
+    bool isConnected() const { return fd_ >= 0; }
+
+    // count 件の要求をまとめて送る・count 件の応答を受け取る（パイプライン）
+    bool send(const QuoteRequest* requests, std::size_t count);
+    bool receive(QuoteResponse* responses, std::size_t count);
+
+    // 1件送って応答を待つ
+    bool call(const QuoteRequest& request, QuoteResponse& response);
+
+    // 生のバイト列を送る（不正なフレームのテスト用）
+    bool sendBytes(const char* data, std::size_t size);
+
+    int fd() const { return fd_; }
+
+private:
+    int fd_ = -1;
+    std::vector<char> buffer_;
+};
+
+#endif // QUOTE_SERVER_HPP
@@ -0,0 +1,46 @@
+#include "quote_service.hpp"
+
+QuoteService::QuoteService(std::size_t shardCount, std::size_t expectedSessions)
+    : sessions_(shardCount, expectedSessions) {}
+
+bool QuoteService::addLot(std::uint32_t lotId, const StayPricingEngine& pricing) {
+    if (!sessions_.addLot(lotId, pricing)) {
+        return false;
+    }
+    if (lotId >= lots_.size()) {
+        lots_.resize(static_cast<std::size_t>(lotId) + 1);
+    }
+    lots_[lotId].emplace(pricing);
+    return true;
+}
+
+void QuoteService::handle(const QuoteRequest& request, QuoteResponse& response) {
+    response = QuoteResponse{request.opcode, QuoteStatus::Ok, request.requestId, 0};
+    switch (request.opcode) {
+    case QuoteOpcode::Quote:
+        if (request.lotId >= lots_.size() || !lots_[request.lotId]) {
+            response.status = QuoteStatus::NotFound;
+        } else if (!lots_[request.lotId]->quoteTotal(request.startTime, request.endTime, response.fee)) {
+            response.status = QuoteStatus::Rejected;
+        }
+        return;
+    case QuoteOpcode::Entry:
+        if (request.lotId >= lots_.size() || !lots_[request.lotId]) {
+            response.status = QuoteStatus::NotFound;
+        } else if (!sessions_.entry(request.ticketId, request.lotId, request.startTime)) {
+            response.status = QuoteStatus::Rejected;
+        }
+        return;
+    case QuoteOpcode::Exit: {
+        OpenSession open;
+        ClosedSession closed;
+        if (sessions_.exit(request.ticketId, request.endTime, closed)) {
+            response.fee = closed.fee;
+        } else {
+            response.status = sessions_.find(request.ticketId, open) ? QuoteStatus::Rejected : QuoteStatus::NotFound;
+        }
+        return;
+    }
+    }
+    response.status = QuoteStatus::BadRequest;
+}
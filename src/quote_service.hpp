@@ -0,0 +1,30 @@
+#ifndef QUOTE_SERVICE_HPP
+#define QUOTE_SERVICE_HPP
+
+#include "quote_protocol.hpp"
+#include "sharded_session_store.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <vector>
+
+// 料金見積もり・入出庫の要求を処理する（通信方式によらない部分）
+// addLot は要求を受け付け始める前に済ませること。それ以降の handle はスレッドセーフ
+class QuoteService {
+public:
+    explicit QuoteService(std::size_t shardCount = 64, std::size_t expectedSessions = 1024);
+
+    // 駐車場の料金体系を登録（番号が SessionStore::kMaxLots 以上ならfalse）
+    bool addLot(std::uint32_t lotId, const StayPricingEngine& pricing);
+
+    // 要求を処理して応答を作る
+    void handle(const QuoteRequest& request, QuoteResponse& response);
+
+    ShardedSessionStore& sessions() { return sessions_; }
+
+private:
+    ShardedSessionStore sessions_;
+    std::vector<std::optional<StayPricingEngine>> lots_;
+};
+
+#endif // QUOTE_SERVICE_HPP
@@ -0,0 +1,45 @@
+#include "rate_history.hpp"
+#include <numeric>
+
+RateHistoryIndex::RateHistoryIndex(const RateVersionList& versions) {
+    // 種別ごとに版の位置を集め、適用開始の順に並べる（同じ適用開始は元の順を保つ）
+    std::unordered_map<std::string, std::vector<std::size_t>> positions;
+    for (std::size_t i = 0; i < versions.size(); ++i) {
+        positions[versions[i].type].push_back(i);
+    }
+
+    timelines_.reserve(positions.size());
+    for (auto& entry : positions) {
+        std::vector<std::size_t>& order = entry.second;
+        std::stable_sort(order.begin(), order.end(), [&](std::size_t a, std::size_t b) {
+            return versions[a].effectiveFrom < versions[b].effectiveFrom;
+        });
+
+        Timeline& timeline = timelines_[entry.first];
+        timeline.starts_.reserve(order.size());
+        timeline.configs_.reserve(order.size());
+        for (std::size_t index : order) {
+            const RateVersion& version = versions[index];
+            if (!timeline.starts_.empty() && timeline.starts_.back() == version.effectiveFrom) {
+                timeline.configs_.back() = version.config;
+                continue;
+            }
+            timeline.starts_.push_back(version.effectiveFrom);
+            timeline.configs_.push_back(version.config);
+        }
+    }
+}
+
+bool RateHistoryIndex::load(ParkingRateRepository& repository) {
+    RateVersionList versions;
+    if (!repository.loadVersions(versions)) {
+        return false;
+    }
+    *this = RateHistoryIndex(versions);
+    return true;
+}
+
+std::size_t RateHistoryIndex::versionCount() const {
+    return std::accumulate(timelines_.begin(), timelines_.end(), std::size_t(0),
+                           [](std::size_t total, const auto& entry) { return total + entry.second.size(); });
+}
@@ -0,0 +1,69 @@
+#ifndef RATE_HISTORY_HPP
+#define RATE_HISTORY_HPP
+
+#include "parking_rate_repository.hpp"
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// 料金設定の履歴をメモリに展開した索引
+// 過去の駐車記録をまとめて再計算する際に、記録ごとにDBへ問い合わせずに
+// 「その時点で適用されていた版」を二分探索（O(log 版数)）で求める
+class RateHistoryIndex {
+public:
+    // 1つの種別の版の並び（適用開始の昇順）
+    class Timeline {
+    public:
+        // timestamp（エポック秒）の時点で適用されていた版（最初の版より前ならnullptr）
+        const ParkingRateConfig* find(std::int64_t timestamp) const {
+            auto it = std::upper_bound(starts_.begin(), starts_.end(), timestamp);
+            if (it == starts_.begin()) {
+                return nullptr;
+            }
+            return &configs_[static_cast<std::size_t>(it - starts_.begin()) - 1];
+        }
+
+        std::size_t size() const { return starts_.size(); }
+        std::int64_t effectiveFrom(std::size_t index) const { return starts_[index]; }
+        const ParkingRateConfig& config(std::size_t index) const { return configs_[index]; }
+
+    private:
+        friend class RateHistoryIndex;
+
+        // 二分探索で触るのは適用開始だけなので、設定とは別の配列に置く
+        std::vector<std::int64_t> starts_;
+        std::vector<ParkingRateConfig> configs_;
+    };
+
+    RateHistoryIndex() = default;
+
+    // 版の一覧から構築（順不同でよい。同じ種別・適用開始の版は後のものを使う）
+    explicit RateHistoryIndex(const RateVersionList& versions);
+
+    // リポジトリの全ての版で置き換える（読み込めなければ何も変えずにfalse）
+    bool load(ParkingRateRepository& repository);
+
+    // 種別の版の並び（種別がなければnullptr）
+    // 同じ種別の記録を続けて引く場合は、これを一度求めてから Timeline::find を使う
+    const Timeline* timeline(const std::string& type) const {
+        auto it = timelines_.find(type);
+        return it != timelines_.end() ? &it->second : nullptr;
+    }
+
+    // timestamp の時点で適用されていた版（見つからなければnullptr）
+    const ParkingRateConfig* find(const std::string& type, std::int64_t timestamp) const {
+        const Timeline* versions = timeline(type);
+        return versions ? versions->find(timestamp) : nullptr;
+    }
+
+    std::size_t typeCount() const { return timelines_.size(); }
+    std::size_t versionCount() const;
+
+private:
+    std::unordered_map<std::string, Timeline> timelines_;
+};
+
+#endif // RATE_HISTORY_HPP
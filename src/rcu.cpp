@@ -0,0 +1,85 @@
+#include "rcu.hpp"
+#include <thread>
+
+namespace {
+
+// 読み取り中のスレッドが記録するスロット（0は読み取り中でないことを表す）
+struct alignas(64) ReaderSlot {
+    std::atomic<std::uint64_t> epoch{0};
+    std::atomic<bool> inUse{false};
+    ReaderSlot* next = nullptr;
+};
+
+// 全スロットの連結リスト（スロットは解放せず、終了したスレッドのものを再利用する）
+std::atomic<ReaderSlot*> slotHead{nullptr};
+
+// 書き込みのたびに進めるエポック
+std::atomic<std::uint64_t> globalEpoch{1};
+
+ReaderSlot* acquireSlot() {
+    for (ReaderSlot* slot = slotHead.load(std::memory_order_acquire); slot; slot = slot->next) {
+        bool expected = false;
+        if (!slot->inUse.load(std::memory_order_relaxed) &&
+            slot->inUse.compare_exchange_strong(expected, true, std::memory_order_acquire)) {
+            return slot;
+        }
+    }
+
+    ReaderSlot* slot = new ReaderSlot();
+    slot->inUse.store(true, std::memory_order_relaxed);
+    ReaderSlot* head = slotHead.load(std::memory_order_relaxed);
+    do {
+        slot->next = head;
+    } while (!slotHead.compare_exchange_weak(head, slot, std::memory_order_release, std::memory_order_relaxed));
+    return slot;
+}
+
+// スレッドごとのスロットと入れ子の深さ
+struct ThreadReader {
+    ReaderSlot* slot = nullptr;
+    int depth = 0;
+
+    ~ThreadReader() {
+        if (slot) {
+            slot->epoch.store(0, std::memory_order_release);
+            slot->inUse.store(false, std::memory_order_release);
+        }
+    }
+};
+
+thread_local ThreadReader threadReader;
+
+} // namespace
+
+RcuReadGuard::RcuReadGuard() {
+    ThreadReader& reader = threadReader;
+    if (reader.depth++ == 0) {
+        if (!reader.slot) {
+            reader.slot = acquireSlot();
+        }
+        // 以降のポインタの読み込みより前にエポックが見えるよう seq_cst で書く
+        reader.slot->epoch.store(globalEpoch.load(std::memory_order_seq_cst), std::memory_order_seq_cst);
+    }
+}
+
+RcuReadGuard::~RcuReadGuard() {
+    ThreadReader& reader = threadReader;
+    if (--reader.depth == 0) {
+        reader.slot->epoch.store(0, std::memory_order_release);
+    }
+}
+
+void rcuSynchronize() {
+    // 新しいエポック以降に始まった読み取りは、差し替え後の値しか見ない
+    std::uint64_t target = globalEpoch.fetch_add(1, std::memory_order_seq_cst) + 1;
+
+    for (ReaderSlot* slot = slotHead.load(std::memory_order_acquire); slot; slot = slot->next) {
+        for (;;) {
+            std::uint64_t epoch = slot->epoch.load(std::memory_order_seq_cst);
+            if (epoch == 0 || epoch >= target) {
+                break;
+            }
+            std::this_thread::yield();
+        }
+    }
+}
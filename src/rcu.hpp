@@ -0,0 +1,62 @@
+#ifndef RCU_HPP
+#define RCU_HPP
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+
+// エポックベースのRCU（Read-Copy-Update）
+//
+// 読み取り側は RcuReadGuard の生存期間中、RcuCell から読んだポインタを安全に参照できる。
+// 読み取り側の処理はスレッドごとのスロットへのエポックの書き込みだけで、ロックも待ちもない。
+// 書き込み側は新しい値に差し替えた後、古い値を読んでいる可能性のある読み取りが
+// 全て終わるのを待ってから古い値を破棄する（読み取り側は止めない）。
+
+// 読み取り区間（入れ子にできる）
+class RcuReadGuard {
+public:
+    RcuReadGuard();
+    ~RcuReadGuard();
+
+    RcuReadGuard(const RcuReadGuard&) = delete;
+    RcuReadGuard& operator=(const RcuReadGuard&) = delete;
+};
+
+// 差し替え前に開始された全ての読み取り区間が終わるまで待つ
+// 読み取り区間の中から呼んではいけない
+void rcuSynchronize();
+
+// RCUで公開する不変の値
+template <typename T>
+class RcuCell {
+public:
+    explicit RcuCell(std::unique_ptr<const T> initial = nullptr) : current_(initial.release()) {
+    }
+
+    ~RcuCell() {
+        delete current_.load(std::memory_order_acquire);
+    }
+
+    RcuCell(const RcuCell&) = delete;
+    RcuCell& operator=(const RcuCell&) = delete;
+
+    // 読み取り区間の中で呼ぶこと。返したポインタは区間の終わりまで有効
+    const T* read() const {
+        return current_.load(std::memory_order_seq_cst);
+    }
+
+    // 値を差し替え、古い値を読んでいる読み取りが終わってから破棄する
+    // 書き込み同士の排他は呼び出し側で行う
+    void publish(std::unique_ptr<const T> value) {
+        const T* old = current_.exchange(value.release(), std::memory_order_seq_cst);
+        if (old) {
+            rcuSynchronize();
+            delete old;
+        }
+    }
+
+private:
+    std::atomic<const T*> current_;
+};
+
+#endif // RCU_HPP
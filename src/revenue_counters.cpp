@@ -0,0 +1,54 @@
+#include "revenue_counters.hpp"
+#include <limits>
+
+RevenueCounters::RevenueCounters(int retainDays, int utcOffsetSeconds)
+    : retainDays_(retainDays > 0 ? retainDays : 1),
+      utcOffsetSeconds_(utcOffsetSeconds),
+      newestDay_(std::numeric_limits<std::int64_t>::min()) {}
+
+void RevenueCounters::addExit(std::uint32_t lotId, std::int64_t time, std::int64_t fee) {
+    DailyRevenue* revenue = counterFor(lotId, floorDiv(time + utcOffsetSeconds_, kSecondsPerDay));
+    if (revenue) {
+        ++revenue->exits;
+        revenue->fees += fee;
+    }
+}
+
+void RevenueCounters::addPayment(std::uint32_t lotId, std::int64_t time, std::int64_t amount) {
+    DailyRevenue* revenue = counterFor(lotId, floorDiv(time + utcOffsetSeconds_, kSecondsPerDay));
+    if (revenue) {
+        revenue->payments += amount;
+    }
+}
+
+void RevenueCounters::merge(const DailyRevenue& source) {
+    DailyRevenue* revenue = counterFor(source.lotId, source.day);
+    if (revenue) {
+        revenue->exits += source.exits;
+        revenue->fees += source.fees;
+        revenue->payments += source.payments;
+    }
+}
+
+std::vector<DailyRevenue> RevenueCounters::list() const {
+    std::vector<DailyRevenue> result;
+    result.reserve(counters_.size());
+    for (const auto& entry : counters_) {
+        result.push_back(entry.second);
+    }
+    return result;
+}
+
+DailyRevenue* RevenueCounters::counterFor(std::uint32_t lotId, std::int64_t day) {
+    if (day > newestDay_) {
+        newestDay_ = day;
+        // 保持する期間より前の日を捨てる（キーは日付が先なので先頭から）
+        auto end = counters_.lower_bound(std::make_pair(newestDay_ - retainDays_ + 1, std::uint32_t(0)));
+        counters_.erase(counters_.begin(), end);
+    }
+    if (day <= newestDay_ - retainDays_) {
+        return nullptr;
+    }
+    auto it = counters_.emplace(std::make_pair(day, lotId), DailyRevenue{lotId, day, 0, 0, 0}).first;
+    return &it->second;
+}
@@ -0,0 +1,47 @@
+#ifndef REVENUE_COUNTERS_HPP
+#define REVENUE_COUNTERS_HPP
+
+#include "civil_time.hpp"
+#include <cstdint>
+#include <map>
+#include <utility>
+#include <vector>
+
+// 駐車場・日ごとの売上
+struct DailyRevenue {
+    std::uint32_t lotId;
+    std::int64_t day;       // 1970-01-01を0とする現地の日数
+    std::uint64_t exits;    // 出庫台数
+    std::int64_t fees;      // 出庫時の料金の合計
+    std::int64_t payments;  // 精算額の合計
+};
+
+// 直近 retainDays 日分の日ごとの売上
+// 新しい日の記録が来ると、その日から retainDays 日より前の日を捨てる（それより古い記録は数えない）
+// スレッドセーフではない
+class RevenueCounters {
+public:
+    explicit RevenueCounters(int retainDays = 31, int utcOffsetSeconds = kJstUtcOffsetSeconds);
+
+    // time（エポック秒）の現地の日に加える
+    void addExit(std::uint32_t lotId, std::int64_t time, std::int64_t fee);
+    void addPayment(std::uint32_t lotId, std::int64_t time, std::int64_t amount);
+
+    // 集計済みの値を足し込む（スナップショットからの復元・シャードごとの集計の合算）
+    void merge(const DailyRevenue& revenue);
+
+    // 日付・駐車場の順
+    std::vector<DailyRevenue> list() const;
+
+    int utcOffsetSeconds() const { return utcOffsetSeconds_; }
+
+private:
+    DailyRevenue* counterFor(std::uint32_t lotId, std::int64_t day);
+
+    int retainDays_;
+    int utcOffsetSeconds_;
+    std::int64_t newestDay_;
+    std::map<std::pair<std::int64_t, std::uint32_t>, DailyRevenue> counters_;
+};
+
+#endif // REVENUE_COUNTERS_HPP
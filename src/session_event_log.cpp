@@ -0,0 +1,590 @@
+#include "session_event_log.hpp"
+#include "crc32c.hpp"
+#include "io_uring_queue.hpp"
+#include <dirent.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <algorithm>
+#include <cerrno>
+#include <cinttypes>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+
+namespace {
+
+const char kSegmentMagic[8] = {'P', 'K', 'E', 'V', 'T', 'L', 'O', 'G'};
+constexpr std::uint32_t kSegmentFormatVersion = 1;
+
+struct SegmentHeader {
+    char magic[8];                // "PKEVTLOG"
+    std::uint32_t formatVersion;
+    std::uint32_t headerCrc;      // このフィールドを0にしたヘッダーの CRC-32C
+    std::uint64_t firstSequence;  // このセグメントの最初のイベントの通し番号
+    std::uint64_t reserved;
+};
+
+static_assert(sizeof(SegmentHeader) == 32, "セグメントのヘッダーは32バイト");
+
+// io_uring で書くときに1回の書き込みにまとめる大きさ（登録済みバッファ）
+constexpr std::size_t kRingStagingBytes = 256 * 1024;
+
+// レコードの枠（この後に SessionEvent が続く）
+struct RecordFrame {
+    std::uint32_t length;  // SessionEvent の大きさ
+    std::uint32_t crc;     // SessionEvent の CRC-32C
+};
+
+constexpr std::size_t kRecordSize = sizeof(RecordFrame) + sizeof(SessionEvent);
+
+std::uint32_t headerChecksum(const SegmentHeader& header) {
+    SegmentHeader copy = header;
+    copy.headerCrc = 0;
+    return crc32c(&copy, sizeof(copy));
+}
+
+std::string segmentPath(const std::string& directory, std::uint64_t firstSequence) {
+    char name[48];
+    std::snprintf(name, sizeof(name), "segment-%020" PRIu64 ".log", firstSequence);
+    return directory + "/" + name;
+}
+
+// ディレクトリ内のセグメントの最初の通し番号（昇順）
+bool listSegments(const std::string& directory, std::vector<std::uint64_t>& segments) {
+    DIR* dir = ::opendir(directory.c_str());
+    if (!dir) {
+        return false;
+    }
+    while (dirent* entry = ::readdir(dir)) {
+        std::uint64_t firstSequence = 0;
+        char suffix[8] = {};
+        if (std::sscanf(entry->d_name, "segment-%20" SCNu64 ".%4s", &firstSequence, suffix) == 2 &&
+            std::strcmp(suffix, "log") == 0) {
+            segments.push_back(firstSequence);
+        }
+    }
+    ::closedir(dir);
+    std::sort(segments.begin(), segments.end());
+    return true;
+}
+
+bool writeAll(int fd, const char* data, std::size_t size) {
+    while (size > 0) {
+        ssize_t written = ::write(fd, data, size);
+        if (written < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return false;
+        }
+        data += written;
+        size -= static_cast<std::size_t>(written);
+    }
+    return true;
+}
+
+void syncDirectory(const std::string& directory) {
+    int fd = ::open(directory.c_str(), O_RDONLY);
+    if (fd >= 0) {
+        ::fsync(fd);
+        ::close(fd);
+    }
+}
+
+} // namespace
+
+SessionEventLog::SessionEventLog() = default;
+
+SessionEventLog::~SessionEventLog() {
+    close();
+}
+
+bool SessionEventLog::open(const std::string& directory, const SessionEventLogOptions& options,
+                           const ReplayHandler& replay) {
+    close();
+
+    if (::mkdir(directory.c_str(), 0755) != 0 && errno != EEXIST) {
+        std::cerr << "Can't create session log directory: " << directory << std::endl;
+        return false;
+    }
+    std::vector<std::uint64_t> segments;
+    if (!listSegments(directory, segments)) {
+        std::cerr << "Can't read session log directory: " << directory << std::endl;
+        return false;
+    }
+
+    // 全セグメントを順に読み直す（通し番号はセグメントをまたいで連続していること）
+    std::uint64_t nextSequence = segments.empty() ? 1 : segments.front();
+    for (std::size_t i = 0; i < segments.size(); ++i) {
+        if (segments[i] != nextSequence) {
+            std::cerr << "Session log sequence gap before: " << segmentPath(directory, segments[i]) << std::endl;
+            return false;
+        }
+        std::uint64_t eventCount = 0;
+        if (!replaySegment(segmentPath(directory, segments[i]), segments[i], i + 1 == segments.size(), replay,
+                           eventCount)) {
+            return false;
+        }
+        nextSequence = segments[i] + eventCount;
+    }
+
+    // replay は呼び出し側のロックを取ることがあるので、再生が終わってからロックする
+    std::lock_guard<std::mutex> lock(mutex_);
+    directory_ = directory;
+    options_ = options;
+    segments_ = segments;
+    nextSequence_ = nextSequence;
+    bufferFirstSequence_ = nextSequence;
+    committedSequence_ = nextSequence - 1;
+    buffer_.clear();
+    failed_ = false;
+    lastSync_ = std::chrono::steady_clock::now();
+
+    if (options.ioUring) {
+        ring_ = std::make_unique<IoUringQueue>();
+        staging_.reset(new char[kRingStagingBytes]);
+        iovec staging{staging_.get(), kRingStagingBytes};
+        if (!ring_->open(8) || !ring_->registerBuffers(&staging, 1)) {
+            std::cerr << "io_uring is unavailable, falling back to write" << std::endl;
+            ring_.reset();
+            staging_.reset();
+        }
+    }
+
+    // 最後のセグメントの続きに追記する（ヘッダーを書く途中で止まっていた場合は作り直す）
+    struct stat status;
+    std::string path = segments_.empty() ? std::string() : segmentPath(directory, segments_.back());
+    if (!segments_.empty() && ::stat(path.c_str(), &status) == 0 &&
+        status.st_size >= static_cast<off_t>(sizeof(SegmentHeader))) {
+        fd_ = ::open(path.c_str(), O_WRONLY | O_APPEND | O_CLOEXEC);
+        if (fd_ < 0) {
+            std::cerr << "Can't open session log segment: " << path << std::endl;
+            return false;
+        }
+        segmentSize_ = static_cast<std::uint64_t>(status.st_size);
+    } else {
+        if (!segments_.empty()) {
+            segments_.pop_back();
+        }
+        if (!openSegment(nextSequence)) {
+            return false;
+        }
+        segments_.push_back(nextSequence);
+    }
+    open_ = true;
+    return true;
+}
+
+bool SessionEventLog::replaySegment(const std::string& path, std::uint64_t firstSequence, bool last,
+                                    const ReplayHandler& replay, std::uint64_t& eventCount) {
+    eventCount = 0;
+    int fd = ::open(path.c_str(), last ? O_RDWR | O_CLOEXEC : O_RDONLY | O_CLOEXEC);
+    struct stat status;
+    if (fd < 0 || ::fstat(fd, &status) != 0) {
+        std::cerr << "Can't open session log segment: " << path << std::endl;
+        if (fd >= 0) {
+            ::close(fd);
+        }
+        return false;
+    }
+    std::size_t size = static_cast<std::size_t>(status.st_size);
+    if (size < sizeof(SegmentHeader)) {
+        ::close(fd);
+        if (last) {
+            // ヘッダーを書く途中で止まったセグメント（open で作り直す）
+            return true;
+        }
+        std::cerr << "Invalid session log segment: " << path << std::endl;
+        return false;
+    }
+
+    void* base = ::mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (base == MAP_FAILED) {
+        std::cerr << "Can't map session log segment: " << path << std::endl;
+        ::close(fd);
+        return false;
+    }
+    ::madvise(base, size, MADV_SEQUENTIAL);
+    const char* bytes = static_cast<const char*>(base);
+
+    SegmentHeader header;
+    std::memcpy(&header, bytes, sizeof(header));
+    bool valid = std::memcmp(header.magic, kSegmentMagic, sizeof(kSegmentMagic)) == 0 &&
+                 header.formatVersion == kSegmentFormatVersion && header.headerCrc == headerChecksum(header) &&
+                 header.firstSequence == firstSequence;
+    if (!valid) {
+        std::cerr << "Invalid session log segment: " << path << std::endl;
+        ::munmap(base, size);
+        ::close(fd);
+        return false;
+    }
+
+    bool replayed = true;
+    std::size_t offset = sizeof(SegmentHeader);
+    while (offset + kRecordSize <= size) {
+        RecordFrame frame;
+        SessionEvent event;
+        std::memcpy(&frame, bytes + offset, sizeof(frame));
+        std::memcpy(&event, bytes + offset + sizeof(frame), sizeof(event));
+        if (frame.length != sizeof(SessionEvent) || frame.crc != crc32c(&event, sizeof(event)) ||
+            event.sequence != firstSequence + eventCount) {
+            break;
+        }
+        if (replay && !replay(event)) {
+            std::cerr << "Session log replay rejected event " << event.sequence << ": " << path << std::endl;
+            replayed = false;
+            break;
+        }
+        offset += kRecordSize;
+        ++eventCount;
+    }
+    ::munmap(base, size);
+
+    if (replayed && offset != size) {
+        if (!last) {
+            std::cerr << "Corrupted session log segment: " << path << std::endl;
+            replayed = false;
+        } else if (::ftruncate(fd, static_cast<off_t>(offset)) != 0 || ::fsync(fd) != 0) {
+            // 書きかけの末尾を切り詰めて、続きから追記できるようにする
+            std::cerr << "Can't truncate session log segment: " << path << std::endl;
+            replayed = false;
+        }
+    }
+    ::close(fd);
+    return replayed;
+}
+
+bool SessionEventLog::openSegment(std::uint64_t firstSequence) {
+    std::string path = segmentPath(directory_, firstSequence);
+    int fd = ::open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_APPEND | O_CLOEXEC, 0644);
+    if (fd < 0) {
+        std::cerr << "Can't create session log segment: " << path << std::endl;
+        return false;
+    }
+    SegmentHeader header{};
+    std::memcpy(header.magic, kSegmentMagic, sizeof(kSegmentMagic));
+    header.formatVersion = kSegmentFormatVersion;
+    header.firstSequence = firstSequence;
+    header.headerCrc = headerChecksum(header);
+    if (!writeAll(fd, reinterpret_cast<const char*>(&header), sizeof(header)) || ::fsync(fd) != 0) {
+        std::cerr << "Can't write session log segment: " << path << std::endl;
+        ::close(fd);
+        return false;
+    }
+    syncDirectory(directory_);
+
+    closeSegment();
+    fd_ = fd;
+    segmentSize_ = sizeof(header);
+    return true;
+}
+
+void SessionEventLog::closeSegment() {
+    if (fd_ >= 0) {
+        ::close(fd_);
+    }
+    fd_ = -1;
+    segmentSize_ = 0;
+}
+
+void SessionEventLog::close() {
+    flush();
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (fd_ >= 0 && options_.sync != EventLogSync::Always) {
+        ::fsync(fd_);
+    }
+    closeSegment();
+    ring_.reset();
+    staging_.reset();
+    open_ = false;
+}
+
+bool SessionEventLog::usesIoUring() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return ring_ != nullptr;
+}
+
+bool SessionEventLog::isOpen() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return open_;
+}
+
+std::uint64_t SessionEventLog::append(SessionEventType type, std::uint64_t ticketId, std::uint32_t lotId,
+                                      std::int64_t time, std::int64_t amount) {
+    SessionEvent event{};
+    event.ticketId = ticketId;
+    event.time = time;
+    event.amount = amount;
+    event.lotId = lotId;
+    event.type = type;
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!open_) {
+        return 0;
+    }
+    event.sequence = nextSequence_++;
+    RecordFrame frame{static_cast<std::uint32_t>(sizeof(event)), crc32c(&event, sizeof(event))};
+    std::size_t offset = buffer_.size();
+    buffer_.resize(offset + kRecordSize);
+    std::memcpy(buffer_.data() + offset, &frame, sizeof(frame));
+    std::memcpy(buffer_.data() + offset + sizeof(frame), &event, sizeof(event));
+    return event.sequence;
+}
+
+bool SessionEventLog::commit(std::uint64_t sequence) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    // 他のスレッドが書いている間は待ち、その書き込みに含まれていれば終わる
+    for (;;) {
+        if (failed_) {
+            return false;
+        }
+        if (committedSequence_ >= sequence) {
+            return true;
+        }
+        if (!committing_) {
+            break;
+        }
+        committed_.wait(lock);
+    }
+    if (!open_ || sequence >= nextSequence_) {
+        return false;
+    }
+
+    // それまでに積まれた全てのイベントをまとめて書く
+    committing_ = true;
+    std::vector<char> batch;
+    batch.swap(spare_);
+    batch.swap(buffer_);
+    std::uint64_t firstSequence = bufferFirstSequence_;
+    std::uint64_t lastSequence = nextSequence_ - 1;
+    bufferFirstSequence_ = nextSequence_;
+    lock.unlock();
+
+    bool written = writeBatch(batch, firstSequence);
+    batch.clear();
+
+    lock.lock();
+    spare_.swap(batch);
+    committing_ = false;
+    if (written) {
+        committedSequence_ = lastSequence;
+    } else {
+        failed_ = true;
+    }
+    committed_.notify_all();
+    return written;
+}
+
+bool SessionEventLog::writeBatch(const std::vector<char>& batch, std::uint64_t firstSequence) {
+    if (batch.empty()) {
+        return true;
+    }
+    // 大きくなったセグメントは閉じ、このバッチから次のセグメントに書く
+    if (segmentSize_ >= options_.segmentBytes) {
+        if (options_.sync != EventLogSync::Always && ::fsync(fd_) != 0) {
+            return false;
+        }
+        if (!openSegment(firstSequence)) {
+            return false;
+        }
+        std::lock_guard<std::mutex> lock(mutex_);
+        segments_.push_back(firstSequence);
+    }
+
+    std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+    bool sync = options_.sync == EventLogSync::Always ||
+                (options_.sync == EventLogSync::Interval &&
+                 now - lastSync_ >= std::chrono::milliseconds(options_.syncIntervalMs));
+    // fsync しないコミットは write でも1回なので、io_uring は使わない
+    // （O_APPEND のファイルへの書き込みはカーネルのワーカースレッドに回され、かえって遅い）
+    if (ring_ && sync) {
+        if (!writeWithRing(batch.data(), batch.size(), sync)) {
+            return false;
+        }
+    } else {
+        if (!writeAll(fd_, batch.data(), batch.size())) {
+            std::cerr << "Can't write session log: " << directory_ << std::endl;
+            return false;
+        }
+        if (sync && ::fdatasync(fd_) != 0) {
+            std::cerr << "Can't sync session log: " << directory_ << std::endl;
+            return false;
+        }
+    }
+    segmentSize_ += batch.size();
+    if (sync) {
+        lastSync_ = now;
+    }
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    ++writeCount_;
+    if (sync) {
+        ++syncCount_;
+    }
+    return true;
+}
+
+bool SessionEventLog::writeWithRing(const char* data, std::size_t size, bool sync) {
+    while (size > 0) {
+        std::size_t chunk = std::min(size, kRingStagingBytes);
+        bool last = chunk == size;
+        std::memcpy(staging_.get(), data, chunk);
+
+        // 最後の書き込みには fsync をつなげ、書き込みが終わってから実行させる
+        io_uring_sqe* write = ring_->getSqe();
+        write->opcode = IORING_OP_WRITE_FIXED;
+        write->fd = fd_;
+        write->off = static_cast<std::uint64_t>(-1);  // O_APPEND なので末尾に書く
+        write->addr = reinterpret_cast<std::uint64_t>(staging_.get());
+        write->len = static_cast<std::uint32_t>(chunk);
+        write->buf_index = 0;
+        unsigned waitCount = 1;
+        if (last && sync) {
+            write->flags |= IOSQE_IO_LINK;
+            io_uring_sqe* fsync = ring_->getSqe();
+            fsync->opcode = IORING_OP_FSYNC;
+            fsync->fd = fd_;
+            fsync->fsync_flags = IORING_FSYNC_DATASYNC;
+            fsync->user_data = 1;
+            waitCount = 2;
+        }
+        int submitted = ring_->submitAndWait(waitCount);
+        while (submitted == -EINTR) {
+            submitted = ring_->submitAndWait(waitCount);
+        }
+
+        int written = -EIO;
+        int synced = 0;
+        io_uring_cqe completion;
+        for (unsigned received = 0; received < waitCount;) {
+            if (!ring_->peek(completion)) {
+                if (submitted < 0 || ring_->submitAndWait(1) < 0) {
+                    std::cerr << "Can't write session log: " << directory_ << std::endl;
+                    return false;
+                }
+                continue;
+            }
+            if (completion.user_data == 0) {
+                written = completion.res;
+            } else {
+                synced = completion.res;
+            }
+            ++received;
+        }
+        if (written < 0) {
+            std::cerr << "Can't write session log: " << directory_ << std::endl;
+            return false;
+        }
+        // 途中までしか書けなかった場合（つなげた fsync は取り消される）は残りを write で書く
+        if (static_cast<std::size_t>(written) < chunk) {
+            if (!writeAll(fd_, data + written, chunk - static_cast<std::size_t>(written))) {
+                std::cerr << "Can't write session log: " << directory_ << std::endl;
+                return false;
+            }
+            synced = last && sync ? (::fdatasync(fd_) == 0 ? 0 : -EIO) : 0;
+        }
+        if (synced < 0) {
+            std::cerr << "Can't sync session log: " << directory_ << std::endl;
+            return false;
+        }
+        data += chunk;
+        size -= chunk;
+    }
+    return true;
+}
+
+bool SessionEventLog::flush() {
+    std::uint64_t last;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        last = nextSequence_ - 1;
+    }
+    return commit(last);
+}
+
+bool SessionEventLog::sync() {
+    if (!flush()) {
+        return false;
+    }
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (committing_) {
+        committed_.wait(lock);
+    }
+    if (failed_ || !open_) {
+        return !failed_;
+    }
+    // コミット中の印を立てて、ファイルを触るのをこのスレッドだけにする
+    committing_ = true;
+    lock.unlock();
+    bool synced = ::fdatasync(fd_) == 0;
+    if (synced) {
+        lastSync_ = std::chrono::steady_clock::now();
+    }
+    lock.lock();
+    committing_ = false;
+    if (synced) {
+        ++syncCount_;
+    } else {
+        std::cerr << "Can't sync session log: " << directory_ << std::endl;
+        failed_ = true;
+    }
+    committed_.notify_all();
+    return synced;
+}
+
+std::uint64_t SessionEventLog::nextSequence() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return nextSequence_;
+}
+
+std::uint64_t SessionEventLog::committedSequence() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return committedSequence_;
+}
+
+std::uint64_t SessionEventLog::writeCount() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return writeCount_;
+}
+
+std::uint64_t SessionEventLog::syncCount() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return syncCount_;
+}
+
+std::uint64_t SessionEventLog::firstSequence() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return segments_.empty() ? nextSequence_ : segments_.front();
+}
+
+std::size_t SessionEventLog::truncateBefore(std::uint64_t sequence) {
+    // 次のセグメントの先頭が sequence 以下なら、そのセグメントのイベントは全て sequence より前
+    std::vector<std::uint64_t> removable;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        std::size_t count = 0;
+        while (count + 1 < segments_.size() && segments_[count + 1] <= sequence) {
+            ++count;
+        }
+        removable.assign(segments_.begin(), segments_.begin() + static_cast<std::ptrdiff_t>(count));
+        segments_.erase(segments_.begin(), segments_.begin() + static_cast<std::ptrdiff_t>(count));
+    }
+    // 古い順に消すので、途中で止まっても残ったセグメントの通し番号は連続している
+    for (std::uint64_t firstSequence : removable) {
+        std::string path = segmentPath(directory_, firstSequence);
+        if (::unlink(path.c_str()) != 0) {
+            std::cerr << "Can't remove session log segment: " << path << std::endl;
+        }
+    }
+    if (!removable.empty()) {
+        syncDirectory(directory_);
+    }
+    return removable.size();
+}
+
+std::size_t SessionEventLog::segmentCount() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return segments_.size();
+}
@@ -0,0 +1,153 @@
+#ifndef SESSION_EVENT_LOG_HPP
+#define SESSION_EVENT_LOG_HPP
+
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+// 駐車セッションのイベントの種類
+enum class SessionEventType : std::uint8_t {
+    Entry = 1,    // 入庫
+    Exit = 2,     // 出庫（amount は料金）
+    Payment = 3,  // 精算（amount は支払額。セッションは閉じない）
+};
+
+// ログに記録するイベント（このままの形でファイルに書く）
+struct SessionEvent {
+    std::uint64_t sequence;  // ログが振る通し番号（1から）
+    std::uint64_t ticketId;
+    std::int64_t time;       // エポック秒
+    std::int64_t amount;
+    std::uint32_t lotId;
+    SessionEventType type;
+    std::uint8_t reserved[3];
+};
+
+static_assert(sizeof(SessionEvent) == 40, "イベントは40バイト");
+
+// fsync の方針
+enum class EventLogSync {
+    None,      // write のみ（OSのクラッシュや電源断では失われうる）
+    Interval,  // 前回の fsync から syncIntervalMs 以上たったコミットで fsync する
+    Always,    // コミットごとに fsync する（同時にコミットしたイベントはまとめて1回）
+};
+
+// SessionEventLog の設定
+struct SessionEventLogOptions {
+    EventLogSync sync = EventLogSync::Always;
+    int syncIntervalMs = 100;                          // Interval の間隔
+    std::uint64_t segmentBytes = std::uint64_t(64) << 20;  // セグメントを切り替える大きさ
+    // fsync するコミットを io_uring で書く（使えない環境では write / fdatasync のまま）
+    // 書き込みとそれにつなげた fsync を、登録済みバッファから1回の io_uring_enter で投入する
+    bool ioUring = false;
+};
+
+class IoUringQueue;
+
+// 駐車セッションの追記専用イベントログ（ログ先行書き込み）
+//
+// ディレクトリに segment-<最初の通し番号>.log を作り、一定の大きさで次のセグメントに切り替える
+// 各レコードは [長さ 4バイト][CRC-32C 4バイト][SessionEvent 40バイト]
+//
+// - append はメモリ上のバッファに積むだけで、commit がファイルに書く
+// - 同時に commit したスレッドのうち1つがまとめて write / fsync し、他はその完了を待つ（グループコミット）
+// - open は全セグメントを読み直して、イベントを通し番号の順に replay に渡す
+//   最後のセグメントの末尾が書きかけ（長さ・CRC・通し番号の不一致）なら、そこで切り詰めて続きから追記する
+//   途中のセグメントが壊れている場合は open に失敗する
+// - スレッドセーフ
+class SessionEventLog {
+public:
+    using ReplayHandler = std::function<bool(const SessionEvent&)>;
+
+    SessionEventLog();
+    ~SessionEventLog();
+
+    SessionEventLog(const SessionEventLog&) = delete;
+    SessionEventLog& operator=(const SessionEventLog&) = delete;
+
+    // ディレクトリのログを開く（なければ作る）。既存のイベントを順に replay に渡し、
+    // replay がfalseを返した場合は open に失敗する
+    bool open(const std::string& directory, const SessionEventLogOptions& options = SessionEventLogOptions(),
+              const ReplayHandler& replay = nullptr);
+
+    // 残りのイベントをコミットして閉じる
+    void close();
+
+    bool isOpen() const;
+
+    // イベントをバッファに積み、振った通し番号を返す（開いていなければ0）
+    std::uint64_t append(SessionEventType type, std::uint64_t ticketId, std::uint32_t lotId, std::int64_t time,
+                         std::int64_t amount = 0);
+
+    // sequence までのイベントをファイルに書く（fsync は方針による）
+    // 書き込みに失敗した場合はfalseで、以降のコミットも全て失敗する
+    bool commit(std::uint64_t sequence);
+
+    // ここまでに積んだイベントを全てコミット
+    bool flush();
+
+    // ここまでに積んだイベントを全てコミットし、方針によらず fsync する
+    bool sync();
+
+    // 次に振る通し番号・コミット済みの最後の通し番号
+    std::uint64_t nextSequence() const;
+    std::uint64_t committedSequence() const;
+
+    // コミットのたびに増える（write の回数）・fsync の回数
+    std::uint64_t writeCount() const;
+    std::uint64_t syncCount() const;
+
+    // 残っている最も古いイベントの通し番号（最初のセグメントの先頭）
+    std::uint64_t firstSequence() const;
+
+    // 全てのイベントが sequence より前のセグメントを削除し、削除した数を返す（書き込み中のセグメントは残す）
+    // スナップショットに反映済みのイベントを捨てるために使う
+    std::size_t truncateBefore(std::uint64_t sequence);
+
+    std::size_t segmentCount() const;
+    const std::string& directory() const { return directory_; }
+
+    // コミットを io_uring で書いているか
+    bool usesIoUring() const;
+
+private:
+    bool replaySegment(const std::string& path, std::uint64_t firstSequence, bool last,
+                       const ReplayHandler& replay, std::uint64_t& eventCount);
+    bool openSegment(std::uint64_t firstSequence);
+    bool writeBatch(const std::vector<char>& batch, std::uint64_t firstSequence);
+    bool writeWithRing(const char* data, std::size_t size, bool sync);
+    void closeSegment();
+
+    std::string directory_;
+    SessionEventLogOptions options_;
+
+    mutable std::mutex mutex_;
+    std::condition_variable committed_;
+    std::vector<char> buffer_;  // コミット前のレコード
+    std::vector<char> spare_;   // 書き込み中でない側のバッファ（確保し直さないように使い回す）
+    std::uint64_t bufferFirstSequence_ = 1;
+    std::uint64_t nextSequence_ = 1;
+    std::uint64_t committedSequence_ = 0;
+    std::uint64_t writeCount_ = 0;
+    std::uint64_t syncCount_ = 0;
+    bool committing_ = false;
+    bool failed_ = false;
+    bool open_ = false;
+
+    std::vector<std::uint64_t> segments_;  // 各セグメントの最初の通し番号（昇順）
+
+    // 以下は open / close とコミット中のスレッド（committing_ を立てたスレッド）だけが触る
+    int fd_ = -1;
+    std::uint64_t segmentSize_ = 0;
+    std::chrono::steady_clock::time_point lastSync_;
+    std::unique_ptr<IoUringQueue> ring_;
+    std::unique_ptr<char[]> staging_;  // ring_ に登録した書き込み用バッファ
+};
+
+#endif // SESSION_EVENT_LOG_HPP
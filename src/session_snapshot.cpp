@@ -0,0 +1,257 @@
+#include "session_snapshot.hpp"
+#include "crc32c.hpp"
+#include "sharded_session_store.hpp"
+#include <dirent.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <algorithm>
+#include <cerrno>
+#include <cinttypes>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+
+namespace {
+
+const char kSnapshotMagic[8] = {'P', 'K', 'S', 'E', 'S', 'S', 'N', 'P'};
+constexpr std::uint32_t kSnapshotFormatVersion = 2;
+constexpr std::uint32_t kSnapshotFormatVersionWithoutShards = 1;
+
+struct SnapshotHeader {
+    char magic[8];                // "PKSESSNP"
+    std::uint32_t formatVersion;
+    std::uint32_t headerCrc;      // このフィールドを0にしたヘッダーの CRC-32C
+    std::uint64_t sequence;       // 反映済みのイベントの通し番号（シャードごとの最小値）
+    std::uint64_t sessionCount;
+    std::uint64_t revenueCount;
+    std::uint64_t fileSize;
+    std::uint32_t payloadCrc;     // ヘッダーより後の CRC-32C
+    std::uint32_t shardCount;     // シャードごとの通し番号の数（版2から。0なら全て sequence）
+    std::uint8_t reserved[8];
+};
+
+struct SnapshotSessionRecord {
+    std::uint64_t ticketId;
+    std::int64_t entryTime;
+    std::uint32_t lotId;
+    std::uint32_t reserved;
+};
+
+struct SnapshotRevenueRecord {
+    std::int64_t day;
+    std::uint32_t lotId;
+    std::uint32_t reserved;
+    std::uint64_t exits;
+    std::int64_t fees;
+    std::int64_t payments;
+};
+
+static_assert(sizeof(SnapshotHeader) == 64, "スナップショットのヘッダーは64バイト");
+static_assert(sizeof(SnapshotSessionRecord) == 24, "セッションは24バイト");
+static_assert(sizeof(SnapshotRevenueRecord) == 40, "売上は40バイト");
+
+std::uint32_t headerChecksum(const SnapshotHeader& header) {
+    SnapshotHeader copy = header;
+    copy.headerCrc = 0;
+    return crc32c(&copy, sizeof(copy));
+}
+
+std::string snapshotPath(const std::string& directory, std::uint64_t sequence) {
+    char name[48];
+    std::snprintf(name, sizeof(name), "snapshot-%020" PRIu64 ".snap", sequence);
+    return directory + "/" + name;
+}
+
+// ディレクトリ内のスナップショットの通し番号（昇順）
+std::vector<std::uint64_t> listSnapshots(const std::string& directory) {
+    std::vector<std::uint64_t> sequences;
+    if (DIR* dir = ::opendir(directory.c_str())) {
+        while (dirent* entry = ::readdir(dir)) {
+            std::uint64_t sequence = 0;
+            char suffix[8] = {};
+            if (std::sscanf(entry->d_name, "snapshot-%20" SCNu64 ".%5s", &sequence, suffix) == 2 &&
+                std::strcmp(suffix, "snap") == 0) {
+                sequences.push_back(sequence);
+            }
+        }
+        ::closedir(dir);
+    }
+    std::sort(sequences.begin(), sequences.end());
+    return sequences;
+}
+
+bool writeAll(int fd, const char* data, std::size_t size) {
+    while (size > 0) {
+        ssize_t written = ::write(fd, data, size);
+        if (written < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return false;
+        }
+        data += written;
+        size -= static_cast<std::size_t>(written);
+    }
+    return true;
+}
+
+bool readAll(int fd, char* data, std::size_t size) {
+    while (size > 0) {
+        ssize_t count = ::read(fd, data, size);
+        if (count < 0 && errno == EINTR) {
+            continue;
+        }
+        if (count <= 0) {
+            return false;
+        }
+        data += count;
+        size -= static_cast<std::size_t>(count);
+    }
+    return true;
+}
+
+} // namespace
+
+bool SessionSnapshot::covers(std::uint64_t eventSequence, std::uint64_t ticketId) const {
+    if (eventSequence <= sequence) {
+        return true;
+    }
+    return !shardSequences.empty() &&
+           eventSequence <= shardSequences[ShardedSessionStore::shardIndexFor(ticketId, shardSequences.size())];
+}
+
+bool writeSessionSnapshot(const std::string& directory, const SessionSnapshot& snapshot) {
+    SnapshotHeader header{};
+    std::memcpy(header.magic, kSnapshotMagic, sizeof(kSnapshotMagic));
+    header.formatVersion = kSnapshotFormatVersion;
+    header.sequence = snapshot.sequence;
+    header.sessionCount = snapshot.sessions.size();
+    header.revenueCount = snapshot.revenue.size();
+    header.shardCount = static_cast<std::uint32_t>(snapshot.shardSequences.size());
+    header.fileSize = sizeof(SnapshotHeader) + header.sessionCount * sizeof(SnapshotSessionRecord) +
+                      header.revenueCount * sizeof(SnapshotRevenueRecord) +
+                      header.shardCount * sizeof(std::uint64_t);
+
+    std::vector<char> image(static_cast<std::size_t>(header.fileSize), 0);
+    auto* sessions = reinterpret_cast<SnapshotSessionRecord*>(image.data() + sizeof(SnapshotHeader));
+    for (std::size_t i = 0; i < snapshot.sessions.size(); ++i) {
+        const OpenSession& session = snapshot.sessions[i];
+        sessions[i] = SnapshotSessionRecord{session.ticketId, session.entryTime, session.lotId, 0};
+    }
+    auto* revenue = reinterpret_cast<SnapshotRevenueRecord*>(sessions + snapshot.sessions.size());
+    for (std::size_t i = 0; i < snapshot.revenue.size(); ++i) {
+        const DailyRevenue& daily = snapshot.revenue[i];
+        revenue[i] = SnapshotRevenueRecord{daily.day, daily.lotId, 0, daily.exits, daily.fees, daily.payments};
+    }
+    if (!snapshot.shardSequences.empty()) {
+        std::memcpy(revenue + snapshot.revenue.size(), snapshot.shardSequences.data(),
+                    snapshot.shardSequences.size() * sizeof(std::uint64_t));
+    }
+    header.payloadCrc = crc32c(image.data() + sizeof(SnapshotHeader), image.size() - sizeof(SnapshotHeader));
+    header.headerCrc = headerChecksum(header);
+    std::memcpy(image.data(), &header, sizeof(header));
+
+    std::string path = snapshotPath(directory, snapshot.sequence);
+    std::string temporary = path + ".tmp";
+    int fd = ::open(temporary.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (fd < 0) {
+        std::cerr << "Can't create session snapshot: " << temporary << std::endl;
+        return false;
+    }
+    bool written = writeAll(fd, image.data(), image.size()) && ::fsync(fd) == 0;
+    written = ::close(fd) == 0 && written;
+    if (!written || std::rename(temporary.c_str(), path.c_str()) != 0) {
+        std::cerr << "Can't write session snapshot: " << path << std::endl;
+        std::remove(temporary.c_str());
+        return false;
+    }
+    int directoryFd = ::open(directory.c_str(), O_RDONLY);
+    if (directoryFd >= 0) {
+        ::fsync(directoryFd);
+        ::close(directoryFd);
+    }
+    return true;
+}
+
+bool loadLatestSessionSnapshot(const std::string& directory, SessionSnapshot& snapshot) {
+    snapshot = SessionSnapshot();
+    std::vector<std::uint64_t> sequences = listSnapshots(directory);
+    if (sequences.empty()) {
+        return true;
+    }
+
+    std::string path = snapshotPath(directory, sequences.back());
+    int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    struct stat status;
+    if (fd < 0 || ::fstat(fd, &status) != 0) {
+        std::cerr << "Can't open session snapshot: " << path << std::endl;
+        if (fd >= 0) {
+            ::close(fd);
+        }
+        return false;
+    }
+    std::vector<char> image(static_cast<std::size_t>(status.st_size));
+    bool read = readAll(fd, image.data(), image.size());
+    ::close(fd);
+
+    SnapshotHeader header{};
+    bool valid = read && image.size() >= sizeof(SnapshotHeader);
+    if (valid) {
+        std::memcpy(&header, image.data(), sizeof(header));
+        if (header.formatVersion == kSnapshotFormatVersionWithoutShards) {
+            header.shardCount = 0;
+        }
+        // シャード数は2のべき乗（版1のファイルでは0）
+        valid = std::memcmp(header.magic, kSnapshotMagic, sizeof(kSnapshotMagic)) == 0 &&
+                (header.formatVersion == kSnapshotFormatVersion ||
+                 header.formatVersion == kSnapshotFormatVersionWithoutShards) &&
+                header.headerCrc == headerChecksum(header) &&
+                header.sequence == sequences.back() && header.fileSize == image.size() &&
+                header.sessionCount <= image.size() / sizeof(SnapshotSessionRecord) &&
+                header.revenueCount <= image.size() / sizeof(SnapshotRevenueRecord) &&
+                header.shardCount <= ShardedSessionStore::kMaxShards &&
+                (header.shardCount & (header.shardCount - 1)) == 0 &&
+                header.fileSize == sizeof(SnapshotHeader) + header.sessionCount * sizeof(SnapshotSessionRecord) +
+                                       header.revenueCount * sizeof(SnapshotRevenueRecord) +
+                                       header.shardCount * sizeof(std::uint64_t) &&
+                header.payloadCrc ==
+                    crc32c(image.data() + sizeof(SnapshotHeader), image.size() - sizeof(SnapshotHeader));
+    }
+    if (!valid) {
+        std::cerr << "Invalid session snapshot: " << path << std::endl;
+        return false;
+    }
+
+    snapshot.sequence = header.sequence;
+    snapshot.sessions.resize(static_cast<std::size_t>(header.sessionCount));
+    const char* cursor = image.data() + sizeof(SnapshotHeader);
+    for (OpenSession& session : snapshot.sessions) {
+        SnapshotSessionRecord record;
+        std::memcpy(&record, cursor, sizeof(record));
+        cursor += sizeof(record);
+        session = OpenSession{record.ticketId, record.entryTime, record.lotId};
+    }
+    snapshot.revenue.resize(static_cast<std::size_t>(header.revenueCount));
+    for (DailyRevenue& daily : snapshot.revenue) {
+        SnapshotRevenueRecord record;
+        std::memcpy(&record, cursor, sizeof(record));
+        cursor += sizeof(record);
+        daily = DailyRevenue{record.lotId, record.day, record.exits, record.fees, record.payments};
+    }
+    snapshot.shardSequences.resize(header.shardCount);
+    if (!snapshot.shardSequences.empty()) {
+        std::memcpy(snapshot.shardSequences.data(), cursor, snapshot.shardSequences.size() * sizeof(std::uint64_t));
+    }
+    return true;
+}
+
+std::size_t removeSessionSnapshotsBefore(const std::string& directory, std::uint64_t sequence) {
+    std::size_t removed = 0;
+    for (std::uint64_t existing : listSnapshots(directory)) {
+        if (existing < sequence && std::remove(snapshotPath(directory, existing).c_str()) == 0) {
+            ++removed;
+        }
+    }
+    return removed;
+}
@@ -0,0 +1,42 @@
+#ifndef SESSION_SNAPSHOT_HPP
+#define SESSION_SNAPSHOT_HPP
+
+#include "revenue_counters.hpp"
+#include "session_store.hpp"
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// 入庫中のセッションと日ごとの売上
+// 少なくとも sequence までのイベントログを反映した状態を表す
+//
+// シャードを1つずつ複製した場合は、シャードごとに反映済みの通し番号が異なる。
+// shardSequences[i] は駐車券番号のシャード番号が i（シャード数 shardSequences.size() で求める）の
+// イベントをどこまで反映したかを表し、sequence はその最小値。空なら全て sequence まで
+struct SessionSnapshot {
+    std::uint64_t sequence = 0;
+    std::vector<OpenSession> sessions;
+    std::vector<DailyRevenue> revenue;
+    std::vector<std::uint64_t> shardSequences;
+
+    // このイベントが既にスナップショットに反映されているか
+    bool covers(std::uint64_t eventSequence, std::uint64_t ticketId) const;
+};
+
+// ディレクトリに snapshot-<通し番号>.snap として書き出す（一時ファイルに書いて fsync してから rename する）
+// レイアウト（リトルエンディアン）
+//   ヘッダー 64バイト（magic "PKSESSNP"、版、件数、通し番号、シャード数、CRC-32C）
+//   セッション 24バイト × sessionCount
+//   売上     40バイト × revenueCount
+//   シャードごとの通し番号 8バイト × shardCount
+// 版1（シャードごとの通し番号がない）のファイルも読み込める
+bool writeSessionSnapshot(const std::string& directory, const SessionSnapshot& snapshot);
+
+// 最も新しいスナップショットを読み込む
+// スナップショットがなければ空のまま true、壊れていればfalse
+bool loadLatestSessionSnapshot(const std::string& directory, SessionSnapshot& snapshot);
+
+// sequence より前のスナップショットを削除し、削除した数を返す
+std::size_t removeSessionSnapshotsBefore(const std::string& directory, std::uint64_t sequence);
+
+#endif // SESSION_SNAPSHOT_HPP
@@ -0,0 +1,175 @@
+#include "session_store.hpp"
+
+namespace {
+
+// 負荷率3/4以下で expectedSessions 件が入る2のべき乗のスロット数
+std::size_t capacityFor(std::size_t expectedSessions) {
+    std::size_t capacity = 16;
+    while (capacity / 4 * 3 < expectedSessions) {
+        capacity *= 2;
+    }
+    return capacity;
+}
+
+} // namespace
+
+SessionStore::SessionStore(std::size_t expectedSessions) {
+    rehash(capacityFor(expectedSessions));
+}
+
+bool SessionStore::addLot(std::uint32_t lotId, const StayPricingEngine& pricing) {
+    if (lotId >= kMaxLots) {
+        return false;
+    }
+    if (lotId >= lots_.size()) {
+        lots_.resize(static_cast<std::size_t>(lotId) + 1);
+    }
+    lots_[lotId].emplace(pricing);
+    return true;
+}
+
+bool SessionStore::entry(std::uint64_t ticketId, std::uint32_t lotId, std::int64_t entryTime) {
+    if (ticketId == 0 || lotId >= lots_.size() || !lots_[lotId]) {
+        return false;
+    }
+    if ((size_ + 1) > capacity() / 4 * 3) {
+        rehash(capacity() * 2);
+    }
+
+    std::size_t slot = slotOf(ticketId);
+    while (ticketIds_[slot] != 0) {
+        if (ticketIds_[slot] == ticketId) {
+            return false;
+        }
+        slot = (slot + 1) & mask_;
+    }
+    ticketIds_[slot] = ticketId;
+    entryTimes_[slot] = entryTime;
+    lotIds_[slot] = lotId;
+    ++size_;
+    return true;
+}
+
+bool SessionStore::exit(std::uint64_t ticketId, std::int64_t exitTime, ClosedSession& closed) {
+    std::size_t slot = findSlot(ticketId);
+    if (slot == kNotFound) {
+        return false;
+    }
+    std::int64_t fee = 0;
+    if (!lots_[lotIds_[slot]]->quoteTotal(entryTimes_[slot], exitTime, fee)) {
+        return false;
+    }
+    closed = ClosedSession{ticketId, entryTimes_[slot], exitTime, lotIds_[slot], fee};
+    eraseSlot(slot);
+    return true;
+}
+
+bool SessionStore::erase(std::uint64_t ticketId) {
+    std::size_t slot = findSlot(ticketId);
+    if (slot == kNotFound) {
+        return false;
+    }
+    eraseSlot(slot);
+    return true;
+}
+
+bool SessionStore::find(std::uint64_t ticketId, OpenSession& session) const {
+    std::size_t slot = findSlot(ticketId);
+    if (slot == kNotFound) {
+        return false;
+    }
+    session = OpenSession{ticketId, entryTimes_[slot], lotIds_[slot]};
+    return true;
+}
+
+void SessionStore::collect(std::vector<OpenSession>& sessions) const {
+    sessions.reserve(sessions.size() + size_);
+    for (std::size_t slot = 0; slot < ticketIds_.size(); ++slot) {
+        if (ticketIds_[slot] != 0) {
+            sessions.push_back(OpenSession{ticketIds_[slot], entryTimes_[slot], lotIds_[slot]});
+        }
+    }
+}
+
+void SessionStore::reserve(std::size_t expectedSessions) {
+    std::size_t capacity = capacityFor(expectedSessions);
+    if (capacity > this->capacity()) {
+        rehash(capacity);
+    }
+}
+
+std::size_t SessionStore::memoryBytes() const {
+    return capacity() * (sizeof(std::uint64_t) + sizeof(std::int64_t) + sizeof(std::uint32_t));
+}
+
+std::uint64_t SessionStore::plateTicketId(const std::string& plate) {
+    // FNV-1a（64ビット）
+    std::uint64_t hash = 0xcbf29ce484222325ULL;
+    for (unsigned char c : plate) {
+        hash ^= c;
+        hash *= 0x100000001b3ULL;
+    }
+    return hash != 0 ? hash : 1;
+}
+
+std::size_t SessionStore::slotOf(std::uint64_t ticketId) const {
+    return static_cast<std::size_t>(hashTicketId(ticketId)) & mask_;
+}
+
+std::size_t SessionStore::findSlot(std::uint64_t ticketId) const {
+    if (ticketId == 0) {
+        return kNotFound;
+    }
+    std::size_t slot = slotOf(ticketId);
+    while (ticketIds_[slot] != 0) {
+        if (ticketIds_[slot] == ticketId) {
+            return slot;
+        }
+        slot = (slot + 1) & mask_;
+    }
+    return kNotFound;
+}
+
+void SessionStore::eraseSlot(std::size_t slot) {
+    // 空きスロットまでの後続の要素のうち、本来の位置から見て空けた穴を越えているものを穴へ詰める
+    std::size_t hole = slot;
+    std::size_t next = slot;
+    for (;;) {
+        next = (next + 1) & mask_;
+        if (ticketIds_[next] == 0) {
+            break;
+        }
+        std::size_t home = slotOf(ticketIds_[next]);
+        if (((next - home) & mask_) >= ((next - hole) & mask_)) {
+            ticketIds_[hole] = ticketIds_[next];
+            entryTimes_[hole] = entryTimes_[next];
+            lotIds_[hole] = lotIds_[next];
+            hole = next;
+        }
+    }
+    ticketIds_[hole] = 0;
+    --size_;
+}
+
+void SessionStore::rehash(std::size_t newCapacity) {
+    std::vector<std::uint64_t> ticketIds(newCapacity, 0);
+    std::vector<std::int64_t> entryTimes(newCapacity);
+    std::vector<std::uint32_t> lotIds(newCapacity);
+    ticketIds_.swap(ticketIds);
+    entryTimes_.swap(entryTimes);
+    lotIds_.swap(lotIds);
+    mask_ = newCapacity - 1;
+
+    for (std::size_t i = 0; i < ticketIds.size(); ++i) {
+        if (ticketIds[i] == 0) {
+            continue;
+        }
+        std::size_t slot = slotOf(ticketIds[i]);
+        while (ticketIds_[slot] != 0) {
+            slot = (slot + 1) & mask_;
+        }
+        ticketIds_[slot] = ticketIds[i];
+        entryTimes_[slot] = entryTimes[i];
+        lotIds_[slot] = lotIds[i];
+    }
+}
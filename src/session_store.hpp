@@ -0,0 +1,102 @@
+#ifndef SESSION_STORE_HPP
+#define SESSION_STORE_HPP
+
+#include "stay_pricing.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <vector>
+
+// 入庫中の駐車セッション
+struct OpenSession {
+    std::uint64_t ticketId;
+    std::int64_t entryTime;  // エポック秒
+    std::uint32_t lotId;
+};
+
+// 出庫で閉じたセッションと料金
+struct ClosedSession {
+    std::uint64_t ticketId;
+    std::int64_t entryTime;
+    std::int64_t exitTime;
+    std::uint32_t lotId;
+    std::int64_t fee;
+};
+
+// 入庫・出庫イベントから駐車セッションを管理し、出庫時に料金を計算する
+//
+// 入庫中のセッションは駐車券番号をキーとするオープンアドレス法（線形探索）のハッシュ表に置く
+// - 探索で触るのは駐車券番号の配列だけで、入庫時刻・駐車場番号は別の配列に置く（SoA）
+// - 削除は後続の要素を詰める（墓標を残さないので、入出庫を繰り返しても探索は長くならない）
+// - セッションごとのメモリ確保はなく、負荷率が3/4を超えたときだけ表を2倍にする
+//
+// 料金は駐車場ごとに登録した StayPricingEngine::quoteTotal で計算する
+// スレッドセーフではない（複数スレッドから使う場合は ShardedSessionStore を使う）
+class SessionStore {
+public:
+    // 登録できる駐車場番号の上限（駐車場ごとの料金体系は番号で直接引く）
+    static constexpr std::uint32_t kMaxLots = 1u << 16;
+
+    // expectedSessions 件まで表を作り直さずに入庫できるように確保する
+    explicit SessionStore(std::size_t expectedSessions = 1024);
+
+    // 駐車場の料金体系を登録（登録済みなら置き換える。番号が上限以上ならfalse）
+    bool addLot(std::uint32_t lotId, const StayPricingEngine& pricing);
+
+    // 入庫。駐車券番号が0、入庫中の番号と重複、または未登録の駐車場ならfalse
+    bool entry(std::uint64_t ticketId, std::uint32_t lotId, std::int64_t entryTime);
+
+    // 出庫。料金を計算してセッションを閉じる
+    // 入庫中でない、または出庫時刻が入庫より前ならfalse（セッションはそのまま残る）
+    bool exit(std::uint64_t ticketId, std::int64_t exitTime, ClosedSession& closed);
+
+    // 料金を計算せずにセッションを閉じる（イベントログの再生用。入庫中でなければfalse）
+    bool erase(std::uint64_t ticketId);
+
+    // 入庫中のセッション（なければfalse）
+    bool find(std::uint64_t ticketId, OpenSession& session) const;
+
+    // 入庫中の全てのセッションを sessions の末尾に加える（順不同）
+    void collect(std::vector<OpenSession>& sessions) const;
+
+    // expectedSessions 件まで表を作り直さずに入庫できるように広げる
+    void reserve(std::size_t expectedSessions);
+
+    std::size_t size() const { return size_; }
+    std::size_t capacity() const { return ticketIds_.size(); }
+    std::size_t memoryBytes() const;
+
+    // 駐車券のない入庫（ナンバー認識など）で使う、ナンバーから求めた駐車券番号（0にはならない）
+    static std::uint64_t plateTicketId(const std::string& plate);
+
+    // 連番の駐車券番号でも偏らないように混ぜたハッシュ（splitmix64 の最終段）
+    // 表のスロットは下位ビットで決める（分割する場合は上位ビットを使う）
+    static std::uint64_t hashTicketId(std::uint64_t ticketId) {
+        ticketId ^= ticketId >> 30;
+        ticketId *= 0xbf58476d1ce4e5b9ULL;
+        ticketId ^= ticketId >> 27;
+        ticketId *= 0x94d049bb133111ebULL;
+        ticketId ^= ticketId >> 31;
+        return ticketId;
+    }
+
+private:
+    std::size_t slotOf(std::uint64_t ticketId) const;
+    std::size_t findSlot(std::uint64_t ticketId) const;
+    void eraseSlot(std::size_t slot);
+    void rehash(std::size_t newCapacity);
+
+    static constexpr std::size_t kNotFound = static_cast<std::size_t>(-1);
+
+    // スロットごとの列（ticketIds_ が0のスロットは空き）
+    std::vector<std::uint64_t> ticketIds_;
+    std::vector<std::int64_t> entryTimes_;
+    std::vector<std::uint32_t> lotIds_;
+    std::size_t mask_ = 0;
+    std::size_t size_ = 0;
+
+    std::vector<std::optional<StayPricingEngine>> lots_;
+};
+
+#endif // SESSION_STORE_HPP
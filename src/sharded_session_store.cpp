@@ -0,0 +1,66 @@
+#include "sharded_session_store.hpp"
+
+ShardedSessionStore::ShardedSessionStore(std::size_t shardCount, std::size_t expectedSessions)
+    : shardCount_(1) {
+    while (shardCount_ < shardCount && shardCount_ < kMaxShards) {
+        shardCount_ *= 2;
+    }
+    shards_.reset(new Shard[shardCount_]);
+    std::size_t perShard = (expectedSessions + shardCount_ - 1) / shardCount_;
+    for (std::size_t i = 0; i < shardCount_; ++i) {
+        // ハッシュで均等に散るが、偏りに備えて少し多めに確保する
+        shards_[i].sessions.reserve(perShard + perShard / 8);
+    }
+}
+
+bool ShardedSessionStore::addLot(std::uint32_t lotId, const StayPricingEngine& pricing) {
+    for (std::size_t i = 0; i < shardCount_; ++i) {
+        std::lock_guard<std::mutex> lock(shards_[i].mutex);
+        if (!shards_[i].sessions.addLot(lotId, pricing)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool ShardedSessionStore::entry(std::uint64_t ticketId, std::uint32_t lotId, std::int64_t entryTime) {
+    Shard& shard = shardOf(ticketId);
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    return shard.sessions.entry(ticketId, lotId, entryTime);
+}
+
+bool ShardedSessionStore::exit(std::uint64_t ticketId, std::int64_t exitTime, ClosedSession& closed) {
+    Shard& shard = shardOf(ticketId);
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    return shard.sessions.exit(ticketId, exitTime, closed);
+}
+
+bool ShardedSessionStore::erase(std::uint64_t ticketId) {
+    Shard& shard = shardOf(ticketId);
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    return shard.sessions.erase(ticketId);
+}
+
+bool ShardedSessionStore::find(std::uint64_t ticketId, OpenSession& session) const {
+    Shard& shard = shardOf(ticketId);
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    return shard.sessions.find(ticketId, session);
+}
+
+std::size_t ShardedSessionStore::size() const {
+    std::size_t total = 0;
+    for (std::size_t i = 0; i < shardCount_; ++i) {
+        std::lock_guard<std::mutex> lock(shards_[i].mutex);
+        total += shards_[i].sessions.size();
+    }
+    return total;
+}
+
+std::size_t ShardedSessionStore::memoryBytes() const {
+    std::size_t total = 0;
+    for (std::size_t i = 0; i < shardCount_; ++i) {
+        std::lock_guard<std::mutex> lock(shards_[i].mutex);
+        total += shards_[i].sessions.memoryBytes();
+    }
+    return total;
+}
@@ -0,0 +1,93 @@
+#ifndef SHARDED_SESSION_STORE_HPP
+#define SHARDED_SESSION_STORE_HPP
+
+#include "session_store.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+// 複数のゲートから同時に届く入庫・出庫イベントを受け付けるセッション管理（スレッドセーフ）
+//
+// 駐車券番号のハッシュの上位ビットで分割先（シャード）を決め、シャードごとに
+// SessionStore とロックを持つ（ロックストライピング）。異なるシャードへの入出庫は互いに待たない
+// シャード内のスロットはハッシュの下位ビットで決まるので、シャード内で偏ることもない
+// 全シャードに同じ駐車場の料金体系を持たせ、出庫時の料金計算もシャードのロック内で完結する
+class ShardedSessionStore {
+public:
+    static constexpr std::size_t kMaxShards = std::size_t(1) << 16;
+
+    // shardCount は2のべき乗に切り上げる（上限 kMaxShards。ゲート数より十分多くすると待ちが起きにくい）
+    // expectedSessions は全シャードの合計
+    explicit ShardedSessionStore(std::size_t shardCount = 64, std::size_t expectedSessions = 1024);
+
+    // 全てのシャードに駐車場の料金体系を登録
+    bool addLot(std::uint32_t lotId, const StayPricingEngine& pricing);
+
+    // SessionStore と同じ（駐車券番号のシャードだけをロックする）
+    bool entry(std::uint64_t ticketId, std::uint32_t lotId, std::int64_t entryTime);
+    bool exit(std::uint64_t ticketId, std::int64_t exitTime, ClosedSession& closed);
+    bool erase(std::uint64_t ticketId);
+    bool find(std::uint64_t ticketId, OpenSession& session) const;
+
+    // 駐車券番号のシャードをロックしたまま function(SessionStore&) を呼ぶ
+    // セッションの更新とイベントログへの追記を、同じ駐車券について同じ順序にする場合などに使う
+    template <typename Function>
+    auto withShard(std::uint64_t ticketId, Function&& function) -> decltype(function(std::declval<SessionStore&>())) {
+        Shard& shard = shardOf(ticketId);
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        return function(shard.sessions);
+    }
+
+    // 全てのシャードを番号の順にロックしてから function(シャード番号, SessionStore&) を順に呼ぶ
+    // 呼び出し中は全ての入出庫が止まるので、ある時点の全体の複製を取る場合だけに使う
+    template <typename Function>
+    void withAllShards(Function&& function) const {
+        std::vector<std::unique_lock<std::mutex>> locks;
+        locks.reserve(shardCount_);
+        for (std::size_t i = 0; i < shardCount_; ++i) {
+            locks.emplace_back(shards_[i].mutex);
+        }
+        for (std::size_t i = 0; i < shardCount_; ++i) {
+            function(i, static_cast<const SessionStore&>(shards_[i].sessions));
+        }
+    }
+
+    // シャード番号 index だけをロックしたまま function(const SessionStore&) を呼ぶ
+    // 他のシャードの入出庫は止めずに、シャードを1つずつ複製する場合に使う
+    template <typename Function>
+    void withShardAt(std::size_t index, Function&& function) const {
+        std::lock_guard<std::mutex> lock(shards_[index].mutex);
+        function(static_cast<const SessionStore&>(shards_[index].sessions));
+    }
+
+    // 駐車券番号のシャード番号（0 〜 shardCount() - 1）
+    // ハッシュの上位16ビットで選ぶ（シャード内のスロットは下位ビットで決まる）
+    std::size_t shardIndex(std::uint64_t ticketId) const { return shardIndexFor(ticketId, shardCount_); }
+
+    // シャード数が shardCount（2のべき乗）の場合のシャード番号
+    static std::size_t shardIndexFor(std::uint64_t ticketId, std::size_t shardCount) {
+        return static_cast<std::size_t>(SessionStore::hashTicketId(ticketId) >> 48) & (shardCount - 1);
+    }
+
+    // 全シャードの合計（各シャードを順にロックするので、更新中は近似値）
+    std::size_t size() const;
+    std::size_t memoryBytes() const;
+    std::size_t shardCount() const { return shardCount_; }
+
+private:
+    // シャード同士が同じキャッシュラインを共有しないように揃える
+    struct alignas(64) Shard {
+        mutable std::mutex mutex;
+        SessionStore sessions{0};  // 大きさはコンストラクタでシャードごとの件数に合わせる
+    };
+
+    Shard& shardOf(std::uint64_t ticketId) const { return shards_[shardIndex(ticketId)]; }
+
+    std::size_t shardCount_;
+    std::unique_ptr<Shard[]> shards_;
+};
+
+#endif // SHARDED_SESSION_STORE_HPP
@@ -0,0 +1,483 @@
+#include "sqlite_rate_connection.hpp"
+#include <sqlite3.h>
+#include <iostream>
+#include <chrono>
+#include <cstring>
+#include <string>
+
+namespace {
+
+const char* journalModeName(SQLiteJournalMode mode) {
+    switch (mode) {
+        case SQLiteJournalMode::Keep:     return nullptr;
+        case SQLiteJournalMode::Delete:   return "delete";
+        case SQLiteJournalMode::Truncate: return "truncate";
+        case SQLiteJournalMode::Persist:  return "persist";
+        case SQLiteJournalMode::Memory:   return "memory";
+        case SQLiteJournalMode::Wal:      return "wal";
+    }
+    return nullptr;
+}
+
+const char* synchronousName(SQLiteSynchronous level) {
+    switch (level) {
+        case SQLiteSynchronous::Off:    return "OFF";
+        case SQLiteSynchronous::Normal: return "NORMAL";
+        case SQLiteSynchronous::Full:   return "FULL";
+        case SQLiteSynchronous::Extra:  return "EXTRA";
+    }
+    return "FULL";
+}
+
+// 次の呼び出しに備えてステートメントを初期状態に戻す
+void resetStatement(sqlite3_stmt* stmt) {
+    sqlite3_reset(stmt);
+    sqlite3_clear_bindings(stmt);
+}
+
+// 引数のないステートメント（BEGIN / COMMIT など）を実行
+bool execute(sqlite3_stmt* stmt) {
+    int rc = sqlite3_step(stmt);
+    sqlite3_reset(stmt);
+    return rc == SQLITE_DONE;
+}
+
+// 料金設定の列（firstColumn から8列）を読み込む
+void readConfig(sqlite3_stmt* stmt, int firstColumn, ParkingRateConfig& config) {
+    config.unitMinutes = sqlite3_column_int(stmt, firstColumn);
+    config.unitPrice = sqlite3_column_int(stmt, firstColumn + 1);
+    config.maxMinutes = sqlite3_column_int(stmt, firstColumn + 2);
+    config.maxFee = sqlite3_column_int(stmt, firstColumn + 3);
+    config.nightUnitMinutes = sqlite3_column_int(stmt, firstColumn + 4);
+    config.nightUnitPrice = sqlite3_column_int(stmt, firstColumn + 5);
+    config.nightMaxMinutes = sqlite3_column_int(stmt, firstColumn + 6);
+    config.nightMaxFee = sqlite3_column_int(stmt, firstColumn + 7);
+}
+
+// 料金設定（8列）を firstIndex 番目のパラメータから順にバインド
+void bindConfig(sqlite3_stmt* stmt, int firstIndex, const ParkingRateConfig& config) {
+    sqlite3_bind_int(stmt, firstIndex, config.unitMinutes);
+    sqlite3_bind_int(stmt, firstIndex + 1, config.unitPrice);
+    sqlite3_bind_int(stmt, firstIndex + 2, config.maxMinutes);
+    sqlite3_bind_int(stmt, firstIndex + 3, config.maxFee);
+    sqlite3_bind_int(stmt, firstIndex + 4, config.nightUnitMinutes);
+    sqlite3_bind_int(stmt, firstIndex + 5, config.nightUnitPrice);
+    sqlite3_bind_int(stmt, firstIndex + 6, config.nightMaxMinutes);
+    sqlite3_bind_int(stmt, firstIndex + 7, config.nightMaxFee);
+}
+
+// 現在時刻（エポック秒）。save で記録する版の適用開始に使う
+std::int64_t currentEpochSeconds() {
+    return std::chrono::duration_cast<std::chrono::seconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count();
+}
+
+} // namespace
+
+SQLiteRateConnection::SQLiteRateConnection(const std::string& dbPath, const SQLiteRepositoryOptions& options,
+                                           bool singleThreaded)
+    : db_(nullptr), dbPath_(dbPath), saveStmt_(nullptr), loadStmt_(nullptr), existsStmt_(nullptr),
+      dataVersionStmt_(nullptr), loadAllStmt_(nullptr), beginReadStmt_(nullptr),
+      beginWriteStmt_(nullptr), commitStmt_(nullptr), rollbackStmt_(nullptr), saveVersionStmt_(nullptr),
+      loadAsOfStmt_(nullptr), loadVersionsStmt_(nullptr) {
+    // 1つのスレッドだけが使う接続はSQLite内部のミューテックスを省く
+    int flags = SQLITE_OPEN_READWRITE | SQLITE_OPEN_CREATE | (singleThreaded ? SQLITE_OPEN_NOMUTEX : 0);
+    int rc = sqlite3_open_v2(dbPath_.c_str(), &db_, flags, nullptr);
+    if (rc != SQLITE_OK) {
+        std::cerr << "Can't open database: " << sqlite3_errmsg(db_) << std::endl;
+        sqlite3_close(db_);
+        db_ = nullptr;
+    } else if (!applyOptions(options) || !initializeDatabase() || !backfillHistory() || !prepareStatements()) {
+        finalizeStatements();
+        sqlite3_close(db_);
+        db_ = nullptr;
+    }
+}
+
+SQLiteRateConnection::~SQLiteRateConnection() {
+    if (db_) {
+        finalizeStatements();
+        sqlite3_close(db_);
+    }
+}
+
+bool SQLiteRateConnection::save(const std::string& type, const ParkingRateConfig& config) {
+    return saveBatch(RateConfigList{{type, config}});
+}
+
+bool SQLiteRateConnection::load(const std::string& type, ParkingRateConfig& config) {
+    if (!db_) return false;
+    
+    return loadRow(type, config);
+}
+
+bool SQLiteRateConnection::exists(const std::string& type) {
+    if (!db_) return false;
+    
+    sqlite3_stmt* stmt = existsStmt_;
+    sqlite3_bind_text(stmt, 1, type.c_str(), -1, SQLITE_STATIC);
+    int rc = sqlite3_step(stmt);
+    bool exists = (rc == SQLITE_ROW);
+    resetStatement(stmt);
+    
+    return exists;
+}
+
+bool SQLiteRateConnection::dataVersion(std::uint64_t& version) {
+    if (!db_) return false;
+    
+    sqlite3_stmt* stmt = dataVersionStmt_;
+    int rc = sqlite3_step(stmt);
+    if (rc == SQLITE_ROW) {
+        version = static_cast<std::uint64_t>(sqlite3_column_int64(stmt, 0));
+    }
+    resetStatement(stmt);
+    
+    return rc == SQLITE_ROW;
+}
+
+bool SQLiteRateConnection::saveBatch(const RateConfigList& configs) {
+    if (!db_) return false;
+    
+    // 1つのトランザクションにまとめ、同期書き込みを件数によらず1回にする
+    // 現在の料金設定と履歴の版は同じトランザクションで書き込む
+    if (!execute(beginWriteStmt_)) {
+        return false;
+    }
+    std::int64_t effectiveFrom = currentEpochSeconds();
+    for (const auto& entry : configs) {
+        if (!saveRow(entry.first, entry.second, effectiveFrom)) {
+            execute(rollbackStmt_);
+            return false;
+        }
+    }
+    if (!execute(commitStmt_)) {
+        execute(rollbackStmt_);
+        return false;
+    }
+    return true;
+}
+
+bool SQLiteRateConnection::loadAll(RateConfigList& configs) {
+    configs.clear();
+    if (!db_) return false;
+    
+    sqlite3_stmt* stmt = loadAllStmt_;
+    int rc;
+    while ((rc = sqlite3_step(stmt)) == SQLITE_ROW) {
+        const char* type = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 0));
+        ParkingRateConfig config;
+        readConfig(stmt, 1, config);
+        configs.emplace_back(type ? type : "", config);
+    }
+    resetStatement(stmt);
+    
+    return rc == SQLITE_DONE;
+}
+
+bool SQLiteRateConnection::loadMany(const std::vector<std::string>& types, RateConfigList& configs) {
+    configs.clear();
+    if (!db_) return false;
+    
+    // 読み込みトランザクションで囲み、一貫した内容をロック1回で読む
+    if (!execute(beginReadStmt_)) {
+        return false;
+    }
+    for (const std::string& type : types) {
+        ParkingRateConfig config;
+        if (loadRow(type, config)) {
+            configs.emplace_back(type, config);
+        }
+    }
+    execute(commitStmt_);
+    return true;
+}
+
+bool SQLiteRateConnection::saveVersion(const RateVersion& version) {
+    if (!db_) return false;
+    
+    return saveVersionRow(version);
+}
+
+bool SQLiteRateConnection::loadAsOf(const std::string& type, std::int64_t timestamp, ParkingRateConfig& config) {
+    if (!db_) return false;
+    
+    // 主キー (type, effective_from) の索引を逆順にたどり、最初の1行だけを読む
+    sqlite3_stmt* stmt = loadAsOfStmt_;
+    sqlite3_bind_text(stmt, 1, type.c_str(), -1, SQLITE_STATIC);
+    sqlite3_bind_int64(stmt, 2, timestamp);
+    
+    int rc = sqlite3_step(stmt);
+    if (rc == SQLITE_ROW) {
+        readConfig(stmt, 0, config);
+    }
+    resetStatement(stmt);
+    
+    return rc == SQLITE_ROW;
+}
+
+bool SQLiteRateConnection::loadVersions(RateVersionList& versions) {
+    versions.clear();
+    if (!db_) return false;
+    
+    sqlite3_stmt* stmt = loadVersionsStmt_;
+    int rc;
+    while ((rc = sqlite3_step(stmt)) == SQLITE_ROW) {
+        const char* type = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 0));
+        RateVersion version;
+        version.type = type ? type : "";
+        version.effectiveFrom = sqlite3_column_int64(stmt, 1);
+        readConfig(stmt, 2, version.config);
+        versions.push_back(std::move(version));
+    }
+    resetStatement(stmt);
+    
+    return rc == SQLITE_DONE;
+}
+
+// journal_mode は切り替え後のモードを返す（切り替えられない場合は元のモード）
+bool SQLiteRateConnection::setJournalMode(const char* mode) {
+    std::string sql = std::string("PRAGMA journal_mode=") + mode + ";";
+    sqlite3_stmt* stmt;
+    if (sqlite3_prepare_v2(db_, sql.c_str(), -1, &stmt, nullptr) != SQLITE_OK) {
+        return false;
+    }
+    bool switched = false;
+    if (sqlite3_step(stmt) == SQLITE_ROW) {
+        const char* current = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 0));
+        switched = current && std::strcmp(current, mode) == 0;
+    }
+    sqlite3_finalize(stmt);
+    return switched;
+}
+
+// 接続設定をPRAGMAで適用
+bool SQLiteRateConnection::applyOptions(const SQLiteRepositoryOptions& options) {
+    // ロック待ちは他のPRAGMA（WALへの切り替えなど）より先に設定する
+    sqlite3_busy_timeout(db_, options.busyTimeoutMs);
+    
+    const char* journalMode = journalModeName(options.journalMode);
+    if (journalMode && !setJournalMode(journalMode)) {
+        std::cerr << "Can't set journal_mode=" << journalMode << std::endl;
+        return false;
+    }
+    
+    std::string sql = std::string("PRAGMA synchronous=") + synchronousName(options.synchronous) + ";"
+          "PRAGMA mmap_size=" + std::to_string(options.mmapSize) + ";"
+          "PRAGMA cache_size=" + std::to_string(options.cacheSize) + ";";
+    char* errMsg = nullptr;
+    if (sqlite3_exec(db_, sql.c_str(), nullptr, nullptr, &errMsg) != SQLITE_OK) {
+        std::cerr << "SQL error: " << errMsg << std::endl;
+        sqlite3_free(errMsg);
+        return false;
+    }
+    
+    return true;
+}
+
+bool SQLiteRateConnection::initializeDatabase() {
+    const char* createTableSQL = 
+        "CREATE TABLE IF NOT EXISTS parking_rates ("
+        "type TEXT PRIMARY KEY,"
+        "unit_minutes INTEGER,"
+        "unit_price INTEGER,"
+        "max_minutes INTEGER,"
+        "max_fee INTEGER,"
+        "night_unit_minutes INTEGER,"
+        "night_unit_price INTEGER,"
+        "night_max_minutes INTEGER,"
+        "night_max_fee INTEGER"
+        ");"
+        // 料金設定の履歴。主キーの索引で「ある時点の版」を1回の索引探索で引く
+        "CREATE TABLE IF NOT EXISTS parking_rate_history ("
+        "type TEXT NOT NULL,"
+        "effective_from INTEGER NOT NULL,"
+        "unit_minutes INTEGER,"
+        "unit_price INTEGER,"
+        "max_minutes INTEGER,"
+        "max_fee INTEGER,"
+        "night_unit_minutes INTEGER,"
+        "night_unit_price INTEGER,"
+        "night_max_minutes INTEGER,"
+        "night_max_fee INTEGER,"
+        "PRIMARY KEY (type, effective_from)"
+        ") WITHOUT ROWID;";
+    
+    char* errMsg = nullptr;
+    int rc = sqlite3_exec(db_, createTableSQL, nullptr, nullptr, &errMsg);
+    
+    if (rc != SQLITE_OK) {
+        std::cerr << "SQL error: " << errMsg << std::endl;
+        sqlite3_free(errMsg);
+        return false;
+    }
+    
+    return true;
+}
+
+// 履歴のテーブルができる前に保存された料金設定を、適用開始0の版として履歴に写す（1回だけ）
+// 写す必要があるかを先に読み取りで確かめ、開くたびに書き込みロックを取らないようにする
+bool SQLiteRateConnection::backfillHistory() {
+    const char* pendingSQL =
+        "SELECT 1 FROM parking_rates r "
+        "WHERE NOT EXISTS (SELECT 1 FROM parking_rate_history h WHERE h.type = r.type) LIMIT 1;";
+    sqlite3_stmt* stmt;
+    if (sqlite3_prepare_v2(db_, pendingSQL, -1, &stmt, nullptr) != SQLITE_OK) {
+        std::cerr << "SQL error: " << sqlite3_errmsg(db_) << std::endl;
+        return false;
+    }
+    int rc = sqlite3_step(stmt);
+    sqlite3_finalize(stmt);
+    if (rc == SQLITE_DONE) {
+        return true;
+    }
+    if (rc != SQLITE_ROW) {
+        std::cerr << "SQL error: " << sqlite3_errmsg(db_) << std::endl;
+        return false;
+    }
+    
+    // 同時に開いた別の接続が先に写していれば、NOT EXISTS で何もしない
+    const char* backfillSQL =
+        "INSERT OR IGNORE INTO parking_rate_history "
+        "(type, effective_from, unit_minutes, unit_price, max_minutes, max_fee, "
+        "night_unit_minutes, night_unit_price, night_max_minutes, night_max_fee) "
+        "SELECT r.type, 0, r.unit_minutes, r.unit_price, r.max_minutes, r.max_fee, "
+        "r.night_unit_minutes, r.night_unit_price, r.night_max_minutes, r.night_max_fee "
+        "FROM parking_rates r "
+        "WHERE NOT EXISTS (SELECT 1 FROM parking_rate_history h WHERE h.type = r.type);";
+    char* errMsg = nullptr;
+    if (sqlite3_exec(db_, backfillSQL, nullptr, nullptr, &errMsg) != SQLITE_OK) {
+        std::cerr << "SQL error: " << errMsg << std::endl;
+        sqlite3_free(errMsg);
+        return false;
+    }
+    
+    return true;
+}
+
+bool SQLiteRateConnection::prepareStatements() {
+    const char* insertSQL = 
+        "INSERT OR REPLACE INTO parking_rates "
+        "(type, unit_minutes, unit_price, max_minutes, max_fee, "
+        "night_unit_minutes, night_unit_price, night_max_minutes, night_max_fee) "
+        "VALUES (?, ?, ?, ?, ?, ?, ?, ?, ?);";
+    const char* selectSQL = 
+        "SELECT unit_minutes, unit_price, max_minutes, max_fee, "
+        "night_unit_minutes, night_unit_price, night_max_minutes, night_max_fee "
+        "FROM parking_rates WHERE type = ?;";
+    const char* existsSQL = "SELECT 1 FROM parking_rates WHERE type = ?;";
+    const char* dataVersionSQL = "PRAGMA data_version;";
+    const char* selectAllSQL = 
+        "SELECT type, unit_minutes, unit_price, max_minutes, max_fee, "
+        "night_unit_minutes, night_unit_price, night_max_minutes, night_max_fee "
+        "FROM parking_rates ORDER BY type;";
+    const char* insertVersionSQL = 
+        "INSERT INTO parking_rate_history "
+        "(type, effective_from, unit_minutes, unit_price, max_minutes, max_fee, "
+        "night_unit_minutes, night_unit_price, night_max_minutes, night_max_fee) "
+        "VALUES (?, ?, ?, ?, ?, ?, ?, ?, ?, ?) "
+        "ON CONFLICT(type, effective_from) DO UPDATE SET "
+        "unit_minutes = excluded.unit_minutes, unit_price = excluded.unit_price, "
+        "max_minutes = excluded.max_minutes, max_fee = excluded.max_fee, "
+        "night_unit_minutes = excluded.night_unit_minutes, night_unit_price = excluded.night_unit_price, "
+        "night_max_minutes = excluded.night_max_minutes, night_max_fee = excluded.night_max_fee;";
+    const char* selectAsOfSQL = 
+        "SELECT unit_minutes, unit_price, max_minutes, max_fee, "
+        "night_unit_minutes, night_unit_price, night_max_minutes, night_max_fee "
+        "FROM parking_rate_history WHERE type = ? AND effective_from <= ? "
+        "ORDER BY effective_from DESC LIMIT 1;";
+    const char* selectVersionsSQL = 
+        "SELECT type, effective_from, unit_minutes, unit_price, max_minutes, max_fee, "
+        "night_unit_minutes, night_unit_price, night_max_minutes, night_max_fee "
+        "FROM parking_rate_history ORDER BY type, effective_from;";
+    
+    // SQLITE_PREPARE_PERSISTENT: 長期間保持するステートメントであることをSQLiteに伝える
+    const unsigned int flags = SQLITE_PREPARE_PERSISTENT;
+    if (sqlite3_prepare_v3(db_, insertSQL, -1, flags, &saveStmt_, nullptr) != SQLITE_OK ||
+        sqlite3_prepare_v3(db_, selectSQL, -1, flags, &loadStmt_, nullptr) != SQLITE_OK ||
+        sqlite3_prepare_v3(db_, existsSQL, -1, flags, &existsStmt_, nullptr) != SQLITE_OK ||
+        sqlite3_prepare_v3(db_, dataVersionSQL, -1, flags, &dataVersionStmt_, nullptr) != SQLITE_OK ||
+        sqlite3_prepare_v3(db_, selectAllSQL, -1, flags, &loadAllStmt_, nullptr) != SQLITE_OK ||
+        sqlite3_prepare_v3(db_, "BEGIN;", -1, flags, &beginReadStmt_, nullptr) != SQLITE_OK ||
+        sqlite3_prepare_v3(db_, "BEGIN IMMEDIATE;", -1, flags, &beginWriteStmt_, nullptr) != SQLITE_OK ||
+        sqlite3_prepare_v3(db_, "COMMIT;", -1, flags, &commitStmt_, nullptr) != SQLITE_OK ||
+        sqlite3_prepare_v3(db_, "ROLLBACK;", -1, flags, &rollbackStmt_, nullptr) != SQLITE_OK ||
+        sqlite3_prepare_v3(db_, insertVersionSQL, -1, flags, &saveVersionStmt_, nullptr) != SQLITE_OK ||
+        sqlite3_prepare_v3(db_, selectAsOfSQL, -1, flags, &loadAsOfStmt_, nullptr) != SQLITE_OK ||
+        sqlite3_prepare_v3(db_, selectVersionsSQL, -1, flags, &loadVersionsStmt_, nullptr) != SQLITE_OK) {
+        std::cerr << "SQL error: " << sqlite3_errmsg(db_) << std::endl;
+        return false;
+    }
+    
+    return true;
+}
+
+void SQLiteRateConnection::finalizeStatements() {
+    // sqlite3_finalize(nullptr) は何もしない
+    sqlite3_finalize(saveStmt_);
+    sqlite3_finalize(loadStmt_);
+    sqlite3_finalize(existsStmt_);
+    sqlite3_finalize(dataVersionStmt_);
+    sqlite3_finalize(loadAllStmt_);
+    sqlite3_finalize(beginReadStmt_);
+    sqlite3_finalize(beginWriteStmt_);
+    sqlite3_finalize(commitStmt_);
+    sqlite3_finalize(rollbackStmt_);
+    sqlite3_finalize(saveVersionStmt_);
+    sqlite3_finalize(loadAsOfStmt_);
+    sqlite3_finalize(loadVersionsStmt_);
+    saveStmt_ = nullptr;
+    loadStmt_ = nullptr;
+    existsStmt_ = nullptr;
+    dataVersionStmt_ = nullptr;
+    loadAllStmt_ = nullptr;
+    beginReadStmt_ = nullptr;
+    beginWriteStmt_ = nullptr;
+    commitStmt_ = nullptr;
+    rollbackStmt_ = nullptr;
+    saveVersionStmt_ = nullptr;
+    loadAsOfStmt_ = nullptr;
+    loadVersionsStmt_ = nullptr;
+}
+
+// トランザクションの外・中のどちらからでも使う1件の保存
+bool SQLiteRateConnection::saveRow(const std::string& type, const ParkingRateConfig& config,
+                                   std::int64_t effectiveFrom) {
+    sqlite3_stmt* stmt = saveStmt_;
+    sqlite3_bind_text(stmt, 1, type.c_str(), -1, SQLITE_STATIC);
+    bindConfig(stmt, 2, config);
+    
+    int rc = sqlite3_step(stmt);
+    resetStatement(stmt);
+    if (rc != SQLITE_DONE) {
+        return false;
+    }
+    
+    return saveVersionRow(RateVersion{type, effectiveFrom, config});
+}
+
+bool SQLiteRateConnection::saveVersionRow(const RateVersion& version) {
+    sqlite3_stmt* stmt = saveVersionStmt_;
+    sqlite3_bind_text(stmt, 1, version.type.c_str(), -1, SQLITE_STATIC);
+    sqlite3_bind_int64(stmt, 2, version.effectiveFrom);
+    bindConfig(stmt, 3, version.config);
+    
+    int rc = sqlite3_step(stmt);
+    resetStatement(stmt);
+    
+    return rc == SQLITE_DONE;
+}
+
+// トランザクションの外・中のどちらからでも使う1件の読み込み
+bool SQLiteRateConnection::loadRow(const std::string& type, ParkingRateConfig& config) {
+    sqlite3_stmt* stmt = loadStmt_;
+    sqlite3_bind_text(stmt, 1, type.c_str(), -1, SQLITE_STATIC);
+    
+    int rc = sqlite3_step(stmt);
+    if (rc == SQLITE_ROW) {
+        readConfig(stmt, 0, config);
+    }
+    resetStatement(stmt);
+    
+    return rc == SQLITE_ROW;
+}
@@ -0,0 +1,71 @@
+#ifndef SQLITE_RATE_CONNECTION_HPP
+#define SQLITE_RATE_CONNECTION_HPP
+
+#include "parking_rate_repository.hpp"
+#include <cstdint>
+#include <string>
+#include <vector>
+
+struct sqlite3;
+struct sqlite3_stmt;
+
+// SQLiteの1つの接続と、その接続で準備済みのステートメント
+// SQLiteリポジトリの実装（単一接続・接続プール）が共有する内部クラス
+// 開けなかった場合や設定を適用できなかった場合は全ての操作がfalseを返す
+class SQLiteRateConnection {
+public:
+    // singleThreaded: 呼び出し側が1スレッドずつしか使わない場合はtrue（SQLite内部の排他を省く）
+    SQLiteRateConnection(const std::string& dbPath, const SQLiteRepositoryOptions& options,
+                         bool singleThreaded = false);
+    ~SQLiteRateConnection();
+
+    SQLiteRateConnection(const SQLiteRateConnection&) = delete;
+    SQLiteRateConnection& operator=(const SQLiteRateConnection&) = delete;
+
+    bool isOpen() const { return db_ != nullptr; }
+
+    bool save(const std::string& type, const ParkingRateConfig& config);
+    bool load(const std::string& type, ParkingRateConfig& config);
+    bool exists(const std::string& type);
+    bool dataVersion(std::uint64_t& version);
+    bool saveBatch(const RateConfigList& configs);
+    bool loadAll(RateConfigList& configs);
+    bool loadMany(const std::vector<std::string>& types, RateConfigList& configs);
+    bool saveVersion(const RateVersion& version);
+    bool loadAsOf(const std::string& type, std::int64_t timestamp, ParkingRateConfig& config);
+    bool loadVersions(RateVersionList& versions);
+
+private:
+    sqlite3* db_;
+    std::string dbPath_;
+
+    // 接続の生存期間中は準備済みのステートメントを使い回す
+    sqlite3_stmt* saveStmt_;
+    sqlite3_stmt* loadStmt_;
+    sqlite3_stmt* existsStmt_;
+    sqlite3_stmt* dataVersionStmt_;
+    sqlite3_stmt* loadAllStmt_;
+    sqlite3_stmt* beginReadStmt_;
+    sqlite3_stmt* beginWriteStmt_;
+    sqlite3_stmt* commitStmt_;
+    sqlite3_stmt* rollbackStmt_;
+    sqlite3_stmt* saveVersionStmt_;
+    sqlite3_stmt* loadAsOfStmt_;
+    sqlite3_stmt* loadVersionsStmt_;
+
+    bool setJournalMode(const char* mode);
+    bool applyOptions(const SQLiteRepositoryOptions& options);
+    bool initializeDatabase();
+    bool backfillHistory();
+    bool prepareStatements();
+    void finalizeStatements();
+
+    // トランザクションの外・中のどちらからでも使う1件の保存・読み込み
+    // saveRow は現在の料金設定を置き換え、effectiveFrom を適用開始とする版も記録する
+    // （同じ秒に保存を繰り返した場合は、その秒の版を後の保存で置き換える）
+    bool saveRow(const std::string& type, const ParkingRateConfig& config, std::int64_t effectiveFrom);
+    bool saveVersionRow(const RateVersion& version);
+    bool loadRow(const std::string& type, ParkingRateConfig& config);
+};
+
+#endif // SQLITE_RATE_CONNECTION_HPP
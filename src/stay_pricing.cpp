@@ -0,0 +1,125 @@
+#include "stay_pricing.hpp"
+
+namespace {
+
+// 日中の時間帯（現地時刻の分）。18:00ちょうどの1分間までが日中
+constexpr int kDaytimeStartMinute = 8 * 60;
+constexpr int kDaytimeEndMinute = 18 * 60 + 1;
+
+const WeekendCalendar kWeekendCalendar;
+
+} // namespace
+
+DayKind WeekendCalendar::classify(std::int64_t dayNumber) const {
+    int weekday = dayOfWeek(dayNumber);
+    return (weekday == 0 || weekday == 6) ? DayKind::Holiday : DayKind::Weekday;
+}
+
+StayPricingEngine::StayPricingEngine(const DayTariffs& tariffs, int utcOffsetSeconds)
+    : tariffs_(tariffs), calendar_(&kWeekendCalendar), utcOffsetSeconds_(utcOffsetSeconds) {
+}
+
+StayPricingEngine::StayPricingEngine(const DayTariffs& tariffs, const DayCalendar& calendar, int utcOffsetSeconds)
+    : tariffs_(tariffs), calendar_(&calendar), utcOffsetSeconds_(utcOffsetSeconds) {
+}
+
+template <typename SegmentHandler>
+bool StayPricingEngine::walkSegments(std::int64_t entryTime, std::int64_t exitTime, SegmentHandler&& handler) const {
+    if (exitTime < entryTime) {
+        return false;
+    }
+
+    // 現地時刻の分に変換（入庫は切り捨て、出庫は切り上げ）
+    const std::int64_t offset = utcOffsetSeconds_;
+    const std::int64_t endMinute = -floorDiv(-(exitTime + offset), 60);
+    std::int64_t minute = floorDiv(entryTime + offset, 60);
+
+    // 結合中の区間
+    bool open = false;
+    std::int64_t segmentStart = 0;
+    DayKind segmentKind = DayKind::Weekday;
+    TimeBand segmentBand = TimeBand::Daytime;
+
+    std::int64_t cachedDay = 0;
+    DayKind cachedKind = DayKind::Weekday;
+    bool hasCachedDay = false;
+
+    auto flush = [&](std::int64_t segmentEnd) {
+        const Tariff& tariff = tariffs_[segmentKind];
+        int minutes = static_cast<int>(segmentEnd - segmentStart);
+        int fee = segmentBand == TimeBand::Daytime ? tariff.daytimeFee(minutes) : tariff.nighttimeFee(minutes);
+        handler(segmentStart, segmentEnd, segmentKind, segmentBand, minutes, fee);
+    };
+
+    while (minute < endMinute) {
+        std::int64_t day = floorDiv(minute, kMinutesPerDay);
+        std::int64_t minuteOfDay = minute - day * kMinutesPerDay;
+
+        // 次の境界（日中開始、日中終了、日付の変わり目）まで進める
+        std::int64_t boundary;
+        TimeBand band;
+        if (minuteOfDay < kDaytimeStartMinute) {
+            boundary = day * kMinutesPerDay + kDaytimeStartMinute;
+            band = TimeBand::Nighttime;
+        } else if (minuteOfDay < kDaytimeEndMinute) {
+            boundary = day * kMinutesPerDay + kDaytimeEndMinute;
+            band = TimeBand::Daytime;
+        } else {
+            boundary = (day + 1) * kMinutesPerDay;
+            band = TimeBand::Nighttime;
+        }
+        std::int64_t pieceEnd = boundary < endMinute ? boundary : endMinute;
+
+        if (!hasCachedDay || cachedDay != day) {
+            cachedDay = day;
+            cachedKind = calendar_->classify(day);
+            hasCachedDay = true;
+        }
+
+        if (open && (segmentKind != cachedKind || segmentBand != band)) {
+            flush(minute);
+            open = false;
+        }
+        if (!open) {
+            segmentStart = minute;
+            segmentKind = cachedKind;
+            segmentBand = band;
+            open = true;
+        }
+        minute = pieceEnd;
+    }
+
+    if (open) {
+        flush(minute);
+    }
+    return true;
+}
+
+bool StayPricingEngine::quote(std::int64_t entryTime, std::int64_t exitTime, StayQuote& result) const {
+    result.totalFee = 0;
+    result.segments.clear();
+
+    const std::int64_t offset = utcOffsetSeconds_;
+    return walkSegments(entryTime, exitTime,
+        [&](std::int64_t startMinute, std::int64_t endMinute, DayKind kind, TimeBand band, int minutes, int fee) {
+            // 区間の時刻はエポック秒に戻し、最初と最後は実際の入庫・出庫時刻に合わせる
+            std::int64_t startTime = startMinute * 60 - offset;
+            std::int64_t endTime = endMinute * 60 - offset;
+            if (result.segments.empty()) {
+                startTime = entryTime;
+            }
+            if (endTime > exitTime) {
+                endTime = exitTime;
+            }
+            result.segments.push_back(StaySegment{startTime, endTime, kind, band, minutes, fee});
+            result.totalFee += fee;
+        });
+}
+
+bool StayPricingEngine::quoteTotal(std::int64_t entryTime, std::int64_t exitTime, std::int64_t& totalFee) const {
+    totalFee = 0;
+    return walkSegments(entryTime, exitTime,
+        [&](std::int64_t, std::int64_t, DayKind, TimeBand, int, int fee) {
+            totalFee += fee;
+        });
+}
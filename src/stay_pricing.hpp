@@ -0,0 +1,78 @@
+#ifndef STAY_PRICING_HPP
+#define STAY_PRICING_HPP
+
+#include "tariff.hpp"
+#include "civil_time.hpp"
+#include <cstdint>
+#include <vector>
+
+// 日付（1970-01-01を0とする現地の日数）から平日・休日を判定するインターフェース
+class DayCalendar {
+public:
+    virtual ~DayCalendar() = default;
+
+    virtual DayKind classify(std::int64_t dayNumber) const = 0;
+};
+
+// 土曜日・日曜日を休日とするカレンダー
+class WeekendCalendar : public DayCalendar {
+public:
+    DayKind classify(std::int64_t dayNumber) const override;
+};
+
+// 日中・夜間の区別
+enum class TimeBand : std::uint8_t {
+    Daytime = 0,    // 08:00-18:00（18:00ちょうどを含む）
+    Nighttime = 1,  // 18:01-07:59
+};
+
+// 同じ日種別・時間帯が続く区間と、その区間の料金
+struct StaySegment {
+    std::int64_t startTime;  // 区間の開始（エポック秒）
+    std::int64_t endTime;    // 区間の終了（エポック秒）
+    DayKind dayKind;
+    TimeBand band;
+    int minutes;             // 課金対象の分数
+    int fee;                 // 区間ごとに最大料金を適用した料金
+};
+
+// 料金の見積もり結果
+struct StayQuote {
+    std::int64_t totalFee = 0;
+    std::vector<StaySegment> segments;  // 時刻順の内訳
+};
+
+// 入庫・出庫時刻から、日中・夜間と平日・休日の境界で区間に分けて料金を計算する
+// 計算量は境界の数（1日あたり最大3つ）に比例し、駐車時間の分数には依存しない
+//
+// - 時刻は現地時刻の分単位で扱い、入庫は切り捨て、出庫は切り上げる
+// - 区間の料金は DayTariffs の日種別ごとの日中・夜間料金で計算する
+// - 同じ日種別の夜間が日付をまたぐ場合は1つの区間として最大料金を適用する
+class StayPricingEngine {
+public:
+    // 土日を休日として扱う
+    explicit StayPricingEngine(const DayTariffs& tariffs, int utcOffsetSeconds = kJstUtcOffsetSeconds);
+    // calendar は StayPricingEngine より長く生存すること
+    StayPricingEngine(const DayTariffs& tariffs, const DayCalendar& calendar,
+                      int utcOffsetSeconds = kJstUtcOffsetSeconds);
+
+    // 料金と内訳を計算（出庫が入庫より前ならfalse）
+    bool quote(std::int64_t entryTime, std::int64_t exitTime, StayQuote& result) const;
+
+    // 料金の合計のみを計算（内訳を作らないためメモリ確保なし）
+    bool quoteTotal(std::int64_t entryTime, std::int64_t exitTime, std::int64_t& totalFee) const;
+
+    const DayTariffs& tariffs() const { return tariffs_; }
+    const DayCalendar& calendar() const { return *calendar_; }
+    int utcOffsetSeconds() const { return utcOffsetSeconds_; }
+
+private:
+    template <typename SegmentHandler>
+    bool walkSegments(std::int64_t entryTime, std::int64_t exitTime, SegmentHandler&& handler) const;
+
+    DayTariffs tariffs_;
+    const DayCalendar* calendar_;
+    int utcOffsetSeconds_;
+};
+
+#endif // STAY_PRICING_HPP
@@ -0,0 +1,108 @@
+#ifndef TARIFF_HPP
+#define TARIFF_HPP
+
+#include "fee_kernel.hpp"
+#include <cstdint>
+#include <type_traits>
+
+// 日中・夜間の料金帯をまとめた料金体系
+// 全てconstexprで評価できるため、固定の料金体系はコンパイル時に計算できる
+struct Tariff {
+    FeeRate daytime;    // 日中（08:00-18:00）の料金帯
+    FeeRate nighttime;  // 夜間（18:01-07:59）の料金帯
+
+    constexpr int daytimeFee(int minutes) const {
+        return calculateRateFee(minutes, daytime);
+    }
+
+    constexpr int nighttimeFee(int minutes) const {
+        return calculateRateFee(minutes, nighttime);
+    }
+
+    // 時刻を指定した料金計算（hour: 0-23, minute: 0-59）
+    constexpr int calculateFee(int minutes, int startHour, int startMinute) const {
+        return isDaytimeStart(startHour, startMinute) ? daytimeFee(minutes) : nighttimeFee(minutes);
+    }
+};
+
+static_assert(std::is_trivially_copyable<Tariff>::value, "Tariffは配列やセッション情報に埋め込める値型");
+
+// 平日・休日の区別
+enum class DayKind : std::uint8_t {
+    Weekday = 0,
+    Holiday = 1,
+};
+
+constexpr int kDayKindCount = 2;
+
+// 平日の既定料金
+// 日中は60分500円・12時間（720分）まで最大料金1500円、夜間は60分300円・最大料金1000円
+inline constexpr Tariff kWeekdayTariff = {
+    {60, 500, 720, 1500},
+    {60, 300, 720, 1000},
+};
+
+// 休日の既定料金
+// 日中は30分500円・6時間（360分）まで最大料金1500円、夜間は60分300円・最大料金1000円
+inline constexpr Tariff kHolidayTariff = {
+    {30, 500, 360, 1500},
+    {60, 300, 360, 1000},
+};
+
+// 平日と休日が混在する場合の料金計算（ParkingLot::calculateFee と同じく日中料金で計算）
+constexpr int calculateMixedFee(int weekdayMinutes, int holidayMinutes,
+                                const Tariff& weekdayTariff, const Tariff& holidayTariff) {
+    int weekdayFee = weekdayMinutes > 0 ? weekdayTariff.daytimeFee(weekdayMinutes) : 0;
+    int holidayFee = holidayMinutes > 0 ? holidayTariff.daytimeFee(holidayMinutes) : 0;
+    return weekdayFee + holidayFee;
+}
+
+// 平日・休日の料金体系を DayKind で引けるようにまとめたもの
+// WeekdayParkingLot / HolidayParkingLot の組を値として置き換える
+struct DayTariffs {
+    Tariff byKind[kDayKindCount];
+
+    constexpr const Tariff& operator[](DayKind kind) const {
+        return byKind[static_cast<int>(kind)];
+    }
+
+    constexpr Tariff& operator[](DayKind kind) {
+        return byKind[static_cast<int>(kind)];
+    }
+
+    // 時刻を指定した料金計算
+    constexpr int calculateFee(DayKind kind, int minutes, int startHour, int startMinute) const {
+        return (*this)[kind].calculateFee(minutes, startHour, startMinute);
+    }
+
+    // 平日と休日が混在する場合の料金計算
+    constexpr int calculateMixedFee(int weekdayMinutes, int holidayMinutes) const {
+        return ::calculateMixedFee(weekdayMinutes, holidayMinutes, (*this)[DayKind::Weekday], (*this)[DayKind::Holiday]);
+    }
+};
+
+static_assert(std::is_trivially_copyable<DayTariffs>::value, "DayTariffsは値型");
+
+// 既定の平日・休日の料金体系
+inline constexpr DayTariffs kDefaultDayTariffs = {{kWeekdayTariff, kHolidayTariff}};
+
+// 料金体系をテンプレート引数で固定した料金計算
+// 仮想呼び出しも初期化処理もなく、定数の引数ならコンパイル時に評価される
+template <const Tariff& Plan>
+struct FixedTariff {
+    static constexpr const Tariff& tariff = Plan;
+
+    // WeekdayParkingLot::calculateFee(minutes) などと同じく日中料金で計算
+    static constexpr int calculateFee(int minutes) {
+        return Plan.daytimeFee(minutes);
+    }
+
+    static constexpr int calculateFee(int minutes, int startHour, int startMinute) {
+        return Plan.calculateFee(minutes, startHour, startMinute);
+    }
+};
+
+using WeekdayTariff = FixedTariff<kWeekdayTariff>;
+using HolidayTariff = FixedTariff<kHolidayTariff>;
+
+#endif // TARIFF_HPP
@@ -0,0 +1,52 @@
+#include "tariff_registry.hpp"
+
+TariffRegistry::TariffRegistry(int horizonMinutes)
+    : horizonMinutes_(horizonMinutes), cell_(std::make_unique<const Snapshot>()) {
+}
+
+template <typename Modifier>
+void TariffRegistry::update(Modifier&& modify) {
+    std::lock_guard<std::mutex> lock(writerMutex_);
+
+    // 書き込みは writerMutex_ で直列化されているため、現在の値は読み取り区間なしで参照できる
+    const Snapshot* current = cell_.read();
+    std::unique_ptr<Snapshot> next(new Snapshot(*current));
+    modify(*next);
+    next->version = current->version + 1;
+
+    cell_.publish(std::move(next));
+}
+
+void TariffRegistry::publish(const std::string& type, const ParkingRateConfig& config) {
+    // 料金表の構築はロックの外で行う
+    auto tariff = std::make_shared<const CompiledTariff>(config, horizonMinutes_);
+    update([&](Snapshot& snapshot) {
+        snapshot.tariffs[type] = std::move(tariff);
+    });
+}
+
+void TariffRegistry::publishAll(const std::vector<std::pair<std::string, ParkingRateConfig>>& configs) {
+    std::vector<std::shared_ptr<const CompiledTariff>> tariffs;
+    tariffs.reserve(configs.size());
+    for (const auto& entry : configs) {
+        tariffs.push_back(std::make_shared<const CompiledTariff>(entry.second, horizonMinutes_));
+    }
+    update([&](Snapshot& snapshot) {
+        for (std::size_t i = 0; i < configs.size(); ++i) {
+            snapshot.tariffs[configs[i].first] = std::move(tariffs[i]);
+        }
+    });
+}
+
+bool TariffRegistry::remove(const std::string& type) {
+    bool removed = false;
+    update([&](Snapshot& snapshot) {
+        removed = snapshot.tariffs.erase(type) > 0;
+    });
+    return removed;
+}
+
+std::uint64_t TariffRegistry::version() const {
+    RcuReadGuard guard;
+    return cell_.read()->version;
+}
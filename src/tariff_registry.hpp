@@ -0,0 +1,80 @@
+#ifndef TARIFF_REGISTRY_HPP
+#define TARIFF_REGISTRY_HPP
+
+#include "compiled_tariff.hpp"
+#include "rcu.hpp"
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+// 料金体系を料金計算スレッドに公開するレジストリ
+//
+// 公開する内容は不変のスナップショット（種別ごとの CompiledTariff）で、RCUで差し替える。
+// - 料金計算（読み取り）はロックを取らず、書き込み中も止まらない
+// - 書き込みは新しいスナップショットを作って差し替え、古いスナップショットを読んでいる
+//   料金計算が終わってから破棄する（書き込み同士は直列化する）
+class TariffRegistry {
+public:
+    // 不変のスナップショット
+    struct Snapshot {
+        std::uint64_t version = 0;
+        std::unordered_map<std::string, std::shared_ptr<const CompiledTariff>> tariffs;
+
+        // 見つからなければnullptr
+        const CompiledTariff* find(const std::string& type) const {
+            auto it = tariffs.find(type);
+            return it != tariffs.end() ? it->second.get() : nullptr;
+        }
+    };
+
+    explicit TariffRegistry(int horizonMinutes = CompiledTariff::kDefaultHorizonMinutes);
+
+    TariffRegistry(const TariffRegistry&) = delete;
+    TariffRegistry& operator=(const TariffRegistry&) = delete;
+
+    // 料金設定を公開（同じ種別があれば置き換える）
+    void publish(const std::string& type, const ParkingRateConfig& config);
+
+    // 複数の料金設定を1つのスナップショットとしてまとめて公開
+    void publishAll(const std::vector<std::pair<std::string, ParkingRateConfig>>& configs);
+
+    // 料金設定を削除（存在しなければfalse）
+    bool remove(const std::string& type);
+
+    // 料金計算（種別が見つからなければfalse）
+    bool calculateFee(const std::string& type, int minutes, int startHour, int startMinute, int& fee) const {
+        RcuReadGuard guard;
+        const CompiledTariff* tariff = cell_.read()->find(type);
+        if (!tariff) {
+            return false;
+        }
+        fee = tariff->calculateFee(minutes, startHour, startMinute);
+        return true;
+    }
+
+    // 読み取り区間の中で現在のスナップショットを reader に渡す
+    // reader の外にスナップショットへの参照を持ち出してはいけない
+    template <typename Reader>
+    auto read(Reader&& reader) const -> decltype(reader(std::declval<const Snapshot&>())) {
+        RcuReadGuard guard;
+        return reader(*cell_.read());
+    }
+
+    // 公開されているスナップショットのバージョン（公開のたびに増える）
+    std::uint64_t version() const;
+
+private:
+    // 現在のスナップショットを複製し、modify で変更してから公開する
+    template <typename Modifier>
+    void update(Modifier&& modify);
+
+    int horizonMinutes_;
+    std::mutex writerMutex_;
+    RcuCell<Snapshot> cell_;
+};
+
+#endif // TARIFF_REGISTRY_HPP
@@ -0,0 +1,277 @@
+#include "tariff_snapshot.hpp"
+#include "crc32c.hpp"
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <map>
+#include <vector>
+
+static_assert(sizeof(int) == sizeof(std::int32_t), "料金表は int32 のまま参照する");
+
+namespace {
+
+const char kMagic[8] = {'P', 'K', 'T', 'A', 'R', 'I', 'F', 'F'};
+constexpr std::uint32_t kByteOrderMark = 0x01020304u;
+constexpr std::uint64_t kAlignment = 64;
+
+// 読み込み時に受け付ける事前計算範囲の上限（サイズ計算があふれないようにする）
+constexpr std::int32_t kMaxHorizonMinutes = 1 << 24;
+
+// 日中・夜間の表を合わせた1エントリ分の料金表の件数
+std::uint64_t tableLength(std::int32_t horizonMinutes) {
+    return 2 * (static_cast<std::uint64_t>(horizonMinutes) + 1);
+}
+
+std::uint64_t alignUp(std::uint64_t value) {
+    return (value + kAlignment - 1) / kAlignment * kAlignment;
+}
+
+std::uint32_t headerChecksum(const TariffSnapshotHeader& header) {
+    TariffSnapshotHeader copy = header;
+    copy.headerCrc = 0;
+    return crc32c(&copy, sizeof(copy));
+}
+
+// 全て書き込むまで write を繰り返す
+bool writeAll(int fd, const char* data, std::size_t size) {
+    while (size > 0) {
+        ssize_t written = ::write(fd, data, size);
+        if (written < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return false;
+        }
+        data += written;
+        size -= static_cast<std::size_t>(written);
+    }
+    return true;
+}
+
+// rename をディスクに反映させるため、ファイルのあるディレクトリを fsync する
+void syncDirectory(const std::string& path) {
+    std::string::size_type slash = path.rfind('/');
+    std::string directory = slash == std::string::npos ? "." : (slash == 0 ? "/" : path.substr(0, slash));
+    int fd = ::open(directory.c_str(), O_RDONLY);
+    if (fd >= 0) {
+        ::fsync(fd);
+        ::close(fd);
+    }
+}
+
+} // namespace
+
+bool writeTariffSnapshot(const std::string& path, const RateConfigList& configs, int horizonMinutes) {
+    if (horizonMinutes < 0) {
+        horizonMinutes = 0;
+    }
+    if (horizonMinutes > kMaxHorizonMinutes) {
+        std::cerr << "Tariff snapshot horizon too large: " << horizonMinutes << std::endl;
+        return false;
+    }
+
+    // 種別名の順に並べる（同じ種別は後のものを使う）
+    std::map<std::string, ParkingRateConfig> sorted;
+    for (const auto& entry : configs) {
+        if (entry.first.empty() || entry.first.size() > kTariffSnapshotMaxTypeLength ||
+            entry.first.find('\0') != std::string::npos) {
+            std::cerr << "Invalid tariff type for snapshot: " << entry.first << std::endl;
+            return false;
+        }
+        sorted[entry.first] = entry.second;
+    }
+
+    TariffSnapshotHeader header{};
+    std::memcpy(header.magic, kMagic, sizeof(kMagic));
+    header.formatVersion = kTariffSnapshotFormatVersion;
+    header.byteOrderMark = kByteOrderMark;
+    header.entryCount = static_cast<std::uint32_t>(sorted.size());
+    header.horizonMinutes = horizonMinutes;
+    header.entriesOffset = alignUp(sizeof(TariffSnapshotHeader));
+    header.tablesOffset = alignUp(header.entriesOffset + sorted.size() * sizeof(TariffSnapshotEntry));
+    header.fileSize = header.tablesOffset +
+                      sorted.size() * tableLength(horizonMinutes) * sizeof(std::int32_t);
+
+    std::vector<char> image(static_cast<std::size_t>(header.fileSize), 0);
+    auto* entries = reinterpret_cast<TariffSnapshotEntry*>(image.data() + header.entriesOffset);
+    auto* tables = reinterpret_cast<std::int32_t*>(image.data() + header.tablesOffset);
+    std::size_t length = static_cast<std::size_t>(horizonMinutes) + 1;
+    std::size_t index = 0;
+    for (const auto& entry : sorted) {
+        std::memcpy(entries[index].type, entry.first.data(), entry.first.size());
+        entries[index].config = entry.second;
+
+        CompiledTariff compiled(entry.second, horizonMinutes);
+        std::int32_t* table = tables + index * 2 * length;
+        std::memcpy(table, compiled.daytimeTable(), length * sizeof(std::int32_t));
+        std::memcpy(table + length, compiled.nighttimeTable(), length * sizeof(std::int32_t));
+        ++index;
+    }
+
+    header.payloadCrc = crc32c(image.data() + header.entriesOffset,
+                               static_cast<std::size_t>(header.fileSize - header.entriesOffset));
+    header.headerCrc = headerChecksum(header);
+    std::memcpy(image.data(), &header, sizeof(header));
+
+    // 読み込み側が書きかけのファイルを見ないよう、一時ファイルに書いてから置き換える
+    std::string temporary = path + ".tmp";
+    int fd = ::open(temporary.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (fd < 0) {
+        std::cerr << "Can't create tariff snapshot: " << temporary << std::endl;
+        return false;
+    }
+    bool written = writeAll(fd, image.data(), image.size()) && ::fsync(fd) == 0;
+    written = ::close(fd) == 0 && written;
+    if (!written || std::rename(temporary.c_str(), path.c_str()) != 0) {
+        std::cerr << "Can't write tariff snapshot: " << path << std::endl;
+        std::remove(temporary.c_str());
+        return false;
+    }
+    syncDirectory(path);
+    return true;
+}
+
+bool writeTariffSnapshot(const std::string& path, ParkingRateRepository& repository, int horizonMinutes) {
+    RateConfigList configs;
+    if (!repository.loadAll(configs)) {
+        return false;
+    }
+    return writeTariffSnapshot(path, configs, horizonMinutes);
+}
+
+MappedTariffSnapshot::~MappedTariffSnapshot() {
+    close();
+}
+
+bool MappedTariffSnapshot::open(const std::string& path, bool verifyChecksum) {
+    close();
+
+    int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        std::cerr << "Can't open tariff snapshot: " << path << std::endl;
+        return false;
+    }
+    struct stat status;
+    if (::fstat(fd, &status) != 0 || status.st_size < static_cast<off_t>(sizeof(TariffSnapshotHeader))) {
+        std::cerr << "Invalid tariff snapshot: " << path << std::endl;
+        ::close(fd);
+        return false;
+    }
+    std::size_t fileSize = static_cast<std::size_t>(status.st_size);
+    void* base = ::mmap(nullptr, fileSize, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+    if (base == MAP_FAILED) {
+        std::cerr << "Can't map tariff snapshot: " << path << std::endl;
+        return false;
+    }
+
+    // ヘッダーと各領域の範囲を検査する（ここで通れば、以降の参照は全てファイルの範囲内）
+    const auto* header = static_cast<const TariffSnapshotHeader*>(base);
+    const char* bytes = static_cast<const char*>(base);
+    bool valid = std::memcmp(header->magic, kMagic, sizeof(kMagic)) == 0 &&
+                 header->formatVersion == kTariffSnapshotFormatVersion &&
+                 header->byteOrderMark == kByteOrderMark &&
+                 header->headerCrc == headerChecksum(*header) &&
+                 header->fileSize == fileSize &&
+                 header->horizonMinutes >= 0 && header->horizonMinutes <= kMaxHorizonMinutes &&
+                 header->entryCount <= fileSize / sizeof(TariffSnapshotEntry) &&
+                 header->entriesOffset == alignUp(sizeof(TariffSnapshotHeader)) &&
+                 header->tablesOffset ==
+                     alignUp(header->entriesOffset + std::uint64_t(header->entryCount) * sizeof(TariffSnapshotEntry)) &&
+                 header->fileSize == header->tablesOffset + std::uint64_t(header->entryCount) *
+                                                                tableLength(header->horizonMinutes) *
+                                                                sizeof(std::int32_t);
+    const auto* entries = reinterpret_cast<const TariffSnapshotEntry*>(bytes + sizeof(TariffSnapshotHeader));
+    if (valid) {
+        // 種別名がNUL終端され、昇順に並んでいること（二分探索の前提）
+        for (std::uint32_t i = 0; i < header->entryCount && valid; ++i) {
+            valid = entries[i].type[kTariffSnapshotMaxTypeLength] == '\0' && entries[i].type[0] != '\0' &&
+                    (i == 0 || std::strcmp(entries[i - 1].type, entries[i].type) < 0);
+        }
+    }
+    if (valid && verifyChecksum) {
+        valid = header->payloadCrc == crc32c(bytes + header->entriesOffset,
+                                             static_cast<std::size_t>(header->fileSize - header->entriesOffset));
+    }
+    if (!valid) {
+        std::cerr << "Invalid tariff snapshot: " << path << std::endl;
+        ::munmap(base, fileSize);
+        return false;
+    }
+
+    base_ = base;
+    mappedBytes_ = fileSize;
+    header_ = header;
+    entries_ = reinterpret_cast<const TariffSnapshotEntry*>(bytes + header->entriesOffset);
+    tables_ = reinterpret_cast<const std::int32_t*>(bytes + header->tablesOffset);
+    return true;
+}
+
+void MappedTariffSnapshot::close() {
+    if (base_) {
+        ::munmap(base_, mappedBytes_);
+    }
+    base_ = nullptr;
+    mappedBytes_ = 0;
+    header_ = nullptr;
+    entries_ = nullptr;
+    tables_ = nullptr;
+}
+
+MappedTariffSnapshot::View MappedTariffSnapshot::at(std::size_t index) const {
+    std::size_t length = static_cast<std::size_t>(header_->horizonMinutes) + 1;
+    View view;
+    view.entry_ = &entries_[index];
+    view.daytimeTable_ = tables_ + index * 2 * length;
+    view.nighttimeTable_ = view.daytimeTable_ + length;
+    view.horizonMinutes_ = header_->horizonMinutes;
+    view.tariff_ = makeTariff(entries_[index].config);
+    return view;
+}
+
+bool MappedTariffSnapshot::find(const std::string& type, View& view) const {
+    if (!header_ || type.size() > kTariffSnapshotMaxTypeLength) {
+        return false;
+    }
+    const TariffSnapshotEntry* end = entries_ + header_->entryCount;
+    const TariffSnapshotEntry* it = std::lower_bound(
+        entries_, end, type.c_str(),
+        [](const TariffSnapshotEntry& entry, const char* key) { return std::strcmp(entry.type, key) < 0; });
+    if (it == end || std::strcmp(it->type, type.c_str()) != 0) {
+        return false;
+    }
+    view = at(static_cast<std::size_t>(it - entries_));
+    return true;
+}
+
+bool MappedTariffSnapshot::calculateFee(const std::string& type, int minutes, int startHour, int startMinute,
+                                        int& fee) const {
+    View view;
+    if (!find(type, view)) {
+        return false;
+    }
+    fee = view.calculateFee(minutes, startHour, startMinute);
+    return true;
+}
+
+RateConfigList MappedTariffSnapshot::configs() const {
+    RateConfigList result;
+    result.reserve(size());
+    for (std::size_t i = 0; i < size(); ++i) {
+        result.emplace_back(entries_[i].type, entries_[i].config);
+    }
+    return result;
+}
+
+bool importTariffSnapshot(const MappedTariffSnapshot& snapshot, ParkingRateRepository& repository) {
+    if (!snapshot.isOpen()) {
+        return false;
+    }
+    return repository.saveBatch(snapshot.configs());
+}
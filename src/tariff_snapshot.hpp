@@ -0,0 +1,138 @@
+#ifndef TARIFF_SNAPSHOT_HPP
+#define TARIFF_SNAPSHOT_HPP
+
+#include "compiled_tariff.hpp"
+#include "parking_rate_repository.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+// 料金体系のスナップショットファイル
+//
+// 料金設定と事前計算した料金表（CompiledTariff と同じ内容）を固定レイアウトのバイナリに書き出す。
+// 読み込み側はファイルを mmap するだけで料金計算でき、解析もSQLも不要
+// （起動にかかる時間は実際に触れたページのページフォールトだけになる）
+//
+// レイアウト（リトルエンディアン、各領域は64バイト境界から始まる）
+//   ヘッダー   TariffSnapshotHeader（64バイト）
+//   エントリ   TariffSnapshotEntry × entryCount（種別名の昇順、二分探索で引く）
+//   料金表     エントリと同じ順に、日中の表・夜間の表（それぞれ int32 × (horizonMinutes + 1)）
+//
+// ヘッダーとそれ以外（エントリと料金表）はそれぞれ CRC-32C で検査する
+
+constexpr std::uint32_t kTariffSnapshotFormatVersion = 1;
+
+// 種別名の最大長（NUL終端を除く）
+constexpr std::size_t kTariffSnapshotMaxTypeLength = 31;
+
+struct TariffSnapshotHeader {
+    char magic[8];                // "PKTARIFF"
+    std::uint32_t formatVersion;  // kTariffSnapshotFormatVersion
+    std::uint32_t byteOrderMark;  // 0x01020304（書き出したCPUと読み込むCPUのバイト順の確認）
+    std::uint64_t fileSize;
+    std::uint64_t entriesOffset;
+    std::uint64_t tablesOffset;
+    std::uint32_t entryCount;
+    std::int32_t horizonMinutes;
+    std::uint32_t payloadCrc;     // entriesOffset からファイル末尾までの CRC-32C
+    std::uint32_t headerCrc;      // このフィールドを0にしたヘッダーの CRC-32C
+    std::uint8_t reserved[8];
+};
+
+struct TariffSnapshotEntry {
+    char type[kTariffSnapshotMaxTypeLength + 1];  // NUL終端、残りは0埋め
+    ParkingRateConfig config;
+};
+
+static_assert(sizeof(TariffSnapshotHeader) == 64, "スナップショットのヘッダーは64バイト");
+static_assert(sizeof(TariffSnapshotEntry) == 64, "スナップショットのエントリは64バイト");
+
+// スナップショットを書き出す（一時ファイルに書いて fsync してから rename する）
+// 種別名が長すぎる場合や書き込みに失敗した場合はfalse（既存のファイルはそのまま残る）
+// 同じ種別が複数あれば後のものを使う
+bool writeTariffSnapshot(const std::string& path, const RateConfigList& configs,
+                         int horizonMinutes = CompiledTariff::kDefaultHorizonMinutes);
+
+// リポジトリの全ての料金設定（loadAll）を書き出す
+bool writeTariffSnapshot(const std::string& path, ParkingRateRepository& repository,
+                         int horizonMinutes = CompiledTariff::kDefaultHorizonMinutes);
+
+// mmap したスナップショット（読み取り専用、開いた後はスレッドセーフ）
+class MappedTariffSnapshot {
+public:
+    // 1つの種別の料金体系。料金表はスナップショット内を直接参照する
+    // 参照先のスナップショットを閉じた後は使えない
+    class View {
+    public:
+        int daytimeFee(int minutes) const {
+            if (static_cast<unsigned>(minutes) <= static_cast<unsigned>(horizonMinutes_)) {
+                return daytimeTable_[minutes];
+            }
+            return tariff_.daytimeFee(minutes);
+        }
+
+        int nighttimeFee(int minutes) const {
+            if (static_cast<unsigned>(minutes) <= static_cast<unsigned>(horizonMinutes_)) {
+                return nighttimeTable_[minutes];
+            }
+            return tariff_.nighttimeFee(minutes);
+        }
+
+        // CompiledTariff::calculateFee と同じ結果
+        int calculateFee(int minutes, int startHour, int startMinute) const {
+            return isDaytimeStart(startHour, startMinute) ? daytimeFee(minutes) : nighttimeFee(minutes);
+        }
+
+        const char* type() const { return entry_->type; }
+        const ParkingRateConfig& config() const { return entry_->config; }
+
+    private:
+        friend class MappedTariffSnapshot;
+
+        const TariffSnapshotEntry* entry_ = nullptr;
+        const std::int32_t* daytimeTable_ = nullptr;
+        const std::int32_t* nighttimeTable_ = nullptr;
+        int horizonMinutes_ = 0;
+        Tariff tariff_{};
+    };
+
+    MappedTariffSnapshot() = default;
+    ~MappedTariffSnapshot();
+
+    MappedTariffSnapshot(const MappedTariffSnapshot&) = delete;
+    MappedTariffSnapshot& operator=(const MappedTariffSnapshot&) = delete;
+
+    // ファイルを mmap してヘッダーと範囲を検査する（開いていたものは閉じる）
+    // verifyChecksum がtrueなら料金表も含めて CRC-32C を検査する（全ページを読むことになる）
+    bool open(const std::string& path, bool verifyChecksum = true);
+    void close();
+
+    bool isOpen() const { return base_ != nullptr; }
+    std::size_t size() const { return header_ ? header_->entryCount : 0; }
+    int horizonMinutes() const { return header_ ? header_->horizonMinutes : 0; }
+    std::size_t mappedBytes() const { return mappedBytes_; }
+
+    // 種別を二分探索で引く（見つからなければfalse）
+    bool find(const std::string& type, View& view) const;
+
+    // index 番目（種別名の順）の料金体系
+    View at(std::size_t index) const;
+
+    // 料金計算（種別が見つからなければfalse）
+    bool calculateFee(const std::string& type, int minutes, int startHour, int startMinute, int& fee) const;
+
+    // 全ての料金設定（リポジトリへの取り込み用）
+    RateConfigList configs() const;
+
+private:
+    void* base_ = nullptr;
+    std::size_t mappedBytes_ = 0;
+    const TariffSnapshotHeader* header_ = nullptr;
+    const TariffSnapshotEntry* entries_ = nullptr;
+    const std::int32_t* tables_ = nullptr;
+};
+
+// スナップショットの全ての料金設定をリポジトリに保存（1トランザクション）
+bool importTariffSnapshot(const MappedTariffSnapshot& snapshot, ParkingRateRepository& repository);
+
+#endif // TARIFF_SNAPSHOT_HPP
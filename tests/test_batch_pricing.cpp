@@ -0,0 +1,190 @@
+// 駐車記録の一括料金計算のテスト
+#include "catch.hpp"
+#include "../src/batch_pricing.hpp"
+#include <unistd.h>
+#include <cstdio>
+#include <fstream>
+#include <string>
+
+namespace {
+
+std::int64_t jst(int month, int day, int hour, int minute) {
+    return epochFromLocal(2024, month, day, hour, minute);
+}
+
+bool price(const BatchPricer& pricer, const std::string& line, std::int64_t& fee, char delimiter = ',') {
+    return pricer.priceLine(line.data(), line.data() + line.size(), delimiter, fee);
+}
+
+std::string runAll(const BatchPricer& pricer, const std::string& input, const BatchPricingOptions& options,
+                   BatchPricingStats& stats) {
+    std::string output;
+    bool succeeded = pricer.run(input.data(), input.size(), options,
+                                [&output](const char* data, std::size_t size) {
+                                    output.append(data, size);
+                                    return true;
+                                },
+                                stats);
+    REQUIRE(succeeded == true);
+    return output;
+}
+
+} // namespace
+
+TEST_CASE("一括料金計算: 1行の解析", "[batch]") {
+    StayPricingEngine pricing(kDefaultDayTariffs);
+    BatchPricer pricer;
+    REQUIRE(pricer.addLot(1, pricing) == true);
+    REQUIRE(pricer.addLot(BatchPricer::kMaxLots, pricing) == false);
+    std::int64_t fee = 0;
+    std::int64_t expected = 0;
+
+    SECTION("現地時刻とエポック秒は同じ料金") {
+        REQUIRE(pricing.quoteTotal(jst(1, 5, 12, 0), jst(1, 6, 15, 0), expected) == true);
+        REQUIRE(price(pricer, "2024-01-05 12:00,2024-01-06 15:00,1,auto", fee) == true);
+        REQUIRE(fee == expected);
+        REQUIRE(price(pricer, std::to_string(jst(1, 5, 12, 0)) + "," + std::to_string(jst(1, 6, 15, 0)) + ",1,auto",
+                      fee) == true);
+        REQUIRE(fee == expected);
+        REQUIRE(price(pricer, "2024-01-05T12:00:00, 2024-01-06 15:00:00 ,1,\r", fee) == true);
+        REQUIRE(fee == expected);
+        REQUIRE(price(pricer, "2024-01-05 12:00\t2024-01-06 15:00\t1\tauto", fee, '\t') == true);
+        REQUIRE(fee == expected);
+    }
+
+    SECTION("日種別を指定するとその料金で計算する") {
+        // 2024-01-06 は土曜日
+        REQUIRE(price(pricer, "2024-01-06 12:00,2024-01-06 15:00,1,auto", fee) == true);
+        REQUIRE(pricing.quoteTotal(jst(1, 6, 12, 0), jst(1, 6, 15, 0), expected) == true);
+        REQUIRE(fee == expected);
+
+        std::int64_t weekdayFee = 0;
+        std::int64_t holidayFee = 0;
+        REQUIRE(price(pricer, "2024-01-06 12:00,2024-01-06 15:00,1,weekday", weekdayFee) == true);
+        REQUIRE(price(pricer, "2024-01-05 12:00,2024-01-05 15:00,1,holiday", holidayFee) == true);
+        REQUIRE(weekdayFee == kDefaultDayTariffs.calculateFee(DayKind::Weekday, 180, 12, 0));
+        REQUIRE(holidayFee == kDefaultDayTariffs.calculateFee(DayKind::Holiday, 180, 12, 0));
+        REQUIRE(holidayFee == expected);
+    }
+
+    SECTION("解析・計算できない行") {
+        REQUIRE(price(pricer, "", fee) == false);
+        REQUIRE(price(pricer, "2024-01-05 12:00,2024-01-06 15:00,1", fee) == false);            // 項目が足りない
+        REQUIRE(price(pricer, "2024-01-05 12:00,2024-01-06 15:00,1,auto,x", fee) == false);     // 項目が多い
+        REQUIRE(price(pricer, "2024-01-05 12:00,2024-01-06 15:00,2,auto", fee) == false);       // 未登録の駐車場
+        REQUIRE(price(pricer, "2024-01-05 12:00,2024-01-06 15:00,1,sunday", fee) == false);     // 日種別
+        REQUIRE(price(pricer, "2024-02-30 12:00,2024-03-01 15:00,1,auto", fee) == false);       // 存在しない日付
+        REQUIRE(price(pricer, "2024-01-05 24:00,2024-01-06 15:00,1,auto", fee) == false);
+        REQUIRE(price(pricer, "2024-01-05 12:0,2024-01-06 15:00,1,auto", fee) == false);
+        REQUIRE(price(pricer, "2024-01-05 12:00,2024-01-05 11:00,1,auto", fee) == false);       // 出庫が入庫より前
+        REQUIRE(price(pricer, "12a,13,1,auto", fee) == false);
+        REQUIRE(price(pricer, "1234567890123456789,1234567890123456790,1,auto", fee) == false);  // 桁あふれ
+    }
+}
+
+TEST_CASE("一括料金計算: 行の境界で区切る", "[batch]") {
+    std::string text = "a\nbb\nccc\n\ndddd";
+    for (std::size_t chunkBytes = 1; chunkBytes <= text.size() + 1; ++chunkBytes) {
+        auto chunks = splitLines(text.data(), text.size(), chunkBytes);
+        REQUIRE(chunks.front().first == 0);
+        REQUIRE(chunks.back().second == text.size());
+        for (std::size_t i = 0; i < chunks.size(); ++i) {
+            REQUIRE(chunks[i].first < chunks[i].second);
+            if (i + 1 < chunks.size()) {
+                REQUIRE(chunks[i].second == chunks[i + 1].first);
+                REQUIRE(text[chunks[i].second - 1] == '\n');
+            }
+        }
+    }
+    REQUIRE(splitLines(text.data(), text.size(), 1).size() == 5);
+    REQUIRE(splitLines(text.data(), text.size(), 100).size() == 1);
+    REQUIRE(splitLines(text.data(), 0, 4).empty());
+}
+
+TEST_CASE("一括料金計算: 並列でも入力の順に出力する", "[batch]") {
+    StayPricingEngine pricing(kDefaultDayTariffs);
+    BatchPricer pricer;
+    REQUIRE(pricer.addLot(1, pricing) == true);
+    REQUIRE(pricer.addLot(2, pricing) == true);
+
+    // 滞在時間・駐車場・日種別を変えた行と、ときどき不正な行
+    const char* kinds[] = {"auto", "weekday", "holiday"};
+    std::string input = "entry,exit,lot,day\n";
+    std::string expected;
+    const std::size_t rowCount = 5000;
+    for (std::size_t i = 0; i < rowCount; ++i) {
+        std::int64_t entry = jst(1, 1, 0, 0) + static_cast<std::int64_t>(i) * 517;
+        std::int64_t exit = entry + static_cast<std::int64_t>(i * 7919 % 5000) * 60;
+        if (i % 97 == 0) {
+            input += "broken\n";
+            expected += "error\n";
+            continue;
+        }
+        std::string line = std::to_string(entry) + "," + std::to_string(exit) + "," + std::to_string(1 + i % 2) +
+                           "," + kinds[i % 3];
+        std::int64_t fee = 0;
+        REQUIRE(price(pricer, line, fee) == true);
+        input += line + (i % 5 == 0 ? "\r\n" : "\n");
+        expected += std::to_string(fee) + "\n";
+    }
+
+    BatchPricingOptions options;
+    options.threadCount = GENERATE(1, 2, 4, 8);
+    options.chunkBytes = GENERATE(1, 100, 4096, kBatchPricingDefaultChunkBytes);
+    BatchPricingStats stats;
+    REQUIRE(runAll(pricer, input, options, stats) == expected);
+    REQUIRE(stats.rows == rowCount);
+    REQUIRE(stats.errors == (rowCount + 96) / 97);
+    REQUIRE(stats.bytes == input.size());
+
+    SECTION("最後の行に改行がなくてもよい") {
+        input.pop_back();
+        REQUIRE(runAll(pricer, input, options, stats) == expected);
+    }
+
+    SECTION("書き出しに失敗したら中断する") {
+        std::size_t calls = 0;
+        bool succeeded = pricer.run(input.data(), input.size(), options,
+                                    [&calls](const char*, std::size_t) { return ++calls < 2; }, stats);
+        REQUIRE(succeeded == (stats.chunks < 2));
+        REQUIRE(calls == std::min<std::size_t>(stats.chunks, 2));
+    }
+}
+
+TEST_CASE("一括料金計算: ファイル", "[batch]") {
+    StayPricingEngine pricing(kDefaultDayTariffs);
+    BatchPricer pricer;
+    REQUIRE(pricer.addLot(1, pricing) == true);
+    std::string path = "/tmp/batch-pricing-test-" + std::to_string(::getpid()) + ".tsv";
+    std::string output;
+    auto sink = [&output](const char* data, std::size_t size) {
+        output.append(data, size);
+        return true;
+    };
+    BatchPricingStats stats;
+
+    SECTION("TSV を mmap して計算する") {
+        std::ofstream(path) << "entry\texit\tlot\tday\n"
+                            << "2024-01-05 12:00\t2024-01-06 15:00\t1\tauto\n"
+                            << "2024-01-05 12:00\t2024-01-05 12:00\t1\tweekday\n";
+        std::int64_t expected = 0;
+        REQUIRE(pricing.quoteTotal(jst(1, 5, 12, 0), jst(1, 6, 15, 0), expected) == true);
+        REQUIRE(pricer.runFile(path, BatchPricingOptions(), sink, stats) == true);
+        REQUIRE(output == std::to_string(expected) + "\n0\n");
+        REQUIRE(stats.rows == 2);
+        REQUIRE(stats.errors == 0);
+    }
+
+    SECTION("空のファイル") {
+        std::ofstream{path};
+        REQUIRE(pricer.runFile(path, BatchPricingOptions(), sink, stats) == true);
+        REQUIRE(output.empty());
+        REQUIRE(stats.rows == 0);
+    }
+
+    SECTION("開けないファイル") {
+        REQUIRE(pricer.runFile(path + ".missing", BatchPricingOptions(), sink, stats) == false);
+    }
+
+    std::remove(path.c_str());
+}
@@ -0,0 +1,124 @@
+// constexprの料金体系のテスト
+// 受け入れテスト（test_acceptance.cpp）と同じ内容をコンパイル時に検証する
+#include "catch.hpp"
+#include "../src/parking_lot.hpp"
+#include "../src/tariff.hpp"
+
+// 駐車場料金計算: 60分ごとに500円
+inline constexpr Tariff kBasicTariff = {{60, 500, 0, 0}, {60, 500, 0, 0}};
+static_assert(FixedTariff<kBasicTariff>::calculateFee(100) == 1000, "100分駐車した場合、料金は1000円");
+
+// 休日と平日で料金が異なる
+// 平日は60分500円（後方互換性）
+static_assert(WeekdayTariff::calculateFee(60) == 500, "");
+static_assert(WeekdayTariff::calculateFee(100) == 1000, "");
+// 平日の日中料金（08:00-18:00）
+static_assert(WeekdayTariff::calculateFee(60, 10, 0) == 500, "");
+static_assert(WeekdayTariff::calculateFee(100, 10, 0) == 1000, "");
+static_assert(WeekdayTariff::calculateFee(720, 8, 0) == 1500, "");
+// 平日の夜間料金（18:01-07:59）
+static_assert(WeekdayTariff::calculateFee(60, 20, 0) == 300, "");
+static_assert(WeekdayTariff::calculateFee(100, 20, 0) == 600, "");
+static_assert(WeekdayTariff::calculateFee(720, 20, 0) == 1000, "");
+static_assert(WeekdayTariff::calculateFee(60, 1, 0) == 300, "");
+// 休日は30分500円（後方互換性）
+static_assert(HolidayTariff::calculateFee(30) == 500, "");
+static_assert(HolidayTariff::calculateFee(60) == 1000, "");
+static_assert(HolidayTariff::calculateFee(100) == 2000, "");
+// 休日の日中料金（08:00-18:00）
+static_assert(HolidayTariff::calculateFee(30, 10, 0) == 500, "");
+static_assert(HolidayTariff::calculateFee(60, 10, 0) == 1000, "");
+static_assert(HolidayTariff::calculateFee(360, 8, 0) == 1500, "");
+// 休日の夜間料金（18:01-07:59）
+static_assert(HolidayTariff::calculateFee(60, 20, 0) == 300, "");
+static_assert(HolidayTariff::calculateFee(120, 20, 0) == 600, "");
+static_assert(HolidayTariff::calculateFee(360, 20, 0) == 1000, "");
+static_assert(HolidayTariff::calculateFee(60, 1, 0) == 300, "");
+
+// 最大料金の適用
+// 平日は12時間（720分）まで最大料金1500円
+static_assert(WeekdayTariff::calculateFee(720) == 1500, "");
+static_assert(WeekdayTariff::calculateFee(800) == 1500, "");
+static_assert(WeekdayTariff::calculateFee(719) == 1500, "");
+static_assert(WeekdayTariff::calculateFee(600) == 1500, "");
+// 休日は6時間（360分）まで最大料金1500円
+static_assert(HolidayTariff::calculateFee(360) == 1500, "");
+static_assert(HolidayTariff::calculateFee(400) == 1500, "");
+static_assert(HolidayTariff::calculateFee(359) == 1500, "");
+static_assert(HolidayTariff::calculateFee(300) == 1500, "");
+static_assert(HolidayTariff::calculateFee(100) == 2000, "");
+
+// 閾値の境界値テスト
+// 平日の閾値テスト（720分）
+static_assert(WeekdayTariff::calculateFee(719) == 1500, "");
+static_assert(WeekdayTariff::calculateFee(720) == 1500, "");
+static_assert(WeekdayTariff::calculateFee(721) == 1500, "");
+static_assert(WeekdayTariff::calculateFee(600) == 1500, "");
+static_assert(WeekdayTariff::calculateFee(100) == 1000, "");
+// 休日の閾値テスト（360分と300分）
+static_assert(HolidayTariff::calculateFee(299) == 5000, "");
+static_assert(HolidayTariff::calculateFee(300) == 1500, "");
+static_assert(HolidayTariff::calculateFee(301) == 1500, "");
+static_assert(HolidayTariff::calculateFee(359) == 1500, "");
+static_assert(HolidayTariff::calculateFee(360) == 1500, "");
+static_assert(HolidayTariff::calculateFee(361) == 1500, "");
+static_assert(HolidayTariff::calculateFee(100) == 2000, "");
+static_assert(HolidayTariff::calculateFee(150) == 2500, "");
+
+// 平日の日中・夜間の閾値テスト
+// 日中の開始時刻の閾値（08:00）
+static_assert(WeekdayTariff::calculateFee(60, 7, 59) == 300, "");
+static_assert(WeekdayTariff::calculateFee(60, 8, 0) == 500, "");
+static_assert(WeekdayTariff::calculateFee(60, 8, 1) == 500, "");
+// 日中の終了時刻の閾値（18:00）
+static_assert(WeekdayTariff::calculateFee(60, 17, 59) == 500, "");
+static_assert(WeekdayTariff::calculateFee(60, 18, 0) == 500, "");
+static_assert(WeekdayTariff::calculateFee(60, 18, 1) == 300, "");
+// 夜間の境界（深夜から朝まで）
+static_assert(WeekdayTariff::calculateFee(60, 0, 0) == 300, "");
+static_assert(WeekdayTariff::calculateFee(60, 1, 0) == 300, "");
+static_assert(WeekdayTariff::calculateFee(60, 7, 59) == 300, "");
+static_assert(WeekdayTariff::calculateFee(60, 23, 59) == 300, "");
+// 日中料金の最大料金閾値（300分、720分）
+static_assert(WeekdayTariff::calculateFee(299, 10, 0) == 2500, "");
+static_assert(WeekdayTariff::calculateFee(300, 10, 0) == 1500, "");
+static_assert(WeekdayTariff::calculateFee(301, 10, 0) == 1500, "");
+static_assert(WeekdayTariff::calculateFee(719, 10, 0) == 1500, "");
+static_assert(WeekdayTariff::calculateFee(720, 10, 0) == 1500, "");
+static_assert(WeekdayTariff::calculateFee(721, 10, 0) == 1500, "");
+// 夜間料金の最大料金閾値（300分、720分）
+static_assert(WeekdayTariff::calculateFee(299, 20, 0) == 1500, "");
+static_assert(WeekdayTariff::calculateFee(300, 20, 0) == 1000, "");
+static_assert(WeekdayTariff::calculateFee(301, 20, 0) == 1000, "");
+static_assert(WeekdayTariff::calculateFee(719, 20, 0) == 1000, "");
+static_assert(WeekdayTariff::calculateFee(720, 20, 0) == 1000, "");
+static_assert(WeekdayTariff::calculateFee(721, 20, 0) == 1000, "");
+// 時間帯が変わる境界（開始時刻のみで判定）
+static_assert(WeekdayTariff::calculateFee(120, 17, 0) == 1000, "");
+static_assert(WeekdayTariff::calculateFee(120, 18, 0) == 1000, "");
+static_assert(WeekdayTariff::calculateFee(120, 18, 1) == 600, "");
+
+// 平日と休日が混在する場合の料金計算（金曜日12時から土曜日15時まで）
+static_assert(calculateMixedFee(720, 900, kWeekdayTariff, kHolidayTariff) == 3000, "");
+
+TEST_CASE("constexprの料金体系はParkingLotと一致する", "[constexpr]") {
+    SECTION("既定の料金体系はParkingLotの既定値と同じ") {
+        WeekdayParkingLot weekdayLot;
+        HolidayParkingLot holidayLot;
+
+        for (int minutes = 0; minutes <= 3000; ++minutes) {
+            if (WeekdayTariff::calculateFee(minutes, 10, 0) != weekdayLot.calculateFee(minutes, 10, 0) ||
+                WeekdayTariff::calculateFee(minutes, 20, 0) != weekdayLot.calculateFee(minutes, 20, 0) ||
+                HolidayTariff::calculateFee(minutes, 10, 0) != holidayLot.calculateFee(minutes, 10, 0) ||
+                HolidayTariff::calculateFee(minutes, 20, 0) != holidayLot.calculateFee(minutes, 20, 0)) {
+                FAIL("minutes=" << minutes);
+            }
+        }
+    }
+
+    SECTION("料金をコンパイル時定数として使える") {
+        constexpr int fee = HolidayTariff::calculateFee(30, 10, 0);
+        int table[fee / 100] = {};
+        REQUIRE(sizeof(table) / sizeof(table[0]) == 5);
+    }
+}
@@ -0,0 +1,138 @@
+// 祝日カレンダーのテスト
+#include "catch.hpp"
+#include "../src/holiday_calendar.hpp"
+#include <atomic>
+#include <cstdio>
+#include <fstream>
+#include <thread>
+
+TEST_CASE("祝日カレンダー", "[holiday]") {
+    const std::int64_t newYear = daysFromCivil(2024, 1, 1);        // 月曜日（元日）
+    const std::int64_t comingOfAge = daysFromCivil(2024, 1, 8);    // 月曜日（成人の日）
+    const std::int64_t tuesday = daysFromCivil(2024, 1, 9);
+    const std::int64_t saturday = daysFromCivil(2024, 1, 6);
+
+    SECTION("土日と登録された祝日を休日として分類する") {
+        HolidayCalendar calendar;
+        REQUIRE(calendar.classify(newYear) == DayKind::Weekday);
+        REQUIRE(calendar.classify(saturday) == DayKind::Holiday);
+
+        calendar.replace({newYear, comingOfAge});
+        REQUIRE(calendar.holidayCount() == 2);
+        REQUIRE(calendar.classify(newYear) == DayKind::Holiday);
+        REQUIRE(calendar.classify(comingOfAge) == DayKind::Holiday);
+        REQUIRE(calendar.classify(tuesday) == DayKind::Weekday);
+        // 範囲外の日付
+        REQUIRE(calendar.classify(daysFromCivil(1999, 12, 31)) == DayKind::Weekday);
+        REQUIRE(calendar.classify(daysFromCivil(2099, 1, 1)) == DayKind::Weekday);
+    }
+
+    SECTION("土日を休日にしない設定") {
+        HolidayCalendar calendar(false);
+        REQUIRE(calendar.classify(saturday) == DayKind::Weekday);
+    }
+
+    SECTION("ファイルから読み込む") {
+        const char* path = "/tmp/test_holidays.txt";
+        {
+            std::ofstream file(path);
+            file << "# 2024年の祝日\n"
+                 << "2024-01-01 元日\n"
+                 << "\n"
+                 << "2024-01-08,成人の日\n";
+        }
+        HolidayCalendar calendar;
+        REQUIRE(calendar.loadFromFile(path) == true);
+        REQUIRE(calendar.holidayCount() == 2);
+        REQUIRE(calendar.isRegisteredHoliday(comingOfAge) == true);
+
+        // 不正な行があれば現在の内容を維持する
+        {
+            std::ofstream file(path);
+            file << "2024-02-30\n";
+        }
+        REQUIRE(calendar.loadFromFile(path) == false);
+        REQUIRE(calendar.holidayCount() == 2);
+        REQUIRE(calendar.loadFromFile("/tmp/nonexistent_holidays.txt") == false);
+        std::remove(path);
+    }
+
+    SECTION("日付の後ろに余計な文字が続けば不正とする") {
+        std::int64_t day = 0;
+        REQUIRE(parseIsoDate("2024-01-01", 10, day) == true);
+        REQUIRE(day == newYear);
+        REQUIRE(parseIsoDate("2024-01-01x", 11, day) == false);
+        REQUIRE(parseIsoDate("2024-01-0", 9, day) == false);
+
+        const char* path = "/tmp/test_holidays_trailing.txt";
+        {
+            std::ofstream file(path);
+            file << "2024-01-01x\n";
+        }
+        HolidayCalendar calendar;
+        REQUIRE(calendar.loadFromFile(path) == false);
+        REQUIRE(calendar.holidayCount() == 0);
+        std::remove(path);
+    }
+
+    SECTION("DBから全国共通の祝日と拠点の休業日を読み込む") {
+        const char* testDb = "/tmp/test_holidays.db";
+        std::remove(testDb);
+        REQUIRE(saveHolidayToDatabase(testDb, newYear, "", "元日") == true);
+        REQUIRE(saveHolidayToDatabase(testDb, tuesday, "site-a", "設備点検") == true);
+        REQUIRE(saveHolidayToDatabase(testDb, comingOfAge, "site-b", "設備点検") == true);
+
+        HolidayCalendar calendar;
+        REQUIRE(calendar.loadFromDatabase(testDb, "site-a") == true);
+        REQUIRE(calendar.holidayCount() == 2);
+        REQUIRE(calendar.classify(newYear) == DayKind::Holiday);
+        REQUIRE(calendar.classify(tuesday) == DayKind::Holiday);
+        REQUIRE(calendar.classify(comingOfAge) == DayKind::Weekday);
+
+        REQUIRE(calendar.loadFromDatabase("/tmp/nonexistent_holidays.db") == false);
+        std::remove(testDb);
+    }
+
+    SECTION("料金計算で祝日を休日料金にする") {
+        HolidayCalendar calendar;
+        calendar.replace({newYear});
+        StayPricingEngine engine(kDefaultDayTariffs, calendar);
+
+        StayQuote quote;
+        // 元日（月曜日）10:00-11:00 → 休日料金（30分500円）
+        REQUIRE(engine.quote(epochFromLocal(2024, 1, 1, 10, 0), epochFromLocal(2024, 1, 1, 11, 0), quote));
+        REQUIRE(quote.totalFee == 1000);
+    }
+
+    SECTION("料金計算中に読み込み直しても読み取り側は止まらない") {
+        HolidayCalendar calendar;
+        std::atomic<bool> stop(false);
+        std::atomic<long> reads(0);
+        std::atomic<long> holidays(0);
+
+        std::thread reader([&]() {
+            while (!stop.load()) {
+                if (calendar.classify(newYear) == DayKind::Holiday) {
+                    ++holidays;
+                }
+                ++reads;
+            }
+        });
+
+        // 読み取りが始まってから書き換える
+        while (reads.load() == 0) {
+            std::this_thread::yield();
+        }
+        for (int i = 0; i < 200; ++i) {
+            calendar.replace(i % 2 == 0 ? std::vector<std::int64_t>{newYear, comingOfAge}
+                                        : std::vector<std::int64_t>{});
+            std::this_thread::yield();
+        }
+        stop.store(true);
+        reader.join();
+
+        REQUIRE(reads.load() > 0);
+        REQUIRE(holidays.load() <= reads.load());
+        REQUIRE(calendar.holidayCount() == 0);
+    }
+}
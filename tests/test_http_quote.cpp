@@ -0,0 +1,302 @@
+// 料金見積もりの HTTP/1.1 + JSON 版のテスト
+#include "catch.hpp"
+#include "../src/http_quote.hpp"
+#include "../src/quote_server.hpp"
+#include <sys/socket.h>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+
+std::int64_t jst(int month, int day, int hour, int minute) {
+    return epochFromLocal(2024, month, day, hour, minute);
+}
+
+std::string post(const std::string& path, const std::string& body, const std::string& headers = "") {
+    return "POST " + path + " HTTP/1.1\r\nHost: localhost\r\nContent-Type: application/json\r\nContent-Length: " +
+           std::to_string(body.size()) + "\r\n" + headers + "\r\n" + body;
+}
+
+HttpParseResult parse(const std::string& text, HttpQuoteRequest& request, std::size_t& consumed) {
+    return parseHttpQuoteRequest(text.data(), text.size(), request, consumed);
+}
+
+std::string writeQuote(const QuoteResponse& response, bool keepAlive) {
+    char out[kHttpQuoteMaxResponseBytes];
+    std::size_t size = writeHttpQuoteResponse(response, keepAlive, out);
+    REQUIRE(size <= sizeof(out));
+    return std::string(out, size);
+}
+
+// count 件の応答を受け取る（途中で閉じられたら受け取れた分だけ返す）
+std::vector<HttpQuoteResponse> receiveResponses(QuoteClient& client, std::size_t count, bool& closed) {
+    std::vector<HttpQuoteResponse> responses;
+    std::vector<char> buffer;
+    std::size_t offset = 0;
+    closed = false;
+    char chunk[16384];
+    while (responses.size() < count) {
+        HttpQuoteResponse response;
+        std::size_t consumed = 0;
+        HttpParseResult result = parseHttpQuoteResponse(buffer.data() + offset, buffer.size() - offset, response,
+                                                        consumed);
+        if (result == HttpParseResult::Complete) {
+            responses.push_back(response);
+            offset += consumed;
+            continue;
+        }
+        REQUIRE(result == HttpParseResult::Incomplete);
+        ssize_t received = ::recv(client.fd(), chunk, sizeof(chunk), 0);
+        if (received <= 0) {
+            closed = true;
+            break;
+        }
+        buffer.insert(buffer.end(), chunk, chunk + received);
+    }
+    return responses;
+}
+
+bool peerClosed(QuoteClient& client) {
+    char byte;
+    return ::recv(client.fd(), &byte, 1, 0) == 0;
+}
+
+} // namespace
+
+TEST_CASE("HTTP見積もり: 要求の解析", "[server][http]") {
+    HttpQuoteRequest request;
+    std::size_t consumed = 0;
+
+    SECTION("見積もり・入庫・出庫") {
+        std::string text = post("/quote", "{\"lotId\":3,\"entryTime\":1704420000,\"exitTime\":1704510000}");
+        REQUIRE(parse(text, request, consumed) == HttpParseResult::Complete);
+        REQUIRE(consumed == text.size());
+        REQUIRE(request.errorStatus == 0);
+        REQUIRE(request.keepAlive == true);
+        REQUIRE(request.quote.opcode == QuoteOpcode::Quote);
+        REQUIRE(request.quote.lotId == 3);
+        REQUIRE(request.quote.startTime == 1704420000);
+        REQUIRE(request.quote.endTime == 1704510000);
+
+        // 項目の順と空白は問わない
+        text = post("/entry", "{ \"entryTime\" : -60 , \"ticketId\":18446744073709551615, \"lotId\":1 }");
+        REQUIRE(parse(text, request, consumed) == HttpParseResult::Complete);
+        REQUIRE(request.errorStatus == 0);
+        REQUIRE(request.quote.opcode == QuoteOpcode::Entry);
+        REQUIRE(request.quote.ticketId == 18446744073709551615ULL);
+        REQUIRE(request.quote.startTime == -60);
+
+        text = post("/exit", "{\"ticketId\":1001,\"exitTime\":1704510000}", "Connection: close\r\n");
+        REQUIRE(parse(text, request, consumed) == HttpParseResult::Complete);
+        REQUIRE(request.errorStatus == 0);
+        REQUIRE(request.keepAlive == false);
+        REQUIRE(request.quote.opcode == QuoteOpcode::Exit);
+        REQUIRE(request.quote.ticketId == 1001);
+        REQUIRE(request.quote.endTime == 1704510000);
+    }
+
+    SECTION("途中までの要求は続きを待つ") {
+        std::string text = post("/quote", "{\"lotId\":1,\"entryTime\":0,\"exitTime\":60}");
+        for (std::size_t size = 0; size < text.size(); ++size) {
+            REQUIRE(parseHttpQuoteRequest(text.data(), size, request, consumed) == HttpParseResult::Incomplete);
+        }
+    }
+
+    SECTION("続けて送られた要求は1つずつ解析する") {
+        std::string first = post("/quote", "{\"lotId\":1,\"entryTime\":0,\"exitTime\":60}");
+        std::string text = first + post("/exit", "{\"ticketId\":7,\"exitTime\":60}");
+        REQUIRE(parse(text, request, consumed) == HttpParseResult::Complete);
+        REQUIRE(consumed == first.size());
+        REQUIRE(parseHttpQuoteRequest(text.data() + consumed, text.size() - consumed, request, consumed) ==
+                HttpParseResult::Complete);
+        REQUIRE(request.quote.opcode == QuoteOpcode::Exit);
+    }
+
+    SECTION("HTTP/1.0 は既定で閉じる") {
+        std::string text = "POST /quote HTTP/1.0\r\nContent-Length: 2\r\n\r\n{}";
+        REQUIRE(parse(text, request, consumed) == HttpParseResult::Complete);
+        REQUIRE(request.keepAlive == false);
+    }
+
+    SECTION("パス・メソッド・本文の誤りはその要求だけエラー") {
+        REQUIRE(parse(post("/tariffs", "{}"), request, consumed) == HttpParseResult::Complete);
+        REQUIRE(request.errorStatus == 404);
+        REQUIRE(parse("GET /quote HTTP/1.1\r\n\r\n", request, consumed) == HttpParseResult::Complete);
+        REQUIRE(request.errorStatus == 405);
+        REQUIRE(parse(post("/quote", "{\"lotId\":1,\"entryTime\":0}"), request, consumed) ==
+                HttpParseResult::Complete);
+        REQUIRE(request.errorStatus == 400);  // 項目が足りない
+        REQUIRE(parse(post("/quote", "{\"lotId\":1,\"entryTime\":0,\"exitTime\":60,\"x\":1}"), request, consumed) ==
+                HttpParseResult::Complete);
+        REQUIRE(request.errorStatus == 400);  // 知らない項目
+        REQUIRE(parse(post("/quote", "{\"lotId\":1,\"entryTime\":0,\"exitTime\":6.5}"), request, consumed) ==
+                HttpParseResult::Complete);
+        REQUIRE(request.errorStatus == 400);  // 小数
+        REQUIRE(parse(post("/quote", "{\"lotId\":1,\"lotId\":2,\"entryTime\":0,\"exitTime\":60}"), request,
+                      consumed) == HttpParseResult::Complete);
+        REQUIRE(request.errorStatus == 400);  // 重複
+        REQUIRE(parse(post("/quote", "{\"lotId\":4294967296,\"entryTime\":0,\"exitTime\":60}"), request,
+                      consumed) == HttpParseResult::Complete);
+        REQUIRE(request.errorStatus == 400);  // 範囲外
+    }
+
+    SECTION("区切りが分からない要求は不正") {
+        REQUIRE(parse("POST /quote HTTP/1.1\r\nTransfer-Encoding: chunked\r\n\r\n", request, consumed) ==
+                HttpParseResult::Invalid);
+        REQUIRE(request.errorStatus == 501);
+        REQUIRE(parse("POST /quote HTTP/1.1\r\nContent-Length: 2\r\nContent-Length: 3\r\n\r\n{}", request,
+                      consumed) == HttpParseResult::Invalid);
+        REQUIRE(request.errorStatus == 400);
+        REQUIRE(parse("POST /quote HTTP/1.1\r\nContent-Length: 5000\r\n\r\n", request, consumed) ==
+                HttpParseResult::Invalid);
+        REQUIRE(request.errorStatus == 413);
+        REQUIRE(parse(std::string(kHttpQuoteMaxRequestBytes, 'a'), request, consumed) == HttpParseResult::Invalid);
+        REQUIRE(request.errorStatus == 431);
+        REQUIRE(parse("hello\r\n\r\n", request, consumed) == HttpParseResult::Invalid);
+    }
+}
+
+TEST_CASE("HTTP見積もり: 応答の書き出し", "[server][http]") {
+    HttpQuoteResponse parsed;
+    std::size_t consumed = 0;
+
+    std::string text = writeQuote(QuoteResponse{QuoteOpcode::Exit, QuoteStatus::Ok, 0, 5000}, true);
+    REQUIRE(text == "HTTP/1.1 200 OK\r\nContent-Type: application/json\r\nContent-Length: 26\r\n\r\n"
+                    "{\"status\":\"ok\",\"fee\":5000}");
+    REQUIRE(parseHttpQuoteResponse(text.data(), text.size(), parsed, consumed) == HttpParseResult::Complete);
+    REQUIRE(consumed == text.size());
+    REQUIRE(parsed.status == 200);
+    REQUIRE(parsed.hasFee == true);
+    REQUIRE(parsed.fee == 5000);
+
+    text = writeQuote(QuoteResponse{QuoteOpcode::Entry, QuoteStatus::Rejected, 0, 0}, false);
+    REQUIRE(parseHttpQuoteResponse(text.data(), text.size(), parsed, consumed) == HttpParseResult::Complete);
+    REQUIRE(parsed.status == 409);
+    REQUIRE(parsed.quoteStatus == QuoteStatus::Rejected);
+    REQUIRE(parsed.hasFee == false);
+    REQUIRE(parsed.keepAlive == false);
+
+    text = writeQuote(QuoteResponse{QuoteOpcode::Quote, QuoteStatus::Ok, 0, -9223372036854775807LL - 1}, true);
+    REQUIRE(parseHttpQuoteResponse(text.data(), text.size(), parsed, consumed) == HttpParseResult::Complete);
+    REQUIRE(parsed.fee == -9223372036854775807LL - 1);
+
+    char out[kHttpQuoteMaxResponseBytes];
+    for (int status : {400, 404, 405, 413, 431, 501}) {
+        std::size_t size = writeHttpErrorResponse(status, false, out);
+        REQUIRE(size <= sizeof(out));
+        REQUIRE(parseHttpQuoteResponse(out, size, parsed, consumed) == HttpParseResult::Complete);
+        REQUIRE(parsed.status == status);
+        REQUIRE(parsed.keepAlive == false);
+    }
+}
+
+TEST_CASE("HTTP見積もり: サーバー", "[server][http]") {
+    StayPricingEngine pricing(kDefaultDayTariffs);
+    QuoteService service(16, 1024);
+    REQUIRE(service.addLot(1, pricing) == true);
+
+    QuoteServerOptions options;
+    options.reactorCount = 2;
+    options.protocol = QuoteServerProtocol::Http;
+    options.backend = GENERATE(QuoteServerBackend::Epoll, QuoteServerBackend::IoUring);
+    QuoteServer server(service);
+    REQUIRE(server.start(options) == true);
+
+    QuoteClient client;
+    REQUIRE(client.connectTcp("127.0.0.1", server.tcpPort()) == true);
+    bool closed = false;
+
+    SECTION("入庫して出庫すると料金が返る") {
+        std::string entry = post("/entry", "{\"lotId\":1,\"ticketId\":1001,\"entryTime\":" +
+                                               std::to_string(jst(1, 5, 12, 0)) + "}");
+        REQUIRE(client.sendBytes(entry.data(), entry.size()) == true);
+        std::vector<HttpQuoteResponse> responses = receiveResponses(client, 1, closed);
+        REQUIRE(responses.size() == 1);
+        REQUIRE(responses[0].status == 200);
+
+        std::string exit = post("/exit", "{\"ticketId\":1001,\"exitTime\":" + std::to_string(jst(1, 6, 15, 0)) + "}");
+        REQUIRE(client.sendBytes(exit.data(), exit.size()) == true);
+        responses = receiveResponses(client, 1, closed);
+        REQUIRE(responses.size() == 1);
+        REQUIRE(responses[0].status == 200);
+        REQUIRE(responses[0].fee == 5000);
+
+        REQUIRE(client.sendBytes(exit.data(), exit.size()) == true);
+        responses = receiveResponses(client, 1, closed);
+        REQUIRE(responses.size() == 1);
+        REQUIRE(responses[0].status == 404);
+        REQUIRE(responses[0].quoteStatus == QuoteStatus::NotFound);
+    }
+
+    SECTION("パイプラインの応答は要求の順に返る") {
+        // 送信バッファに収まらない量の応答も、送り終えてから残りを処理する
+        const std::size_t count = 3000;
+        std::string requests;
+        std::vector<std::int64_t> expected;
+        for (std::size_t i = 0; i < count; ++i) {
+            std::int64_t entry = jst(1, 5, 0, 0) + static_cast<std::int64_t>(i) * 60;
+            std::int64_t exit = entry + static_cast<std::int64_t>(i % 2000) * 60;
+            requests += post("/quote", "{\"lotId\":1,\"entryTime\":" + std::to_string(entry) +
+                                           ",\"exitTime\":" + std::to_string(exit) + "}");
+            expected.emplace_back();
+            REQUIRE(pricing.quoteTotal(entry, exit, expected.back()) == true);
+        }
+        std::thread sender([&] { client.sendBytes(requests.data(), requests.size()); });
+        std::vector<HttpQuoteResponse> responses = receiveResponses(client, count, closed);
+        sender.join();
+        REQUIRE(responses.size() == count);
+        for (std::size_t i = 0; i < count; ++i) {
+            REQUIRE(responses[i].status == 200);
+            REQUIRE(responses[i].fee == expected[i]);
+        }
+        REQUIRE(server.requestCount() == count);
+    }
+
+    SECTION("要求ごとのエラーでは接続を閉じない") {
+        std::string requests = post("/tariffs", "{}") + "GET /quote HTTP/1.1\r\n\r\n" +
+                               post("/quote", "{\"lotId\":2,\"entryTime\":0,\"exitTime\":60}") +
+                               post("/quote", "{\"lotId\":1}") +
+                               post("/quote", "{\"lotId\":1,\"entryTime\":0,\"exitTime\":60}");
+        REQUIRE(client.sendBytes(requests.data(), requests.size()) == true);
+        std::vector<HttpQuoteResponse> responses = receiveResponses(client, 5, closed);
+        REQUIRE(responses.size() == 5);
+        REQUIRE(responses[0].status == 404);
+        REQUIRE(responses[1].status == 405);
+        REQUIRE(responses[2].status == 404);  // 未登録の駐車場
+        REQUIRE(responses[3].status == 400);
+        REQUIRE(responses[4].status == 200);
+    }
+
+    SECTION("Connection: close の要求に応答したら閉じる") {
+        std::string requests = post("/quote", "{\"lotId\":1,\"entryTime\":0,\"exitTime\":60}", "Connection: close\r\n") +
+                               post("/quote", "{\"lotId\":1,\"entryTime\":0,\"exitTime\":60}");
+        REQUIRE(client.sendBytes(requests.data(), requests.size()) == true);
+        std::vector<HttpQuoteResponse> responses = receiveResponses(client, 2, closed);
+        REQUIRE(responses.size() == 1);
+        REQUIRE(responses[0].status == 200);
+        REQUIRE(responses[0].keepAlive == false);
+        REQUIRE(closed == true);
+    }
+
+    SECTION("区切りが分からない要求には応答して閉じる") {
+        std::string requests = "POST /quote HTTP/1.1\r\nContent-Length: 100000\r\n\r\n";
+        REQUIRE(client.sendBytes(requests.data(), requests.size()) == true);
+        std::vector<HttpQuoteResponse> responses = receiveResponses(client, 1, closed);
+        REQUIRE(responses.size() == 1);
+        REQUIRE(responses[0].status == 413);
+        REQUIRE(peerClosed(client) == true);
+
+        // 他の接続には影響しない
+        QuoteClient other;
+        REQUIRE(other.connectTcp("127.0.0.1", server.tcpPort()) == true);
+        std::string quote = post("/quote", "{\"lotId\":1,\"entryTime\":0,\"exitTime\":60}");
+        REQUIRE(other.sendBytes(quote.data(), quote.size()) == true);
+        responses = receiveResponses(other, 1, closed);
+        REQUIRE(responses.size() == 1);
+        REQUIRE(responses[0].status == 200);
+    }
+
+    server.stop();
+}
@@ -3,4 +3,4 @@
 #include "catch.hpp"
 
 // このファイルは単にCatch2のmain関数を提供するだけ
-// 実際のテストケースは test_acceptance.cpp と test_unit.cpp に定義されている
+// 実際のテストケースは test_acceptance.cpp、test_unit.cpp などの各ファイルに定義されている
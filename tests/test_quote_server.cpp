@@ -0,0 +1,333 @@
+// 料金見積もりサーバーのテスト
+#include "catch.hpp"
+#include "../src/quote_server.hpp"
+#include "../src/io_uring_queue.hpp"
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/resource.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <algorithm>
+#include <chrono>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+
+std::int64_t jst(int month, int day, int hour, int minute) {
+    return epochFromLocal(2024, month, day, hour, minute);
+}
+
+QuoteRequest request(QuoteOpcode opcode, std::uint32_t requestId, std::uint32_t lotId, std::uint64_t ticketId,
+                     std::int64_t startTime, std::int64_t endTime) {
+    return QuoteRequest{opcode, requestId, lotId, ticketId, startTime, endTime};
+}
+
+std::string unixSocketPath(const char* name) {
+    return "/tmp/" + std::string(name) + "-" + std::to_string(::getpid()) + ".sock";
+}
+
+} // namespace
+
+TEST_CASE("料金見積もり: フレームの符号化", "[server]") {
+    SECTION("要求と応答を往復できる") {
+        QuoteRequest sent = request(QuoteOpcode::Exit, 7, 3, 0x1122334455667788ULL, -5, jst(1, 5, 12, 0));
+        char frame[kQuoteRequestFrameSize];
+        encodeQuoteRequest(sent, frame);
+
+        QuoteRequest decoded;
+        REQUIRE(decodeQuoteRequest(frame, sizeof(frame), decoded) == QuoteFrameResult::Complete);
+        REQUIRE(decoded.opcode == QuoteOpcode::Exit);
+        REQUIRE(decoded.requestId == 7);
+        REQUIRE(decoded.lotId == 3);
+        REQUIRE(decoded.ticketId == 0x1122334455667788ULL);
+        REQUIRE(decoded.startTime == -5);
+        REQUIRE(decoded.endTime == jst(1, 5, 12, 0));
+
+        QuoteResponse response{QuoteOpcode::Quote, QuoteStatus::Rejected, 9, 1234};
+        char responseFrame[kQuoteResponseFrameSize];
+        encodeQuoteResponse(response, responseFrame);
+        QuoteResponse decodedResponse;
+        REQUIRE(decodeQuoteResponse(responseFrame, sizeof(responseFrame), decodedResponse) ==
+                QuoteFrameResult::Complete);
+        REQUIRE(decodedResponse.opcode == QuoteOpcode::Quote);
+        REQUIRE(decodedResponse.status == QuoteStatus::Rejected);
+        REQUIRE(decodedResponse.requestId == 9);
+        REQUIRE(decodedResponse.fee == 1234);
+    }
+
+    SECTION("途中までのフレームは続きを待つ") {
+        char frame[kQuoteRequestFrameSize];
+        encodeQuoteRequest(request(QuoteOpcode::Quote, 1, 1, 0, 0, 60), frame);
+        QuoteRequest decoded;
+        for (std::size_t size = 0; size < sizeof(frame); ++size) {
+            REQUIRE(decodeQuoteRequest(frame, size, decoded) == QuoteFrameResult::Incomplete);
+        }
+    }
+
+    SECTION("長さの欄が合わないフレームは不正") {
+        char frame[kQuoteRequestFrameSize];
+        encodeQuoteRequest(request(QuoteOpcode::Quote, 1, 1, 0, 0, 60), frame);
+        frame[0] = 100;
+        QuoteRequest decoded;
+        REQUIRE(decodeQuoteRequest(frame, 4, decoded) == QuoteFrameResult::Invalid);
+    }
+}
+
+TEST_CASE("料金見積もり: 要求の処理", "[server]") {
+    StayPricingEngine pricing(kDefaultDayTariffs);
+    QuoteService service(4, 16);
+    REQUIRE(service.addLot(1, pricing) == true);
+    QuoteResponse response;
+
+    SECTION("見積もりは StayPricingEngine と同じ料金") {
+        std::int64_t expected = 0;
+        REQUIRE(pricing.quoteTotal(jst(1, 5, 12, 0), jst(1, 6, 15, 0), expected) == true);
+        service.handle(request(QuoteOpcode::Quote, 1, 1, 0, jst(1, 5, 12, 0), jst(1, 6, 15, 0)), response);
+        REQUIRE(response.status == QuoteStatus::Ok);
+        REQUIRE(response.requestId == 1);
+        REQUIRE(response.fee == expected);
+    }
+
+    SECTION("入庫して出庫すると料金が返る") {
+        service.handle(request(QuoteOpcode::Entry, 1, 1, 1001, jst(1, 5, 12, 0), 0), response);
+        REQUIRE(response.status == QuoteStatus::Ok);
+        service.handle(request(QuoteOpcode::Entry, 2, 1, 1001, jst(1, 5, 13, 0), 0), response);
+        REQUIRE(response.status == QuoteStatus::Rejected);
+
+        service.handle(request(QuoteOpcode::Exit, 3, 0, 1001, 0, jst(1, 5, 11, 0)), response);
+        REQUIRE(response.status == QuoteStatus::Rejected);  // 入庫より前の出庫はセッションを残す
+        service.handle(request(QuoteOpcode::Exit, 4, 0, 1001, 0, jst(1, 6, 15, 0)), response);
+        REQUIRE(response.status == QuoteStatus::Ok);
+        REQUIRE(response.fee == 5000);
+        service.handle(request(QuoteOpcode::Exit, 5, 0, 1001, 0, jst(1, 6, 15, 0)), response);
+        REQUIRE(response.status == QuoteStatus::NotFound);
+    }
+
+    SECTION("未登録の駐車場・不明な要求") {
+        service.handle(request(QuoteOpcode::Quote, 1, 2, 0, 0, 60), response);
+        REQUIRE(response.status == QuoteStatus::NotFound);
+        service.handle(request(QuoteOpcode::Entry, 2, 2, 1, 0, 0), response);
+        REQUIRE(response.status == QuoteStatus::NotFound);
+        service.handle(request(static_cast<QuoteOpcode>(99), 3, 1, 0, 0, 60), response);
+        REQUIRE(response.status == QuoteStatus::BadRequest);
+        REQUIRE(response.requestId == 3);
+    }
+}
+
+TEST_CASE("料金見積もり: サーバー", "[server]") {
+    StayPricingEngine pricing(kDefaultDayTariffs);
+    QuoteService service(16, 1024);
+    REQUIRE(service.addLot(1, pricing) == true);
+
+    QuoteServerOptions options;
+    options.reactorCount = 2;
+    options.unixPath = unixSocketPath("quote-server-test");
+    options.backend = GENERATE(QuoteServerBackend::Epoll, QuoteServerBackend::IoUring);
+    QuoteServer server(service);
+    REQUIRE(server.start(options) == true);
+    REQUIRE(server.tcpPort() > 0);
+    REQUIRE(server.reactorCount() == 2);
+
+    // io_uring が使えない環境では epoll で動く
+    IoUringQueue probe;
+    bool ioUringAvailable = probe.open(8);
+    probe.close();
+    if (options.backend == QuoteServerBackend::IoUring && ioUringAvailable) {
+        REQUIRE(server.backend() == QuoteServerBackend::IoUring);
+    } else {
+        REQUIRE(server.backend() == QuoteServerBackend::Epoll);
+    }
+
+    SECTION("TCPとUnixドメインソケットで入庫・出庫") {
+        QuoteClient tcp;
+        QuoteClient local;
+        REQUIRE(tcp.connectTcp("127.0.0.1", server.tcpPort()) == true);
+        REQUIRE(local.connectUnix(options.unixPath) == true);
+
+        QuoteResponse response;
+        REQUIRE(tcp.call(request(QuoteOpcode::Entry, 1, 1, 1001, jst(1, 5, 12, 0), 0), response) == true);
+        REQUIRE(response.status == QuoteStatus::Ok);
+        REQUIRE(response.requestId == 1);
+        // 別の接続から出庫しても同じセッション
+        REQUIRE(local.call(request(QuoteOpcode::Exit, 2, 0, 1001, 0, jst(1, 6, 15, 0)), response) == true);
+        REQUIRE(response.status == QuoteStatus::Ok);
+        REQUIRE(response.opcode == QuoteOpcode::Exit);
+        REQUIRE(response.fee == 5000);
+        REQUIRE(server.requestCount() == 2);
+        REQUIRE(server.connectionCount() == 2);
+        REQUIRE(server.syscallCount() > 0);
+    }
+
+    SECTION("パイプラインの応答は要求の順に返る") {
+        QuoteClient client;
+        REQUIRE(client.connectTcp("127.0.0.1", server.tcpPort()) == true);
+        const std::size_t count = 5000;
+        std::vector<QuoteRequest> requests;
+        std::vector<std::int64_t> expected;
+        for (std::size_t i = 0; i < count; ++i) {
+            std::int64_t entry = jst(1, 5, 0, 0) + static_cast<std::int64_t>(i) * 60;
+            std::int64_t exit = entry + static_cast<std::int64_t>(i % 2000) * 60;
+            requests.push_back(request(QuoteOpcode::Quote, static_cast<std::uint32_t>(i), 1, 0, entry, exit));
+            expected.emplace_back();
+            REQUIRE(pricing.quoteTotal(entry, exit, expected.back()) == true);
+        }
+        // 受信しながら送らないと詰まる量なので、送信は別スレッドで行う
+        std::thread sender([&] { client.send(requests.data(), requests.size()); });
+        std::vector<QuoteResponse> responses(count);
+        bool received = client.receive(responses.data(), responses.size());
+        sender.join();
+        REQUIRE(received == true);
+        for (std::size_t i = 0; i < count; ++i) {
+            REQUIRE(responses[i].requestId == i);
+            REQUIRE(responses[i].fee == expected[i]);
+        }
+    }
+
+    SECTION("1バイトずつ届いたフレームも処理する") {
+        QuoteClient client;
+        REQUIRE(client.connectUnix(options.unixPath) == true);
+        char frame[kQuoteRequestFrameSize];
+        encodeQuoteRequest(request(QuoteOpcode::Quote, 42, 1, 0, jst(1, 5, 12, 0), jst(1, 5, 13, 0)), frame);
+        for (char byte : frame) {
+            REQUIRE(client.sendBytes(&byte, 1) == true);
+        }
+        QuoteResponse response;
+        REQUIRE(client.receive(&response, 1) == true);
+        REQUIRE(response.requestId == 42);
+        REQUIRE(response.status == QuoteStatus::Ok);
+    }
+
+    SECTION("不正なフレームを送った接続は閉じる") {
+        QuoteClient client;
+        REQUIRE(client.connectTcp("127.0.0.1", server.tcpPort()) == true);
+        char garbage[kQuoteRequestFrameSize] = {static_cast<char>(0xff)};
+        REQUIRE(client.sendBytes(garbage, sizeof(garbage)) == true);
+        QuoteResponse response;
+        REQUIRE(client.receive(&response, 1) == false);
+
+        // 他の接続には影響しない
+        QuoteClient other;
+        REQUIRE(other.connectTcp("127.0.0.1", server.tcpPort()) == true);
+        REQUIRE(other.call(request(QuoteOpcode::Quote, 1, 1, 0, 0, 60), response) == true);
+        REQUIRE(response.status == QuoteStatus::Ok);
+    }
+
+    server.stop();
+    REQUIRE(server.isRunning() == false);
+    REQUIRE(::access(options.unixPath.c_str(), F_OK) != 0);
+}
+
+TEST_CASE("料金見積もり: fd が足りない間は io_uring の受け付けを待ってから登録し直す", "[server]") {
+    IoUringQueue probe;
+    if (!probe.open(8)) {
+        return;  // io_uring が使えない環境
+    }
+    probe.close();
+
+    StayPricingEngine pricing(kDefaultDayTariffs);
+    QuoteService service(16, 1024);
+    REQUIRE(service.addLot(1, pricing) == true);
+    QuoteServerOptions options;
+    options.reactorCount = 1;
+    options.backend = QuoteServerBackend::IoUring;
+    QuoteServer server(service);
+    REQUIRE(server.start(options) == true);
+
+    sockaddr_in address{};
+    address.sin_family = AF_INET;
+    address.sin_port = htons(static_cast<std::uint16_t>(server.tcpPort()));
+    address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    int client = ::socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    REQUIRE(client >= 0);
+
+    // 空いている fd を使い切ってから接続し、サーバーの受け付けを EMFILE で失敗させ続ける
+    rlimit original;
+    REQUIRE(::getrlimit(RLIMIT_NOFILE, &original) == 0);
+    rlimit lowered = original;
+    lowered.rlim_cur = std::min<rlim_t>(original.rlim_cur, 1024);
+    REQUIRE(::setrlimit(RLIMIT_NOFILE, &lowered) == 0);
+    std::vector<int> fillers;
+    for (int fd; (fd = ::dup(client)) >= 0;) {
+        fillers.push_back(fd);
+    }
+    bool connected = ::connect(client, reinterpret_cast<sockaddr*>(&address), sizeof(address)) == 0;
+    std::uint64_t syscallsBefore = server.syscallCount();
+    std::this_thread::sleep_for(std::chrono::milliseconds(200));
+    std::uint64_t syscallsWhileFull = server.syscallCount() - syscallsBefore;
+    for (int fd : fillers) {
+        ::close(fd);
+    }
+    REQUIRE(::setrlimit(RLIMIT_NOFILE, &original) == 0);
+
+    REQUIRE(connected == true);
+    REQUIRE(!fillers.empty());
+    REQUIRE(server.connectionCount() == 0);
+    // すぐに登録し直していれば 200ms で何万回も io_uring_enter を呼ぶ
+    REQUIRE(syscallsWhileFull < 1000);
+
+    // fd が空けば受け付ける
+    for (int wait = 0; wait < 1000 && server.connectionCount() == 0; ++wait) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    REQUIRE(server.connectionCount() == 1);
+    ::close(client);
+    server.stop();
+}
+
+TEST_CASE("io_uring の投入・完了キュー", "[server]") {
+    IoUringQueue ring;
+    if (!ring.open(4)) {
+        WARN("io_uring is unavailable");
+        return;
+    }
+
+    SECTION("まとめて投入した要求の完了を取り出す") {
+        for (std::uint64_t i = 1; i <= 3; ++i) {
+            io_uring_sqe* sqe = ring.getSqe();
+            REQUIRE(sqe != nullptr);
+            sqe->opcode = IORING_OP_NOP;
+            sqe->user_data = i;
+        }
+        REQUIRE(ring.submitAndWait(3) == 3);
+        REQUIRE(ring.enterCount() == 1);
+        std::uint64_t sum = 0;
+        io_uring_cqe completion;
+        while (ring.peek(completion)) {
+            REQUIRE(completion.res == 0);
+            sum += completion.user_data;
+        }
+        REQUIRE(sum == 6);
+    }
+
+    SECTION("登録済みバッファに読み込む") {
+        char buffer[64] = {};
+        iovec registered{buffer, sizeof(buffer)};
+        REQUIRE(ring.registerBuffers(&registered, 1) == true);
+        int pipeFds[2];
+        REQUIRE(::pipe(pipeFds) == 0);
+        REQUIRE(::write(pipeFds[1], "parking", 7) == 7);
+
+        io_uring_sqe* sqe = ring.getSqe();
+        sqe->opcode = IORING_OP_READ_FIXED;
+        sqe->fd = pipeFds[0];
+        sqe->addr = reinterpret_cast<std::uint64_t>(buffer + 8);
+        sqe->len = 16;
+        sqe->buf_index = 0;
+        REQUIRE(ring.submitAndWait(1) == 1);
+        io_uring_cqe completion;
+        REQUIRE(ring.peek(completion) == true);
+        REQUIRE(completion.res == 7);
+        REQUIRE(std::string(buffer + 8, 7) == "parking");
+        ::close(pipeFds[0]);
+        ::close(pipeFds[1]);
+    }
+
+    SECTION("一杯のキューからは取れない") {
+        for (int i = 0; i < 4; ++i) {
+            REQUIRE(ring.getSqe() != nullptr);
+        }
+        REQUIRE(ring.getSqe() == nullptr);
+    }
+}
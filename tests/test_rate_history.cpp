@@ -0,0 +1,229 @@
+// 料金設定の履歴（版）と履歴索引のテスト
+#include "catch.hpp"
+#include "../src/rate_history.hpp"
+#include "../src/parking_rate_repository.hpp"
+#include <sqlite3.h>
+#include <chrono>
+#include <cstdio>
+#include <random>
+#include <string>
+
+namespace {
+
+ParkingRateConfig priced(int unitPrice) {
+    return ParkingRateConfig{60, unitPrice, 720, 1500, 60, 300, 720, 1000};
+}
+
+// 2024-04-01 00:00:00 JST
+const std::int64_t kApril = 1711897200;
+const std::int64_t kDay = 86400;
+
+} // namespace
+
+TEST_CASE("料金設定の履歴: SQLiteリポジトリ", "[history]") {
+    const char* testDb = "/tmp/test_rate_history.db";
+    std::remove(testDb);
+    auto repo = createSQLiteRepository(testDb);
+
+    SECTION("ある時点で適用されていた版を読み込む") {
+        REQUIRE(repo->saveVersion(RateVersion{"weekday", kApril, priced(500)}) == true);
+        REQUIRE(repo->saveVersion(RateVersion{"weekday", kApril + 30 * kDay, priced(600)}) == true);
+        REQUIRE(repo->saveVersion(RateVersion{"weekday", kApril + 10 * kDay, priced(550)}) == true);
+        REQUIRE(repo->saveVersion(RateVersion{"holiday", kApril, priced(700)}) == true);
+
+        ParkingRateConfig config;
+        REQUIRE(repo->loadAsOf("weekday", kApril - 1, config) == false);
+        REQUIRE(repo->loadAsOf("weekday", kApril, config) == true);
+        REQUIRE(config.unitPrice == 500);
+        REQUIRE(repo->loadAsOf("weekday", kApril + 10 * kDay - 1, config) == true);
+        REQUIRE(config.unitPrice == 500);
+        REQUIRE(repo->loadAsOf("weekday", kApril + 10 * kDay, config) == true);
+        REQUIRE(config.unitPrice == 550);
+        REQUIRE(repo->loadAsOf("weekday", kApril + 365 * kDay, config) == true);
+        REQUIRE(config.unitPrice == 600);
+        REQUIRE(repo->loadAsOf("holiday", kApril + 365 * kDay, config) == true);
+        REQUIRE(config.unitPrice == 700);
+        REQUIRE(repo->loadAsOf("event", kApril, config) == false);
+
+        // 版の保存は現在の料金設定を変えない
+        REQUIRE(repo->exists("weekday") == false);
+
+        // 同じ適用開始の版は置き換える
+        REQUIRE(repo->saveVersion(RateVersion{"weekday", kApril, priced(510)}) == true);
+        REQUIRE(repo->loadAsOf("weekday", kApril + 1, config) == true);
+        REQUIRE(config.unitPrice == 510);
+
+        RateVersionList versions;
+        REQUIRE(repo->loadVersions(versions) == true);
+        REQUIRE(versions.size() == 4);
+        REQUIRE(versions[0].type == "holiday");
+        REQUIRE(versions[1].effectiveFrom == kApril);
+        REQUIRE(versions[2].effectiveFrom == kApril + 10 * kDay);
+        REQUIRE(versions[3].config.unitPrice == 600);
+    }
+
+    SECTION("save は保存時刻を適用開始とする版も記録する") {
+        std::int64_t before = std::chrono::duration_cast<std::chrono::seconds>(
+            std::chrono::system_clock::now().time_since_epoch()).count();
+        REQUIRE(repo->saveVersion(RateVersion{"weekday", kApril, priced(500)}) == true);
+        REQUIRE(repo->save("weekday", priced(800)) == true);
+
+        ParkingRateConfig config;
+        REQUIRE(repo->loadAsOf("weekday", kApril + kDay, config) == true);
+        REQUIRE(config.unitPrice == 500);
+        REQUIRE(repo->loadAsOf("weekday", before + 60, config) == true);
+        REQUIRE(config.unitPrice == 800);
+
+        RateVersionList versions;
+        REQUIRE(repo->loadVersions(versions) == true);
+        REQUIRE(versions.size() == 2);
+        REQUIRE(versions[1].effectiveFrom >= before);
+    }
+
+    SECTION("同じ秒に save を繰り返すと、その秒の版は後の保存で置き換える") {
+        auto now = []() {
+            return std::chrono::duration_cast<std::chrono::seconds>(
+                std::chrono::system_clock::now().time_since_epoch()).count();
+        };
+        // 秒の境目をまたいだらやり直す
+        std::int64_t savedAt = 0;
+        for (int attempt = 0; attempt < 10; ++attempt) {
+            std::int64_t before = now();
+            REQUIRE(repo->save("weekday", priced(500 + attempt)) == true);
+            REQUIRE(repo->save("weekday", priced(800 + attempt)) == true);
+            if (now() == before) {
+                savedAt = before;
+                break;
+            }
+        }
+        REQUIRE(savedAt != 0);
+
+        ParkingRateConfig current;
+        ParkingRateConfig asOf;
+        REQUIRE(repo->load("weekday", current) == true);
+        REQUIRE(repo->loadAsOf("weekday", savedAt, asOf) == true);
+        REQUIRE(asOf.unitPrice == current.unitPrice);
+        REQUIRE(current.unitPrice >= 800);
+
+        RateVersionList versions;
+        REQUIRE(repo->loadVersions(versions) == true);
+        REQUIRE(versions.back().effectiveFrom == savedAt);
+        REQUIRE(versions.back().config.unitPrice == current.unitPrice);
+    }
+
+    std::remove(testDb);
+}
+
+TEST_CASE("料金設定の履歴: 履歴のないDBを開くと現在の設定を版として写す", "[history]") {
+    const char* testDb = "/tmp/test_rate_history_legacy.db";
+    std::remove(testDb);
+
+    // 履歴のテーブルができる前のスキーマ
+    sqlite3* db = nullptr;
+    REQUIRE(sqlite3_open(testDb, &db) == SQLITE_OK);
+    REQUIRE(sqlite3_exec(db,
+                         "CREATE TABLE parking_rates (type TEXT PRIMARY KEY, unit_minutes INTEGER, "
+                         "unit_price INTEGER, max_minutes INTEGER, max_fee INTEGER, night_unit_minutes INTEGER, "
+                         "night_unit_price INTEGER, night_max_minutes INTEGER, night_max_fee INTEGER);"
+                         "INSERT INTO parking_rates VALUES ('weekday', 60, 500, 720, 1500, 60, 300, 720, 1000);"
+                         "INSERT INTO parking_rates VALUES ('holiday', 60, 700, 720, 1500, 60, 300, 720, 1000);",
+                         nullptr, nullptr, nullptr) == SQLITE_OK);
+    sqlite3_close(db);
+
+    {
+        auto repo = createSQLiteRepository(testDb);
+        ParkingRateConfig config;
+        REQUIRE(repo->loadAsOf("weekday", kApril, config) == true);
+        REQUIRE(config.unitPrice == 500);
+        REQUIRE(repo->loadAsOf("holiday", 0, config) == true);
+        REQUIRE(config.unitPrice == 700);
+
+        RateVersionList versions;
+        REQUIRE(repo->loadVersions(versions) == true);
+        REQUIRE(versions.size() == 2);
+        REQUIRE(versions[0].effectiveFrom == 0);
+        REQUIRE(versions[1].effectiveFrom == 0);
+
+        REQUIRE(repo->save("weekday", priced(800)) == true);
+    }
+
+    // 2回目以降に開いたときは写さない
+    auto repo = createSQLiteRepository(testDb);
+    RateVersionList versions;
+    REQUIRE(repo->loadVersions(versions) == true);
+    REQUIRE(versions.size() == 3);
+    ParkingRateConfig config;
+    REQUIRE(repo->loadAsOf("weekday", kApril, config) == true);
+    REQUIRE(config.unitPrice == 500);
+    REQUIRE(repo->load("weekday", config) == true);
+    REQUIRE(config.unitPrice == 800);
+
+    std::remove(testDb);
+}
+
+TEST_CASE("料金設定の履歴: 履歴索引", "[history]") {
+    SECTION("順不同の版から構築し、適用開始の境界で版が切り替わる") {
+        RateHistoryIndex index(RateVersionList{
+            {"weekday", kApril + 30 * kDay, priced(600)},
+            {"weekday", kApril, priced(500)},
+            {"holiday", kApril, priced(700)},
+            {"weekday", kApril + 30 * kDay, priced(610)},  // 同じ適用開始は後の版を使う
+        });
+        REQUIRE(index.typeCount() == 2);
+        REQUIRE(index.versionCount() == 3);
+
+        REQUIRE(index.find("weekday", kApril - 1) == nullptr);
+        REQUIRE(index.find("weekday", kApril)->unitPrice == 500);
+        REQUIRE(index.find("weekday", kApril + 30 * kDay - 1)->unitPrice == 500);
+        REQUIRE(index.find("weekday", kApril + 30 * kDay)->unitPrice == 610);
+        REQUIRE(index.find("holiday", kApril + 100 * kDay)->unitPrice == 700);
+        REQUIRE(index.find("event", kApril) == nullptr);
+
+        const RateHistoryIndex::Timeline* weekday = index.timeline("weekday");
+        REQUIRE(weekday != nullptr);
+        REQUIRE(weekday->size() == 2);
+        REQUIRE(weekday->effectiveFrom(1) == kApril + 30 * kDay);
+        REQUIRE(weekday->config(1).unitPrice == 610);
+    }
+
+    SECTION("DBの loadAsOf と同じ版を返す") {
+        const char* testDb = "/tmp/test_rate_history_index.db";
+        std::remove(testDb);
+        auto repo = createSQLiteRepository(testDb);
+
+        std::mt19937 random(7);
+        RateVersionList versions;
+        for (int i = 0; i < 200; ++i) {
+            std::string type = "type" + std::to_string(i % 5);
+            std::int64_t effectiveFrom = kApril + static_cast<std::int64_t>(random() % (365 * kDay));
+            versions.push_back(RateVersion{type, effectiveFrom, priced(i)});
+        }
+        for (const RateVersion& version : versions) {
+            REQUIRE(repo->saveVersion(version) == true);
+        }
+
+        RateHistoryIndex index;
+        REQUIRE(index.load(*repo) == true);
+        REQUIRE(index.versionCount() == 200);
+
+        for (int i = 0; i < 2000; ++i) {
+            std::string type = "type" + std::to_string(i % 6);
+            std::int64_t timestamp = kApril - kDay + static_cast<std::int64_t>(random() % (367 * kDay));
+            ParkingRateConfig expected;
+            bool found = repo->loadAsOf(type, timestamp, expected);
+            const ParkingRateConfig* actual = index.find(type, timestamp);
+            REQUIRE((actual != nullptr) == found);
+            if (found) {
+                REQUIRE(actual->unitPrice == expected.unitPrice);
+            }
+        }
+        std::remove(testDb);
+    }
+
+    SECTION("読み込めない場合は元の内容を保つ") {
+        RateHistoryIndex index(RateVersionList{{"weekday", kApril, priced(500)}});
+        auto broken = createSQLiteRepository("/nonexistent_dir/test.db");
+        REQUIRE(index.load(*broken) == false);
+        REQUIRE(index.find("weekday", kApril)->unitPrice == 500);
+    }
+}
@@ -0,0 +1,549 @@
+// 駐車セッションのイベントログと、ログから復元するセッション管理のテスト
+#include "catch.hpp"
+#include "../src/journaled_session_store.hpp"
+#include "../src/io_uring_queue.hpp"
+#include "../src/session_snapshot.hpp"
+#include <dirent.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+
+const char* kLogDirectory = "/tmp/test_session_event_log";
+
+void removeLogDirectory(const std::string& directory) {
+    if (DIR* dir = ::opendir(directory.c_str())) {
+        while (dirent* entry = ::readdir(dir)) {
+            std::string name = entry->d_name;
+            if (name != "." && name != "..") {
+                std::remove((directory + "/" + name).c_str());
+            }
+        }
+        ::closedir(dir);
+    }
+    ::rmdir(directory.c_str());
+}
+
+std::vector<std::string> segmentFiles(const std::string& directory) {
+    std::vector<std::string> files;
+    if (DIR* dir = ::opendir(directory.c_str())) {
+        while (dirent* entry = ::readdir(dir)) {
+            std::string name = entry->d_name;
+            if (name.compare(0, 8, "segment-") == 0) {
+                files.push_back(directory + "/" + name);
+            }
+        }
+        ::closedir(dir);
+    }
+    std::sort(files.begin(), files.end());
+    return files;
+}
+
+off_t fileSize(const std::string& path) {
+    struct stat status;
+    return ::stat(path.c_str(), &status) == 0 ? status.st_size : -1;
+}
+
+// ログを開き直して全イベントを集める
+std::vector<SessionEvent> replayAll(const SessionEventLogOptions& options = SessionEventLogOptions()) {
+    std::vector<SessionEvent> events;
+    SessionEventLog log;
+    bool opened = log.open(kLogDirectory, options, [&](const SessionEvent& event) {
+        events.push_back(event);
+        return true;
+    });
+    REQUIRE(opened == true);
+    return events;
+}
+
+std::int64_t jst(int month, int day, int hour, int minute) {
+    return epochFromLocal(2024, month, day, hour, minute);
+}
+
+// 1レコードの大きさ（長さ・CRC・イベント）
+const off_t kRecordBytes = 8 + sizeof(SessionEvent);
+
+} // namespace
+
+TEST_CASE("セッションのイベントログ", "[eventlog]") {
+    removeLogDirectory(kLogDirectory);
+
+    SECTION("追記したイベントを開き直すと順に再生する") {
+        {
+            SessionEventLog log;
+            REQUIRE(log.open(kLogDirectory) == true);
+            REQUIRE(log.append(SessionEventType::Entry, 10, 1, 1000) == 1);
+            REQUIRE(log.append(SessionEventType::Payment, 10, 1, 1500, 700) == 2);
+            REQUIRE(log.append(SessionEventType::Exit, 10, 1, 2000, 700) == 3);
+            REQUIRE(log.committedSequence() == 0);
+
+            // まとめて積んだイベントは1回の書き込みでコミットされる
+            REQUIRE(log.commit(2) == true);
+            REQUIRE(log.committedSequence() == 3);
+            REQUIRE(log.writeCount() == 1);
+            REQUIRE(log.syncCount() == 1);
+            REQUIRE(log.commit(3) == true);
+            REQUIRE(log.writeCount() == 1);
+        }
+
+        std::vector<SessionEvent> events = replayAll();
+        REQUIRE(events.size() == 3);
+        REQUIRE(events[0].type == SessionEventType::Entry);
+        REQUIRE(events[0].ticketId == 10);
+        REQUIRE(events[0].lotId == 1);
+        REQUIRE(events[1].type == SessionEventType::Payment);
+        REQUIRE(events[1].amount == 700);
+        REQUIRE(events[2].sequence == 3);
+        REQUIRE(events[2].time == 2000);
+
+        // 続きの通し番号から追記する
+        SessionEventLog log;
+        REQUIRE(log.open(kLogDirectory) == true);
+        REQUIRE(log.nextSequence() == 4);
+        REQUIRE(log.append(SessionEventType::Entry, 11, 1, 3000) == 4);
+        REQUIRE(log.flush() == true);
+    }
+
+    SECTION("大きくなるとセグメントを切り替え、全セグメントを再生する") {
+        SessionEventLogOptions options;
+        options.sync = EventLogSync::None;
+        options.segmentBytes = 1024;
+        {
+            SessionEventLog log;
+            REQUIRE(log.open(kLogDirectory, options) == true);
+            for (std::uint64_t i = 1; i <= 200; ++i) {
+                REQUIRE(log.commit(log.append(SessionEventType::Entry, i, 0, static_cast<std::int64_t>(i))) == true);
+            }
+            REQUIRE(log.segmentCount() > 5);
+            REQUIRE(log.syncCount() == 0);
+        }
+        REQUIRE(segmentFiles(kLogDirectory).size() > 5);
+
+        std::vector<SessionEvent> events = replayAll(options);
+        REQUIRE(events.size() == 200);
+        for (std::size_t i = 0; i < events.size(); ++i) {
+            REQUIRE(events[i].sequence == i + 1);
+            REQUIRE(events[i].ticketId == i + 1);
+        }
+    }
+
+    SECTION("io_uring で書いたログも同じ形式で再生する") {
+        SessionEventLogOptions options;
+        options.ioUring = true;
+        options.segmentBytes = 64 * 1024;
+        {
+            SessionEventLog log;
+            REQUIRE(log.open(kLogDirectory, options) == true);
+            IoUringQueue probe;
+            REQUIRE(log.usesIoUring() == probe.open(8));
+            // 1回のコミットで登録済みバッファより大きいバッチも書ける
+            for (std::uint64_t i = 1; i <= 10000; ++i) {
+                log.append(SessionEventType::Entry, i, 0, static_cast<std::int64_t>(i));
+            }
+            REQUIRE(log.flush() == true);
+            for (std::uint64_t i = 10001; i <= 10100; ++i) {
+                REQUIRE(log.commit(log.append(SessionEventType::Exit, i, 0, 0, 300)) == true);
+            }
+            REQUIRE(log.syncCount() == 101);
+            REQUIRE(log.sync() == true);
+        }
+        std::vector<SessionEvent> events = replayAll();
+        REQUIRE(events.size() == 10100);
+        for (std::size_t i = 0; i < events.size(); ++i) {
+            REQUIRE(events[i].sequence == i + 1);
+            REQUIRE(events[i].ticketId == i + 1);
+        }
+        REQUIRE(events.back().amount == 300);
+    }
+
+    SECTION("書きかけの末尾は切り詰めて続きから追記する") {
+        {
+            SessionEventLog log;
+            REQUIRE(log.open(kLogDirectory) == true);
+            for (std::uint64_t i = 1; i <= 10; ++i) {
+                log.append(SessionEventType::Entry, i, 0, 0);
+            }
+            REQUIRE(log.flush() == true);
+        }
+        // 最後のレコードの途中で止まった状態にする
+        std::string segment = segmentFiles(kLogDirectory).back();
+        off_t size = fileSize(segment);
+        REQUIRE(::truncate(segment.c_str(), size - 5) == 0);
+
+        std::vector<SessionEvent> events = replayAll();
+        REQUIRE(events.size() == 9);
+        REQUIRE(fileSize(segment) == size - kRecordBytes);
+
+        {
+            SessionEventLog log;
+            REQUIRE(log.open(kLogDirectory) == true);
+            REQUIRE(log.append(SessionEventType::Entry, 99, 0, 0) == 10);
+            REQUIRE(log.flush() == true);
+        }
+        events = replayAll();
+        REQUIRE(events.size() == 10);
+        REQUIRE(events.back().ticketId == 99);
+    }
+
+    SECTION("CRCが合わないレコード以降は再生しない") {
+        {
+            SessionEventLog log;
+            REQUIRE(log.open(kLogDirectory) == true);
+            for (std::uint64_t i = 1; i <= 10; ++i) {
+                log.append(SessionEventType::Entry, i, 0, 0);
+            }
+            REQUIRE(log.flush() == true);
+        }
+        // 6番目のレコードの駐車券番号を書き換える
+        std::string segment = segmentFiles(kLogDirectory).back();
+        FILE* file = std::fopen(segment.c_str(), "r+b");
+        REQUIRE(file != nullptr);
+        std::fseek(file, 32 + 5 * kRecordBytes + 8 + 8, SEEK_SET);
+        std::fputc(0x7f, file);
+        std::fclose(file);
+
+        std::vector<SessionEvent> events = replayAll();
+        REQUIRE(events.size() == 5);
+    }
+
+    SECTION("途中のセグメントが壊れていれば開かない") {
+        SessionEventLogOptions options;
+        options.segmentBytes = 256;
+        {
+            SessionEventLog log;
+            REQUIRE(log.open(kLogDirectory, options) == true);
+            for (std::uint64_t i = 1; i <= 20; ++i) {
+                REQUIRE(log.commit(log.append(SessionEventType::Entry, i, 0, 0)) == true);
+            }
+        }
+        std::vector<std::string> segments = segmentFiles(kLogDirectory);
+        REQUIRE(segments.size() >= 2);
+        REQUIRE(::truncate(segments.front().c_str(), fileSize(segments.front()) - 1) == 0);
+
+        SessionEventLog log;
+        REQUIRE(log.open(kLogDirectory, options) == false);
+        REQUIRE(log.isOpen() == false);
+    }
+
+    SECTION("複数スレッドのコミットをまとめて書く") {
+        const int threadCount = 8;
+        const int perThread = 200;
+        SessionEventLog log;
+        REQUIRE(log.open(kLogDirectory) == true);
+        std::atomic<int> failures{0};
+        std::vector<std::thread> gates;
+        for (int t = 0; t < threadCount; ++t) {
+            gates.emplace_back([&, t] {
+                for (int i = 0; i < perThread; ++i) {
+                    std::uint64_t sequence = log.append(SessionEventType::Entry,
+                                                        static_cast<std::uint64_t>(t * perThread + i + 1), 0, 0);
+                    if (!log.commit(sequence)) {
+                        ++failures;
+                    }
+                }
+            });
+        }
+        for (std::thread& gate : gates) {
+            gate.join();
+        }
+        REQUIRE(failures == 0);
+        REQUIRE(log.committedSequence() == threadCount * perThread);
+        REQUIRE(log.writeCount() <= static_cast<std::uint64_t>(threadCount * perThread));
+        log.close();
+
+        REQUIRE(replayAll().size() == threadCount * perThread);
+    }
+
+    SECTION("再生を拒否されたら開かない") {
+        {
+            SessionEventLog log;
+            REQUIRE(log.open(kLogDirectory) == true);
+            log.append(SessionEventType::Entry, 1, 0, 0);
+        }
+        SessionEventLog log;
+        REQUIRE(log.open(kLogDirectory, SessionEventLogOptions(), [](const SessionEvent&) { return false; }) == false);
+    }
+
+    removeLogDirectory(kLogDirectory);
+}
+
+TEST_CASE("イベントログから復元するセッション管理", "[eventlog]") {
+    removeLogDirectory(kLogDirectory);
+    StayPricingEngine pricing(kDefaultDayTariffs);
+
+    SECTION("再起動すると入庫中のセッションだけが残る") {
+        {
+            JournaledSessionStore store(4);
+            REQUIRE(store.addLot(1, pricing) == true);
+            REQUIRE(store.open(kLogDirectory) == true);
+            REQUIRE(store.entry(1, 1, jst(1, 10, 10, 0)) == true);
+            REQUIRE(store.entry(2, 1, jst(1, 10, 10, 30)) == true);
+            REQUIRE(store.entry(3, 1, jst(1, 10, 11, 0)) == true);
+            REQUIRE(store.entry(3, 1, jst(1, 10, 11, 0)) == false);  // 重複はログに残さない
+            REQUIRE(store.pay(2, jst(1, 10, 11, 0), 500) == true);
+            REQUIRE(store.pay(9, jst(1, 10, 11, 0), 500) == false);
+            ClosedSession closed;
+            REQUIRE(store.exit(1, jst(1, 10, 11, 0), closed) == true);
+            REQUIRE(closed.fee == 500);
+            REQUIRE(store.log().nextSequence() == 6);
+        }
+
+        JournaledSessionStore store(16);
+        REQUIRE(store.addLot(1, pricing) == true);
+        REQUIRE(store.open(kLogDirectory) == true);
+        REQUIRE(store.replayedEvents() == 5);
+        REQUIRE(store.size() == 2);
+        OpenSession open;
+        REQUIRE(store.find(1, open) == false);
+        REQUIRE(store.find(2, open) == true);
+        REQUIRE(open.entryTime == jst(1, 10, 10, 30));
+
+        ClosedSession closed;
+        REQUIRE(store.exit(3, jst(1, 10, 12, 0), closed) == true);
+        REQUIRE(closed.fee == 500);
+        REQUIRE(store.size() == 1);
+    }
+
+    SECTION("駐車場を登録せずに開くと再生に失敗する") {
+        {
+            JournaledSessionStore store;
+            REQUIRE(store.addLot(1, pricing) == true);
+            REQUIRE(store.open(kLogDirectory) == true);
+            REQUIRE(store.entry(1, 1, jst(1, 10, 10, 0)) == true);
+        }
+        JournaledSessionStore store;
+        REQUIRE(store.open(kLogDirectory) == false);
+    }
+
+    removeLogDirectory(kLogDirectory);
+}
+
+TEST_CASE("日ごとの売上", "[eventlog]") {
+    RevenueCounters counters(3);
+    counters.addExit(1, jst(1, 10, 10, 0), 500);
+    counters.addExit(1, jst(1, 10, 23, 59), 300);
+    counters.addExit(2, jst(1, 10, 12, 0), 1000);
+    counters.addPayment(1, jst(1, 11, 0, 0), 700);  // 現地時刻の日付で区切る
+
+    std::vector<DailyRevenue> revenue = counters.list();
+    REQUIRE(revenue.size() == 3);
+    REQUIRE(revenue[0].lotId == 1);
+    REQUIRE(revenue[0].day == daysFromCivil(2024, 1, 10));
+    REQUIRE(revenue[0].exits == 2);
+    REQUIRE(revenue[0].fees == 800);
+    REQUIRE(revenue[1].lotId == 2);
+    REQUIRE(revenue[2].day == daysFromCivil(2024, 1, 11));
+    REQUIRE(revenue[2].payments == 700);
+
+    // 3日分だけ残す
+    counters.addExit(1, jst(1, 13, 10, 0), 500);
+    revenue = counters.list();
+    REQUIRE(revenue.size() == 2);
+    REQUIRE(revenue.front().day == daysFromCivil(2024, 1, 11));
+    counters.addExit(1, jst(1, 10, 10, 0), 500);  // 期間外は数えない
+    REQUIRE(counters.list().size() == 2);
+}
+
+TEST_CASE("スナップショットとログの削除", "[eventlog]") {
+    removeLogDirectory(kLogDirectory);
+    StayPricingEngine pricing(kDefaultDayTariffs);
+    SessionEventLogOptions options;
+    options.sync = EventLogSync::None;
+    options.segmentBytes = 4096;
+
+    SECTION("スナップショットより後のログだけを再生して同じ状態に戻る") {
+        std::vector<DailyRevenue> expectedRevenue;
+        std::uint64_t snapshotSequence = 0;
+        {
+            JournaledSessionStore store(8);
+            REQUIRE(store.addLot(1, pricing) == true);
+            REQUIRE(store.open(kLogDirectory, options) == true);
+            for (std::uint64_t id = 1; id <= 1000; ++id) {
+                REQUIRE(store.entry(id, 1, jst(1, 10, 10, 0)) == true);
+            }
+            ClosedSession closed;
+            for (std::uint64_t id = 1; id <= 1000; id += 2) {
+                REQUIRE(store.exit(id, jst(1, 10, 11, 0), closed) == true);
+            }
+            std::size_t segmentsBefore = store.log().segmentCount();
+            REQUIRE(segmentsBefore > 10);
+
+            REQUIRE(store.snapshot() == true);
+            snapshotSequence = store.snapshotSequence();
+            REQUIRE(snapshotSequence == 1500);
+            REQUIRE(store.log().segmentCount() < segmentsBefore);
+            REQUIRE(store.log().firstSequence() <= snapshotSequence + 1);
+
+            // スナップショット後の入出庫・精算
+            REQUIRE(store.entry(5000, 1, jst(1, 11, 9, 0)) == true);
+            REQUIRE(store.pay(2, jst(1, 11, 9, 0), 1500) == true);
+            REQUIRE(store.exit(4, jst(1, 11, 10, 0), closed) == true);
+            expectedRevenue = store.revenue();
+        }
+
+        JournaledSessionStore store(8);
+        REQUIRE(store.addLot(1, pricing) == true);
+        REQUIRE(store.open(kLogDirectory, options) == true);
+        REQUIRE(store.restoredSequence() == snapshotSequence);
+        REQUIRE(store.replayedEvents() == 3);
+        REQUIRE(store.size() == 500);
+        OpenSession open;
+        REQUIRE(store.find(5000, open) == true);
+        REQUIRE(store.find(4, open) == false);
+        REQUIRE(store.find(1, open) == false);
+
+        std::vector<DailyRevenue> revenue = store.revenue();
+        REQUIRE(revenue.size() == expectedRevenue.size());
+        REQUIRE(revenue.size() == 2);
+        for (std::size_t i = 0; i < revenue.size(); ++i) {
+            REQUIRE(revenue[i].day == expectedRevenue[i].day);
+            REQUIRE(revenue[i].exits == expectedRevenue[i].exits);
+            REQUIRE(revenue[i].fees == expectedRevenue[i].fees);
+            REQUIRE(revenue[i].payments == expectedRevenue[i].payments);
+        }
+        REQUIRE(revenue[0].exits == 500);
+        REQUIRE(revenue[0].fees == 500 * 500);
+        REQUIRE(revenue[1].payments == 1500);
+    }
+
+    SECTION("シャードごとに反映済みのイベントは再生しない") {
+        ClosedSession closed;
+        std::vector<DailyRevenue> expectedRevenue;
+        {
+            JournaledSessionStore store(2);
+            REQUIRE(store.addLot(1, pricing) == true);
+            REQUIRE(store.open(kLogDirectory, options) == true);
+            for (std::uint64_t id = 1; id <= 8; ++id) {
+                REQUIRE(store.entry(id, 1, jst(1, 10, 10, 0)) == true);
+            }
+            REQUIRE(store.exit(1, jst(1, 10, 11, 0), closed) == true);  // 通し番号9
+            REQUIRE(store.pay(2, jst(1, 10, 11, 0), 700) == true);      // 通し番号10
+            expectedRevenue = store.revenue();
+        }
+
+        // 駐車券1のシャードは最後まで、もう一方のシャードは通し番号4までを反映したスナップショット
+        const std::size_t coveredShard = ShardedSessionStore::shardIndexFor(1, 2);
+        SessionSnapshot snapshot;
+        snapshot.sequence = 4;
+        snapshot.shardSequences = {4, 4};
+        snapshot.shardSequences[coveredShard] = 10;
+        RevenueCounters counters(31, kJstUtcOffsetSeconds);
+        counters.addExit(1, jst(1, 10, 11, 0), closed.fee);
+        std::uint64_t expectedReplays = 0;
+        for (std::uint64_t id = 2; id <= 8; ++id) {
+            bool covered = ShardedSessionStore::shardIndexFor(id, 2) == coveredShard;
+            if (covered || id <= 4) {
+                snapshot.sessions.push_back(OpenSession{id, jst(1, 10, 10, 0), 1});
+            } else {
+                ++expectedReplays;
+            }
+            if (id == 2) {
+                if (covered) {
+                    counters.addPayment(1, jst(1, 10, 11, 0), 700);
+                } else {
+                    ++expectedReplays;
+                }
+            }
+        }
+        REQUIRE(expectedReplays > 0);
+        snapshot.revenue = counters.list();
+        REQUIRE(writeSessionSnapshot(kLogDirectory, snapshot) == true);
+
+        SessionSnapshot loaded;
+        REQUIRE(loadLatestSessionSnapshot(kLogDirectory, loaded) == true);
+        REQUIRE(loaded.shardSequences == snapshot.shardSequences);
+
+        // シャード数が違っても、スナップショットのシャード数で反映済みかを判定する
+        JournaledSessionStore store(16);
+        REQUIRE(store.addLot(1, pricing) == true);
+        REQUIRE(store.open(kLogDirectory, options) == true);
+        REQUIRE(store.restoredSequence() == 4);
+        REQUIRE(store.replayedEvents() == expectedReplays);
+        REQUIRE(store.size() == 7);
+        OpenSession open;
+        REQUIRE(store.find(1, open) == false);
+        REQUIRE(store.find(8, open) == true);
+        std::vector<DailyRevenue> revenue = store.revenue();
+        REQUIRE(revenue.size() == expectedRevenue.size());
+        REQUIRE(revenue.front().exits == expectedRevenue.front().exits);
+        REQUIRE(revenue.front().fees == expectedRevenue.front().fees);
+        REQUIRE(revenue.front().payments == 700);
+    }
+
+    SECTION("入出庫と並行してバックグラウンドで取る") {
+        SessionSnapshotOptions snapshotOptions;
+        snapshotOptions.intervalMs = 2;
+        std::size_t expectedSize = 0;
+        {
+            JournaledSessionStore store(16);
+            REQUIRE(store.addLot(0, pricing) == true);
+            REQUIRE(store.open(kLogDirectory, options, snapshotOptions) == true);
+            std::atomic<int> failures{0};
+            std::vector<std::thread> gates;
+            for (int t = 0; t < 4; ++t) {
+                gates.emplace_back([&, t] {
+                    std::uint64_t base = static_cast<std::uint64_t>(t) * 100000 + 1;
+                    ClosedSession closed;
+                    for (std::uint64_t i = 0; i < 5000; ++i) {
+                        if (!store.entry(base + i, 0, jst(1, 10, 10, 0))) {
+                            ++failures;
+                        }
+                        if (i % 3 == 0 && !store.exit(base + i, jst(1, 10, 12, 0), closed)) {
+                            ++failures;
+                        }
+                    }
+                });
+            }
+            for (std::thread& gate : gates) {
+                gate.join();
+            }
+            REQUIRE(failures == 0);
+            for (int wait = 0; wait < 1000 && store.snapshotSequence() == 0; ++wait) {
+                std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            }
+            REQUIRE(store.snapshotSequence() > 0);
+            expectedSize = store.size();
+        }
+
+        JournaledSessionStore store(4);
+        REQUIRE(store.addLot(0, pricing) == true);
+        REQUIRE(store.open(kLogDirectory, options) == true);
+        REQUIRE(store.size() == expectedSize);
+        REQUIRE(store.revenue().front().exits == 4 * 1667);
+    }
+
+    SECTION("壊れたスナップショットからは復元しない") {
+        {
+            JournaledSessionStore store;
+            REQUIRE(store.addLot(1, pricing) == true);
+            REQUIRE(store.open(kLogDirectory, options) == true);
+            REQUIRE(store.entry(1, 1, jst(1, 10, 10, 0)) == true);
+            REQUIRE(store.snapshot() == true);
+        }
+        std::string snapshot;
+        if (DIR* dir = ::opendir(kLogDirectory)) {
+            while (dirent* entry = ::readdir(dir)) {
+                std::string name = entry->d_name;
+                if (name.compare(0, 9, "snapshot-") == 0) {
+                    snapshot = std::string(kLogDirectory) + "/" + name;
+                }
+            }
+            ::closedir(dir);
+        }
+        REQUIRE(!snapshot.empty());
+        REQUIRE(::truncate(snapshot.c_str(), fileSize(snapshot) - 1) == 0);
+
+        JournaledSessionStore store;
+        REQUIRE(store.addLot(1, pricing) == true);
+        REQUIRE(store.open(kLogDirectory, options) == false);
+    }
+
+    removeLogDirectory(kLogDirectory);
+}
@@ -0,0 +1,235 @@
+// 駐車セッション管理のテスト
+#include "catch.hpp"
+#include "../src/session_store.hpp"
+#include "../src/sharded_session_store.hpp"
+#include <atomic>
+#include <thread>
+#include <random>
+#include <unordered_map>
+#include <vector>
+
+namespace {
+
+std::int64_t jst(int month, int day, int hour, int minute) {
+    return epochFromLocal(2024, month, day, hour, minute);
+}
+
+// 全ての日を休日とするカレンダー
+class AllHolidayCalendar : public DayCalendar {
+public:
+    DayKind classify(std::int64_t) const override { return DayKind::Holiday; }
+};
+
+} // namespace
+
+TEST_CASE("駐車セッション: 入庫と出庫", "[session]") {
+    StayPricingEngine weekends(kDefaultDayTariffs);
+    SessionStore store;
+    REQUIRE(store.addLot(1, weekends) == true);
+
+    SECTION("出庫で料金を計算してセッションを閉じる") {
+        REQUIRE(store.entry(1001, 1, jst(1, 5, 12, 0)) == true);
+        REQUIRE(store.size() == 1);
+
+        OpenSession open;
+        REQUIRE(store.find(1001, open) == true);
+        REQUIRE(open.lotId == 1);
+        REQUIRE(open.entryTime == jst(1, 5, 12, 0));
+
+        ClosedSession closed;
+        REQUIRE(store.exit(1001, jst(1, 6, 15, 0), closed) == true);
+        REQUIRE(closed.ticketId == 1001);
+        REQUIRE(closed.lotId == 1);
+        REQUIRE(closed.entryTime == jst(1, 5, 12, 0));
+        REQUIRE(closed.exitTime == jst(1, 6, 15, 0));
+        REQUIRE(closed.fee == 5000);
+        REQUIRE(store.size() == 0);
+        REQUIRE(store.find(1001, open) == false);
+        REQUIRE(store.exit(1001, jst(1, 6, 16, 0), closed) == false);
+    }
+
+    SECTION("駐車場ごとの料金体系で計算する") {
+        AllHolidayCalendar holidays;
+        DayTariffs tariffs = kDefaultDayTariffs;
+        tariffs[DayKind::Holiday].daytime.unitPrice = 800;
+        StayPricingEngine holidayPricing(tariffs, holidays);
+        REQUIRE(store.addLot(2, holidayPricing) == true);
+
+        REQUIRE(store.entry(1, 1, jst(1, 10, 10, 0)) == true);
+        REQUIRE(store.entry(2, 2, jst(1, 10, 10, 0)) == true);
+        ClosedSession closed;
+        REQUIRE(store.exit(1, jst(1, 10, 11, 0), closed) == true);
+        REQUIRE(closed.fee == 500);
+        REQUIRE(store.exit(2, jst(1, 10, 11, 0), closed) == true);
+        std::int64_t expected = 0;
+        REQUIRE(holidayPricing.quoteTotal(jst(1, 10, 10, 0), jst(1, 10, 11, 0), expected) == true);
+        REQUIRE(closed.fee == expected);
+    }
+
+    SECTION("受け付けない入庫・出庫") {
+        REQUIRE(store.entry(0, 1, jst(1, 10, 10, 0)) == false);   // 駐車券番号0
+        REQUIRE(store.entry(7, 9, jst(1, 10, 10, 0)) == false);   // 未登録の駐車場
+        REQUIRE(store.addLot(SessionStore::kMaxLots, weekends) == false);
+
+        REQUIRE(store.entry(7, 1, jst(1, 10, 10, 0)) == true);
+        REQUIRE(store.entry(7, 1, jst(1, 10, 11, 0)) == false);   // 入庫中の番号
+        ClosedSession closed;
+        REQUIRE(store.exit(7, jst(1, 10, 9, 0), closed) == false);  // 入庫より前の出庫
+        REQUIRE(store.size() == 1);
+        REQUIRE(store.exit(7, jst(1, 10, 10, 30), closed) == true);
+        REQUIRE(store.exit(0, jst(1, 10, 10, 30), closed) == false);
+    }
+
+    SECTION("ナンバーから駐車券番号を求める") {
+        std::uint64_t id = SessionStore::plateTicketId("品川 500 さ 12-34");
+        REQUIRE(id != 0);
+        REQUIRE(id == SessionStore::plateTicketId("品川 500 さ 12-34"));
+        REQUIRE(id != SessionStore::plateTicketId("品川 500 さ 12-35"));
+        REQUIRE(store.entry(id, 1, jst(1, 10, 10, 0)) == true);
+        OpenSession open;
+        REQUIRE(store.find(SessionStore::plateTicketId("品川 500 さ 12-34"), open) == true);
+    }
+}
+
+TEST_CASE("駐車セッション: ハッシュ表", "[session]") {
+    StayPricingEngine pricing(kDefaultDayTariffs);
+
+    SECTION("入出庫を繰り返しても std::unordered_map と同じ内容を保つ") {
+        SessionStore store(16);
+        REQUIRE(store.addLot(0, pricing) == true);
+        std::unordered_map<std::uint64_t, std::int64_t> model;
+        std::mt19937_64 random(11);
+        const std::int64_t base = jst(1, 10, 0, 0);
+
+        for (int i = 0; i < 200000; ++i) {
+            // 番号の範囲を狭くして衝突と詰め直しを起こす
+            std::uint64_t ticketId = random() % 5000 + 1;
+            std::int64_t time = base + static_cast<std::int64_t>(i);
+            if (random() % 2 == 0) {
+                bool inserted = model.emplace(ticketId, time).second;
+                REQUIRE(store.entry(ticketId, 0, time) == inserted);
+            } else {
+                ClosedSession closed;
+                auto it = model.find(ticketId);
+                REQUIRE(store.exit(ticketId, time, closed) == (it != model.end()));
+                if (it != model.end()) {
+                    REQUIRE(closed.entryTime == it->second);
+                    model.erase(it);
+                }
+            }
+            REQUIRE(store.size() == model.size());
+        }
+
+        for (const auto& entry : model) {
+            OpenSession open;
+            REQUIRE(store.find(entry.first, open) == true);
+            REQUIRE(open.entryTime == entry.second);
+        }
+        REQUIRE(store.capacity() >= store.size() * 4 / 3);
+    }
+
+    SECTION("連番の駐車券を大量に入庫できる") {
+        const std::size_t count = 1000000;
+        SessionStore store(count);
+        REQUIRE(store.addLot(0, pricing) == true);
+        std::size_t capacity = store.capacity();
+        for (std::uint64_t ticketId = 1; ticketId <= count; ++ticketId) {
+            store.entry(ticketId, 0, jst(1, 10, 10, 0));
+        }
+        REQUIRE(store.size() == count);
+        REQUIRE(store.capacity() == capacity);  // 事前に確保した分で足りる
+
+        ClosedSession closed;
+        std::int64_t total = 0;
+        for (std::uint64_t ticketId = 1; ticketId <= count; ticketId += 2) {
+            REQUIRE(store.exit(ticketId, jst(1, 10, 11, 0), closed));
+            total += closed.fee;
+        }
+        REQUIRE(total == 500LL * (count / 2));
+        REQUIRE(store.size() == count / 2);
+    }
+}
+
+TEST_CASE("駐車セッション: シャード分割", "[session]") {
+    StayPricingEngine pricing(kDefaultDayTariffs);
+
+    SECTION("シャード数は2のべき乗に切り上げる") {
+        REQUIRE(ShardedSessionStore(1).shardCount() == 1);
+        REQUIRE(ShardedSessionStore(48).shardCount() == 64);
+        REQUIRE(ShardedSessionStore(0).shardCount() == 1);
+    }
+
+    SECTION("シングルスレッドでは SessionStore と同じ結果") {
+        ShardedSessionStore store(8);
+        REQUIRE(store.addLot(1, pricing) == true);
+        REQUIRE(store.addLot(SessionStore::kMaxLots, pricing) == false);
+        REQUIRE(store.entry(1001, 1, jst(1, 5, 12, 0)) == true);
+        REQUIRE(store.entry(1001, 1, jst(1, 5, 12, 0)) == false);
+        REQUIRE(store.entry(1002, 2, jst(1, 5, 12, 0)) == false);
+
+        OpenSession open;
+        REQUIRE(store.find(1001, open) == true);
+        REQUIRE(open.entryTime == jst(1, 5, 12, 0));
+        ClosedSession closed;
+        REQUIRE(store.exit(1001, jst(1, 6, 15, 0), closed) == true);
+        REQUIRE(closed.fee == 5000);
+        REQUIRE(store.size() == 0);
+    }
+
+    SECTION("複数のゲートから同時に入出庫しても取りこぼさない") {
+        const int threadCount = 8;
+        const std::uint64_t perThread = 20000;
+        ShardedSessionStore store(16, threadCount * perThread);
+        REQUIRE(store.addLot(0, pricing) == true);
+
+        std::atomic<std::int64_t> totalFee{0};
+        std::atomic<int> failures{0};
+        std::vector<std::thread> gates;
+        for (int t = 0; t < threadCount; ++t) {
+            gates.emplace_back([&, t] {
+                std::uint64_t first = static_cast<std::uint64_t>(t) * perThread + 1;
+                for (std::uint64_t id = first; id < first + perThread; ++id) {
+                    if (!store.entry(id, 0, jst(1, 10, 10, 0))) {
+                        ++failures;
+                    }
+                }
+                // 半分だけ出庫する
+                ClosedSession closed;
+                for (std::uint64_t id = first; id < first + perThread; id += 2) {
+                    if (!store.exit(id, jst(1, 10, 11, 0), closed)) {
+                        ++failures;
+                    }
+                    totalFee += closed.fee;
+                }
+            });
+        }
+        for (std::thread& gate : gates) {
+            gate.join();
+        }
+
+        REQUIRE(failures == 0);
+        REQUIRE(store.size() == threadCount * perThread / 2);
+        REQUIRE(totalFee == 500LL * threadCount * perThread / 2);
+    }
+
+    SECTION("同じ駐車券の同時入庫は1つだけ成功する") {
+        ShardedSessionStore store(4);
+        REQUIRE(store.addLot(0, pricing) == true);
+        std::atomic<int> accepted{0};
+        std::vector<std::thread> gates;
+        for (int t = 0; t < 8; ++t) {
+            gates.emplace_back([&] {
+                for (std::uint64_t id = 1; id <= 1000; ++id) {
+                    if (store.entry(id, 0, jst(1, 10, 10, 0))) {
+                        ++accepted;
+                    }
+                }
+            });
+        }
+        for (std::thread& gate : gates) {
+            gate.join();
+        }
+        REQUIRE(accepted == 1000);
+        REQUIRE(store.size() == 1000);
+    }
+}
@@ -0,0 +1,125 @@
+// 入庫・出庫時刻による料金計算のテスト
+#include "catch.hpp"
+#include "../src/stay_pricing.hpp"
+
+namespace {
+
+// 2024-01-05（金）の現地時刻をエポック秒に変換
+std::int64_t jst(int month, int day, int hour, int minute, int second = 0) {
+    return epochFromLocal(2024, month, day, hour, minute) + second;
+}
+
+// 全ての日を休日とするカレンダー
+class AllHolidayCalendar : public DayCalendar {
+public:
+    DayKind classify(std::int64_t) const override { return DayKind::Holiday; }
+};
+
+} // namespace
+
+TEST_CASE("入庫・出庫時刻による料金計算", "[stay]") {
+    StayPricingEngine engine(kDefaultDayTariffs);
+
+    SECTION("金曜日12時から土曜日15時まで（日中・夜間・平日・休日の区間に分かれる）") {
+        StayQuote quote;
+        REQUIRE(engine.quote(jst(1, 5, 12, 0), jst(1, 6, 15, 0), quote) == true);
+
+        REQUIRE(quote.segments.size() == 4);
+        // 金曜日の日中 12:00-18:01（361分）→ 最大料金1500円
+        REQUIRE(quote.segments[0].dayKind == DayKind::Weekday);
+        REQUIRE(quote.segments[0].band == TimeBand::Daytime);
+        REQUIRE(quote.segments[0].minutes == 361);
+        REQUIRE(quote.segments[0].fee == 1500);
+        // 金曜日の夜間 18:01-24:00（359分）→ 最大料金1000円
+        REQUIRE(quote.segments[1].dayKind == DayKind::Weekday);
+        REQUIRE(quote.segments[1].band == TimeBand::Nighttime);
+        REQUIRE(quote.segments[1].minutes == 359);
+        REQUIRE(quote.segments[1].fee == 1000);
+        // 土曜日の夜間 00:00-08:00（480分）→ 休日の夜間最大料金1000円
+        REQUIRE(quote.segments[2].dayKind == DayKind::Holiday);
+        REQUIRE(quote.segments[2].band == TimeBand::Nighttime);
+        REQUIRE(quote.segments[2].minutes == 480);
+        REQUIRE(quote.segments[2].fee == 1000);
+        // 土曜日の日中 08:00-15:00（420分）→ 休日の最大料金1500円
+        REQUIRE(quote.segments[3].dayKind == DayKind::Holiday);
+        REQUIRE(quote.segments[3].band == TimeBand::Daytime);
+        REQUIRE(quote.segments[3].minutes == 420);
+        REQUIRE(quote.segments[3].fee == 1500);
+
+        REQUIRE(quote.totalFee == 5000);
+        REQUIRE(quote.segments.front().startTime == jst(1, 5, 12, 0));
+        REQUIRE(quote.segments[1].startTime == jst(1, 5, 18, 1));
+        REQUIRE(quote.segments.back().endTime == jst(1, 6, 15, 0));
+    }
+
+    SECTION("日中のみの駐車は1区間") {
+        StayQuote quote;
+        REQUIRE(engine.quote(jst(1, 10, 10, 0), jst(1, 10, 11, 0), quote) == true);
+        REQUIRE(quote.segments.size() == 1);
+        REQUIRE(quote.totalFee == 500);
+    }
+
+    SECTION("平日の夜間が日付をまたぐ場合は1区間として最大料金を適用") {
+        StayQuote quote;
+        // 火曜日20:00から水曜日07:00（660分）
+        REQUIRE(engine.quote(jst(1, 9, 20, 0), jst(1, 10, 7, 0), quote) == true);
+        REQUIRE(quote.segments.size() == 1);
+        REQUIRE(quote.segments[0].minutes == 660);
+        REQUIRE(quote.totalFee == 1000);
+    }
+
+    SECTION("18:00ちょうどの1分間は日中") {
+        StayQuote quote;
+        REQUIRE(engine.quote(jst(1, 10, 18, 0), jst(1, 10, 18, 1), quote) == true);
+        REQUIRE(quote.segments.size() == 1);
+        REQUIRE(quote.segments[0].band == TimeBand::Daytime);
+        REQUIRE(quote.totalFee == 500);
+    }
+
+    SECTION("秒は入庫を切り捨て、出庫を切り上げる") {
+        StayQuote quote;
+        // 10:00:30 から 11:00:10 → 10:00 から 11:01 の61分
+        REQUIRE(engine.quote(jst(1, 10, 10, 0, 30), jst(1, 10, 11, 0, 10), quote) == true);
+        REQUIRE(quote.segments[0].minutes == 61);
+        REQUIRE(quote.totalFee == 1000);
+    }
+
+    SECTION("入庫と出庫が同時なら0円、出庫が前ならエラー") {
+        StayQuote quote;
+        REQUIRE(engine.quote(jst(1, 10, 10, 0), jst(1, 10, 10, 0), quote) == true);
+        REQUIRE(quote.segments.empty());
+        REQUIRE(quote.totalFee == 0);
+
+        REQUIRE(engine.quote(jst(1, 10, 10, 0), jst(1, 10, 9, 0), quote) == false);
+        std::int64_t total = 0;
+        REQUIRE(engine.quoteTotal(jst(1, 10, 10, 0), jst(1, 10, 9, 0), total) == false);
+    }
+
+    SECTION("4週間の駐車は境界ごとの区間の合計") {
+        StayQuote quote;
+        REQUIRE(engine.quote(jst(1, 1, 0, 0), jst(1, 29, 0, 0), quote) == true);
+
+        // 1日あたり日中1区間、夜間は休日と平日の切り替わりでのみ分かれる
+        std::int64_t sum = 0;
+        for (const StaySegment& segment : quote.segments) {
+            sum += segment.fee;
+        }
+        REQUIRE(quote.totalFee == sum);
+        REQUIRE(quote.segments.size() > 28 * 2);
+        REQUIRE(quote.segments.size() <= 28 * 3);
+
+        std::int64_t total = 0;
+        REQUIRE(engine.quoteTotal(jst(1, 1, 0, 0), jst(1, 29, 0, 0), total) == true);
+        REQUIRE(total == quote.totalFee);
+    }
+
+    SECTION("カレンダーを差し替えられる") {
+        AllHolidayCalendar calendar;
+        StayPricingEngine holidayEngine(kDefaultDayTariffs, calendar);
+        StayQuote quote;
+        // 水曜日でも休日料金（30分500円）
+        REQUIRE(holidayEngine.quote(jst(1, 10, 10, 0), jst(1, 10, 11, 0), quote) == true);
+        REQUIRE(quote.segments[0].dayKind == DayKind::Holiday);
+        REQUIRE(quote.totalFee == 1000);
+    }
+}
@@ -0,0 +1,162 @@
+// RCUによる料金体系の公開のテスト
+#include "catch.hpp"
+#include "../src/tariff_registry.hpp"
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <vector>
+
+namespace {
+
+// バージョン v の料金設定（日中・夜間とも60分 v 円、最大料金なし）
+ParkingRateConfig versionedConfig(int v) {
+    return ParkingRateConfig{60, v, 0, 0, 60, v, 0, 0};
+}
+
+// 破棄された数を数える値
+struct Tracked {
+    explicit Tracked(std::atomic<int>& counter) : destroyed(counter) {}
+    ~Tracked() { ++destroyed; }
+    std::atomic<int>& destroyed;
+};
+
+} // namespace
+
+TEST_CASE("RCUによる値の公開", "[rcu]") {
+    SECTION("古い値は読み取り区間が終わるまで破棄されない") {
+        std::atomic<int> destroyed(0);
+        RcuCell<Tracked> cell(std::make_unique<const Tracked>(destroyed));
+
+        std::atomic<bool> reading(false);
+        std::atomic<bool> release(false);
+        std::thread reader([&]() {
+            RcuReadGuard guard;
+            const Tracked* value = cell.read();
+            reading.store(true);
+            while (!release.load()) {
+                std::this_thread::yield();
+            }
+            // 区間内なので差し替え後も参照できる
+            (void)value->destroyed.load();
+        });
+        while (!reading.load()) {
+            std::this_thread::yield();
+        }
+
+        std::atomic<bool> published(false);
+        std::thread writer([&]() {
+            cell.publish(std::make_unique<const Tracked>(destroyed));
+            published.store(true);
+        });
+
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+        REQUIRE(published.load() == false);
+        REQUIRE(destroyed.load() == 0);
+
+        release.store(true);
+        reader.join();
+        writer.join();
+        REQUIRE(published.load() == true);
+        REQUIRE(destroyed.load() == 1);
+    }
+
+    SECTION("読み取り区間は入れ子にできる") {
+        std::atomic<int> destroyed(0);
+        RcuCell<Tracked> cell(std::make_unique<const Tracked>(destroyed));
+        {
+            RcuReadGuard outer;
+            {
+                RcuReadGuard inner;
+                REQUIRE(cell.read() != nullptr);
+            }
+            REQUIRE(cell.read() != nullptr);
+        }
+        cell.publish(std::make_unique<const Tracked>(destroyed));
+        REQUIRE(destroyed.load() == 1);
+    }
+}
+
+TEST_CASE("料金体系のレジストリ", "[registry]") {
+    SECTION("公開・置き換え・削除") {
+        TariffRegistry registry;
+        int fee = 0;
+        REQUIRE(registry.calculateFee("weekday", 60, 10, 0, fee) == false);
+
+        registry.publishAll({{"weekday", makeRateConfig(kWeekdayTariff)}, {"holiday", makeRateConfig(kHolidayTariff)}});
+        REQUIRE(registry.version() == 1);
+        REQUIRE(registry.calculateFee("weekday", 60, 10, 0, fee) == true);
+        REQUIRE(fee == 500);
+        REQUIRE(registry.calculateFee("holiday", 60, 10, 0, fee) == true);
+        REQUIRE(fee == 1000);
+
+        registry.publish("weekday", versionedConfig(700));
+        REQUIRE(registry.calculateFee("weekday", 60, 10, 0, fee) == true);
+        REQUIRE(fee == 700);
+
+        REQUIRE(registry.remove("holiday") == true);
+        REQUIRE(registry.remove("holiday") == false);
+        REQUIRE(registry.calculateFee("holiday", 60, 10, 0, fee) == false);
+        REQUIRE(registry.read([](const TariffRegistry::Snapshot& snapshot) { return snapshot.tariffs.size(); }) == 1);
+    }
+
+    SECTION("複数の読み取りスレッドと更新し続ける書き込みスレッド") {
+        TariffRegistry registry(600);
+        registry.publish("weekday", versionedConfig(1));
+
+        const int readerCount = 4;
+        const int updates = 300;
+        std::atomic<bool> stop(false);
+        std::atomic<long> reads(0);
+        std::atomic<long> errors(0);
+
+        std::vector<std::thread> readers;
+        for (int r = 0; r < readerCount; ++r) {
+            readers.emplace_back([&]() {
+                std::uint64_t lastVersion = 0;
+                int lastPrice = 0;
+                while (!stop.load(std::memory_order_relaxed)) {
+                    bool consistent = registry.read([&](const TariffRegistry::Snapshot& snapshot) {
+                        const CompiledTariff* tariff = snapshot.find("weekday");
+                        if (!tariff || snapshot.version < lastVersion) {
+                            return false;
+                        }
+                        // 1つのスナップショット内では設定と料金表が必ず一致する
+                        int price = tariff->config().unitPrice;
+                        bool ok = tariff->config().nightUnitPrice == price &&
+                                  tariff->daytimeFee(60) == price &&
+                                  tariff->nighttimeFee(599) == price * 10 &&
+                                  price >= lastPrice;
+                        lastVersion = snapshot.version;
+                        lastPrice = price;
+                        return ok;
+                    });
+                    if (!consistent) {
+                        ++errors;
+                    }
+                    ++reads;
+                }
+            });
+        }
+
+        // 読み取りが始まってから更新する
+        while (reads.load() == 0) {
+            std::this_thread::yield();
+        }
+        for (int v = 2; v <= updates; ++v) {
+            registry.publish("weekday", versionedConfig(v));
+            if (v % 2 == 0) {
+                registry.publish("other", versionedConfig(v));
+            }
+        }
+        stop.store(true);
+        for (std::thread& reader : readers) {
+            reader.join();
+        }
+
+        REQUIRE(errors.load() == 0);
+        REQUIRE(reads.load() > 0);
+        int fee = 0;
+        REQUIRE(registry.calculateFee("weekday", 60, 10, 0, fee) == true);
+        REQUIRE(fee == updates);
+    }
+}
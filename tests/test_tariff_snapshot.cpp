@@ -0,0 +1,172 @@
+// 料金体系のスナップショットファイルと CRC-32C のテスト
+#include "catch.hpp"
+#include "../src/tariff_snapshot.hpp"
+#include "../src/crc32c.hpp"
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace {
+
+const char* kSnapshotPath = "/tmp/test_tariff_snapshot.bin";
+
+std::vector<char> readFile(const char* path) {
+    std::ifstream in(path, std::ios::binary);
+    return std::vector<char>(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+}
+
+void writeFile(const char* path, const std::vector<char>& bytes) {
+    std::ofstream out(path, std::ios::binary | std::ios::trunc);
+    out.write(bytes.data(), static_cast<std::streamsize>(bytes.size()));
+}
+
+RateConfigList sampleConfigs() {
+    return RateConfigList{
+        {"weekday", {60, 500, 720, 1500, 60, 300, 720, 1000}},
+        {"holiday", {30, 500, 360, 1500, 60, 300, 360, 1000}},
+        {"event", {15, 200, 0, 0, 30, 100, 0, 0}},
+    };
+}
+
+} // namespace
+
+TEST_CASE("CRC-32C", "[crc32c]") {
+    SECTION("既知の値") {
+        REQUIRE(crc32c("123456789", 9) == 0xE3069283u);
+        REQUIRE(crc32c("", 0) == 0u);
+    }
+
+    SECTION("続きから計算でき、命令の有無によらず同じ結果になる") {
+        std::mt19937 random(3);
+        std::vector<unsigned char> data(4096);
+        for (unsigned char& byte : data) {
+            byte = static_cast<unsigned char>(random());
+        }
+        for (std::size_t size = 0; size < 200; ++size) {
+            REQUIRE(crc32c(data.data() + size % 8, size) == crc32cPortable(data.data() + size % 8, size));
+        }
+        std::uint32_t whole = crc32c(data.data(), data.size());
+        REQUIRE(crc32c(data.data() + 1000, data.size() - 1000, crc32c(data.data(), 1000)) == whole);
+    }
+}
+
+TEST_CASE("料金体系のスナップショット", "[snapshot]") {
+    std::remove(kSnapshotPath);
+
+    SECTION("mmap した料金表で CompiledTariff と同じ料金を計算する") {
+        const int horizon = 2 * 24 * 60;
+        REQUIRE(writeTariffSnapshot(kSnapshotPath, sampleConfigs(), horizon) == true);
+
+        MappedTariffSnapshot snapshot;
+        REQUIRE(snapshot.open(kSnapshotPath) == true);
+        REQUIRE(snapshot.size() == 3);
+        REQUIRE(snapshot.horizonMinutes() == horizon);
+
+        for (const auto& entry : sampleConfigs()) {
+            CompiledTariff compiled(entry.second, horizon);
+            MappedTariffSnapshot::View view;
+            REQUIRE(snapshot.find(entry.first, view) == true);
+            REQUIRE(std::string(view.type()) == entry.first);
+            REQUIRE(view.config().unitMinutes == entry.second.unitMinutes);
+            // 表の範囲外は料金カーネルで計算する
+            for (int minutes = -5; minutes <= horizon + 200; ++minutes) {
+                REQUIRE(view.daytimeFee(minutes) == compiled.daytimeFee(minutes));
+                REQUIRE(view.nighttimeFee(minutes) == compiled.nighttimeFee(minutes));
+            }
+        }
+
+        int fee = 0;
+        REQUIRE(snapshot.calculateFee("weekday", 60, 10, 0, fee) == true);
+        REQUIRE(fee == 500);
+        REQUIRE(snapshot.calculateFee("weekday", 60, 20, 0, fee) == true);
+        REQUIRE(fee == 300);
+        REQUIRE(snapshot.calculateFee("missing", 60, 10, 0, fee) == false);
+        REQUIRE(snapshot.calculateFee("a_type_name_that_is_longer_than_thirty_one", 60, 10, 0, fee) == false);
+
+        // 種別名の順に並んでいる
+        RateConfigList configs = snapshot.configs();
+        REQUIRE(configs.size() == 3);
+        REQUIRE(configs[0].first == "event");
+        REQUIRE(configs[2].first == "weekday");
+    }
+
+    SECTION("リポジトリから書き出し、別のリポジトリに取り込める") {
+        const char* sourceDb = "/tmp/test_tariff_snapshot_source.db";
+        const char* targetDb = "/tmp/test_tariff_snapshot_target.db";
+        std::remove(sourceDb);
+        std::remove(targetDb);
+
+        auto source = createSQLiteRepository(sourceDb);
+        REQUIRE(source->saveBatch(sampleConfigs()) == true);
+        REQUIRE(writeTariffSnapshot(kSnapshotPath, *source) == true);
+
+        MappedTariffSnapshot snapshot;
+        REQUIRE(snapshot.open(kSnapshotPath) == true);
+        REQUIRE(snapshot.horizonMinutes() == CompiledTariff::kDefaultHorizonMinutes);
+        auto target = createSQLiteRepository(targetDb);
+        REQUIRE(importTariffSnapshot(snapshot, *target) == true);
+
+        ParkingRateConfig loaded;
+        REQUIRE(target->load("holiday", loaded) == true);
+        REQUIRE(loaded.unitMinutes == 30);
+        REQUIRE(loaded.nightMaxMinutes == 360);
+
+        std::remove(sourceDb);
+        std::remove(targetDb);
+    }
+
+    SECTION("壊れたファイルは開かない") {
+        REQUIRE(writeTariffSnapshot(kSnapshotPath, sampleConfigs(), 120) == true);
+        std::vector<char> original = readFile(kSnapshotPath);
+
+        // 料金表の1バイトが壊れた場合は CRC で検出する（検査を省けば開ける）
+        std::vector<char> corrupted = original;
+        corrupted[corrupted.size() - 10] ^= 0x01;
+        writeFile(kSnapshotPath, corrupted);
+        MappedTariffSnapshot snapshot;
+        REQUIRE(snapshot.open(kSnapshotPath) == false);
+        REQUIRE(snapshot.isOpen() == false);
+        REQUIRE(snapshot.open(kSnapshotPath, false) == true);
+        snapshot.close();
+
+        // ヘッダーの破損は検査を省いても検出する
+        corrupted = original;
+        corrupted[40] ^= 0x01;
+        writeFile(kSnapshotPath, corrupted);
+        REQUIRE(snapshot.open(kSnapshotPath, false) == false);
+
+        // 途中で切れたファイル
+        corrupted.assign(original.begin(), original.end() - 4);
+        writeFile(kSnapshotPath, corrupted);
+        REQUIRE(snapshot.open(kSnapshotPath, false) == false);
+
+        writeFile(kSnapshotPath, original);
+        REQUIRE(snapshot.open(kSnapshotPath) == true);
+    }
+
+    SECTION("書き出せない種別があれば既存のファイルを残す") {
+        REQUIRE(writeTariffSnapshot(kSnapshotPath, sampleConfigs(), 60) == true);
+        RateConfigList invalid = sampleConfigs();
+        invalid.emplace_back(std::string(kTariffSnapshotMaxTypeLength + 1, 'x'), invalid[0].second);
+        REQUIRE(writeTariffSnapshot(kSnapshotPath, invalid, 60) == false);
+
+        MappedTariffSnapshot snapshot;
+        REQUIRE(snapshot.open(kSnapshotPath) == true);
+        REQUIRE(snapshot.size() == 3);
+    }
+
+    SECTION("料金設定が空でも書き出せる") {
+        REQUIRE(writeTariffSnapshot(kSnapshotPath, RateConfigList(), 60) == true);
+        MappedTariffSnapshot snapshot;
+        REQUIRE(snapshot.open(kSnapshotPath) == true);
+        REQUIRE(snapshot.size() == 0);
+        int fee = 0;
+        REQUIRE(snapshot.calculateFee("weekday", 60, 10, 0, fee) == false);
+    }
+
+    std::remove(kSnapshotPath);
+}
@@ -2,8 +2,26 @@
 #include "catch.hpp"
 #include "../src/parking_lot.hpp"
 #include "../src/parking_rate_repository.hpp"
+#include "../src/compiled_tariff.hpp"
+#include "../src/caching_rate_repository.hpp"
+#include "../src/pooled_rate_repository.hpp"
+#include "../src/async_rate_repository.hpp"
+#include <sqlite3.h>
+#include <dirent.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <atomic>
 #include <cstdio>
 #include <cstring>
+#include <cmath>
+#include <limits>
+#include <condition_variable>
+#include <map>
+#include <mutex>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
 
 TEST_CASE("ユニットテスト: calculateBaseFee", "[unit]") {
     SECTION("基本料金計算のテスト") {
@@ -264,6 +282,722 @@ TEST_CASE("ユニットテスト: ParkingRateRepository", "[unit]") {
     }
 }
 
+TEST_CASE("ユニットテスト: 準備済みステートメントの再利用", "[unit]") {
+    SECTION("同じリポジトリで保存・読み込み・存在確認を繰り返せる") {
+        const char* testDb = "/tmp/test_unit_repo_stmt.db";
+        std::remove(testDb);
+
+        auto repo = createSQLiteRepository(testDb);
+
+        for (int i = 0; i < 100; ++i) {
+            ParkingRateConfig config = {60, 500 + i, 720, 1500, 60, 300, 720, 1000};
+            std::string type = "type" + std::to_string(i % 10);
+            REQUIRE(repo->save(type, config) == true);
+
+            ParkingRateConfig loaded;
+            REQUIRE(repo->load(type, loaded) == true);
+            REQUIRE(loaded.unitPrice == 500 + i);
+
+            // 見つからない場合の後も次の呼び出しに影響しない
+            REQUIRE(repo->load("missing", loaded) == false);
+            REQUIRE(repo->exists("missing") == false);
+            REQUIRE(repo->exists(type) == true);
+        }
+
+        std::remove(testDb);
+    }
+
+    SECTION("DBを開けない場合は全ての操作が失敗する") {
+        auto repo = createSQLiteRepository("/nonexistent_dir/test.db");
+        ParkingRateConfig config = {60, 500, 720, 1500, 60, 300, 720, 1000};
+        REQUIRE(repo->save("weekday", config) == false);
+        REQUIRE(repo->load("weekday", config) == false);
+        REQUIRE(repo->exists("weekday") == false);
+    }
+}
+
+TEST_CASE("ユニットテスト: 料金設定のキャッシュ", "[unit][cache]") {
+    const char* testDb = "/tmp/test_unit_cache.db";
+    std::remove(testDb);
+
+    ParkingRateConfig weekday = {60, 500, 720, 1500, 60, 300, 720, 1000};
+    ParkingRateConfig updated = {60, 600, 720, 1800, 60, 300, 720, 1000};
+
+    SECTION("他の接続の変更でdata_versionが変わる") {
+        auto repo = createSQLiteRepository(testDb);
+        auto other = createSQLiteRepository(testDb);
+
+        std::uint64_t before = 0, after = 0;
+        REQUIRE(repo->dataVersion(before) == true);
+        // 自分の変更では変わらない
+        REQUIRE(repo->save("weekday", weekday) == true);
+        REQUIRE(repo->dataVersion(after) == true);
+        REQUIRE(after == before);
+        // 他の接続の変更で変わる
+        REQUIRE(other->save("weekday", updated) == true);
+        REQUIRE(repo->dataVersion(after) == true);
+        REQUIRE(after != before);
+    }
+
+    SECTION("他の接続の変更は確認間隔の経過後に見える") {
+        auto writer = createSQLiteRepository(testDb);
+        REQUIRE(writer->save("weekday", weekday) == true);
+
+        auto cached = createCachingRepository(createSQLiteRepository(testDb), std::chrono::milliseconds(50));
+        ParkingRateConfig loaded;
+        REQUIRE(cached->load("weekday", loaded) == true);
+        REQUIRE(loaded.unitPrice == 500);
+        REQUIRE(cached->exists("holiday") == false);
+
+        REQUIRE(writer->save("weekday", updated) == true);
+        REQUIRE(writer->save("holiday", weekday) == true);
+
+        // 確認間隔内はキャッシュから返す
+        REQUIRE(cached->load("weekday", loaded) == true);
+        REQUIRE(loaded.unitPrice == 500);
+        REQUIRE(cached->exists("holiday") == false);
+
+        std::this_thread::sleep_for(std::chrono::milliseconds(60));
+        REQUIRE(cached->load("weekday", loaded) == true);
+        REQUIRE(loaded.unitPrice == 600);
+        REQUIRE(cached->exists("holiday") == true);
+    }
+
+    SECTION("自分の保存はすぐに見える") {
+        auto cached = createCachingRepository(createSQLiteRepository(testDb), std::chrono::hours(1));
+        REQUIRE(cached->exists("weekday") == false);
+        REQUIRE(cached->save("weekday", weekday) == true);
+        REQUIRE(cached->exists("weekday") == true);
+
+        REQUIRE(cached->save("weekday", updated) == true);
+        ParkingRateConfig loaded;
+        REQUIRE(cached->load("weekday", loaded) == true);
+        REQUIRE(loaded.maxFee == 1800);
+
+        // 書き込みは下のリポジトリにも反映されている
+        auto direct = createSQLiteRepository(testDb);
+        REQUIRE(direct->load("weekday", loaded) == true);
+        REQUIRE(loaded.maxFee == 1800);
+    }
+
+    std::remove(testDb);
+}
+
+TEST_CASE("ユニットテスト: 料金設定の一括保存・読み込み", "[unit][batch]") {
+    const char* testDb = "/tmp/test_unit_repo_batch.db";
+    std::remove(testDb);
+
+    RateConfigList configs;
+    for (int i = 0; i < 200; ++i) {
+        ParkingRateConfig config = {60, 100 + i, 720, 1500, 60, 300, 720, 1000};
+        configs.emplace_back("type" + std::to_string(1000 + i), config);
+    }
+
+    SECTION("一括保存した内容を種別の順に全件読み込める") {
+        auto repo = createSQLiteRepository(testDb);
+        REQUIRE(repo->saveBatch(configs) == true);
+
+        RateConfigList loaded;
+        REQUIRE(repo->loadAll(loaded) == true);
+        REQUIRE(loaded.size() == configs.size());
+        for (std::size_t i = 0; i < configs.size(); ++i) {
+            REQUIRE(loaded[i].first == configs[i].first);
+            REQUIRE(loaded[i].second.unitPrice == configs[i].second.unitPrice);
+        }
+
+        // 空の一括保存も成功する
+        REQUIRE(repo->saveBatch(RateConfigList()) == true);
+    }
+
+    SECTION("指定した種別のうち存在するものだけを返す") {
+        auto repo = createSQLiteRepository(testDb);
+        REQUIRE(repo->saveBatch(configs) == true);
+
+        RateConfigList loaded;
+        REQUIRE(repo->loadMany({"type1005", "missing", "type1199"}, loaded) == true);
+        REQUIRE(loaded.size() == 2);
+        REQUIRE(loaded[0].first == "type1005");
+        REQUIRE(loaded[0].second.unitPrice == 105);
+        REQUIRE(loaded[1].first == "type1199");
+        REQUIRE(loaded[1].second.unitPrice == 299);
+    }
+
+    SECTION("書き込みロックを取れない場合は何も保存しない") {
+        auto repo = createSQLiteRepository(testDb);
+        sqlite3* other = nullptr;
+        REQUIRE(sqlite3_open(testDb, &other) == SQLITE_OK);
+        REQUIRE(sqlite3_exec(other, "BEGIN IMMEDIATE;", nullptr, nullptr, nullptr) == SQLITE_OK);
+
+        REQUIRE(repo->saveBatch(configs) == false);
+
+        sqlite3_exec(other, "ROLLBACK;", nullptr, nullptr, nullptr);
+        sqlite3_close(other);
+
+        RateConfigList loaded;
+        REQUIRE(repo->loadAll(loaded) == true);
+        REQUIRE(loaded.empty());
+        // 失敗後も通常の操作を続けられる
+        REQUIRE(repo->saveBatch(configs) == true);
+    }
+
+    SECTION("キャッシュ経由の一括操作") {
+        auto cached = createCachingRepository(createSQLiteRepository(testDb), std::chrono::hours(1));
+        REQUIRE(cached->exists("type1000") == false);
+        REQUIRE(cached->saveBatch(configs) == true);
+        REQUIRE(cached->exists("type1000") == true);
+
+        RateConfigList loaded;
+        REQUIRE(cached->loadMany({"type1000", "missing"}, loaded) == true);
+        REQUIRE(loaded.size() == 1);
+        REQUIRE(loaded[0].second.unitPrice == 100);
+
+        REQUIRE(cached->loadAll(loaded) == true);
+        REQUIRE(loaded.size() == configs.size());
+    }
+
+    SECTION("既定の実装は1件ずつの操作に委ねる") {
+        auto repo = createSQLiteRepository(testDb);
+        REQUIRE(repo->saveBatch(configs) == true);
+
+        RateConfigList loaded;
+        REQUIRE(repo->ParkingRateRepository::loadMany({"type1001", "missing"}, loaded) == true);
+        REQUIRE(loaded.size() == 1);
+        REQUIRE(loaded[0].second.unitPrice == 101);
+        REQUIRE(repo->ParkingRateRepository::loadAll(loaded) == false);
+    }
+
+    std::remove(testDb);
+}
+
+TEST_CASE("ユニットテスト: SQLiteの接続設定", "[unit][sqlite]") {
+    const char* testDb = "/tmp/test_unit_repo_options.db";
+    std::remove(testDb);
+    std::remove("/tmp/test_unit_repo_options.db-wal");
+    std::remove("/tmp/test_unit_repo_options.db-shm");
+
+    ParkingRateConfig weekday = {60, 500, 720, 1500, 60, 300, 720, 1000};
+    ParkingRateConfig updated = {60, 600, 720, 1800, 60, 300, 720, 1000};
+
+    // 別の接続でPRAGMAの値を読む
+    auto pragmaText = [&](const char* sql) {
+        sqlite3* db = nullptr;
+        sqlite3_open(testDb, &db);
+        sqlite3_stmt* stmt = nullptr;
+        std::string value;
+        if (sqlite3_prepare_v2(db, sql, -1, &stmt, nullptr) == SQLITE_OK && sqlite3_step(stmt) == SQLITE_ROW) {
+            value = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 0));
+        }
+        sqlite3_finalize(stmt);
+        sqlite3_close(db);
+        return value;
+    };
+
+    SECTION("本番向け設定ではWALになり、既定の設定で開いても維持される") {
+        auto repo = createSQLiteRepository(testDb, SQLiteRepositoryOptions::production());
+        REQUIRE(repo->save("weekday", weekday) == true);
+        REQUIRE(pragmaText("PRAGMA journal_mode;") == "wal");
+
+        auto plain = createSQLiteRepository(testDb);
+        ParkingRateConfig loaded;
+        REQUIRE(plain->load("weekday", loaded) == true);
+        REQUIRE(pragmaText("PRAGMA journal_mode;") == "wal");
+    }
+
+    SECTION("WALでは書き込み中のトランザクションがあっても読み取れる") {
+        auto repo = createSQLiteRepository(testDb, SQLiteRepositoryOptions::production());
+        REQUIRE(repo->save("weekday", weekday) == true);
+
+        sqlite3* writer = nullptr;
+        REQUIRE(sqlite3_open(testDb, &writer) == SQLITE_OK);
+        REQUIRE(sqlite3_exec(writer, "BEGIN IMMEDIATE;"
+                             "UPDATE parking_rates SET unit_price = 600 WHERE type = 'weekday';",
+                             nullptr, nullptr, nullptr) == SQLITE_OK);
+
+        // 未コミットの変更は見えず、待たされることもない
+        ParkingRateConfig loaded;
+        REQUIRE(repo->load("weekday", loaded) == true);
+        REQUIRE(loaded.unitPrice == 500);
+
+        REQUIRE(sqlite3_exec(writer, "COMMIT;", nullptr, nullptr, nullptr) == SQLITE_OK);
+        sqlite3_close(writer);
+        REQUIRE(repo->load("weekday", loaded) == true);
+        REQUIRE(loaded.unitPrice == 600);
+    }
+
+    SECTION("ロック待ちの上限まで他の書き込みの完了を待つ") {
+        SQLiteRepositoryOptions options = SQLiteRepositoryOptions::production();
+        options.busyTimeoutMs = 2000;
+        auto repo = createSQLiteRepository(testDb, options);
+        REQUIRE(repo->save("weekday", weekday) == true);
+
+        sqlite3* writer = nullptr;
+        REQUIRE(sqlite3_open(testDb, &writer) == SQLITE_OK);
+        REQUIRE(sqlite3_exec(writer, "BEGIN IMMEDIATE;", nullptr, nullptr, nullptr) == SQLITE_OK);
+        std::thread release([writer]() {
+            std::this_thread::sleep_for(std::chrono::milliseconds(50));
+            sqlite3_exec(writer, "COMMIT;", nullptr, nullptr, nullptr);
+        });
+
+        REQUIRE(repo->save("weekday", updated) == true);
+        release.join();
+        sqlite3_close(writer);
+
+        ParkingRateConfig loaded;
+        REQUIRE(repo->load("weekday", loaded) == true);
+        REQUIRE(loaded.unitPrice == 600);
+    }
+
+    SECTION("同期レベルとキャッシュサイズを指定できる") {
+        SQLiteRepositoryOptions options;
+        options.journalMode = SQLiteJournalMode::Truncate;
+        options.synchronous = SQLiteSynchronous::Off;
+        options.cacheSize = 100;
+        auto repo = createSQLiteRepository(testDb, options);
+        REQUIRE(repo->saveBatch({{"weekday", weekday}, {"holiday", updated}}) == true);
+        REQUIRE(repo->exists("holiday") == true);
+    }
+
+    std::remove(testDb);
+    std::remove("/tmp/test_unit_repo_options.db-wal");
+    std::remove("/tmp/test_unit_repo_options.db-shm");
+}
+
+namespace {
+
+// 開いているファイル記述子の数（SQLiteの接続が閉じたかを見る）
+std::size_t openFileCount() {
+    std::size_t count = 0;
+    if (DIR* dir = opendir("/proc/self/fd")) {
+        while (readdir(dir)) {
+            ++count;
+        }
+        closedir(dir);
+    }
+    return count;
+}
+
+} // namespace
+
+TEST_CASE("ユニットテスト: スレッドごとの接続を使うリポジトリ", "[unit][pool]") {
+    const char* testDb = "/tmp/test_unit_repo_pool.db";
+    auto removeDb = [&]() {
+        std::remove(testDb);
+        std::remove("/tmp/test_unit_repo_pool.db-wal");
+        std::remove("/tmp/test_unit_repo_pool.db-shm");
+    };
+    removeDb();
+
+    ParkingRateConfig weekday = {60, 500, 720, 1500, 60, 300, 720, 1000};
+
+    SECTION("書き込みはすぐに他のスレッドの読み込みに見える") {
+        auto repo = createPooledSQLiteRepository(testDb);
+        REQUIRE(repo->exists("weekday") == false);
+        REQUIRE(repo->save("weekday", weekday) == true);
+        REQUIRE(repo->exists("weekday") == true);
+
+        bool found = false;
+        ParkingRateConfig loaded{};
+        std::thread other([&]() { found = repo->load("weekday", loaded); });
+        other.join();
+        REQUIRE(found == true);
+        REQUIRE(loaded.unitPrice == 500);
+
+        // 自分の書き込みではバージョンは変わらない
+        std::uint64_t before = 0, after = 0;
+        REQUIRE(repo->dataVersion(before) == true);
+        REQUIRE(repo->saveBatch({{"holiday", weekday}}) == true);
+        REQUIRE(repo->dataVersion(after) == true);
+        REQUIRE(after == before);
+    }
+
+    SECTION("複数の読み込みスレッドと書き込みスレッドが同時に動く") {
+        auto repo = createPooledSQLiteRepository(testDb);
+        RateConfigList configs;
+        for (int i = 0; i < 20; ++i) {
+            configs.emplace_back("type" + std::to_string(i), weekday);
+        }
+        REQUIRE(repo->saveBatch(configs) == true);
+
+        std::atomic<bool> stop(false);
+        std::atomic<long> reads(0);
+        std::atomic<long> errors(0);
+        std::vector<std::thread> readers;
+        for (int r = 0; r < 4; ++r) {
+            readers.emplace_back([&, r]() {
+                int lastPrice = 0;
+                for (int i = 0; !stop.load() || i < 100; ++i) {
+                    ParkingRateConfig loaded;
+                    // 1回の一括保存で全種別が同じ料金になるため、一括読み込みの結果は常に揃っている
+                    RateConfigList many;
+                    if (!repo->load("type" + std::to_string((i + r) % 20), loaded) ||
+                        !repo->loadMany({"type0", "type19"}, many) || many.size() != 2 ||
+                        many[0].second.unitPrice != many[1].second.unitPrice ||
+                        many[0].second.unitPrice < lastPrice) {
+                        ++errors;
+                    } else {
+                        lastPrice = many[0].second.unitPrice;
+                    }
+                    ++reads;
+                }
+            });
+        }
+
+        while (reads.load() == 0) {
+            std::this_thread::yield();
+        }
+        for (int round = 1; round <= 50; ++round) {
+            for (auto& entry : configs) {
+                entry.second.unitPrice = 500 + round;
+            }
+            REQUIRE(repo->saveBatch(configs) == true);
+        }
+        stop.store(true);
+        for (std::thread& reader : readers) {
+            reader.join();
+        }
+        REQUIRE(errors.load() == 0);
+
+        ParkingRateConfig loaded;
+        REQUIRE(repo->load("type7", loaded) == true);
+        REQUIRE(loaded.unitPrice == 550);
+    }
+
+    SECTION("同じスレッドで作り直したリポジトリは新しい接続を使う") {
+        {
+            auto repo = createPooledSQLiteRepository(testDb);
+            REQUIRE(repo->save("weekday", weekday) == true);
+            REQUIRE(repo->exists("weekday") == true);
+        }
+        removeDb();
+        auto repo = createPooledSQLiteRepository(testDb);
+        REQUIRE(repo->exists("weekday") == false);
+    }
+
+    SECTION("終了したスレッドの接続を次のスレッドが使い回す") {
+        auto repo = createPooledSQLiteRepository(testDb);
+        REQUIRE(repo->save("weekday", weekday) == true);
+        auto readOnNewThread = [&]() {
+            bool found = false;
+            std::thread reader([&]() {
+                ParkingRateConfig loaded;
+                found = repo->load("weekday", loaded);
+            });
+            reader.join();
+            return found;
+        };
+
+        REQUIRE(readOnNewThread() == true);
+        std::size_t before = openFileCount();
+        for (int i = 0; i < 50; ++i) {
+            REQUIRE(readOnNewThread() == true);
+        }
+        REQUIRE(openFileCount() == before);
+    }
+
+    SECTION("破棄すると、動き続けているスレッドに貸した接続も閉じる") {
+        std::size_t before = openFileCount();
+        auto repo = createPooledSQLiteRepository(testDb);
+        REQUIRE(repo->save("weekday", weekday) == true);
+
+        std::mutex mutex;
+        std::condition_variable changed;
+        bool loaded = false;
+        bool finish = false;
+        std::thread worker([&]() {
+            ParkingRateConfig config;
+            bool found = repo->load("weekday", config);
+            std::unique_lock<std::mutex> lock(mutex);
+            loaded = found;
+            changed.notify_all();
+            changed.wait(lock, [&]() { return finish; });
+        });
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            changed.wait(lock, [&]() { return loaded; });
+        }
+        REQUIRE(openFileCount() > before);
+        repo.reset();
+        std::size_t afterReset = openFileCount();
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            finish = true;
+        }
+        changed.notify_all();
+        worker.join();
+        REQUIRE(afterReset == before);
+    }
+
+    SECTION("開けなかった接続は残さず、次の読み込みで開き直す") {
+        std::string dir = "/tmp/test_unit_repo_pool_" + std::to_string(::getpid());
+        std::string path = dir + "/rates.db";
+        auto repo = createPooledSQLiteRepository(path);
+        RateConfigList configs;
+        REQUIRE(repo->loadAll(configs) == false);
+
+        REQUIRE(::mkdir(dir.c_str(), 0755) == 0);
+        REQUIRE(repo->loadAll(configs) == true);
+        REQUIRE(configs.empty());
+        repo.reset();
+        std::remove(path.c_str());
+        std::remove((path + "-wal").c_str());
+        std::remove((path + "-shm").c_str());
+        ::rmdir(dir.c_str());
+    }
+
+    removeDb();
+}
+
+namespace {
+
+// saveBatch の呼び出しを記録し、必要なら止めておけるメモリ上のリポジトリ
+class RecordingRepository : public ParkingRateRepository {
+public:
+    std::mutex mutex;
+    std::condition_variable released;
+    bool blocked = false;
+    bool failing = false;
+    std::string failingType;  // この種別を含む一括保存は何もコミットせずに失敗する
+    int entered = 0;
+    std::vector<std::size_t> batchSizes;
+    std::map<std::string, ParkingRateConfig> rows;
+
+    bool save(const std::string& type, const ParkingRateConfig& config) override {
+        return saveBatch({{type, config}});
+    }
+
+    bool saveBatch(const RateConfigList& configs) override {
+        std::unique_lock<std::mutex> lock(mutex);
+        ++entered;
+        released.notify_all();
+        released.wait(lock, [this]() { return !blocked; });
+        batchSizes.push_back(configs.size());
+        if (failing) {
+            return false;
+        }
+        for (const auto& entry : configs) {
+            if (entry.first == failingType) {
+                return false;
+            }
+        }
+        for (const auto& entry : configs) {
+            rows[entry.first] = entry.second;
+        }
+        return true;
+    }
+
+    bool load(const std::string& type, ParkingRateConfig& config) override {
+        std::lock_guard<std::mutex> lock(mutex);
+        auto it = rows.find(type);
+        if (it == rows.end()) {
+            return false;
+        }
+        config = it->second;
+        return true;
+    }
+
+    bool exists(const std::string& type) override {
+        std::lock_guard<std::mutex> lock(mutex);
+        return rows.count(type) != 0;
+    }
+
+    // saveBatch が count 回呼ばれるまで待つ
+    void waitUntilEntered(int count) {
+        std::unique_lock<std::mutex> lock(mutex);
+        released.wait(lock, [this, count]() { return entered >= count; });
+    }
+
+    void setBlocked(bool value) {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            blocked = value;
+        }
+        released.notify_all();
+    }
+};
+
+} // namespace
+
+TEST_CASE("ユニットテスト: 非同期書き込みリポジトリ", "[unit][async]") {
+    ParkingRateConfig weekday = {60, 500, 720, 1500, 60, 300, 720, 1000};
+
+    SECTION("コミット前の書き込みも読み込みに見え、future でコミットを確認できる") {
+        auto recording = std::make_unique<RecordingRepository>();
+        RecordingRepository* inner = recording.get();
+        inner->setBlocked(true);
+        AsyncRateRepository repo(std::move(recording));
+
+        std::future<bool> result = repo.saveAsync("weekday", weekday);
+        ParkingRateConfig loaded;
+        REQUIRE(repo.load("weekday", loaded) == true);
+        REQUIRE(loaded.unitPrice == 500);
+        REQUIRE(repo.exists("weekday") == true);
+        REQUIRE(result.wait_for(std::chrono::milliseconds(10)) == std::future_status::timeout);
+
+        inner->setBlocked(false);
+        REQUIRE(result.get() == true);
+        REQUIRE(inner->load("weekday", loaded) == true);
+    }
+
+    SECTION("同じ種別への書き込みは最後の値にまとめて1トランザクションでコミットする") {
+        auto recording = std::make_unique<RecordingRepository>();
+        RecordingRepository* inner = recording.get();
+        AsyncRateRepository repo(std::move(recording));
+
+        // 最初の書き込みのコミット中に残りをためる
+        inner->setBlocked(true);
+        std::vector<std::future<bool>> results;
+        results.push_back(repo.saveAsync("first", weekday));
+        inner->waitUntilEntered(1);
+        for (int i = 0; i < 100; ++i) {
+            ParkingRateConfig config = weekday;
+            config.unitPrice = 1000 + i;
+            results.push_back(repo.saveAsync(i % 2 == 0 ? "weekday" : "holiday", config));
+        }
+        inner->setBlocked(false);
+        for (std::future<bool>& result : results) {
+            REQUIRE(result.get() == true);
+        }
+        repo.flush();
+
+        // コミット中にたまった100件は、種別ごとにまとめられて1回のトランザクションになる
+        REQUIRE(inner->batchSizes == std::vector<std::size_t>{1, 2});
+
+        ParkingRateConfig loaded;
+        REQUIRE(inner->load("weekday", loaded) == true);
+        REQUIRE(loaded.unitPrice == 1098);
+        REQUIRE(inner->load("holiday", loaded) == true);
+        REQUIRE(loaded.unitPrice == 1099);
+    }
+
+    SECTION("コミットに失敗すると future がfalseになり、inner の内容に戻る") {
+        auto recording = std::make_unique<RecordingRepository>();
+        RecordingRepository* inner = recording.get();
+        inner->failing = true;
+        AsyncRateRepository repo(std::move(recording));
+
+        REQUIRE(repo.saveAsync("weekday", weekday).get() == false);
+        REQUIRE(repo.save("weekday", weekday) == false);
+        REQUIRE(repo.exists("weekday") == false);
+    }
+
+    SECTION("saveBatch は maxBatch を超えても分けずにコミットし、途中で失敗すれば何もコミットしない") {
+        auto recording = std::make_unique<RecordingRepository>();
+        RecordingRepository* inner = recording.get();
+        inner->failingType = "broken";
+        AsyncRepositoryOptions options;
+        options.maxBatch = 2;
+        AsyncRateRepository repo(std::move(recording), options);
+
+        RateConfigList configs = {{"a", weekday}, {"b", weekday}, {"broken", weekday}, {"c", weekday}};
+        REQUIRE(repo.saveBatch(configs) == false);
+        REQUIRE(inner->batchSizes == std::vector<std::size_t>{4});
+        REQUIRE(inner->rows.empty());
+        REQUIRE(repo.exists("a") == false);
+
+        configs[2].first = "d";
+        REQUIRE(repo.saveBatch(configs) == true);
+        REQUIRE(inner->batchSizes == std::vector<std::size_t>{4, 4});
+        REQUIRE(inner->rows.size() == 4);
+    }
+
+    SECTION("破棄時にキューに残った書き込みをコミットする") {
+        const char* testDb = "/tmp/test_unit_repo_async.db";
+        std::remove(testDb);
+        {
+            AsyncRepositoryOptions options;
+            options.queueCapacity = 8;
+            options.maxBatch = 4;
+            AsyncRateRepository repo(createSQLiteRepository(testDb), options);
+            for (int i = 0; i < 50; ++i) {
+                ParkingRateConfig config = weekday;
+                config.unitPrice = i;
+                repo.saveAsync("type" + std::to_string(i % 10), config);
+            }
+        }
+        auto direct = createSQLiteRepository(testDb);
+        RateConfigList loaded;
+        REQUIRE(direct->loadAll(loaded) == true);
+        REQUIRE(loaded.size() == 10);
+        ParkingRateConfig config;
+        REQUIRE(direct->load("type3", config) == true);
+        REQUIRE(config.unitPrice == 43);
+        std::remove(testDb);
+    }
+
+    SECTION("複数スレッドからの書き込み") {
+        const char* testDb = "/tmp/test_unit_repo_async.db";
+        std::remove(testDb);
+        {
+            AsyncRateRepository repo(createSQLiteRepository(testDb));
+            std::vector<std::thread> producers;
+            std::atomic<int> failures(0);
+            for (int t = 0; t < 4; ++t) {
+                producers.emplace_back([&, t]() {
+                    for (int i = 0; i < 200; ++i) {
+                        ParkingRateConfig config = weekday;
+                        config.unitPrice = i;
+                        std::string type = "thread" + std::to_string(t);
+                        if (!repo.save(type, config)) {
+                            ++failures;
+                        }
+                        ParkingRateConfig loaded;
+                        // 自分の書き込みは、他のスレッドの書き込み中でもすぐに見える
+                        if (!repo.load(type, loaded) || loaded.unitPrice != i) {
+                            ++failures;
+                        }
+                    }
+                });
+            }
+            for (std::thread& producer : producers) {
+                producer.join();
+            }
+            REQUIRE(failures.load() == 0);
+
+            RateConfigList loaded;
+            REQUIRE(repo.loadAll(loaded) == true);
+            REQUIRE(loaded.size() == 4);
+            REQUIRE(loaded[2].second.unitPrice == 199);
+            // 同時に書き込んだ分はトランザクションがまとめられる
+            REQUIRE(repo.commitCount() <= 800);
+        }
+        std::remove(testDb);
+    }
+}
+
+TEST_CASE("ユニットテスト: キャッシュと inner の呼び出し", "[unit][cache]") {
+    ParkingRateConfig weekday = {60, 500, 720, 1500, 60, 300, 720, 1000};
+
+    SECTION("inner の呼び出し中でも、キャッシュに当たった読み込みは待たない") {
+        auto recording = std::make_unique<RecordingRepository>();
+        RecordingRepository* inner = recording.get();
+        auto cached = createCachingRepository(std::move(recording), std::chrono::hours(1));
+        REQUIRE(cached->save("weekday", weekday) == true);
+        // 初回の読み込みで dataVersion を確認し、以降の確認は1時間後になる
+        REQUIRE(cached->exists("weekday") == true);
+
+        // 他のスレッドの書き込みを inner の中で止める
+        inner->setBlocked(true);
+        std::atomic<bool> saved(false);
+        std::thread writer([&]() {
+            saved.store(cached->save("holiday", weekday));
+        });
+        inner->waitUntilEntered(2);
+
+        ParkingRateConfig loaded;
+        REQUIRE(cached->load("weekday", loaded) == true);
+        REQUIRE(loaded.unitPrice == 500);
+        REQUIRE(cached->exists("weekday") == true);
+        RateConfigList many;
+        REQUIRE(cached->loadMany({"weekday"}, many) == true);
+        REQUIRE(many.size() == 1);
+
+        inner->setBlocked(false);
+        writer.join();
+        REQUIRE(saved.load() == true);
+        REQUIRE(cached->exists("holiday") == true);
+    }
+}
+
 TEST_CASE("ユニットテスト: エッジケース", "[unit]") {
     SECTION("0分のテスト") {
         ParkingLot lot(60, 500);
@@ -300,3 +1034,270 @@ TEST_CASE("ユニットテスト: エッジケース", "[unit]") {
     }
 }
 
+
+// 浮動小数点で切り上げていた従来の料金計算（差分テストの基準）
+static int legacyRateFee(int minutes, int unitMinutes, int unitPrice, int maxMinutes, int maxFee) {
+    int units = static_cast<int>(std::ceil(static_cast<double>(minutes) / unitMinutes));
+    int baseFee = units * unitPrice;
+    if (minutes >= maxMinutes && maxMinutes > 0) {
+        return maxFee;
+    }
+    if (minutes >= 300 && baseFee > maxFee && maxMinutes > 0) {
+        return maxFee;
+    }
+    return baseFee;
+}
+
+TEST_CASE("ユニットテスト: 整数料金カーネル", "[unit]") {
+    SECTION("0分から100,000分まで従来の計算結果と一致する") {
+        ParkingLot basicLot(60, 500);
+        WeekdayParkingLot weekdayLot;
+        HolidayParkingLot holidayLot;
+
+        int mismatches = 0;
+        int firstMismatch = -1;
+        for (int minutes = 0; minutes <= 100000; ++minutes) {
+            bool same =
+                basicLot.calculateFee(minutes) == legacyRateFee(minutes, 60, 500, 0, 0) &&
+                weekdayLot.calculateFee(minutes, 10, 0) == legacyRateFee(minutes, 60, 500, 720, 1500) &&
+                weekdayLot.calculateFee(minutes, 20, 0) == legacyRateFee(minutes, 60, 300, 720, 1000) &&
+                holidayLot.calculateFee(minutes, 10, 0) == legacyRateFee(minutes, 30, 500, 360, 1500) &&
+                holidayLot.calculateFee(minutes, 20, 0) == legacyRateFee(minutes, 60, 300, 360, 1000);
+            if (!same) {
+                if (firstMismatch < 0) {
+                    firstMismatch = minutes;
+                }
+                ++mismatches;
+            }
+        }
+
+        INFO("最初の不一致: " << firstMismatch << "分");
+        REQUIRE(mismatches == 0);
+    }
+
+    SECTION("単位時間数の切り上げ") {
+        REQUIRE(calculateUnits(0, 60) == 0);
+        REQUIRE(calculateUnits(1, 60) == 1);
+        REQUIRE(calculateUnits(60, 60) == 1);
+        REQUIRE(calculateUnits(61, 60) == 2);
+        // 負の時間・不正な単位時間は0単位
+        REQUIRE(calculateUnits(-30, 60) == 0);
+        REQUIRE(calculateUnits(100, 0) == 0);
+        // intの上限付近でもずれない
+        REQUIRE(calculateUnits(std::numeric_limits<int>::max(), 1) == std::numeric_limits<int>::max());
+        REQUIRE(calculateUnits(std::numeric_limits<int>::max(), 60) == 35791395);
+    }
+
+    SECTION("金額がintを超える場合は飽和する") {
+        FeeRate rate{1, 1000, 0, 0};
+        REQUIRE(calculateRateFee(std::numeric_limits<int>::max(), rate) == std::numeric_limits<int>::max());
+
+        FeeRate refund{1, -1000, 0, 0};
+        REQUIRE(calculateRateFee(std::numeric_limits<int>::max(), refund) == std::numeric_limits<int>::min());
+
+        // 最大料金がある場合は飽和せずに最大料金
+        FeeRate capped{1, 1000, 720, 1500};
+        REQUIRE(calculateRateFee(std::numeric_limits<int>::max(), capped) == 1500);
+    }
+}
+
+TEST_CASE("ユニットテスト: 一括料金計算", "[unit][batch]") {
+    SECTION("calculateFeesは1件ずつのcalculateFeeと一致する") {
+        WeekdayParkingLot weekdayLot;
+        HolidayParkingLot holidayLot;
+        ParkingLot basicLot(60, 500);
+
+        std::vector<int> minutes;
+        for (int m = -100; m <= 5000; ++m) {
+            minutes.push_back(m);
+        }
+        minutes.push_back(std::numeric_limits<int>::max());
+        minutes.push_back(std::numeric_limits<int>::min());
+
+        std::vector<int> fees(minutes.size());
+        ParkingLot* lots[] = {&weekdayLot, &holidayLot, &basicLot};
+        for (ParkingLot* lot : lots) {
+            lot->calculateFees(minutes.data(), fees.data(), minutes.size());
+            for (std::size_t i = 0; i < minutes.size(); ++i) {
+                if (fees[i] != lot->calculateFee(minutes[i])) {
+                    FAIL("minutes=" << minutes[i] << " batch=" << fees[i]);
+                }
+            }
+        }
+    }
+
+    SECTION("時刻指定の一括計算は全時刻で1件ずつの計算と一致する") {
+        HolidayParkingLot lot;
+        std::vector<int> minutes, hours, startMinutes;
+        for (int h = 0; h < 24; ++h) {
+            for (int mi = 0; mi < 60; ++mi) {
+                minutes.push_back((h * 60 + mi) * 7 % 1500);
+                hours.push_back(h);
+                startMinutes.push_back(mi);
+            }
+        }
+
+        std::vector<int> fees(minutes.size());
+        lot.calculateFees(minutes.data(), hours.data(), startMinutes.data(), fees.data(), minutes.size());
+        for (std::size_t i = 0; i < minutes.size(); ++i) {
+            REQUIRE(fees[i] == lot.calculateFee(minutes[i], hours[i], startMinutes[i]));
+        }
+    }
+
+    SECTION("前処理した料金帯は任意の設定でcalculateRateFeeと一致する") {
+        std::mt19937 rng(12345);
+        std::uniform_int_distribution<int> anyInt(std::numeric_limits<int>::min(), std::numeric_limits<int>::max());
+        std::uniform_int_distribution<int> smallInt(-10, 2000);
+
+        for (int trial = 0; trial < 2000; ++trial) {
+            FeeRate rate;
+            rate.unitMinutes = trial % 3 == 0 ? anyInt(rng) : smallInt(rng);
+            rate.unitPrice = trial % 5 == 0 ? anyInt(rng) : smallInt(rng);
+            rate.maxMinutes = smallInt(rng);
+            rate.maxFee = smallInt(rng);
+            PreparedFeeRate prepared = prepareFeeRate(rate);
+
+            for (int i = 0; i < 200; ++i) {
+                int minutes = i % 2 == 0 ? anyInt(rng) : smallInt(rng);
+                if (calculatePreparedFee(minutes, prepared) != calculateRateFee(minutes, rate)) {
+                    FAIL("unitMinutes=" << rate.unitMinutes << " unitPrice=" << rate.unitPrice
+                         << " minutes=" << minutes);
+                }
+            }
+        }
+    }
+}
+
+TEST_CASE("ユニットテスト: SIMD料金カーネル", "[unit][simd]") {
+    SECTION("実行時に選ばれたカーネルはCPUの対応状況と一致する") {
+        REQUIRE(activeFeeKernelIsa() == detectFeeKernelIsa());
+        // スカラー実装は常に使える
+        int minutes = 60;
+        int fee = 0;
+        REQUIRE(calculateFeesBatchWithIsa(FeeKernelIsa::Scalar, &minutes, &fee, 1,
+                                          prepareFeeRate(FeeRate{60, 500, 720, 1500})) == true);
+        REQUIRE(fee == 500);
+    }
+
+    SECTION("対応している全てのカーネルがスカラー実装とビット単位で一致する") {
+        std::mt19937 rng(2024);
+        std::uniform_int_distribution<int> anyInt(std::numeric_limits<int>::min(), std::numeric_limits<int>::max());
+        std::uniform_int_distribution<int> smallInt(-10, 2000);
+
+        const FeeKernelIsa isas[] = {FeeKernelIsa::Sse41, FeeKernelIsa::Avx2};
+        for (int trial = 0; trial < 500; ++trial) {
+            FeeRate rate;
+            rate.unitMinutes = trial % 3 == 0 ? anyInt(rng) : smallInt(rng);
+            rate.unitPrice = trial % 5 == 0 ? anyInt(rng) : smallInt(rng);
+            rate.maxMinutes = trial % 7 == 0 ? 0 : smallInt(rng);
+            rate.maxFee = smallInt(rng);
+            PreparedFeeRate prepared = prepareFeeRate(rate);
+
+            // 端数の件数も確認するため長さを毎回変える
+            std::vector<int> minutes(static_cast<std::size_t>(trial % 37 + 1));
+            for (std::size_t i = 0; i < minutes.size(); ++i) {
+                minutes[i] = i % 2 == 0 ? anyInt(rng) : smallInt(rng);
+            }
+
+            std::vector<int> expected(minutes.size());
+            REQUIRE(calculateFeesBatchWithIsa(FeeKernelIsa::Scalar, minutes.data(), expected.data(),
+                                              minutes.size(), prepared));
+            for (FeeKernelIsa isa : isas) {
+                std::vector<int> actual(minutes.size(), 0x5a5a5a5a);
+                if (!calculateFeesBatchWithIsa(isa, minutes.data(), actual.data(), minutes.size(), prepared)) {
+                    continue;  // このCPUでは使えない
+                }
+                if (actual != expected) {
+                    FAIL("isa=" << static_cast<int>(isa) << " unitMinutes=" << rate.unitMinutes
+                         << " unitPrice=" << rate.unitPrice);
+                }
+            }
+        }
+    }
+
+    SECTION("既定の料金設定で全ての分数が一致する") {
+        std::vector<int> minutes;
+        for (int m = 0; m <= 100000; ++m) {
+            minutes.push_back(m);
+        }
+        std::vector<int> expected(minutes.size());
+        std::vector<int> actual(minutes.size());
+
+        PreparedFeeRate rates[] = {
+            prepareFeeRate(FeeRate{60, 500, 720, 1500}), prepareFeeRate(FeeRate{60, 300, 720, 1000}),
+            prepareFeeRate(FeeRate{30, 500, 360, 1500}), prepareFeeRate(FeeRate{60, 300, 360, 1000})};
+        for (const PreparedFeeRate& rate : rates) {
+            calculateFeesBatchWithIsa(FeeKernelIsa::Scalar, minutes.data(), expected.data(), minutes.size(), rate);
+            calculateFeesBatch(minutes.data(), actual.data(), minutes.size(), rate);
+            REQUIRE(actual == expected);
+        }
+    }
+}
+
+TEST_CASE("ユニットテスト: CompiledTariff", "[unit][compiled]") {
+    ParkingRateConfig holidayConfig = {30, 500, 360, 1500, 60, 300, 360, 1000};
+
+    SECTION("料金表の範囲内外でParkingLotと一致する") {
+        CompiledTariff tariff(holidayConfig, 2000);
+        HolidayParkingLot lot;
+
+        for (int minutes = -10; minutes <= 2100; ++minutes) {
+            if (tariff.calculateFee(minutes, 10, 0) != lot.calculateFee(minutes, 10, 0) ||
+                tariff.calculateFee(minutes, 20, 0) != lot.calculateFee(minutes, 20, 0)) {
+                FAIL("minutes=" << minutes);
+            }
+        }
+        REQUIRE(tariff.daytimeFee(std::numeric_limits<int>::max()) == 1500);
+        REQUIRE(tariff.nighttimeFee(std::numeric_limits<int>::min()) == 0);
+    }
+
+    SECTION("既定の範囲は3日間で、料金表のメモリ使用量を報告する") {
+        CompiledTariff tariff(holidayConfig);
+        REQUIRE(tariff.horizonMinutes() == 3 * 24 * 60);
+        REQUIRE(tariff.daytimeTable()[30] == 500);
+        REQUIRE(tariff.nighttimeTable()[60] == 300);
+        REQUIRE(tariff.memoryBytes() >= 2 * (3 * 24 * 60 + 1) * sizeof(int));
+    }
+
+    SECTION("範囲0の場合は全てカーネルで計算する") {
+        CompiledTariff tariff(holidayConfig, 0);
+        REQUIRE(tariff.daytimeFee(0) == 0);
+        REQUIRE(tariff.daytimeFee(60) == 1000);
+        REQUIRE(tariff.nighttimeFee(60) == 300);
+    }
+}
+
+TEST_CASE("ユニットテスト: 値型の料金体系", "[unit][tariff]") {
+    SECTION("ParkingLotは値型の料金体系を公開する") {
+        WeekdayParkingLot weekdayLot;
+        HolidayParkingLot holidayLot;
+        REQUIRE(weekdayLot.tariff().daytime.unitMinutes == 60);
+        REQUIRE(holidayLot.tariff().daytime.unitMinutes == 30);
+
+        ParkingRateConfig config = makeRateConfig(kHolidayTariff);
+        WeekdayParkingLot configuredLot(config);
+        REQUIRE(configuredLot.tariff().daytime.maxMinutes == 360);
+        REQUIRE(configuredLot.tariff().nighttime.maxFee == 1000);
+    }
+
+    SECTION("DayTariffsはDayKindで引いてParkingLotと同じ料金を返す") {
+        WeekdayParkingLot weekdayLot;
+        HolidayParkingLot holidayLot;
+        DayTariffs tariffs = {{weekdayLot.tariff(), holidayLot.tariff()}};
+
+        for (int minutes = 0; minutes <= 1500; minutes += 7) {
+            REQUIRE(tariffs.calculateFee(DayKind::Weekday, minutes, 10, 0) == weekdayLot.calculateFee(minutes, 10, 0));
+            REQUIRE(tariffs.calculateFee(DayKind::Holiday, minutes, 20, 0) == holidayLot.calculateFee(minutes, 20, 0));
+        }
+        REQUIRE(tariffs.calculateMixedFee(720, 900) == ParkingLot::calculateFee(720, 900, &weekdayLot, &holidayLot));
+    }
+
+    SECTION("料金体系を配列にそのまま並べられる") {
+        std::vector<DayTariffs> lots(3, kDefaultDayTariffs);
+        lots[1][DayKind::Holiday].daytime.unitPrice = 600;
+
+        REQUIRE(lots[0].calculateFee(DayKind::Holiday, 30, 10, 0) == 500);
+        REQUIRE(lots[1].calculateFee(DayKind::Holiday, 30, 10, 0) == 600);
+        REQUIRE(lots[2].calculateFee(DayKind::Weekday, 60, 10, 0) == 500);
+    }
+}